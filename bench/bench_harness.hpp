@@ -0,0 +1,200 @@
+/**
+ * @file bench_harness.hpp
+ * @brief Minimal micro-benchmark harness for the Cinema hot paths
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Allocations made by the calling thread so far
+ * @return Number of operator new calls on this thread
+ * @note Defined in alloc_counter.cpp, which replaces the global operator new
+ */
+uint64_t threadAllocations();
+
+/**
+ * @class Bench
+ * @brief Runs timed cases across thread counts and reports them as JSON
+ * 
+ * Every case is run in batches until Config::minSeconds of measured time
+ * have accumulated. A batch starts all worker threads behind a barrier,
+ * splits the batch's operations round-robin between them and is timed
+ * from release to join. An optional reset step runs untimed between
+ * batches for cases that consume state, such as bookings.
+ * 
+ * @par Reported Metrics
+ * - ns_per_op: wall time x threads / operations, the cost of one
+ *   operation as seen by one thread
+ * - allocs_per_op: operator new calls per operation
+ * - ops_per_sec: aggregate throughput of all threads
+ */
+class Bench {
+public:
+    /**
+     * @struct Config
+     * @brief Parameters shared by all cases of a run
+     */
+    struct Config {
+        std::vector<size_t> showCounts{9, 90};       ///< Catalogue sizes to run
+        std::vector<size_t> seatCounts{20, 200};     ///< Seats per show to run
+        std::vector<int> threadCounts{1, 4, 16};     ///< Thread counts to run
+        double minSeconds = 0.2;                     ///< Measured time per case
+    };
+    
+    /**
+     * @struct Result
+     * @brief Measurements of one case at one parameter combination
+     */
+    struct Result {
+        std::string name;        ///< Case name
+        size_t shows;            ///< Number of shows
+        size_t seats;            ///< Seats per show
+        int threads;             ///< Worker threads
+        uint64_t operations;     ///< Operations measured
+        double nsPerOp;          ///< Per-thread cost of one operation
+        double allocsPerOp;      ///< Allocations per operation
+        double opsPerSec;        ///< Aggregate throughput
+    };
+    
+    /**
+     * @brief Parse command line options
+     * @param argc Argument count
+     * @param argv Arguments: --shows a,b --seats a,b --threads a,b --min-seconds s
+     * @return Config with defaults for options not given
+     */
+    static Config parseArgs(int argc, char** argv) {
+        Config config;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string option = argv[i];
+            std::string value = argv[i + 1];
+            if (option == "--shows") {
+                config.showCounts = parseList<size_t>(value);
+            } else if (option == "--seats") {
+                config.seatCounts = parseList<size_t>(value);
+            } else if (option == "--threads") {
+                config.threadCounts = parseList<int>(value);
+            } else if (option == "--min-seconds") {
+                config.minSeconds = std::atof(value.c_str());
+            } else {
+                std::cerr << "Unknown option " << option << std::endl;
+            }
+        }
+        return config;
+    }
+    
+    /**
+     * @brief Measure one case
+     * @param config Run configuration
+     * @param name Case name
+     * @param shows Number of shows the case was set up with
+     * @param seats Seats per show the case was set up with
+     * @param threads Worker threads
+     * @param batchOps Operations per batch
+     * @param reset Called untimed before every batch
+     * @param op Called as op(threadIndex, operationIndex) for every operation
+     * @return Aggregated measurements
+     */
+    template <typename Reset, typename Op>
+    static Result run(const Config& config, const std::string& name, size_t shows, size_t seats,
+                      int threads, size_t batchOps, Reset&& reset, Op&& op) {
+        uint64_t operations = 0;
+        uint64_t allocations = 0;
+        double elapsedNs = 0;
+        
+        while (elapsedNs < config.minSeconds * 1e9 || operations == 0) {
+            reset();
+            
+            std::atomic<int> ready{0};
+            std::atomic<bool> go{false};
+            std::vector<uint64_t> threadAllocs(threads, 0);
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    ready++;
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    uint64_t before = threadAllocations();
+                    for (size_t i = t; i < batchOps; i += threads) {
+                        op(t, i);
+                    }
+                    threadAllocs[t] = threadAllocations() - before;
+                });
+            }
+            while (ready.load() < threads) {
+                std::this_thread::yield();
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            auto end = std::chrono::steady_clock::now();
+            
+            elapsedNs += std::chrono::duration<double, std::nano>(end - start).count();
+            operations += batchOps;
+            for (uint64_t count : threadAllocs) {
+                allocations += count;
+            }
+        }
+        
+        Result result{name, shows, seats, threads, operations,
+                      elapsedNs * threads / static_cast<double>(operations),
+                      static_cast<double>(allocations) / static_cast<double>(operations),
+                      static_cast<double>(operations) / (elapsedNs / 1e9)};
+        std::cerr << name << " shows=" << shows << " seats=" << seats << " threads=" << threads
+                  << ": " << result.nsPerOp << " ns/op, " << result.allocsPerOp << " allocs/op, "
+                  << result.opsPerSec << " ops/s" << std::endl;
+        return result;
+    }
+    
+    /**
+     * @brief Write results as a JSON document
+     * @param out Output stream
+     * @param suite Name of the benchmark executable
+     * @param results Results to write
+     */
+    static void writeJson(std::ostream& out, const std::string& suite, const std::vector<Result>& results) {
+        out << "{\n  \"suite\": \"" << suite << "\",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"shows\": " << r.shows
+                << ", \"seats\": " << r.seats << ", \"threads\": " << r.threads
+                << ", \"operations\": " << r.operations << ", \"ns_per_op\": " << r.nsPerOp
+                << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"ops_per_sec\": " << r.opsPerSec << "}";
+            out << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    template <typename T>
+    static std::vector<T> parseList(const std::string& value) {
+        std::vector<T> list;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            long long parsed = std::atoll(item.c_str());
+            if (parsed > 0) {
+                list.push_back(static_cast<T>(parsed));
+            }
+        }
+        return list;
+    }
+};
@@ -0,0 +1,168 @@
+/**
+ * @file cinema_bench.cpp
+ * @brief Micro-benchmarks for the server booking and formatting hot paths
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ * 
+ * @par Cases
+ * - Shows::bookSeats: single-seat bookings until every show is sold out
+ * - Shows::getAvailableSeats: seat list of one show
+ * - CinemaService::formatCinemaData: full text catalogue
+ * - CinemaService::encodeCatalogue: full binary catalogue
+ * - CinemaSnapshot::cinemaData: cached catalogue read
+ * - BookingService::processBooking: parse, book and build the reply
+ * - SeatAllocator::allocate: best free pair until every show is sold out
+ * 
+ * Each case runs for every combination of --shows, --seats and --threads;
+ * results are printed to stdout as JSON, progress goes to stderr.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "cinema.hpp"
+#include "seat_allocator.hpp"
+
+namespace {
+
+/**
+ * @brief Build a catalogue of three movies per theater
+ * @param showCount Number of shows
+ * @param seatCount Seats per show
+ * @param partlyBooked true to book roughly a third of the seats
+ * @return Shows named "Theater<k>" / "Movie<j>"
+ */
+ShowStore makeShows(size_t showCount, size_t seatCount, bool partlyBooked) {
+    ShowStore shows;
+    shows.reserve(showCount, seatCount);
+    for (size_t i = 0; i < showCount; ++i) {
+        Shows& show = shows.emplace_back("Movie" + std::to_string(i % 3), "2025-09-11 19:30",
+                                         "Theater" + std::to_string(i / 3), seatCount);
+        if (partlyBooked) {
+            std::vector<bool> pattern(seatCount);
+            for (size_t s = 0; s < seatCount; ++s) {
+                pattern[s] = (s * 7 + i) % 3 == 0;
+            }
+            show.seats = pattern;
+        }
+    }
+    return shows;
+}
+
+/**
+ * @struct Catalogue
+ * @brief Shows together with the registry and snapshot built from them
+ */
+struct Catalogue {
+    ShowStore shows;
+    std::unique_ptr<ShowRegistry> registry;
+    std::unique_ptr<CinemaSnapshot> snapshot;
+    
+    void reset(size_t showCount, size_t seatCount, bool partlyBooked) {
+        snapshot.reset();
+        registry.reset();
+        shows = makeShows(showCount, seatCount, partlyBooked);
+        registry = std::make_unique<ShowRegistry>(shows);
+        snapshot = std::make_unique<CinemaSnapshot>(shows, *registry);
+    }
+};
+
+}
+
+int main(int argc, char** argv) {
+    Bench::Config config = Bench::parseArgs(argc, argv);
+    std::vector<Bench::Result> results;
+    
+    for (size_t showCount : config.showCounts) {
+        for (size_t seatCount : config.seatCounts) {
+            const size_t capacity = showCount * seatCount;
+            Catalogue catalogue;
+            
+            // Operation i books seat i % seatCount + 1 of show i / seatCount,
+            // so threads contend on neighbouring seats of the same show
+            std::vector<std::vector<SeatNumber>> seatRequests(capacity);
+            for (size_t i = 0; i < capacity; ++i) {
+                seatRequests[i] = {static_cast<SeatNumber>(i % seatCount + 1)};
+            }
+            
+            // Booking replies re-format the catalogue, so bound the batch
+            const size_t bookingOps = std::min<size_t>(capacity, 2000);
+            const size_t bookingStride = std::max<size_t>(1, capacity / bookingOps);
+            std::vector<std::string> bookingRequests(bookingOps);
+            for (size_t i = 0; i < bookingOps; ++i) {
+                size_t slot = i * bookingStride;
+                size_t show = slot / seatCount;
+                bookingRequests[i] = "Theater" + std::to_string(show / 3) + ",Movie" +
+                                     std::to_string(show % 3) + "," + std::to_string(slot % seatCount + 1);
+            }
+            
+            for (int threads : config.threadCounts) {
+                results.push_back(Bench::run(config, "Shows::bookSeats", showCount, seatCount, threads, capacity,
+                    [&]() { catalogue.reset(showCount, seatCount, false); },
+                    [&](int, size_t i) {
+                        catalogue.shows[i / seatCount].bookSeats(seatRequests[i]);
+                    }));
+                
+                catalogue.reset(showCount, seatCount, true);
+                results.push_back(Bench::run(config, "Shows::getAvailableSeats", showCount, seatCount, threads, 20000,
+                    []() {},
+                    [&](int, size_t i) {
+                        auto seats = catalogue.shows[i % showCount].getAvailableSeats();
+                        (void)seats;
+                    }));
+                
+                results.push_back(Bench::run(config, "CinemaService::formatCinemaData", showCount, seatCount, threads, 200,
+                    []() {},
+                    [&](int, size_t) {
+                        auto data = CinemaService::formatCinemaData(catalogue.shows, *catalogue.registry);
+                        (void)data;
+                    }));
+                
+                results.push_back(Bench::run(config, "CinemaService::encodeCatalogue", showCount, seatCount, threads, 200,
+                    []() {},
+                    [&](int, size_t) {
+                        auto data = CinemaService::encodeCatalogue(catalogue.shows, *catalogue.registry);
+                        (void)data;
+                    }));
+                
+                results.push_back(Bench::run(config, "CinemaSnapshot::cinemaData", showCount, seatCount, threads, 20000,
+                    []() {},
+                    [&](int, size_t) {
+                        auto data = catalogue.snapshot->cinemaData();
+                        (void)data;
+                    }));
+                
+                results.push_back(Bench::run(config, "BookingService::processBooking", showCount, seatCount, threads, bookingOps,
+                    [&]() { catalogue.reset(showCount, seatCount, false); },
+                    [&](int, size_t i) {
+                        auto result = BookingService::processBooking(bookingRequests[i], catalogue.shows,
+                                                                     *catalogue.registry, *catalogue.snapshot);
+                        (void)result;
+                    }));
+                
+                // Operation i asks for a pair in show i % showCount, so threads
+                // race for the same best blocks
+                std::unique_ptr<SeatAllocator> allocator;
+                results.push_back(Bench::run(config, "SeatAllocator::allocate", showCount, seatCount, threads, capacity / 2,
+                    [&]() {
+                        allocator.reset();
+                        catalogue.reset(showCount, seatCount, false);
+                        allocator = std::make_unique<SeatAllocator>(catalogue.shows, *catalogue.registry);
+                    },
+                    [&](int, size_t i) {
+                        SeatBuffer seats;
+                        uint64_t sequence = 0;
+                        allocator->allocate(static_cast<ShowId>(i % showCount), 2, seats, sequence);
+                    }));
+            }
+        }
+    }
+    
+    Bench::writeJson(std::cout, "cinema_bench", results);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file cinema_client_bench.cpp
+ * @brief Micro-benchmark for the client catalogue parser
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ * 
+ * Measures CinemaClient::parseAndUpdateShows() on a text catalogue in the
+ * server's CINEMA DATA STREAM format. Kept apart from cinema_bench because
+ * the client and server libraries each define their own Shows class.
+ * Every thread parses into its own unconnected client.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "lib/websocket_client.hpp"
+
+namespace {
+
+/**
+ * @brief Build a catalogue in the server's text stream format
+ * @param showCount Number of shows, three movies per theater
+ * @param seatCount Seats per show, roughly a third of them booked
+ * @return Cinema data stream text
+ */
+std::string makeCatalogue(size_t showCount, size_t seatCount) {
+    std::stringstream ss;
+    ss << "=== CINEMA DATA STREAM ===\n";
+    ss << "Sequence: 1\n";
+    for (size_t i = 0; i < showCount; ++i) {
+        if (i % 3 == 0) {
+            if (i > 0) ss << "\n";
+            ss << "Theater: Theater" << i / 3 << "\n";
+        }
+        ss << "  Movie: Movie" << i % 3 << " (2025-09-11 19:30)\n";
+        ss << "    Show ID: " << i << "\n";
+        ss << "    Available seats: ";
+        size_t available = 0;
+        for (size_t s = 0; s < seatCount; ++s) {
+            if ((s * 7 + i) % 3 != 0) {
+                ss << (available++ ? ", " : "") << s + 1;
+            }
+        }
+        ss << " (Total: " << available << "/" << seatCount << ")\n";
+    }
+    ss << "\n=== END CINEMA DATA ===\n";
+    return ss.str();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Bench::Config config = Bench::parseArgs(argc, argv);
+    std::vector<Bench::Result> results;
+    
+    for (size_t showCount : config.showCounts) {
+        for (size_t seatCount : config.seatCounts) {
+            const std::string catalogue = makeCatalogue(showCount, seatCount);
+            
+            for (int threads : config.threadCounts) {
+                std::vector<std::unique_ptr<CinemaClient>> clients;
+                for (int t = 0; t < threads; ++t) {
+                    clients.push_back(std::make_unique<CinemaClient>());
+                }
+                
+                results.push_back(Bench::run(config, "CinemaClient::parseAndUpdateShows", showCount, seatCount, threads, 200,
+                    []() {},
+                    [&](int t, size_t) {
+                        clients[t]->parseAndUpdateShows(catalogue);
+                    }));
+            }
+        }
+    }
+    
+    Bench::writeJson(std::cout, "cinema_client_bench", results);
+    return 0;
+}
@@ -64,7 +64,7 @@ std::string CinemaUI::performBooking(const std::vector<Shows>& shows) {
         return "";
     }
     
-    std::vector<uint8_t> selectedSeats = selectSeats(selectedShow);
+    std::vector<SeatNumber> selectedSeats = selectSeats(selectedShow);
     if (selectedSeats.empty()) {
         std::cout << "Booking cancelled." << std::endl;
         return "";
@@ -78,7 +78,7 @@ std::string CinemaUI::performBooking(const std::vector<Shows>& shows) {
     
     
     std::string booking = selectedShow.theater + "," + selectedShow.movie;
-    for (uint8_t seat : selectedSeats) {
+    for (SeatNumber seat : selectedSeats) {
         booking += "," + std::to_string(seat);
     }
     
@@ -144,14 +144,15 @@ Shows CinemaUI::selectShow(const std::string& theater, const std::vector<Shows>&
     }
 }
 
-std::vector<uint8_t> CinemaUI::selectSeats(const Shows& selectedShow) {
+std::vector<SeatNumber> CinemaUI::selectSeats(const Shows& selectedShow) {
     std::cout << UIConstants::CLEAR_SCREEN;
     std::cout << "\nSEAT SELECTION FOR " << selectedShow.movie << " AT " << selectedShow.theater << std::endl;
     std::cout << "Show time: " << selectedShow.dateTime << std::endl;
     
     displaySpecificShow(selectedShow);
     
-    std::cout << "\nAvailable seats are numbered " << UIConstants::MIN_SEAT_NUMBER << "-" << UIConstants::MAX_SEAT_NUMBER << std::endl;
+    const int maxSeatNumber = static_cast<int>(selectedShow.seats.size());
+    std::cout << "\nAvailable seats are numbered " << UIConstants::MIN_SEAT_NUMBER << "-" << maxSeatNumber << std::endl;
     std::cout << "Enter seat numbers separated by spaces OR commas (e.g., 1 2 3 4 OR 1,2,3,4)" << std::endl;
     std::cout << "Enter 0 to cancel booking" << std::endl;
     std::cout << "\nSelect your seats: ";
@@ -163,7 +164,7 @@ std::vector<uint8_t> CinemaUI::selectSeats(const Shows& selectedShow) {
         return {};
     }
     
-    std::vector<uint8_t> seats;
+    std::vector<SeatNumber> seats;
     
     std::string normalizedInput = input;
     std::replace(normalizedInput.begin(), normalizedInput.end(), ',', ' ');
@@ -174,10 +175,10 @@ std::vector<uint8_t> CinemaUI::selectSeats(const Shows& selectedShow) {
     while (ss >> seatStr) {
         try {
             int seat = std::stoi(seatStr);
-            if (seat >= UIConstants::MIN_SEAT_NUMBER && seat <= UIConstants::MAX_SEAT_NUMBER) {
-                seats.push_back(static_cast<uint8_t>(seat));
+            if (seat >= UIConstants::MIN_SEAT_NUMBER && seat <= maxSeatNumber) {
+                seats.push_back(static_cast<SeatNumber>(seat));
             } else {
-                std::cout << "Invalid seat number: " << seat << " (must be " << UIConstants::MIN_SEAT_NUMBER << "-" << UIConstants::MAX_SEAT_NUMBER << ")" << std::endl;
+                std::cout << "Invalid seat number: " << seat << " (must be " << UIConstants::MIN_SEAT_NUMBER << "-" << maxSeatNumber << ")" << std::endl;
                 return {};
             }
         } catch (const std::exception& e) {
@@ -191,8 +192,8 @@ std::vector<uint8_t> CinemaUI::selectSeats(const Shows& selectedShow) {
         return {};
     }
     
-    std::vector<uint8_t> availableSeats = selectedShow.getAvailableSeats();
-    for (uint8_t seat : seats) {
+    std::vector<SeatNumber> availableSeats = selectedShow.getAvailableSeats();
+    for (SeatNumber seat : seats) {
         if (std::find(availableSeats.begin(), availableSeats.end(), seat) == availableSeats.end()) {
             std::cout << "Seat " << static_cast<int>(seat) << " is not available!" << std::endl;
             return {};
@@ -202,7 +203,7 @@ std::vector<uint8_t> CinemaUI::selectSeats(const Shows& selectedShow) {
     return seats;
 }
 
-bool CinemaUI::confirmBooking(const Shows& selectedShow, const std::vector<uint8_t>& seats) {
+bool CinemaUI::confirmBooking(const Shows& selectedShow, const std::vector<SeatNumber>& seats) {
     std::cout << "\nBOOKING CONFIRMATION" << std::endl;
     std::cout << std::string(UIConstants::NARROW_SEPARATOR_WIDTH, '-') << std::endl;
     std::cout << "Theater: " << selectedShow.theater << std::endl;
@@ -232,7 +233,7 @@ void CinemaUI::displaySpecificShow(const Shows& selectedShow) {
     std::cout << selectedShow.movie << " at " << selectedShow.theater << " (" << selectedShow.dateTime << ")" << std::endl;
     std::cout << std::string(UIConstants::MEDIUM_SEPARATOR_WIDTH, '=') << std::endl;
     
-    std::vector<uint8_t> availableSeats = selectedShow.getAvailableSeats();
+    std::vector<SeatNumber> availableSeats = selectedShow.getAvailableSeats();
     
     std::cout << "Available seats: ";
     if (availableSeats.empty()) {
@@ -246,20 +247,25 @@ void CinemaUI::displaySpecificShow(const Shows& selectedShow) {
     }
     std::cout << std::endl;
     
-    showSeatLayout(availableSeats);
+    showSeatLayout(availableSeats, selectedShow.seats.size());
     
     std::cout << std::string(UIConstants::MEDIUM_SEPARATOR_WIDTH, '=') << std::endl;
 }
 
-void CinemaUI::showSeatLayout(const std::vector<uint8_t>& availableSeats) {
+void CinemaUI::showSeatLayout(const std::vector<SeatNumber>& availableSeats, size_t seatCount) {
     std::cout << "\nSCREEN" << std::endl;
     std::cout << "Seat Layout:" << std::endl;
     
-    for (int row = 1; row <= UIConstants::CINEMA_ROWS; ++row) {
+    const int seats = static_cast<int>(seatCount);
+    const int rows = (seats + UIConstants::SEATS_PER_ROW - 1) / UIConstants::SEATS_PER_ROW;
+    for (int row = 1; row <= rows; ++row) {
         std::cout << "Row " << row << ": ";
         for (int seat = 1; seat <= UIConstants::SEATS_PER_ROW; ++seat) {
             int seatNumber = (row - 1) * UIConstants::SEATS_PER_ROW + seat;
-            bool isAvailable = std::find(availableSeats.begin(), availableSeats.end(), static_cast<uint8_t>(seatNumber)) != availableSeats.end();
+            if (seatNumber > seats) {
+                break;
+            }
+            bool isAvailable = std::find(availableSeats.begin(), availableSeats.end(), static_cast<SeatNumber>(seatNumber)) != availableSeats.end();
             
             if (seatNumber < 10) {
                 std::cout << "[" << (isAvailable ? std::to_string(seatNumber) : "X") << " ] ";
@@ -281,7 +287,7 @@ void CinemaUI::showBookingHelp() {
     std::cout << "  1. Select a theater" << std::endl;
     std::cout << "  2. Choose a movie" << std::endl;
     std::cout << "  3. View available seats for your selection" << std::endl;
-    std::cout << "  4. Pick your seats (1-20, multiple seats allowed)" << std::endl;
+    std::cout << "  4. Pick your seats (by number, multiple seats allowed)" << std::endl;
     std::cout << "  5. Confirm your booking" << std::endl;
     std::cout << "\nTips:" << std::endl;
     std::cout << "  • Enter 0 at any step to cancel" << std::endl;
@@ -14,9 +14,7 @@ namespace UIConstants {
     constexpr int MEDIUM_SEPARATOR_WIDTH = 50;
     constexpr int NARROW_SEPARATOR_WIDTH = 40;
     constexpr const char* CLEAR_SCREEN = "\033[2J\033[1;1H";
-    constexpr int CINEMA_ROWS = 4;
     constexpr int SEATS_PER_ROW = 5;
-    constexpr int MAX_SEAT_NUMBER = 20;
     constexpr int MIN_SEAT_NUMBER = 1;
 }
 
@@ -99,7 +97,7 @@ private:
      * @param selectedShow The selected show
      * @return Vector of selected seat numbers, empty if cancelled
      */
-    std::vector<uint8_t> selectSeats(const Shows& selectedShow);
+    std::vector<SeatNumber> selectSeats(const Shows& selectedShow);
 
     /**
      * @brief Confirm booking details
@@ -107,7 +105,7 @@ private:
      * @param seats Vector of seat numbers
      * @return true if user confirmed booking, false if cancelled
      */
-    bool confirmBooking(const Shows& selectedShow, const std::vector<uint8_t>& seats);
+    bool confirmBooking(const Shows& selectedShow, const std::vector<SeatNumber>& seats);
 
     /**
      * @brief Display information for a specific show
@@ -118,8 +116,9 @@ private:
     /**
      * @brief Show visual seat layout
      * @param availableSeats Vector of available seat numbers
+     * @param seatCount Number of seats in the auditorium
      */
-    void showSeatLayout(const std::vector<uint8_t>& availableSeats);
+    void showSeatLayout(const std::vector<SeatNumber>& availableSeats, size_t seatCount);
 
     /**
      * @brief Get user input with validation
@@ -2,17 +2,17 @@
 #include <thread>
 #include <chrono>
 
-Shows::Shows(const std::string& m, const std::string& dt, const std::string& t) 
+Shows::Shows(const std::string& m, const std::string& dt, const std::string& t, size_t seatCount) 
     : movie(m), dateTime(dt), theater(t), seatsMutex(std::make_shared<std::shared_mutex>()) {
-    seats.resize(20, false); 
+    seats.resize(seatCount, false); 
 }
 
-std::vector<uint8_t> Shows::getAvailableSeats() const {
+std::vector<SeatNumber> Shows::getAvailableSeats() const {
     std::shared_lock<std::shared_mutex> lock(*seatsMutex);
-    std::vector<uint8_t> availableSeats;
+    std::vector<SeatNumber> availableSeats;
     for (size_t i = 0; i < seats.size(); ++i) {
         if (!seats[i]) {
-            availableSeats.push_back(static_cast<uint8_t>(i + 1));
+            availableSeats.push_back(static_cast<SeatNumber>(i + 1));
         }
     }
     return availableSeats;
@@ -20,7 +20,27 @@ std::vector<uint8_t> Shows::getAvailableSeats() const {
 
 void Shows::updateSeatAvailability(const std::vector<bool>& seatStatus) {
     std::unique_lock<std::shared_mutex> lock(*seatsMutex);
-    if (seatStatus.size() == seats.size()) {
-        seats = seatStatus;
+    seats = seatStatus;
+}
+
+void Shows::updateSeatAvailability(const uint8_t* bookedBits, size_t seatCount) {
+    std::unique_lock<std::shared_mutex> lock(*seatsMutex);
+    seats.resize(seatCount);
+    for (size_t i = 0; i < seatCount; ++i) {
+        seats[i] = (bookedBits[i / 8] >> (i % 8)) & 1;
+    }
+}
+
+void Shows::markSeatBooked(SeatNumber seat) {
+    std::unique_lock<std::shared_mutex> lock(*seatsMutex);
+    if (seat >= 1 && seat <= seats.size()) {
+        seats[seat - 1] = true;
+    }
+}
+
+void Shows::markSeatAvailable(SeatNumber seat) {
+    std::unique_lock<std::shared_mutex> lock(*seatsMutex);
+    if (seat >= 1 && seat <= seats.size()) {
+        seats[seat - 1] = false;
     }
 }
\ No newline at end of file
@@ -15,6 +15,11 @@
 #include <mutex>
 #include <memory>
 
+/**
+ * @brief 1-based seat number within a show
+ */
+using SeatNumber = uint16_t;
+
 /**
  * @class Shows
  * @brief Represents a movie show with thread-safe seat management
@@ -29,14 +34,16 @@
  * are exclusive.
  * 
  * @par Seat Numbering
- * Seats are numbered 1-20 inclusive. Internal storage uses 0-based indexing.
+ * Seats are numbered 1 to seats.size() inclusive. Internal storage uses
+ * 0-based indexing. The seat count defaults to DEFAULT_SEAT_COUNT and follows
+ * the capacity reported by the server.
  * 
- * @invariant Total seats is always 20
- * @invariant Seat numbers are 1-20 inclusive
- * @invariant seats vector size is always 20
+ * @invariant Seat numbers are 1 to seats.size() inclusive
  */
 class Shows {
 public:
+	static constexpr size_t DEFAULT_SEAT_COUNT = 20;  ///< Seats when no capacity is given
+	
 	std::string movie;                ///< Movie title
 	std::string dateTime;             ///< Show date and time (e.g., "2025-09-11 19:30")
 	std::string theater;              ///< Theater name (e.g., "PVR", "IMAX")
@@ -51,41 +58,68 @@ public:
 	 * @param m Movie title
 	 * @param dt Date and time string
 	 * @param t Theater name
-	 * @post All 20 seats are initially available (false)
+	 * @param seatCount Auditorium capacity
+	 * @post All seats are initially available (false)
 	 * @post seatsMutex is initialized and ready for use
 	 */
-	Shows(const std::string& m, const std::string& dt, const std::string& t);
+	Shows(const std::string& m, const std::string& dt, const std::string& t,
+	      size_t seatCount = DEFAULT_SEAT_COUNT);
 	
 	/**
 	 * @brief Get list of available seat numbers
-	 * @return Vector of available seat numbers (1-20)
+	 * @return Vector of available seat numbers (1 to seats.size())
 	 * @note Thread-safe operation (shared lock)
 	 * @note Returns 1-based seat numbers for user display
 	 */
-	std::vector<uint8_t> getAvailableSeats() const;
+	std::vector<SeatNumber> getAvailableSeats() const;
 	
 	/**
 	 * @brief Book specific seats atomically
-	 * @param seatNumbers Vector of seat numbers to book (1-20)
+	 * @param seatNumbers Vector of seat numbers to book (1 to seats.size())
 	 * @return true if ALL seats were successfully booked
 	 * @retval false if ANY seat is already booked, invalid, or operation fails
 	 * @note Thread-safe operation (exclusive lock)
 	 * @note All-or-nothing operation - either all seats book or none
-	 * @pre All seat numbers must be in range [1,20]
+	 * @pre All seat numbers must be in range [1, seats.size()]
 	 * @post On success: specified seats are marked as booked
 	 * @post On failure: no seats are modified
 	 */
-	bool bookSeats(const std::vector<uint8_t>& seatNumbers);
+	bool bookSeats(const std::vector<SeatNumber>& seatNumbers);
 	
 	/**
 	 * @brief Update seat availability from external source
 	 * @param seatStatus New seat status vector (false=available, true=booked)
-	 * @pre seatStatus.size() must equal 20
-	 * @post If precondition met: seats vector is updated with new status
-	 * @post If precondition not met: no changes made
+	 * @post seats vector is replaced with the new status; its size becomes
+	 *       the show's seat count
 	 * @note Thread-safe operation (exclusive lock)
 	 * @note Used for synchronizing with server updates
 	 */
 	void updateSeatAvailability(const std::vector<bool>& seatStatus);
+	
+	/**
+	 * @brief Update seat availability from a packed bitmap
+	 * @param bookedBits Booked seat bits, bit i of byte j is seat 8*j + i + 1
+	 * @param seatCount Number of seats described by @p bookedBits
+	 * @post seats vector holds the new status; storage is reused when the
+	 *       seat count is unchanged
+	 * @note Thread-safe operation (exclusive lock)
+	 * @note Used by the binary protocol decoder
+	 */
+	void updateSeatAvailability(const uint8_t* bookedBits, size_t seatCount);
+	
+	/**
+	 * @brief Mark a single seat as booked
+	 * @param seat 1-based seat number; out of range seats are ignored
+	 * @note Thread-safe operation (exclusive lock)
+	 */
+	void markSeatBooked(SeatNumber seat);
+	
+	/**
+	 * @brief Mark a single seat as available again
+	 * @param seat 1-based seat number; out of range seats are ignored
+	 * @note Thread-safe operation (exclusive lock)
+	 * @note Used when a hold on the seat is released or expires
+	 */
+	void markSeatAvailable(SeatNumber seat);
 };
 
@@ -1,17 +1,275 @@
 #include "websocket_client.hpp"
 #include <iostream>
+#include <future>
 #include <thread>
 #include <chrono>
-#include <sstream>
 #include <algorithm>
+#include <charconv>
 
-CinemaClient::CinemaClient() 
-    : ws_(ioc_) {
+namespace {
+
+/**
+ * @brief Bounds-checked little-endian reader over a binary frame
+ * 
+ * Strings are returned as views into the frame, so decoding does not copy.
+ * Any read past the end clears ok and yields zero values.
+ */
+struct FrameReader {
+    std::string_view data;
+    size_t pos = 0;
+    bool ok = true;
+    
+    bool need(size_t count) {
+        if (data.size() - pos < count) {
+            ok = false;
+        }
+        return ok;
+    }
+    
+    uint64_t uint(size_t bytes) {
+        if (!need(bytes)) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+        }
+        pos += bytes;
+        return value;
+    }
+    
+    uint16_t u16() { return static_cast<uint16_t>(uint(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(uint(4)); }
+    uint64_t u64() { return uint(8); }
+    
+    std::string_view bytes(size_t count) {
+        if (!need(count)) {
+            return {};
+        }
+        std::string_view view = data.substr(pos, count);
+        pos += count;
+        return view;
+    }
+    
+    std::string_view str() {
+        return bytes(u16());
+    }
+};
+
+/**
+ * @brief Split the next line off a message
+ * @param text Remaining text, advanced past the line
+ * @param line Output: the line without its newline
+ * @return false once @p text is exhausted
+ */
+bool nextLine(std::string_view& text, std::string_view& line) {
+    if (text.empty()) {
+        return false;
+    }
+    size_t end = text.find('\n');
+    line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    return true;
+}
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+/**
+ * @brief Parse the number at the start of a field, after any spaces
+ * @return false if the field does not start with a number
+ */
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    size_t start = text.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        return false;
+    }
+    return std::from_chars(text.data() + start, text.data() + text.size(), value).ec == std::errc();
+}
+
+/**
+ * @brief Call @p apply for every run of digits in a seat list
+ */
+template <typename Apply>
+void forEachSeat(std::string_view list, Apply&& apply) {
+    const char* pos = list.data();
+    const char* end = pos + list.size();
+    while (pos < end) {
+        if (*pos < '0' || *pos > '9') {
+            ++pos;
+            continue;
+        }
+        unsigned seat = 0;
+        auto [next, err] = std::from_chars(pos, end, seat);
+        if (err == std::errc()) {
+            apply(seat);
+        }
+        pos = next;
+    }
+}
+
+using ShowIndex = std::unordered_map<uint32_t, size_t>;
+
+/**
+ * @brief A catalogue being rebuilt against the published snapshot
+ * 
+ * Each parsed show is matched to the previous snapshot by server id and
+ * names; a match with the same seats is shared, not copied. The index is
+ * only rebuilt when the show list changed.
+ */
+struct CatalogueBuilder {
+    explicit CatalogueBuilder(const ShowsSnapshot& base) : base(base) {
+        shows.reserve(base.shows.size());
+    }
+    
+    void add(uint32_t showId, bool hasId, std::string_view theater, std::string_view movie,
+             std::string_view dateTime, const std::vector<bool>& seats) {
+        size_t index = shows.size();
+        size_t previous = index;
+        if (hasId) {
+            auto it = base.indexById->find(showId);
+            previous = it == base.indexById->end() ? base.shows.size() : it->second;
+            ids.emplace_back(showId, index);
+        }
+        
+        const Shows* match = nullptr;
+        if (previous < base.shows.size()) {
+            const Shows& show = *base.shows[previous];
+            if (show.theater == theater && show.movie == movie && show.dateTime == dateTime) {
+                match = &show;
+            }
+        }
+        sameList = sameList && match != nullptr && previous == index;
+        
+        if (match && match->seats == seats) {
+            shows.push_back(base.shows[previous]);
+            return;
+        }
+        auto updated = match ? std::make_shared<Shows>(*match)
+                             : std::make_shared<Shows>(std::string(movie), std::string(dateTime),
+                                                       std::string(theater), seats.size());
+        updated->updateSeatAvailability(seats);
+        shows.push_back(std::move(updated));
+        changed = true;
+    }
+    
+    /**
+     * @return The new snapshot, or nullptr if it would equal the base
+     */
+    ShowsSnapshotPtr finish() {
+        sameList = sameList && shows.size() == base.shows.size();
+        if (sameList && !changed) {
+            return nullptr;
+        }
+        auto next = std::make_shared<ShowsSnapshot>();
+        next->shows = std::move(shows);
+        if (sameList) {
+            next->indexById = base.indexById;
+        } else {
+            next->indexById = std::make_shared<const ShowIndex>(ids.begin(), ids.end());
+        }
+        return next;
+    }
+    
+    const ShowsSnapshot& base;
+    std::vector<std::shared_ptr<const Shows>> shows;
+    std::vector<std::pair<uint32_t, size_t>> ids;
+    bool sameList = true;
+    bool changed = false;
+};
+
+/**
+ * @brief Seat changes applied to a copy of the published snapshot
+ * 
+ * A show is copied the first time it is changed; all others stay shared.
+ */
+struct SnapshotEdit {
+    explicit SnapshotEdit(const ShowsSnapshot& base)
+        : shows(base.shows), indexById(base.indexById), copies(base.shows.size(), nullptr) {}
+    
+    /**
+     * @return The show to modify, or nullptr if @p showId is unknown
+     */
+    Shows* edit(uint32_t showId) {
+        auto it = indexById->find(showId);
+        if (it == indexById->end()) {
+            return nullptr;
+        }
+        Shows*& copy = copies[it->second];
+        if (!copy) {
+            auto updated = std::make_shared<Shows>(*shows[it->second]);
+            copy = updated.get();
+            shows[it->second] = std::move(updated);
+        }
+        return copy;
+    }
+    
+    /**
+     * @return The new snapshot, or nullptr if no show was changed
+     */
+    ShowsSnapshotPtr finish() {
+        if (std::none_of(copies.begin(), copies.end(), [](Shows* copy) { return copy != nullptr; })) {
+            return nullptr;
+        }
+        auto next = std::make_shared<ShowsSnapshot>();
+        next->shows = std::move(shows);
+        next->indexById = std::move(indexById);
+        return next;
+    }
+    
+    std::vector<std::shared_ptr<const Shows>> shows;
+    std::shared_ptr<const ShowIndex> indexById;
+    std::vector<Shows*> copies;
+};
+
+ShowsSnapshotPtr emptySnapshot() {
+    auto empty = std::make_shared<ShowsSnapshot>();
+    empty->indexById = std::make_shared<const ShowIndex>();
+    return empty;
+}
+
+}
+
+const Shows* ShowsSnapshot::find(uint32_t showId) const {
+    auto it = indexById->find(showId);
+    return it == indexById->end() ? nullptr : shows[it->second].get();
+}
+
+CinemaClient::CinemaClient()
+    : ownedIoc_(std::make_unique<net::io_context>(1)),
+      ioc_(*ownedIoc_),
+      strand_(net::make_strand(ioc_)),
+      resolver_(strand_),
+      gapTimer_(strand_),
+      snapshot_(emptySnapshot()) {
+}
+
+CinemaClient::CinemaClient(net::io_context& ioc)
+    : ioc_(ioc),
+      strand_(net::make_strand(ioc_)),
+      resolver_(strand_),
+      gapTimer_(strand_),
+      snapshot_(emptySnapshot()) {
 }
 
 CinemaClient::~CinemaClient() {
-    stopMessageListener();
     disconnect();
+    if (ioThread_) {
+        work_.reset();
+        ioThread_->join();
+    }
+}
+
+void CinemaClient::startIoThread() {
+    if (!ownedIoc_) {
+        return;
+    }
+    std::call_once(ioThreadStarted_, [this]() {
+        work_.emplace(ioc_.get_executor());
+        ioThread_ = std::make_unique<std::thread>([this]() { ioc_.run(); });
+    });
 }
 
 bool CinemaClient::connect(const std::string& host, const std::string& port) {
@@ -25,124 +283,367 @@ bool CinemaClient::connect(const std::string& host, const std::string& port) {
         return true;
     }
     
-    try {
-        tcp::resolver resolver{ioc_};
-        auto const results = resolver.resolve(host, port);
-        
-        auto ep = net::connect(ws_.next_layer(), results);
-        std::string target = "/";
-        ws_.handshake(host + ":" + std::to_string(ep.port()), target);
-        
-        connected_ = true;
-        std::cout << "Connected to Cinema Server at " << host << ":" << port << "!\n" << std::endl;
+    if (strand_.running_in_this_thread()) {
+        std::cerr << "connect() would wait on its own I/O thread, use connectAsync()" << std::endl;
+        return false;
+    }
+    
+    std::promise<bool> done;
+    auto connected = done.get_future();
+    connectAsync(host, port, [&done](bool ok) { done.set_value(ok); });
+    return connected.get();
+}
+
+void CinemaClient::connectAsync(const std::string& host, const std::string& port, ConnectCallback onConnected) {
+    startIoThread();
+    net::post(strand_, [this, host, port, onConnected = std::move(onConnected)]() {
+        if (host.empty() || port.empty() || connected_ || connecting_ || reading_ || writing_) {
+            // Already connected, or the previous connection is still winding down
+            if (onConnected) {
+                onConnected(connected_ && !host.empty() && !port.empty());
+            }
+            return;
+        }
         
-        startMessageListener();
+        connecting_ = true;
+        closing_ = false;
+        ws_.emplace(strand_);
+        websocket::permessage_deflate deflate;
+        deflate.client_enable = compression_;
+        ws_->set_option(deflate);
         
-        return true;
-    } catch (std::exception const& e) {
-        std::cerr << "Connection failed: " << e.what() << std::endl;
+        resolver_.async_resolve(host, port,
+            [this, host, port, onConnected](beast::error_code ec, tcp::resolver::results_type results) {
+                if (ec || closing_) {
+                    return connectFailed(ec ? ec : net::error::operation_aborted, host, port, onConnected);
+                }
+                net::async_connect(ws_->next_layer(), results,
+                    [this, host, port, onConnected](beast::error_code ec, const tcp::endpoint& ep) {
+                        if (ec || closing_) {
+                            return connectFailed(ec ? ec : net::error::operation_aborted, host, port, onConnected);
+                        }
+                        ws_->async_handshake(host + ":" + std::to_string(ep.port()), "/",
+                            [this, host, port, onConnected](beast::error_code ec) {
+                                if (ec || closing_) {
+                                    return connectFailed(ec ? ec : net::error::operation_aborted, host, port, onConnected);
+                                }
+                                connecting_ = false;
+                                connected_ = true;
+                                std::cout << "Connected to Cinema Server at " << host << ":" << port << "!\n" << std::endl;
+                                
+                                reading_ = true;
+                                doRead();
+                                if (binaryProtocol_) {
+                                    enqueue({std::string(CinemaProtocol::BINARY_HELLO), {}});
+                                }
+                                if (onConnected) {
+                                    onConnected(true);
+                                }
+                            });
+                    });
+            });
+    });
+}
+
+void CinemaClient::connectFailed(beast::error_code ec, const std::string& host, const std::string& port,
+                                 const ConnectCallback& onConnected) {
+    connecting_ = false;
+    beast::error_code ignored;
+    ws_->next_layer().close(ignored);
+    if (!closing_) {
+        std::cerr << "Connection failed: " << ec.message() << std::endl;
         std::cerr << "Make sure the cinema server is running on " << host << ":" << port << std::endl;
-        return false;
     }
+    closing_ = false;
+    if (onConnected) {
+        onConnected(false);
+    }
+    notifyIfIdle();
 }
 
 void CinemaClient::disconnect() {
-    if (connected_) {
+    if (strand_.running_in_this_thread()) {
+        // Waiting here would stop the very handlers that finish the close
+        disconnectAsync();
+        return;
+    }
+    
+    std::promise<void> done;
+    auto closed = done.get_future();
+    disconnectAsync([&done]() { done.set_value(); });
+    closed.wait();
+}
+
+void CinemaClient::disconnectAsync(std::function<void()> onClosed) {
+    if (ownedIoc_ && !ioThread_) {
+        // Never connected, and nothing runs the strand to ask
+        if (onClosed) {
+            onClosed();
+        }
+        return;
+    }
+    
+    net::dispatch(strand_, [this, onClosed = std::move(onClosed)]() mutable {
+        if (onClosed) {
+            closeWaiters_.push_back(std::move(onClosed));
+        }
+        if (!connecting_ && !reading_ && !writing_ && !gapTimerArmed_) {
+            notifyIfIdle();
+            return;
+        }
+        if (closing_) {
+            return;
+        }
+        closing_ = true;
         connected_ = false;
-        shouldStop_ = true;
         
-        try {
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            
-            
-            if (ws_.is_open()) {
-                ws_.close(websocket::close_code::normal);
-            }
-            std::cout << "Disconnected from server." << std::endl;
-        } catch (std::exception const& e) {
-            std::string errorMsg = e.what();
-            if (errorMsg.find("gracefully closed") == std::string::npos &&
-                errorMsg.find("Operation canceled") == std::string::npos) {
-                std::cerr << "Error during disconnect: " << e.what() << std::endl;
-            }
+        if (connecting_) {
+            // Abort whichever step is running
+            resolver_.cancel();
+            beast::error_code ignored;
+            ws_->next_layer().close(ignored);
+        } else if (reading_ && !writing_) {
+            startClose();
         }
-    }
+        // Otherwise doWrite() closes once the write in flight completes
+    });
 }
 
 bool CinemaClient::isConnected() const {
     return connected_;
 }
 
-void CinemaClient::sendMessage(const std::string& message) {
+void CinemaClient::setCompression(bool enable) {
+    compression_ = enable;
+}
+
+uint64_t CinemaClient::bytesReceived() const {
+    return bytesReceived_;
+}
+
+void CinemaClient::useBinaryProtocol(bool enable) {
+    binaryProtocol_ = enable;
+    if (connected_) {
+        sendMessage(std::string(enable ? CinemaProtocol::BINARY_HELLO : CinemaProtocol::TEXT_HELLO));
+    }
+}
+
+void CinemaClient::setMessageCallback(MessageCallback callback) {
+    net::dispatch(strand_, [this, callback = std::move(callback)]() mutable {
+        onMessage_ = std::move(callback);
+    });
+}
+
+void CinemaClient::sendMessage(const std::string& message, SendCallback onSent) {
     if (!connected_) {
         std::cerr << "Not connected to server!" << std::endl;
+        if (onSent) {
+            onSent(false);
+        }
         return;
     }
     
-    try {
-        ws_.write(net::buffer(message));
-    } catch (std::exception const& e) {
-        std::cerr << "Failed to send message: " << e.what() << std::endl;
-        connected_ = false;
+    // Runs inline from the client's own handlers, so internal sends are
+    // queued before anything posted after them
+    net::dispatch(strand_, [this, outbound = Outbound{message, std::move(onSent)}]() mutable {
+        enqueue(std::move(outbound));
+    });
+}
+
+void CinemaClient::enqueue(Outbound message) {
+    if (!connected_ || closing_) {
+        if (message.onSent) {
+            message.onSent(false);
+        }
+        return;
+    }
+    outbox_.push_back(std::move(message));
+    if (!writing_) {
+        doWrite();
     }
 }
 
-std::string CinemaClient::getLastResponse() const {
-    std::lock_guard<std::mutex> lock(responseMutex_);
-    return lastResponse_;
+void CinemaClient::doWrite() {
+    writing_ = true;
+    ws_->text(true);
+    ws_->async_write(net::buffer(outbox_.front().message), [this](beast::error_code ec, std::size_t) {
+        Outbound sent = std::move(outbox_.front());
+        outbox_.pop_front();
+        writing_ = false;
+        if (ec && connected_) {
+            std::cerr << "Failed to send message: " << ec.message() << std::endl;
+            connected_ = false;
+        }
+        if (sent.onSent) {
+            sent.onSent(!ec);
+        }
+        
+        if (ec || !reading_) {
+            failOutbox();
+            notifyIfIdle();
+        } else if (closing_) {
+            failOutbox();
+            startClose();
+        } else if (!outbox_.empty()) {
+            doWrite();
+        }
+    });
 }
 
-std::string CinemaClient::getLastBookingResponse() const {
-    std::lock_guard<std::mutex> lock(responseMutex_);
-    return lastBookingResponse_;
+void CinemaClient::startClose() {
+    ws_->async_close(websocket::close_code::normal, [this](beast::error_code ec) {
+        if (ec) {
+            // The pending read fails as soon as the socket is gone
+            beast::error_code ignored;
+            ws_->next_layer().close(ignored);
+        }
+    });
 }
 
+void CinemaClient::doRead() {
+    buffer_.consume(buffer_.size());
+    ws_->async_read(buffer_, [this](beast::error_code ec, std::size_t bytes) { onRead(ec, bytes); });
+}
 
-void CinemaClient::startMessageListener() {
-    shouldStop_ = false;
-    listenerThread_ = std::make_unique<std::thread>([this]() {
-        while (connected_ && !shouldStop_) {
-            try {
-                beast::flat_buffer buffer;
-                ws_.read(buffer);
-                std::string response = beast::buffers_to_string(buffer.data());
-                
-                
-                {
-                    std::lock_guard<std::mutex> lock(responseMutex_);
-                    lastResponse_ = response;
-                }
-                
-                
-                processMessage(response);
-                
-            } catch (std::exception const& e) {
-                if (connected_ && !shouldStop_) {
-                    std::string errorMsg = e.what();
-                    if (errorMsg.find("gracefully closed") == std::string::npos &&
-                        errorMsg.find("Operation canceled") == std::string::npos) {
-                        std::cerr << "Connection lost: " << e.what() << std::endl;
-                    }
-                    connected_ = false;
-                }
-                break;
-            }
+void CinemaClient::onRead(beast::error_code ec, std::size_t bytes) {
+    if (ec) {
+        if (!closing_ && ec != websocket::error::closed && ec != net::error::operation_aborted) {
+            std::cerr << "Connection lost: " << ec.message() << std::endl;
         }
-    });
+        finishConnection(closing_ ? "ERROR: Disconnected" : "ERROR: Connection lost");
+        return;
+    }
+    
+    bytesReceived_ += bytes;
+    if (ws_->got_binary()) {
+        auto data = buffer_.data();
+        processBinaryMessage(std::string_view(static_cast<const char*>(data.data()), data.size()));
+    } else {
+        auto data = buffer_.data();
+        std::string_view response(static_cast<const char*>(data.data()), data.size());
+        processMessage(response);
+        if (onMessage_ && !isSeatDelta(response)) {
+            onMessage_(response);
+        }
+    }
+    doRead();
 }
 
-void CinemaClient::stopMessageListener() {
-    shouldStop_ = true;
-    if (listenerThread_ && listenerThread_->joinable()) {
-        listenerThread_->join();
-        listenerThread_.reset();
+void CinemaClient::finishConnection(const std::string& status) {
+    bool requested = closing_;
+    connected_ = false;
+    reading_ = false;
+    beast::error_code ignored;
+    ws_->next_layer().close(ignored);
+    gapTimer_.cancel();
+    {
+        // The next connection starts from a fresh catalogue, watching every show
+        std::lock_guard<std::mutex> lock(showsMutex_);
+        heldBack_.clear();
+        filtered_ = false;
     }
+    
+    if (requested) {
+        std::cout << "Disconnected from server." << std::endl;
+    }
+    failPendingBookings(status);
+    failOutbox();
+    notifyIfIdle();
 }
 
-void CinemaClient::processMessage(const std::string& response) {
+void CinemaClient::failOutbox() {
+    // The front entry belongs to the write in flight, which reports itself
+    std::deque<Outbound> unsent;
+    if (writing_ && !outbox_.empty()) {
+        unsent.push_back(std::move(outbox_.front()));
+        outbox_.pop_front();
+    }
+    std::swap(unsent, outbox_);
+    for (auto& message : unsent) {
+        if (message.onSent) {
+            message.onSent(false);
+        }
+    }
+}
+
+void CinemaClient::notifyIfIdle() {
+    if (connecting_ || reading_ || writing_ || gapTimerArmed_) {
+        return;
+    }
+    closing_ = false;
+    for (auto& waiter : std::exchange(closeWaiters_, {})) {
+        waiter();
+    }
+}
+
+std::vector<uint64_t> CinemaClient::sendBatch(const std::vector<std::string>& bookings, BookingReplyCallback callback) {
+    std::vector<uint64_t> ids;
+    if (bookings.empty() || bookings.size() > CinemaProtocol::MAX_BATCH_ITEMS || !connected_) {
+        return ids;
+    }
+    
+    std::string request(CinemaProtocol::BATCH_REQUEST);
+    ids.reserve(bookings.size());
+    {
+        // Registered before sending so a fast reply always finds its callback
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        for (const auto& booking : bookings) {
+            uint64_t id = nextRequestId_++;
+            ids.push_back(id);
+            pendingBookings_.emplace(id, callback);
+            request += '\n';
+            request += std::to_string(id);
+            request += ':';
+            request += booking;
+        }
+    }
+    
+    sendMessage(request, [this](bool sent) {
+        if (!sent) {
+            failPendingBookings("ERROR: Not connected to server");
+        }
+    });
+    return ids;
+}
+
+size_t CinemaClient::pendingBookings() const {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    return pendingBookings_.size();
+}
+
+std::string CinemaClient::getLastResponse() const {
+    std::lock_guard<std::mutex> lock(responseMutex_);
+    return lastResponse_;
+}
+
+std::string CinemaClient::getLastBookingResponse() const {
+    std::lock_guard<std::mutex> lock(responseMutex_);
+    return lastBookingResponse_;
+}
+
+void CinemaClient::processMessage(std::string_view response) {
+    
+    // Deltas are applied silently so they don't replace the last full response
+    if (isSeatDelta(response)) {
+        handleSeatDelta(response);
+        return;
+    }
+    
+    if (startsWith(response, CinemaProtocol::BATCH_RESULT_PREFIX)) {
+        handleBatchResult(response);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(responseMutex_);
+        lastResponse_ = response;
+    }
+    
+    if (startsWith(response, CinemaProtocol::SUBSCRIBED_PREFIX)) {
+        handleSubscribed(response);
+    }
     
-    if (response.find("SUCCESS:") != std::string::npos || response.find("ERROR:") != std::string::npos) {
+    if (response.find("SUCCESS:") != std::string_view::npos || response.find("ERROR:") != std::string_view::npos) {
         {
             std::lock_guard<std::mutex> lock(responseMutex_);
             lastBookingResponse_ = response;
@@ -157,7 +658,7 @@ void CinemaClient::processMessage(const std::string& response) {
     if (isCinemaDataStream(response)) {
         parseAndUpdateShows(response);
         
-        if (response.find(CinemaProtocol::BOOKING_UPDATE) != std::string::npos) {
+        if (response.find(CinemaProtocol::BOOKING_UPDATE_PREFIX) != std::string_view::npos) {
             handleBookingUpdate(response);
         }
         return;
@@ -166,12 +667,322 @@ void CinemaClient::processMessage(const std::string& response) {
     handleServerMessage(response);
 }
 
-bool CinemaClient::isCinemaDataStream(const std::string& response) const {
-    return response.find(CinemaProtocol::CINEMA_DATA_STREAM) != std::string::npos ||
-           response.find(CinemaProtocol::UPDATED_CINEMA_DATA) != std::string::npos;
+void CinemaClient::handleSubscribed(std::string_view response) {
+    bool filtered = response != CinemaProtocol::SUBSCRIBED_ALL;
+    {
+        std::lock_guard<std::mutex> lock(showsMutex_);
+        if (filtered == filtered_) {
+            return;
+        }
+        filtered_ = filtered;
+        if (filtered) {
+            releaseHeldBack();
+            return;
+        }
+    }
+    sendMessage("get_data");
+}
+
+void CinemaClient::handleBatchResult(std::string_view response) {
+    std::vector<std::pair<uint64_t, std::string_view>> results;
+    std::string_view line;
+    nextLine(response, line);
+    while (nextLine(response, line)) {
+        size_t colon = line.find(':');
+        uint64_t id = 0;
+        if (colon == 0 || colon == std::string_view::npos || !parseNumber(line.substr(0, colon), id)) {
+            continue;
+        }
+        results.emplace_back(id, line.substr(colon + 1));
+    }
+    
+    // Callbacks run outside the lock so they may send further batches
+    std::vector<std::pair<BookingReplyCallback, size_t>> answered;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto it = pendingBookings_.find(results[i].first);
+            if (it != pendingBookings_.end()) {
+                answered.emplace_back(std::move(it->second), i);
+                pendingBookings_.erase(it);
+            }
+        }
+    }
+    for (auto& [callback, index] : answered) {
+        if (callback) {
+            callback(results[index].first, std::string(results[index].second));
+        }
+    }
+}
+
+void CinemaClient::failPendingBookings(const std::string& status) {
+    std::unordered_map<uint64_t, BookingReplyCallback> failed;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        failed.swap(pendingBookings_);
+    }
+    for (auto& [id, callback] : failed) {
+        if (callback) {
+            callback(id, status);
+        }
+    }
+}
+
+bool CinemaClient::isCinemaDataStream(std::string_view response) const {
+    return response.find(CinemaProtocol::CINEMA_DATA_HEADER) != std::string_view::npos ||
+           response.find(CinemaProtocol::UPDATE_DATA_HEADER) != std::string_view::npos;
+}
+
+bool CinemaClient::isSeatDelta(std::string_view response) const {
+    return startsWith(response, CinemaProtocol::SEAT_DELTA_PREFIX) ||
+           startsWith(response, CinemaProtocol::SEAT_HELD_PREFIX) ||
+           startsWith(response, CinemaProtocol::SEAT_FREED_PREFIX);
+}
+
+void CinemaClient::handleSeatDelta(std::string_view response) {
+    bool needsResync = false;
+    std::vector<SeatUpdate> updates;
+    
+    std::string_view line;
+    while (nextLine(response, line)) {
+        // Held seats are shown taken like booked ones
+        size_t prefixLen = 0;
+        bool freed = startsWith(line, CinemaProtocol::SEAT_FREED_PREFIX);
+        if (freed) {
+            prefixLen = CinemaProtocol::SEAT_FREED_PREFIX.size();
+        } else if (startsWith(line, CinemaProtocol::SEAT_DELTA_PREFIX)) {
+            prefixLen = CinemaProtocol::SEAT_DELTA_PREFIX.size();
+        } else if (startsWith(line, CinemaProtocol::SEAT_HELD_PREFIX)) {
+            prefixLen = CinemaProtocol::SEAT_HELD_PREFIX.size();
+        } else {
+            continue;
+        }
+        
+        size_t seqEnd = line.find(':', prefixLen);
+        size_t idEnd = seqEnd == std::string_view::npos ? std::string_view::npos : line.find(':', seqEnd + 1);
+        SeatUpdate update;
+        update.freed = freed;
+        if (idEnd == std::string_view::npos ||
+            !parseNumber(line.substr(prefixLen, seqEnd - prefixLen), update.sequence) ||
+            !parseNumber(line.substr(seqEnd + 1, idEnd - seqEnd - 1), update.showId)) {
+            needsResync = true;
+            continue;
+        }
+        
+        forEachSeat(line.substr(idEnd + 1), [&update](unsigned seat) {
+            if (seat <= UINT16_MAX) {
+                update.seats.push_back(static_cast<SeatNumber>(seat));
+            }
+        });
+        updates.push_back(std::move(update));
+    }
+    
+    applyDeltas(updates, needsResync);
+}
+
+void CinemaClient::applyDeltas(std::vector<SeatUpdate>& updates, bool needsResync) {
+    bool waiting = false;
+    {
+        std::lock_guard<std::mutex> lock(showsMutex_);
+        SnapshotEdit edit(*snapshot_.load());
+        auto apply = [this, &edit, &needsResync](const SeatUpdate& update) {
+            Shows* show = edit.edit(update.showId);
+            if (!show) {
+                needsResync = true;
+            } else {
+                for (SeatNumber seat : update.seats) {
+                    if (update.freed) {
+                        show->markSeatAvailable(seat);
+                    } else {
+                        show->markSeatBooked(seat);
+                    }
+                }
+            }
+            lastSequence_ = std::max(lastSequence_, update.sequence);
+        };
+        
+        for (SeatUpdate& update : updates) {
+            if (!filtered_ && update.sequence > lastSequence_ + 1) {
+                heldBack_.emplace(update.sequence, std::move(update));
+                continue;
+            }
+            // The snapshot already reflects older updates; a stale SEAT_FREED
+            // would free a seat booked since
+            if (!filtered_ && update.sequence <= lastSequence_) {
+                continue;
+            }
+            apply(update);
+            // Deltas that were waiting for this one follow it in order
+            while (!heldBack_.empty() && heldBack_.begin()->first <= lastSequence_ + 1) {
+                if (heldBack_.begin()->first > lastSequence_) {
+                    apply(heldBack_.begin()->second);
+                }
+                heldBack_.erase(heldBack_.begin());
+            }
+        }
+        
+        if (heldBack_.size() > MAX_HELD_BACK) {
+            heldBack_.clear();
+            needsResync = true;
+        }
+        waiting = !heldBack_.empty();
+        if (auto next = edit.finish()) {
+            snapshot_.store(std::move(next));
+        }
+    }
+    
+    if (needsResync) {
+        sendMessage("get_data");
+    } else if (waiting) {
+        armGapTimer();
+    }
+}
+
+void CinemaClient::releaseHeldBack() {
+    // Deltas the catalogue already reflects are dropped, not re-applied
+    while (!heldBack_.empty() && heldBack_.begin()->first <= lastSequence_) {
+        heldBack_.erase(heldBack_.begin());
+    }
+    if (heldBack_.empty() || (!filtered_ && heldBack_.begin()->first > lastSequence_ + 1)) {
+        return;
+    }
+    SnapshotEdit edit(*snapshot_.load());
+    while (!heldBack_.empty() && (filtered_ || heldBack_.begin()->first <= lastSequence_ + 1)) {
+        const SeatUpdate& update = heldBack_.begin()->second;
+        if (Shows* show = edit.edit(update.showId)) {
+            for (SeatNumber seat : update.seats) {
+                if (update.freed) {
+                    show->markSeatAvailable(seat);
+                } else {
+                    show->markSeatBooked(seat);
+                }
+            }
+        }
+        lastSequence_ = update.sequence;
+        heldBack_.erase(heldBack_.begin());
+    }
+    if (auto next = edit.finish()) {
+        snapshot_.store(std::move(next));
+    }
+}
+
+void CinemaClient::armGapTimer() {
+    if (gapTimerArmed_) {
+        return;
+    }
+    uint64_t missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(showsMutex_);
+        missing = lastSequence_ + 1;
+    }
+    gapTimerArmed_ = true;
+    gapTimer_.expires_after(GAP_TIMEOUT);
+    gapTimer_.async_wait([this, missing](beast::error_code ec) {
+        gapTimerArmed_ = false;
+        if (ec) {
+            notifyIfIdle();
+            return;
+        }
+        bool lost = false;
+        bool waiting = false;
+        {
+            std::lock_guard<std::mutex> lock(showsMutex_);
+            lost = lastSequence_ < missing && !heldBack_.empty();
+            if (lost) {
+                heldBack_.clear();
+            }
+            waiting = !heldBack_.empty();
+        }
+        if (lost) {
+            sendMessage("get_data");
+        } else if (waiting) {
+            // The gap closed but a later one is open
+            armGapTimer();
+        }
+    });
 }
 
-void CinemaClient::handleBookingUpdate(const std::string& response) {
+void CinemaClient::processBinaryMessage(std::string_view frame) {
+    FrameReader header{frame};
+    std::string_view prefix = header.bytes(BinaryProtocol::HEADER_SIZE);
+    if (!header.ok ||
+        static_cast<uint8_t>(prefix[0]) != BinaryProtocol::MAGIC ||
+        static_cast<uint8_t>(prefix[1]) != BinaryProtocol::VERSION) {
+        std::cerr << "Ignoring unsupported binary frame" << std::endl;
+        return;
+    }
+    
+    uint8_t type = static_cast<uint8_t>(prefix[2]);
+    std::string_view body = frame.substr(BinaryProtocol::HEADER_SIZE);
+    bool needsResync = false;
+    
+    if (type == BinaryProtocol::CATALOGUE) {
+        std::lock_guard<std::mutex> lock(showsMutex_);
+        ShowsSnapshotPtr base = snapshot_.load();
+        CatalogueBuilder catalogue(*base);
+        
+        FrameReader reader{body};
+        uint64_t sequence = reader.u64();
+        uint32_t theaterCount = reader.u32();
+        for (uint32_t t = 0; t < theaterCount && reader.ok; ++t) {
+            std::string_view theater = reader.str();
+            uint32_t showCount = reader.u32();
+            for (uint32_t i = 0; i < showCount && reader.ok; ++i) {
+                uint32_t showId = reader.u32();
+                std::string_view movie = reader.str();
+                std::string_view dateTime = reader.str();
+                uint16_t seatCount = reader.u16();
+                std::string_view bits = reader.bytes((seatCount + 7) / 8);
+                if (!reader.ok) {
+                    break;
+                }
+                
+                seatScratch_.assign(seatCount, false);
+                for (size_t seat = 0; seat < seatCount; ++seat) {
+                    seatScratch_[seat] = (static_cast<uint8_t>(bits[seat / 8]) >> (seat % 8)) & 1;
+                }
+                catalogue.add(showId, true, theater, movie, dateTime, seatScratch_);
+            }
+        }
+        if (!reader.ok) {
+            std::cerr << "Ignoring malformed binary catalogue" << std::endl;
+            return;
+        }
+        
+        lastSequence_ = sequence;
+        if (auto next = catalogue.finish()) {
+            snapshot_.store(std::move(next));
+        }
+        releaseHeldBack();
+    } else if (type == BinaryProtocol::SEAT_DELTA || type == BinaryProtocol::SEAT_FREED) {
+        std::vector<SeatUpdate> updates;
+        FrameReader reader{body};
+        while (reader.ok && reader.pos < body.size()) {
+            SeatUpdate update;
+            update.freed = type == BinaryProtocol::SEAT_FREED;
+            update.sequence = reader.u64();
+            update.showId = reader.u32();
+            uint16_t count = reader.u16();
+            if (!reader.need(2 * static_cast<size_t>(count))) {
+                needsResync = true;
+                break;
+            }
+            update.seats.reserve(count);
+            for (uint16_t i = 0; i < count; ++i) {
+                update.seats.push_back(reader.u16());
+            }
+            updates.push_back(std::move(update));
+        }
+        applyDeltas(updates, needsResync);
+        return;
+    }
+    
+    if (needsResync) {
+        sendMessage("get_data");
+    }
+}
+
+void CinemaClient::handleBookingUpdate(std::string_view response) {
      {
         std::lock_guard<std::mutex> lock(responseMutex_);
         lastResponse_ = response;
@@ -180,80 +991,101 @@ void CinemaClient::handleBookingUpdate(const std::string& response) {
     
 }
 
-void CinemaClient::handleServerMessage(const std::string& response) {
+void CinemaClient::handleServerMessage(std::string_view response) {
     std::cout << "\nServer Update:\n" << response << std::endl;
 }
 
-void CinemaClient::parseAndUpdateShows(const std::string& response) {
+void CinemaClient::parseAndUpdateShows(std::string_view response) {
     std::lock_guard<std::mutex> lock(showsMutex_);
-    shows_.clear(); 
-    
-
+    ShowsSnapshotPtr base = snapshot_.load();
+    CatalogueBuilder catalogue(*base);
     
-    std::stringstream ss(response);
-    std::string line;
-    std::string currentTheater;
-    Shows* currentShow = nullptr; 
+    // The show being read; it is added once its seats line arrives, or
+    // with every seat free if the next show starts first
+    std::string_view currentTheater;
+    std::string_view movieName;
+    std::string_view dateTime;
+    uint32_t showId = 0;
+    bool hasId = false;
+    bool inShow = false;
+    auto addShow = [&]() {
+        if (inShow) {
+            catalogue.add(showId, hasId, currentTheater, movieName, dateTime, seatScratch_);
+            inShow = false;
+        }
+    };
     
-    while (std::getline(ss, line)) {
-        if (line.find(CinemaProtocol::THEATER_PREFIX) == 0) {
-            currentTheater = line.substr(CinemaProtocol::THEATER_PREFIX_LEN);
-            currentShow = nullptr; 
+    std::string_view line;
+    while (nextLine(response, line)) {
+        if (startsWith(line, CinemaProtocol::SEQUENCE_PREFIX)) {
+            parseNumber(line.substr(CinemaProtocol::SEQUENCE_PREFIX.size()), lastSequence_);
+        }
+        else if (startsWith(line, CinemaProtocol::THEATER_PREFIX)) {
+            addShow();
+            currentTheater = line.substr(CinemaProtocol::THEATER_PREFIX.size());
         }
-        else if (line.find(CinemaProtocol::MOVIE_PREFIX) == 0 && !currentTheater.empty()) {
-            std::string movieLine = line.substr(CinemaProtocol::MOVIE_PREFIX_LEN);
+        else if (startsWith(line, CinemaProtocol::MOVIE_PREFIX) && !currentTheater.empty()) {
+            addShow();
+            std::string_view movieLine = line.substr(CinemaProtocol::MOVIE_PREFIX.size());
             
             size_t datePos = movieLine.find(" (");
-            if (datePos != std::string::npos) {
-                std::string movieName = movieLine.substr(0, datePos);
-                
-                size_t startDate = movieLine.find("(") + 1;
-                size_t endDate = movieLine.find(")");
-                if (startDate < endDate) {
-                    std::string dateTime = movieLine.substr(startDate, endDate - startDate);
-                    
-                    shows_.emplace_back(movieName, dateTime, currentTheater);
-                    currentShow = &shows_.back(); 
-                }
+            size_t endDate = movieLine.find(')', datePos);
+            if (datePos != std::string_view::npos && endDate != std::string_view::npos) {
+                movieName = movieLine.substr(0, datePos);
+                dateTime = movieLine.substr(datePos + 2, endDate - datePos - 2);
+                hasId = false;
+                inShow = true;
+                seatScratch_.assign(Shows::DEFAULT_SEAT_COUNT, false);
             }
         }
-        else if (line.find("    Available seats:") != std::string::npos && currentShow != nullptr) {
-            std::string seatsLine = line.substr(line.find(":") + 1);
+        else if (startsWith(line, CinemaProtocol::SHOW_ID_PREFIX) && inShow) {
+            hasId = parseNumber(line.substr(CinemaProtocol::SHOW_ID_PREFIX.size()), showId);
+        }
+        else if (startsWith(line, CinemaProtocol::AVAILABLE_SEATS_PREFIX) && inShow) {
+            std::string_view seatsLine = line.substr(CinemaProtocol::AVAILABLE_SEATS_PREFIX.size());
             
-            size_t totalPos = seatsLine.find("(Total:");
-            if (totalPos != std::string::npos) {
+            // "(Total: free/capacity)" carries the auditorium size
+            size_t seatCount = Shows::DEFAULT_SEAT_COUNT;
+            size_t totalPos = seatsLine.find(CinemaProtocol::TOTAL_PREFIX);
+            if (totalPos != std::string_view::npos) {
+                size_t slashPos = seatsLine.find('/', totalPos);
+                if (slashPos != std::string_view::npos) {
+                    parseNumber(seatsLine.substr(slashPos + 1), seatCount);
+                }
                 seatsLine = seatsLine.substr(0, totalPos);
             }
             
-            std::vector<bool> seatStatus(20, true);
-            
-            std::stringstream seatStream(seatsLine);
-            std::string token;
-            
-            std::vector<int> parsedSeats; 
-            
-            while (seatStream >> token) {
-                if (!token.empty() && token.back() == ',') {
-                    token.pop_back();
+            seatScratch_.assign(seatCount, true);
+            forEachSeat(seatsLine, [&](unsigned seat) {
+                if (seat >= 1 && seat <= seatCount) {
+                    seatScratch_[seat - 1] = false;
                 }
-                
-                try {
-                    int seatNum = std::stoi(token);
-                    if (seatNum >= 1 && seatNum <= 20) {
-                        seatStatus[seatNum - 1] = false; 
-                        parsedSeats.push_back(seatNum); 
-                    }
-                } catch (const std::exception&) {
-                    continue;
-                }
-            }
-            
-            currentShow->updateSeatAvailability(seatStatus);
+            });
+            addShow();
         }
     }
+    addShow();
+    
+    if (auto next = catalogue.finish()) {
+        snapshot_.store(std::move(next));
+    }
+    releaseHeldBack();
+}
+
+ShowsSnapshotPtr CinemaClient::snapshot() const {
+    return snapshot_.load();
 }
 
 std::vector<Shows> CinemaClient::getShows() const {
-    std::lock_guard<std::mutex> lock(showsMutex_);
-    return shows_;
-}
\ No newline at end of file
+    ShowsSnapshotPtr current = snapshot();
+    std::vector<Shows> shows;
+    shows.reserve(current->shows.size());
+    for (const auto& show : current->shows) {
+        shows.push_back(*show);
+    }
+    return shows;
+}
+
+std::unordered_map<uint32_t, size_t> CinemaClient::getShowIndexById() const {
+    return *snapshot()->indexById;
+}
@@ -11,14 +11,25 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <string>
+#include <chrono>
+#include <map>
 #include <mutex>
 #include <functional>
 #include <vector>
 #include <atomic>
 #include <thread>
 #include <memory>
+#include <unordered_map>
+#include <string_view>
+#include <deque>
+#include <optional>
 #include "cinema_Client.hpp"
+#include "cinema_protocol.hpp"
 
 namespace beast = boost::beast;
 namespace websocket = beast::websocket;
@@ -26,21 +37,29 @@ namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
 /**
- * @namespace CinemaProtocol
- * @brief Protocol constants for Cinema server communication
+ * @struct ShowsSnapshot
+ * @brief Immutable view of the cached Shows at one point in time
  * 
- * Defines the string patterns and prefixes used in the Cinema booking
- * protocol for parsing server responses and identifying message types.
+ * Published whole by the client and never modified afterwards, so readers
+ * use it without locks for as long as they hold the pointer. Shows that
+ * an update left unchanged are shared with the previous snapshot.
  */
-namespace CinemaProtocol {
-    constexpr const char* THEATER_PREFIX = "Theater: ";           ///< Prefix for theater lines
-    constexpr const char* MOVIE_PREFIX = "  Movie: ";            ///< Prefix for movie lines  
-    constexpr const char* CINEMA_DATA_STREAM = "=== CINEMA DATA STREAM ===";     ///< Cinema data header
-    constexpr const char* UPDATED_CINEMA_DATA = "=== UPDATED CINEMA DATA ===";  ///< Update data header
-    constexpr const char* BOOKING_UPDATE = "BOOKING_UPDATE:";    ///< Booking update prefix
-    constexpr size_t THEATER_PREFIX_LEN = 9;                     ///< Length of theater prefix
-    constexpr size_t MOVIE_PREFIX_LEN = 9;                       ///< Length of movie prefix
-}
+struct ShowsSnapshot {
+    std::vector<std::shared_ptr<const Shows>> shows;   ///< Shows in catalogue order
+    std::shared_ptr<const std::unordered_map<uint32_t, size_t>> indexById; ///< Server show id -> index in shows, never null
+    
+    /**
+     * @brief Look up a show by server id
+     * @param showId Show id as sent by the server
+     * @return The show, or nullptr if this snapshot has no such id
+     */
+    const Shows* find(uint32_t showId) const;
+};
+
+/**
+ * @brief Shared pointer to a published ShowsSnapshot
+ */
+using ShowsSnapshotPtr = std::shared_ptr<const ShowsSnapshot>;
 
 /**
  * @class CinemaClient
@@ -52,61 +71,142 @@ namespace CinemaProtocol {
  * 
  * @par Thread Safety
  * This class is thread-safe. All public methods can be called from multiple threads.
- * Internal message processing runs on a separate background thread.
+ * Messages are processed on the thread running the client's io_context.
+ * 
+ * @par I/O Model
+ * All socket operations are asynchronous and serialized on a strand. Reads
+ * are re-armed after every message and writes go through an outbound
+ * queue, so sendMessage() never blocks. The default constructor owns an
+ * io_context and runs it on one thread started by the first connect; the
+ * other constructor shares the caller's io_context, so any number of
+ * clients can be multiplexed on one thread pool.
  * 
  * @par Connection Lifecycle
  * 1. Create CinemaClient instance
- * 2. Call connect() to establish WebSocket connection
+ * 2. Call connect() or connectAsync() to establish the WebSocket connection
  * 3. Send messages via sendMessage()
- * 4. Receive responses via getLastResponse()/getLastBookingResponse()
- * 5. Get synchronized Shows data via getShows()
- * 6. Call disconnect() or destructor handles cleanup
+ * 4. Receive responses via getLastResponse()/getLastBookingResponse() or
+ *    setMessageCallback()
+ * 5. Get synchronized Shows data via snapshot() or getShows()
+ * 6. Call disconnect() or disconnectAsync(); the destructor disconnects
  * 
  * @par Protocol Support
  * - Cinema data streams (theater/movie listings)
  * - Booking requests and responses  
  * - Real-time booking updates
+ * - SEAT_DELTA messages applied to the cached Shows in sequence order.
+ *   Deltas from different server threads may arrive out of order, so one
+ *   that skips a sequence number is held back until the missing ones
+ *   arrive; only a gap still open after GAP_TIMEOUT triggers a full
+ *   resync (get_data). After a subscription to some shows the sequence
+ *   skips the bookings of the others, so deltas are applied as they come
+ * - Optional binary data frames (see useBinaryProtocol())
  * - Automatic Shows data synchronization
+ * - Batch booking requests (see sendBatch()), pipelined and matched to their
+ *   results by request id
+ * 
+ * @par Shows Cache
+ * Messages are parsed straight from the receive buffer through string
+ * views. Each update is matched to the cached shows by server show id;
+ * unchanged shows are kept as they are and only changed ones are copied,
+ * then the result is published as a new ShowsSnapshot (read-copy-update).
+ * Readers load the current snapshot with one atomic operation and never
+ * block message processing.
  */
 class CinemaClient {
 public:
+    /**
+     * @brief Receives the result of one booking sent with sendBatch()
+     * @param id Request id returned by sendBatch()
+     * @param status SUCCESS: or ERROR: line the server answered with
+     */
+    using BookingReplyCallback = std::function<void(uint64_t id, const std::string& status)>;
+    
+    /**
+     * @brief Receives the outcome of connectAsync()
+     * @param connected true if the handshake completed
+     */
+    using ConnectCallback = std::function<void(bool connected)>;
+    
+    /**
+     * @brief Receives the outcome of one queued message
+     * @param sent true once the message was written to the socket, false
+     *        if the connection closed first
+     */
+    using SendCallback = std::function<void(bool sent)>;
+    
+    /**
+     * @brief Receives every text message that is not a seat delta
+     * @param message Message as received, after the cached state is updated;
+     *        only valid during the call
+     */
+    using MessageCallback = std::function<void(std::string_view message)>;
+    
     /**
      * @brief Constructor
      * @post Client is created but not connected
-     * @post Background thread is not started
+     * @post Its own io_context is created; its thread is not started until
+     *       the first connect
      */
     CinemaClient();
     
+    /**
+     * @brief Constructor for a client sharing an io_context
+     * @param ioc I/O context run by the caller's threads, must outlive this
+     * @post Client is created but not connected; no thread is started
+     */
+    explicit CinemaClient(net::io_context& ioc);
+    
     /**
      * @brief Destructor
-     * @post Stops message listener thread
-     * @post Disconnects from server if connected
-     * @post All resources are cleaned up
+     * @post Disconnects from server if connected and waits for pending
+     *       operations, so no handler refers to this client afterwards
+     * @post The owned io_context thread, if any, is joined
      */
     ~CinemaClient();
     
     /**
-     * @brief Connect to Cinema server
+     * @brief Connect to Cinema server and wait for the handshake
      * @param host Server hostname or IP address
      * @param port Server port number  
      * @return true if connection successful, false otherwise
      * @pre host and port must not be empty
-     * @post On success: connected_ is true, message listener started
+     * @post On success: connected_ is true and messages are being read
      * @post On failure: connected_ remains false
      * @note Thread-safe operation
+     * @note Must not be called from a thread running a shared io_context;
+     *       use connectAsync() there
      */
     bool connect(const std::string& host, const std::string& port);
     
     /**
-     * @brief Disconnect from server
+     * @brief Start connecting to Cinema server
+     * @param host Server hostname or IP address
+     * @param port Server port number
+     * @param onConnected Called on the client's strand with the outcome
+     * @note Returns at once; resolve, connect and handshake run
+     *       asynchronously
+     */
+    void connectAsync(const std::string& host, const std::string& port, ConnectCallback onConnected = {});
+    
+    /**
+     * @brief Disconnect from server and wait until the connection is closed
      * @post connected_ is false
-     * @post Message listener thread is stopped
-     * @post WebSocket connection is closed gracefully
+     * @post WebSocket connection is closed gracefully, queued messages
+     *       that were not written are reported unsent
      * @note Thread-safe operation
      * @note Safe to call multiple times
+     * @note Called from the client's own callbacks it only starts the
+     *       close, like disconnectAsync()
      */
     void disconnect();
     
+    /**
+     * @brief Start closing the connection
+     * @param onClosed Called on the client's strand once nothing is pending
+     */
+    void disconnectAsync(std::function<void()> onClosed = {});
+    
     /**
      * @brief Check connection status
      * @return true if connected to server, false otherwise
@@ -115,14 +215,67 @@ public:
     bool isConnected() const;
     
     /**
-     * @brief Send message to server
+     * @brief Choose between binary and text data streams
+     * @param enable true to request binary frames, false for text
+     * @post If connected: the matching hello is sent and the server replies
+     *       with a fresh catalogue in that format
+     * @post If not connected: the hello is sent by connect()
+     * @note Requests and booking replies stay text in both modes
+     */
+    void useBinaryProtocol(bool enable);
+    
+    /**
+     * @brief Enable or disable permessage-deflate
+     * @param enable true to offer compression in the handshake (default)
+     * @note Takes effect on the next connect()
+     */
+    void setCompression(bool enable);
+    
+    /**
+     * @brief Get number of message bytes received so far
+     * @return Sum of decompressed message sizes
+     * @note Thread-safe operation
+     */
+    uint64_t bytesReceived() const;
+    
+    /**
+     * @brief Queue a message for the server
      * @param message Message string to send
+     * @param onSent Called on the client's strand once the message is
+     *        written, or with false if it never will be
      * @pre Must be connected to server
-     * @post Message is sent via WebSocket
-     * @note Thread-safe operation
+     * @post Message is queued and written in order after earlier ones
+     * @note Thread-safe operation; never blocks on the socket
      * @note If not connected, error is logged and no action taken
      */
-    void sendMessage(const std::string& message);
+    void sendMessage(const std::string& message, SendCallback onSent = {});
+    
+    /**
+     * @brief Set the callback receiving server messages
+     * @param callback Called on the client's strand for every text message
+     *        other than seat deltas; empty to stop
+     * @note Set it before connecting
+     */
+    void setMessageCallback(MessageCallback callback);
+    
+    /**
+     * @brief Send bookings as one batch request without waiting for the result
+     * @param bookings Requests "theater,movie,seat1,...", at most
+     *        CinemaProtocol::MAX_BATCH_ITEMS
+     * @param callback Called once per booking on the listener thread with
+     *        its result, or with an ERROR: line if the connection is lost
+     * @return Request id of every booking in order, empty if nothing was sent
+     * @note Thread-safe operation; any number of batches may be in flight
+     *       and results are matched to their callbacks by id
+     */
+    std::vector<uint64_t> sendBatch(const std::vector<std::string>& bookings, BookingReplyCallback callback);
+    
+    /**
+     * @brief Get number of batch bookings still waiting for a result
+     * @return Bookings sent with sendBatch() and not answered yet
+     * @note Thread-safe operation
+     */
+    size_t pendingBookings() const;
     
     /**
      * @brief Get last server response
@@ -143,57 +296,177 @@ public:
     /**
      * @brief Parse server response and update Shows data
      * @param response Server response string to parse
-     * @post Shows data is updated with parsed information
+     * @post A new snapshot is published if any show was added, removed or
+     *       changed; shows that match the cache are not touched
      * @note Thread-safe operation
      * @note Automatically called by message listener
      */
-    void parseAndUpdateShows(const std::string& response);
+    void parseAndUpdateShows(std::string_view response);
+    
+    /**
+     * @brief Get the current Shows snapshot
+     * @return Immutable snapshot, never null
+     * @note Thread-safe and lock-free; later updates publish new snapshots
+     *       and leave this one unchanged
+     */
+    ShowsSnapshotPtr snapshot() const;
     
     /**
      * @brief Get current Shows data
-     * @return Copy of current Shows vector
+     * @return Copy of the Shows in the current snapshot
      * @note Thread-safe operation
-     * @note Returns snapshot of current data
-     * @note Data is automatically synchronized with server
+     * @note Copies every show; prefer snapshot() where a copy is not needed
      */
     std::vector<Shows> getShows() const;
+    
+    /**
+     * @brief Get the server show ids of the cached Shows
+     * @return Map from server show id to index in getShows()
+     * @note Thread-safe operation
+     * @note Show ids appear in SEAT_DELTA messages
+     */
+    std::unordered_map<uint32_t, size_t> getShowIndexById() const;
 
 private:
-    net::io_context ioc_;                          ///< Boost.Asio I/O context
-    websocket::stream<tcp::socket> ws_;            ///< WebSocket stream
+    /**
+     * @struct Outbound
+     * @brief A queued message and who to tell once it is written
+     */
+    struct Outbound {
+        std::string message;   ///< Text to send
+        SendCallback onSent;   ///< Completion callback, may be empty
+    };
+    
+    /**
+     * @struct SeatUpdate
+     * @brief One decoded seat delta record
+     */
+    struct SeatUpdate {
+        uint64_t sequence = 0;          ///< State version the change produced
+        uint32_t showId = 0;            ///< Server show id
+        bool freed = false;             ///< Seats became available (SEAT_FREED)
+        std::vector<SeatNumber> seats;  ///< Changed seats
+    };
+    
+    static constexpr std::chrono::milliseconds GAP_TIMEOUT{250};  ///< How long a missing delta may be late
+    static constexpr size_t MAX_HELD_BACK = 4096;                 ///< Held back deltas before resyncing anyway
+    
+    std::unique_ptr<net::io_context> ownedIoc_;    ///< Context of the default constructor, null if shared
+    net::io_context& ioc_;                         ///< Boost.Asio I/O context
+    net::strand<net::io_context::executor_type> strand_;  ///< Serializes all socket operations
+    tcp::resolver resolver_;                       ///< Resolves the server address
+    std::optional<websocket::stream<tcp::socket>> ws_;    ///< WebSocket stream, recreated per connection
     std::atomic<bool> connected_{false};           ///< Connection status flag
+    std::atomic<bool> binaryProtocol_{false};      ///< Binary data frames requested
+    std::atomic<bool> compression_{true};          ///< Offer permessage-deflate
+    std::atomic<uint64_t> bytesReceived_{0};       ///< Message bytes received
+
+    std::optional<net::executor_work_guard<net::io_context::executor_type>> work_;  ///< Keeps the owned context running
+    std::unique_ptr<std::thread> ioThread_;        ///< Runs the owned io_context
+    std::once_flag ioThreadStarted_;               ///< Starts ioThread_ once
 
-    std::unique_ptr<std::thread> listenerThread_;  ///< Background message listener thread
-    std::atomic<bool> shouldStop_{false};          ///< Thread stop flag
+    // Strand only
+    beast::flat_buffer buffer_;                     ///< Receive buffer; binary frames are decoded in place
+    std::deque<Outbound> outbox_;                   ///< Messages waiting to be written, front in flight
+    std::vector<std::function<void()>> closeWaiters_; ///< disconnectAsync() callbacks
+    MessageCallback onMessage_;                     ///< User message callback
+    bool connecting_ = false;                       ///< Resolve, connect or handshake pending
+    bool reading_ = false;                          ///< A read is pending
+    bool writing_ = false;                          ///< A write is pending
+    bool gapTimerArmed_ = false;                    ///< gapTimer_ wait is pending
+    net::steady_timer gapTimer_;                    ///< Resyncs when a missing delta stays missing
+    bool closing_ = false;                          ///< disconnect requested
 
     std::string lastResponse_;                      ///< Last server response
     std::string lastBookingResponse_;               ///< Last booking response
     mutable std::mutex responseMutex_;              ///< Protects response data
 
-    std::vector<Shows> shows_;                      ///< Cached Shows data
-    mutable std::mutex showsMutex_;                 ///< Protects Shows data
+    std::atomic<ShowsSnapshotPtr> snapshot_;        ///< Published Shows, replaced whole on every change
+    uint64_t lastSequence_{0};                      ///< State version snapshot_ is complete up to
+    std::map<uint64_t, SeatUpdate> heldBack_;       ///< Deltas past a missing sequence, by sequence
+    bool filtered_ = false;                         ///< Subscribed to some shows only; gaps are expected
+    std::vector<bool> seatScratch_;                 ///< Seat status being parsed, reused between messages
+    std::mutex showsMutex_;                         ///< Serializes updates of the fields above
+
+
+    std::atomic<uint64_t> nextRequestId_{1};        ///< Id of the next batch booking
+    std::unordered_map<uint64_t, BookingReplyCallback> pendingBookings_; ///< Batch bookings awaiting a result
+    mutable std::mutex pendingMutex_;               ///< Protects pendingBookings_
 
     /**
-     * @brief Start background message listener thread
-     * @post Background thread is running and processing messages
-     * @note Called automatically by connect()
+     * @brief Start the thread running the owned io_context
+     * @note Does nothing for a shared io_context or after the first call
+     */
+    void startIoThread();
+    
+    /**
+     * @brief Give up a connection attempt
+     * @param ec Why it failed
+     * @param onConnected Told about the failure
+     */
+    void connectFailed(beast::error_code ec, const std::string& host, const std::string& port,
+                       const ConnectCallback& onConnected);
+    
+    /**
+     * @brief Read the next message; completes in onRead()
+     */
+    void doRead();
+    
+    /**
+     * @brief Handle one received message and read the next
+     * @param ec Read result; any error ends the connection
+     * @param bytes Message size
+     */
+    void onRead(beast::error_code ec, std::size_t bytes);
+    
+    /**
+     * @brief Queue a message; runs on the strand
+     * @param message Text to send
+     */
+    void enqueue(Outbound message);
+    
+    /**
+     * @brief Write the front of the outbound queue
+     */
+    void doWrite();
+    
+    /**
+     * @brief Send the close frame; the pending read then completes
+     */
+    void startClose();
+    
+    /**
+     * @brief Clean up after the read loop ended
+     * @param status Status given to batch bookings still waiting
+     */
+    void finishConnection(const std::string& status);
+    
+    /**
+     * @brief Report queued messages unsent, except the one being written
      */
-    void startMessageListener();
+    void failOutbox();
     
     /**
-     * @brief Stop background message listener thread
-     * @post Background thread is stopped and joined
-     * @note Called automatically by disconnect() and destructor
+     * @brief Run the disconnect callbacks once no operation is pending
      */
-    void stopMessageListener();
+    void notifyIfIdle();
     
     /**
      * @brief Process incoming server message
      * @param response Server message to process
      * @post Appropriate handler is called based on message type
-     * @note Called by background message listener thread
+     * @note Called on the strand for every text message
+     */
+    void processMessage(std::string_view response);
+    
+    /**
+     * @brief Track whether the session now gets deltas for some shows only
+     * @param response "SUBSCRIBED: all shows" or "SUBSCRIBED: n show(s)"
+     * @post Narrowing: held back deltas are applied, later gaps are ignored
+     * @post Back to all shows: full data is re-requested, since the shows
+     *       not watched meanwhile are stale
      */
-    void processMessage(const std::string& response);
+    void handleSubscribed(std::string_view response);
     
     /**
      * @brief Check if response contains cinema data
@@ -201,7 +474,81 @@ private:
      * @return true if response contains cinema data stream
      * @note Used to identify parseable cinema data
      */
-    bool isCinemaDataStream(const std::string& response) const;
+    bool isCinemaDataStream(std::string_view response) const;
+    
+    /**
+     * @brief Check if response is a seat delta message
+     * @param response Server response to check
+     * @return true if response starts with SEAT_DELTA:, SEAT_HELD: or
+     *         SEAT_FREED:
+     */
+    bool isSeatDelta(std::string_view response) const;
+    
+    /**
+     * @brief Decode a binary frame and apply it to the cached Shows
+     * @param frame Frame bytes, viewed directly in the receive buffer
+     * @post Catalogue frames replace the cached state, keeping the Shows
+     *       whose names and seats are unchanged
+     * @post Delta frames mark seats booked and SEAT_FREED frames mark them
+     *       available, in sequence order as for handleSeatDelta()
+     * @note Malformed frames are dropped and a resync is requested
+     */
+    void processBinaryMessage(std::string_view frame);
+    
+    /**
+     * @brief Apply decoded deltas to the cached Shows in sequence order
+     * @param updates Deltas of one message; moved from
+     * @param needsResync Whether decoding already found a malformed record
+     * @post Deltas up to the first missing sequence are applied, later ones
+     *       are held back and the gap timer is armed; every delta is
+     *       applied when filtered_
+     * @post On an unknown show id or too many held back deltas: full data
+     *       is re-requested
+     */
+    void applyDeltas(std::vector<SeatUpdate>& updates, bool needsResync);
+    
+    /**
+     * @brief Apply held back deltas that no longer follow a gap, or all of
+     *        them when filtered_
+     * @note Caller holds showsMutex_; used after a catalogue replaced the
+     *       cached Shows
+     */
+    void releaseHeldBack();
+    
+    /**
+     * @brief Resync if the sequence missing now is still missing after GAP_TIMEOUT
+     * @note Runs on the strand; does nothing while a wait is pending
+     */
+    void armGapTimer();
+    
+    /**
+     * @brief Apply seat delta messages to the cached Shows
+     * @param response One or more "SEAT_DELTA:<seq>:<showId>:<seats>" lines,
+     *        or the same with SEAT_HELD: or SEAT_FREED:
+     * @post Listed seats are marked booked (held seats count as booked);
+     *       SEAT_FREED seats are marked available. Only the shows named are
+     *       copied into the new snapshot
+     * @post On an unknown show id, or a sequence still missing after
+     *       GAP_TIMEOUT: full data is re-requested
+     * @note Unless filtered, deltas at or below the last applied sequence
+     *       are dropped: re-applying a SEAT_FREED would free a seat booked
+     *       since
+     */
+    void handleSeatDelta(std::string_view response);
+    
+    /**
+     * @brief Hand batch results to the callbacks waiting for them
+     * @param response "BATCH_RESULT:<count>" followed by "<id>:<status>" lines
+     * @post Answered ids are no longer pending; unknown ids are ignored
+     */
+    void handleBatchResult(std::string_view response);
+    
+    /**
+     * @brief Answer every pending batch booking with an error
+     * @param status Status passed to the callbacks
+     * @post No bookings are pending
+     */
+    void failPendingBookings(const std::string& status);
     
     /**
      * @brief Handle booking update messages
@@ -209,7 +556,7 @@ private:
      * @post Response is stored and Shows data updated
      * @note Handles real-time booking notifications
      */
-    void handleBookingUpdate(const std::string& response);
+    void handleBookingUpdate(std::string_view response);
     
     /**
      * @brief Handle general server messages
@@ -217,5 +564,5 @@ private:
      * @post Message is displayed to user
      * @note Handles non-data server communications
      */
-    void handleServerMessage(const std::string& response);
+    void handleServerMessage(std::string_view response);
 };
\ No newline at end of file
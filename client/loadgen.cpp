@@ -0,0 +1,603 @@
+/**
+ * @file loadgen.cpp
+ * @brief WebSocket load generator for the Cinema server
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ *
+ * @brief Drives the Cinema server with many concurrent simulated clients
+ *
+ * Opens a configurable number of WebSocket connections from one process,
+ * all multiplexed on a shared io_context, and replays a mix of get_data
+ * and booking requests against the server.
+ *
+ * @par Workload
+ * - Each connection is closed-loop: it waits for the reply to its request,
+ *   optionally sleeps for the think time, then sends the next one
+ * - --get-data is the fraction of requests that are get_data, the rest
+ *   are single-seat bookings
+ * - --hot is the fraction of bookings aimed at the --hot-seats first seats
+ *   of the first show, to create contention on the same seats
+ * - The catalogue (theaters, movies, seat counts, show ids) is read from
+ *   the server once at startup with CinemaClient's parser
+ *
+ * @par Report
+ * - p50/p99/p999 latency of get_data and booking replies
+ * - Booking attempts and successful bookings per second
+ * - Broadcast fan-out delay: time from the first request for a seat to
+ *   the SEAT_DELTA for that seat arriving at each connection
+ *
+ * @par Usage
+ * cinema_loadgen --host localhost --port 8080 --connections 10000
+ *                --threads 4 --duration 30 --get-data 0.8 --hot 0.2
+ *
+ * @note Tens of thousands of connections need a raised open file limit;
+ *       the soft limit is raised to the hard limit on startup
+ */
+
+#include "lib/websocket_client.hpp"
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free log-linear histogram of durations in microseconds
+ *
+ * Values below 32us get their own bucket; above that every power of two is
+ * split into 32 buckets, so percentiles are accurate to about 3%.
+ *
+ * @par Thread Safety
+ * record() may be called from any thread; percentile() is meant to be
+ * called once recording has stopped.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @brief Record one duration
+     * @param elapsed Duration to record
+     */
+    void record(Clock::duration elapsed) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        buckets_[bucketFor(static_cast<uint64_t>(std::max<int64_t>(0, us)))].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get number of recorded values
+     * @return Values recorded so far
+     */
+    uint64_t count() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get a percentile in microseconds
+     * @param p Percentile in [0, 1]
+     * @return Lower bound of the bucket holding the percentile, 0 if empty
+     */
+    uint64_t percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(p * static_cast<double>(total) + 0.5));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKETS; ++b) {
+            seen += buckets_[b].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                return lowerBound(b);
+            }
+        }
+        return lowerBound(BUCKETS - 1);
+    }
+
+private:
+    static constexpr size_t SUB_BUCKETS = 32;
+    static constexpr size_t BUCKETS = SUB_BUCKETS * 40;
+
+    static size_t bucketFor(uint64_t us) {
+        if (us < SUB_BUCKETS) {
+            return static_cast<size_t>(us);
+        }
+        size_t shift = static_cast<size_t>(std::bit_width(us)) - 6;
+        size_t bucket = (shift + 1) * SUB_BUCKETS + static_cast<size_t>((us >> shift) - SUB_BUCKETS);
+        return std::min(bucket, BUCKETS - 1);
+    }
+
+    static uint64_t lowerBound(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        size_t shift = bucket / SUB_BUCKETS - 1;
+        return static_cast<uint64_t>(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+};
+
+/**
+ * @struct LoadGenOptions
+ * @brief Command line configuration of a load run
+ */
+struct LoadGenOptions {
+    std::string host = "localhost";     ///< Server host
+    std::string port = "8080";          ///< Server port
+    size_t connections = 1000;          ///< Simulated clients
+    size_t connectConcurrency = 256;    ///< Handshakes in flight at once
+    int threads = 0;                    ///< I/O threads (0: one per core)
+    double duration = 10.0;             ///< Seconds of load after the ramp-up
+    double getDataRatio = 0.8;          ///< Fraction of requests that are get_data
+    double hotRatio = 0.2;              ///< Fraction of bookings aimed at hot seats
+    size_t hotSeats = 4;                ///< Number of hot seats in the first show
+    int thinkMs = 0;                    ///< Pause between reply and next request
+};
+
+/**
+ * @struct CatalogueShow
+ * @brief Show as needed to build booking requests
+ */
+struct CatalogueShow {
+    std::string theater;    ///< Theater name
+    std::string movie;      ///< Movie title
+    uint32_t id;            ///< Server show id used in SEAT_DELTA
+    size_t seatCount;       ///< Auditorium size
+};
+
+/**
+ * @class LoadGenerator
+ * @brief Shared state and statistics of one load run
+ */
+class LoadGenerator {
+public:
+    LoadGenerator(net::io_context& ioc, const LoadGenOptions& options,
+                  tcp::resolver::results_type endpoints, std::vector<CatalogueShow> catalogue)
+        : ioc_(ioc), options_(options), endpoints_(std::move(endpoints)), catalogue_(std::move(catalogue)) {}
+
+    void startConnections();
+    void onConnectDone(bool ok, Clock::duration elapsed);
+
+    /**
+     * @brief Remember when a seat was first requested
+     * @param showId Server show id
+     * @param seat Seat number
+     */
+    void noteBookingSent(uint32_t showId, size_t seat) {
+        std::unique_lock lock(pendingMutex_);
+        pendingSeats_.try_emplace(seatKey(showId, seat), Clock::now());
+    }
+
+    /**
+     * @brief Record fan-out delay for every seat in a SEAT_DELTA message
+     * @param message One or more "SEAT_DELTA:<seq>:<showId>:<seats>" lines
+     */
+    void recordDeltas(const std::string& message);
+
+    const LoadGenOptions& options() const { return options_; }
+    const std::vector<CatalogueShow>& catalogue() const { return catalogue_; }
+    bool stopping() const { return stopping_.load(std::memory_order_relaxed); }
+    void stop() { stopping_ = true; }
+
+    LatencyHistogram connectLatency;    ///< TCP connect + WebSocket handshake
+    LatencyHistogram getDataLatency;    ///< get_data round trip
+    LatencyHistogram bookingLatency;    ///< Booking round trip
+    LatencyHistogram fanOutDelay;       ///< Seat requested -> SEAT_DELTA received
+
+    std::atomic<uint64_t> connected{0};         ///< Connections established
+    std::atomic<uint64_t> connectFailures{0};   ///< Connections that failed
+    std::atomic<uint64_t> dropped{0};           ///< Established connections lost
+    std::atomic<uint64_t> bookingsOk{0};        ///< SUCCESS replies
+    std::atomic<uint64_t> bookingsFailed{0};    ///< ERROR replies
+    std::atomic<uint64_t> deltasReceived{0};    ///< SEAT_DELTA messages received
+    std::atomic<uint64_t> connectionsDone{0};   ///< Connect attempts finished
+
+private:
+    static uint64_t seatKey(uint32_t showId, size_t seat) {
+        return (static_cast<uint64_t>(showId) << 32) | seat;
+    }
+
+    void startNext();
+
+    net::io_context& ioc_;
+    LoadGenOptions options_;
+    tcp::resolver::results_type endpoints_;
+    std::vector<CatalogueShow> catalogue_;
+    std::atomic<size_t> nextConnection_{0};
+    std::atomic<bool> stopping_{false};
+
+    std::unordered_map<uint64_t, Clock::time_point> pendingSeats_;
+    std::shared_mutex pendingMutex_;
+};
+
+/**
+ * @class LoadConnection
+ * @brief One simulated client running a closed request loop
+ *
+ * All handlers of a connection run on its own strand. The connection
+ * always keeps one read outstanding so broadcasts are consumed even while
+ * it waits for its own reply.
+ */
+class LoadConnection : public std::enable_shared_from_this<LoadConnection> {
+public:
+    LoadConnection(net::io_context& ioc, LoadGenerator& gen, uint32_t seed)
+        : ws_(net::make_strand(ioc)), timer_(ws_.get_executor()), gen_(gen), rng_(seed) {}
+
+    void start(const tcp::resolver::results_type& endpoints) {
+        startedAt_ = Clock::now();
+        beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(30));
+        beast::get_lowest_layer(ws_).async_connect(endpoints,
+            beast::bind_front_handler(&LoadConnection::on_connect, shared_from_this()));
+    }
+
+private:
+    enum class Pending { None, GetData, Booking };
+
+    void on_connect(beast::error_code ec, tcp::resolver::results_type::endpoint_type ep) {
+        if (ec) {
+            gen_.onConnectDone(false, Clock::now() - startedAt_);
+            return;
+        }
+        beast::get_lowest_layer(ws_).socket().set_option(tcp::no_delay(true));
+        host_ = gen_.options().host + ":" + std::to_string(ep.port());
+        ws_.async_handshake(host_, "/",
+            beast::bind_front_handler(&LoadConnection::on_handshake, shared_from_this()));
+    }
+
+    void on_handshake(beast::error_code ec) {
+        if (ec) {
+            gen_.onConnectDone(false, Clock::now() - startedAt_);
+            return;
+        }
+        beast::get_lowest_layer(ws_).expires_never();
+        ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        open_ = true;
+        gen_.onConnectDone(true, Clock::now() - startedAt_);
+        do_read();
+    }
+
+    void do_read() {
+        ws_.async_read(buffer_, beast::bind_front_handler(&LoadConnection::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (open_ && !gen_.stopping()) {
+                gen_.dropped++;
+            }
+            open_ = false;
+            timer_.cancel();
+            return;
+        }
+
+        std::string message = beast::buffers_to_string(buffer_.data());
+        buffer_.consume(buffer_.size());
+
+        if (message.compare(0, CinemaProtocol::SEAT_DELTA_PREFIX.size(), CinemaProtocol::SEAT_DELTA_PREFIX) == 0) {
+            gen_.recordDeltas(message);
+        } else if (message.compare(0, CinemaProtocol::BOOKING_UPDATE_PREFIX.size(),
+                                   CinemaProtocol::BOOKING_UPDATE_PREFIX) == 0) {
+            // Full-state broadcast, not a reply to this connection
+        } else if (!gotInitialData_) {
+            gotInitialData_ = true;
+            schedule_next();
+        } else if (pending_ != Pending::None) {
+            auto elapsed = Clock::now() - sentAt_;
+            if (pending_ == Pending::GetData) {
+                gen_.getDataLatency.record(elapsed);
+            } else {
+                gen_.bookingLatency.record(elapsed);
+                if (message.rfind("SUCCESS:", 0) == 0) {
+                    gen_.bookingsOk++;
+                } else {
+                    gen_.bookingsFailed++;
+                }
+            }
+            pending_ = Pending::None;
+            schedule_next();
+        }
+
+        do_read();
+    }
+
+    void schedule_next() {
+        if (gen_.stopping()) {
+            close();
+            return;
+        }
+        if (gen_.options().thinkMs <= 0) {
+            send_next();
+            return;
+        }
+        timer_.expires_after(std::chrono::milliseconds(gen_.options().thinkMs));
+        timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (!ec && self->open_) {
+                self->gen_.stopping() ? self->close() : self->send_next();
+            }
+        });
+    }
+
+    void send_next() {
+        const auto& options = gen_.options();
+        const auto& catalogue = gen_.catalogue();
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        if (catalogue.empty() || unit(rng_) < options.getDataRatio) {
+            request_ = "get_data";
+            pending_ = Pending::GetData;
+        } else {
+            size_t showIndex = 0;
+            size_t seat = 1;
+            if (unit(rng_) < options.hotRatio) {
+                size_t hot = std::clamp<size_t>(options.hotSeats, 1, catalogue[0].seatCount);
+                seat = std::uniform_int_distribution<size_t>(1, hot)(rng_);
+            } else {
+                showIndex = std::uniform_int_distribution<size_t>(0, catalogue.size() - 1)(rng_);
+                seat = std::uniform_int_distribution<size_t>(1, catalogue[showIndex].seatCount)(rng_);
+            }
+            const auto& show = catalogue[showIndex];
+            request_ = show.theater + "," + show.movie + "," + std::to_string(seat);
+            pending_ = Pending::Booking;
+            gen_.noteBookingSent(show.id, seat);
+        }
+
+        sentAt_ = Clock::now();
+        ws_.async_write(net::buffer(request_),
+            [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec && self->open_ && !self->gen_.stopping()) {
+                    self->gen_.dropped++;
+                    self->open_ = false;
+                }
+            });
+    }
+
+    void close() {
+        if (!open_) {
+            return;
+        }
+        open_ = false;
+        ws_.async_close(websocket::close_code::normal, [self = shared_from_this()](beast::error_code) {});
+    }
+
+    websocket::stream<beast::tcp_stream> ws_;
+    net::steady_timer timer_;
+    beast::flat_buffer buffer_;
+    LoadGenerator& gen_;
+    std::mt19937 rng_;
+    std::string host_;
+    std::string request_;
+    Clock::time_point startedAt_;
+    Clock::time_point sentAt_;
+    Pending pending_ = Pending::None;
+    bool gotInitialData_ = false;
+    bool open_ = false;
+};
+
+void LoadGenerator::startConnections() {
+    size_t initial = std::min(options_.connectConcurrency, options_.connections);
+    for (size_t i = 0; i < initial; ++i) {
+        startNext();
+    }
+}
+
+void LoadGenerator::startNext() {
+    size_t index = nextConnection_.fetch_add(1);
+    if (index >= options_.connections || stopping()) {
+        return;
+    }
+    std::make_shared<LoadConnection>(ioc_, *this, static_cast<uint32_t>(index * 2654435761u))->start(endpoints_);
+}
+
+void LoadGenerator::onConnectDone(bool ok, Clock::duration elapsed) {
+    if (ok) {
+        connected++;
+        connectLatency.record(elapsed);
+    } else {
+        connectFailures++;
+    }
+    connectionsDone++;
+    startNext();
+}
+
+void LoadGenerator::recordDeltas(const std::string& message) {
+    auto now = Clock::now();
+    deltasReceived++;
+
+    std::stringstream lines(message);
+    std::string line;
+    std::shared_lock lock(pendingMutex_);
+    while (std::getline(lines, line)) {
+        size_t seqEnd = line.find(':', CinemaProtocol::SEAT_DELTA_PREFIX.size());
+        size_t idEnd = seqEnd == std::string::npos ? std::string::npos : line.find(':', seqEnd + 1);
+        if (idEnd == std::string::npos) {
+            continue;
+        }
+        uint32_t showId = static_cast<uint32_t>(std::strtoul(line.c_str() + seqEnd + 1, nullptr, 10));
+
+        std::stringstream seats(line.substr(idEnd + 1));
+        std::string seat;
+        while (std::getline(seats, seat, ',')) {
+            auto it = pendingSeats_.find(seatKey(showId, std::strtoul(seat.c_str(), nullptr, 10)));
+            if (it != pendingSeats_.end()) {
+                fanOutDelay.record(now - it->second);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fetch the catalogue once with a blocking connection
+ * @param options Host and port to connect to
+ * @param endpoints Resolved server endpoints
+ * @return Shows in catalogue order with their server ids
+ * @throws boost::system::system_error if the server can't be reached
+ */
+std::vector<CatalogueShow> fetchCatalogue(const LoadGenOptions& options, const tcp::resolver::results_type& endpoints) {
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    auto ep = net::connect(ws.next_layer(), endpoints);
+    ws.handshake(options.host + ":" + std::to_string(ep.port()), "/");
+
+    beast::flat_buffer buffer;
+    ws.read(buffer);
+    std::string data = beast::buffers_to_string(buffer.data());
+    ws.close(websocket::close_code::normal);
+
+    // Reuse the client's parser; it never touches its own connection here
+    CinemaClient parser;
+    parser.parseAndUpdateShows(data);
+    ShowsSnapshotPtr shows = parser.snapshot();
+
+    std::vector<CatalogueShow> catalogue;
+    catalogue.reserve(shows->shows.size());
+    for (const auto& show : shows->shows) {
+        catalogue.push_back({show->theater, show->movie, 0, show->seats.size()});
+    }
+    for (const auto& [id, index] : *shows->indexById) {
+        if (index < catalogue.size()) {
+            catalogue[index].id = id;
+        }
+    }
+    return catalogue;
+}
+
+/**
+ * @brief Parse command line options
+ * @param argc Argument count
+ * @param argv Arguments as "--name value" pairs
+ * @return Options with defaults for anything not given
+ */
+LoadGenOptions parseOptions(int argc, char** argv) {
+    LoadGenOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+        if (name == "--host") options.host = value;
+        else if (name == "--port") options.port = value;
+        else if (name == "--connections") options.connections = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "--connect-concurrency") options.connectConcurrency = std::max<size_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+        else if (name == "--threads") options.threads = std::atoi(value.c_str());
+        else if (name == "--duration") options.duration = std::atof(value.c_str());
+        else if (name == "--get-data") options.getDataRatio = std::clamp(std::atof(value.c_str()), 0.0, 1.0);
+        else if (name == "--hot") options.hotRatio = std::clamp(std::atof(value.c_str()), 0.0, 1.0);
+        else if (name == "--hot-seats") options.hotSeats = std::strtoul(value.c_str(), nullptr, 10);
+        else if (name == "--think-ms") options.thinkMs = std::atoi(value.c_str());
+        else std::cerr << "Unknown option " << name << std::endl;
+    }
+    return options;
+}
+
+/**
+ * @brief Print percentiles of one histogram
+ * @param name Row label
+ * @param histogram Histogram to report
+ */
+void printLatency(const std::string& name, const LatencyHistogram& histogram) {
+    std::cout << "  " << std::left << std::setw(12) << name << std::right
+              << " n=" << std::setw(9) << histogram.count()
+              << "  p50=" << std::setw(8) << histogram.percentile(0.50) << "us"
+              << "  p99=" << std::setw(8) << histogram.percentile(0.99) << "us"
+              << "  p999=" << std::setw(8) << histogram.percentile(0.999) << "us\n";
+}
+
+/**
+ * @brief Load generator entry point
+ * @return 0 on success, 1 if the server could not be reached
+ *
+ * @par Run Phases
+ * 1. Fetch the catalogue with one blocking connection
+ * 2. Ramp up connections, at most --connect-concurrency at a time
+ * 3. Run the request mix for --duration seconds
+ * 4. Close connections and print the report
+ */
+int main(int argc, char** argv) {
+    LoadGenOptions options = parseOptions(argc, argv);
+
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int threadCount = options.threads > 0 ? options.threads
+                                          : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    net::io_context ioc{threadCount};
+    tcp::resolver::results_type endpoints;
+    std::vector<CatalogueShow> catalogue;
+    try {
+        endpoints = tcp::resolver{ioc}.resolve(options.host, options.port);
+        catalogue = fetchCatalogue(options, endpoints);
+    } catch (const std::exception& e) {
+        std::cerr << "Cannot reach server at " << options.host << ":" << options.port << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Catalogue: " << catalogue.size() << " show(s); opening " << options.connections
+              << " connection(s) on " << threadCount << " thread(s)" << std::endl;
+
+    LoadGenerator gen(ioc, options, endpoints, std::move(catalogue));
+    auto work = net::make_work_guard(ioc);
+    gen.startConnections();
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&ioc]() { ioc.run(); });
+    }
+
+    auto rampStart = Clock::now();
+    while (gen.connectionsDone.load() < options.connections) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::cout << "Connected " << gen.connected.load() << ", failed " << gen.connectFailures.load()
+              << " in " << std::chrono::duration<double>(Clock::now() - rampStart).count() << "s" << std::endl;
+
+    // Measure only steady-state load; the ramp-up is reported separately
+    uint64_t okBefore = gen.bookingsOk.load();
+    uint64_t attemptsBefore = okBefore + gen.bookingsFailed.load();
+    auto loadStart = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    double elapsed = std::chrono::duration<double>(Clock::now() - loadStart).count();
+    uint64_t ok = gen.bookingsOk.load() - okBefore;
+    uint64_t attempts = gen.bookingsOk.load() + gen.bookingsFailed.load() - attemptsBefore;
+
+    gen.stop();
+    work.reset();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    ioc.stop();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "\n=== LOAD REPORT (" << elapsed << "s) ===\n";
+    std::cout << "Connections: " << gen.connected.load() << " established, "
+              << gen.connectFailures.load() << " failed, " << gen.dropped.load() << " dropped\n";
+    std::cout << "Bookings/sec: " << ok / elapsed << " successful, " << attempts / elapsed << " attempted\n";
+    std::cout << "Latency:\n";
+    printLatency("connect", gen.connectLatency);
+    printLatency("get_data", gen.getDataLatency);
+    printLatency("booking", gen.bookingLatency);
+    printLatency("fan-out", gen.fanOutDelay);
+    std::cout << "SEAT_DELTA messages received: " << gen.deltasReceived.load() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file cinema_protocol.hpp
+ * @brief Wire protocol shared by the Cinema server and client
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ *
+ * Both sides include this one header, so a prefix the server writes is
+ * the prefix the client looks for.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @namespace CinemaProtocol
+ * @brief Text protocol constants
+ *
+ * Every constant is a std::string_view, so lengths are known at compile
+ * time as .size() instead of being counted by hand.
+ */
+namespace CinemaProtocol {
+    // Data streams
+    inline constexpr std::string_view CINEMA_DATA_HEADER = "=== CINEMA DATA STREAM ===";   ///< Cinema data stream header
+    inline constexpr std::string_view CINEMA_DATA_FOOTER = "=== END CINEMA DATA ===";     ///< Cinema data stream footer
+    inline constexpr std::string_view UPDATE_DATA_HEADER = "=== UPDATED CINEMA DATA ==="; ///< Update data header
+    inline constexpr std::string_view UPDATE_DATA_FOOTER = "=== END UPDATED DATA ===";    ///< Update data footer
+    inline constexpr std::string_view BOOKING_UPDATE_PREFIX = "BOOKING_UPDATE:";          ///< First line of an update stream
+    inline constexpr std::string_view SEQUENCE_PREFIX = "Sequence: ";                     ///< State version line prefix
+    inline constexpr std::string_view THEATER_PREFIX = "Theater: ";                       ///< Theater line prefix
+    inline constexpr std::string_view MOVIE_PREFIX = "  Movie: ";                         ///< Movie line prefix, "(date time)" follows the title
+    inline constexpr std::string_view SHOW_ID_PREFIX = "    Show ID: ";                   ///< Show id line prefix
+    inline constexpr std::string_view AVAILABLE_SEATS_PREFIX = "    Available seats: ";   ///< Free seat list line prefix
+    inline constexpr std::string_view SEAT_SEPARATOR = ", ";                              ///< Between free seats
+    inline constexpr std::string_view SOLD_OUT = "SOLD OUT";                              ///< Free seat list of a full show
+    inline constexpr std::string_view TOTAL_PREFIX = " (Total: ";                         ///< "<free>/<seats>)" follows
+    inline constexpr std::string_view LINE_END = "\n";                                    ///< Ends every line
+
+    // Seat deltas
+    inline constexpr std::string_view SEAT_DELTA_PREFIX = "SEAT_DELTA:";                  ///< Seat delta message prefix
+    inline constexpr std::string_view SEAT_HELD_PREFIX = "SEAT_HELD:";                    ///< Held seats message prefix
+    inline constexpr std::string_view SEAT_FREED_PREFIX = "SEAT_FREED:";                  ///< Released seats message prefix
+    inline constexpr std::string_view SEAT_PREFIX = "SEAT_";                              ///< Common prefix of all seat deltas
+
+    // Requests and replies
+    inline constexpr std::string_view BINARY_HELLO = "protocol:binary";                   ///< Switches a session to binary frames
+    inline constexpr std::string_view TEXT_HELLO = "protocol:text";                       ///< Switches a session back to text
+    inline constexpr std::string_view SUBSCRIBE_PREFIX = "subscribe:";                    ///< Client request to watch shows
+    inline constexpr std::string_view UNSUBSCRIBE_PREFIX = "unsubscribe:";                ///< Client request to stop watching shows
+    inline constexpr std::string_view SUBSCRIBED_PREFIX = "SUBSCRIBED: ";                 ///< Reply to a subscription request
+    inline constexpr std::string_view SUBSCRIBED_ALL = "SUBSCRIBED: all shows";           ///< Reply once every show is watched
+    inline constexpr char SHOWTIME_SEPARATOR = '@';                                       ///< Picks a showtime: "movie@date time"
+    inline constexpr std::string_view BATCH_REQUEST = "batch";                            ///< First line of a batch request
+    inline constexpr std::string_view BATCH_RESULT_PREFIX = "BATCH_RESULT:";              ///< Batch reply prefix
+    inline constexpr std::size_t MAX_BATCH_ITEMS = 1024;                                  ///< Bookings the server accepts per batch
+    inline constexpr std::string_view BOOKING_UNSAVED = "ERROR: Booking could not be saved"; ///< Reply when the journal cannot persist bookings
+    inline constexpr std::string_view RATE_LIMITED = "ERROR: Too many requests, slow down"; ///< Reply to a message over the rate limit
+    inline constexpr std::string_view METRICS_PATH = "/metrics";                          ///< HTTP route serving ServerMetrics
+
+    // Cluster peers
+    inline constexpr std::string_view PEER_HELLO = "protocol:peer";                       ///< Marks a session as another cluster node, ":<secret>" follows
+    inline constexpr std::string_view FORWARD_PREFIX = "FORWARD:";                        ///< Peer request "FORWARD:<id>:<t|b>:<booking>"
+    inline constexpr std::string_view FORWARDED_PREFIX = "FORWARDED:";                    ///< Peer reply "FORWARDED:<id>:<reply>"
+    inline constexpr std::string_view SYNC_REQUEST = "protocol:sync";                     ///< Replica request for the full seat state
+    inline constexpr std::string_view STATE_SYNC_PREFIX = "STATE_SYNC:";                  ///< Seat state reply, see ReplicaSync
+
+    /**
+     * @struct Join
+     * @brief Constants concatenated at compile time
+     * @tparam Parts Constants to join, in order
+     */
+    template <const std::string_view&... Parts>
+    struct Join {
+    private:
+        static constexpr auto storage = [] {
+            std::array<char, (Parts.size() + ... + 0) + 1> text{};
+            std::size_t at = 0;
+            ((std::copy(Parts.begin(), Parts.end(), text.begin() + at), at += Parts.size()), ...);
+            return text;
+        }();
+
+    public:
+        static constexpr std::string_view value{storage.data(), storage.size() - 1};   ///< The joined text
+    };
+
+    /**
+     * @brief Kind of full data stream
+     */
+    enum class Catalogue {
+        Full,     ///< Sent on connect and for get_data
+        Update    ///< Broadcast and sent for refresh
+    };
+
+    /**
+     * @struct CatalogueLayout
+     * @brief Fixed text around the theaters of a data stream
+     * @tparam Kind Stream to describe
+     *
+     * A stream is HEADER, the state version, a line end, the theater
+     * listing and FOOTER. Every theater is THEATER_PREFIX, its name and a
+     * line end, then its shows, then an empty line. Every show is:
+     * @code
+     *   Movie: <movie> (<date time>)
+     *     Show ID: <id>
+     *     Available seats: <seat>, <seat>, ... (Total: <free>/<seats>)
+     * @endcode
+     * with SOLD_OUT in place of an empty seat list.
+     */
+    template <Catalogue Kind>
+    struct CatalogueLayout;
+
+    /**
+     * @brief Text shared by both kinds of stream
+     */
+    struct CatalogueText {
+        static constexpr std::string_view DATE_OPEN = " (";        ///< Between movie title and date
+        static constexpr std::string_view CLOSE_LINE = ")\n";      ///< Ends the movie and the seat lines
+        static constexpr std::string_view TOTAL_SEPARATOR = "/";   ///< Between free and total seats
+
+        /// Fixed bytes of a show entry, without names, numbers and seats
+        static constexpr std::size_t SHOW_FIXED_SIZE =
+            MOVIE_PREFIX.size() + DATE_OPEN.size() + CLOSE_LINE.size() + SHOW_ID_PREFIX.size() + LINE_END.size() +
+            AVAILABLE_SEATS_PREFIX.size() + TOTAL_PREFIX.size() + TOTAL_SEPARATOR.size() + CLOSE_LINE.size();
+
+        /// Fixed bytes of a theater entry, without its name and shows
+        static constexpr std::size_t THEATER_FIXED_SIZE = THEATER_PREFIX.size() + 2 * LINE_END.size();
+    };
+
+    template <>
+    struct CatalogueLayout<Catalogue::Full> : CatalogueText {
+        static constexpr std::string_view HEADER = Join<CINEMA_DATA_HEADER, LINE_END, SEQUENCE_PREFIX>::value;
+        static constexpr std::string_view FOOTER = Join<CINEMA_DATA_FOOTER, LINE_END>::value;
+    };
+
+    template <>
+    struct CatalogueLayout<Catalogue::Update> : CatalogueText {
+        static constexpr std::string_view HEADER =
+            Join<BOOKING_UPDATE_PREFIX, LINE_END, UPDATE_DATA_HEADER, LINE_END, SEQUENCE_PREFIX>::value;
+        static constexpr std::string_view FOOTER = Join<UPDATE_DATA_FOOTER, LINE_END>::value;
+    };
+}
+
+/**
+ * @namespace BinaryProtocol
+ * @brief Layout of the binary data frames
+ *
+ * Every frame starts with MAGIC, VERSION and a message type byte. Integers
+ * are little-endian, strings are a u16 length followed by the bytes.
+ *
+ * @par CATALOGUE
+ * u64 sequence, u32 theater count, then per theater: string name,
+ * u32 show count, then per show: u32 show id, string movie,
+ * string dateTime, u16 seat count, ceil(seat count / 8) bytes of booked
+ * seat bits (bit i of byte j is seat 8*j + i + 1).
+ *
+ * @par SEAT_DELTA
+ * One or more records of u64 sequence, u32 show id, u16 seat count, then
+ * that many u16 seats. Queued deltas may be merged into one frame this way.
+ * Held seats are announced as SEAT_DELTA too, since clients show them taken.
+ *
+ * @par SEAT_FREED
+ * Same records as SEAT_DELTA for seats that became available again, when
+ * a hold was released or expired. Never merged with SEAT_DELTA frames.
+ */
+namespace BinaryProtocol {
+    constexpr uint8_t MAGIC = 0xCB;         ///< First byte of every binary frame
+    constexpr uint8_t VERSION = 2;          ///< Frame layout version (2: u32 catalogue counts)
+    constexpr uint8_t CATALOGUE = 0x01;     ///< Full catalogue message type
+    constexpr uint8_t SEAT_DELTA = 0x02;    ///< Seat delta message type
+    constexpr uint8_t SEAT_FREED = 0x03;    ///< Released seats message type
+    constexpr std::size_t HEADER_SIZE = 3;  ///< Magic, version and type bytes
+}
@@ -0,0 +1,185 @@
+#include "admission.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <utility>
+
+TokenBucket::TokenBucket(double perSecond, double burst, Clock::time_point now)
+    : perSecond_(perSecond), burst_(std::max(burst, 1.0)), tokens_(burst_), last_(now) {}
+
+bool TokenBucket::take(Clock::time_point now) {
+    if (perSecond_ <= 0) {
+        return true;
+    }
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    tokens_ = std::min(burst_, tokens_ + std::max(elapsed, 0.0) * perSecond_);
+    last_ = now;
+    if (tokens_ < 1.0) {
+        return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+}
+
+bool TokenBucket::full(Clock::time_point now) const {
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    return perSecond_ <= 0 || tokens_ + std::max(elapsed, 0.0) * perSecond_ >= burst_;
+}
+
+AdmissionControl::Ticket::Ticket(Ticket&& other) noexcept
+    : control_(std::exchange(other.control_, nullptr)),
+      source_(std::move(other.source_)),
+      messages_(other.messages_),
+      handshaking_(std::exchange(other.handshaking_, false)) {}
+
+AdmissionControl::Ticket& AdmissionControl::Ticket::operator=(Ticket&& other) noexcept {
+    if (this != &other) {
+        release();
+        control_ = std::exchange(other.control_, nullptr);
+        source_ = std::move(other.source_);
+        messages_ = other.messages_;
+        handshaking_ = std::exchange(other.handshaking_, false);
+    }
+    return *this;
+}
+
+AdmissionControl::Ticket::~Ticket() {
+    release();
+}
+
+AdmissionControl::Ticket::operator bool() const {
+    return control_ != nullptr;
+}
+
+void AdmissionControl::Ticket::handshakeDone() {
+    if (control_ && handshaking_) {
+        handshaking_ = false;
+        control_->handshakes_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool AdmissionControl::Ticket::allowMessage(Clock::time_point now) {
+    if (!messages_.take(now)) {
+        return false;
+    }
+    if (source_) {
+        TracedLock<std::mutex> lock(source_->mutex, "admission source");
+        return source_->messages.take(now);
+    }
+    return true;
+}
+
+void AdmissionControl::Ticket::release() {
+    if (!control_) {
+        return;
+    }
+    handshakeDone();
+    control_->connections_.fetch_sub(1, std::memory_order_relaxed);
+    if (source_) {
+        TracedLock<std::mutex> lock(source_->mutex, "admission source");
+        --source_->connections;
+    }
+    source_.reset();
+    control_ = nullptr;
+}
+
+AdmissionControl::AdmissionControl(AdmissionOptions options)
+    : options_(options),
+      trackSources_(options.maxConnectionsPerIp > 0 || options.connectRatePerIp > 0 ||
+                    options.messageRatePerIp > 0) {}
+
+AdmissionControl::Ticket AdmissionControl::admit(const net::ip::address& address, AdmissionVerdict& verdict) {
+    // Accepts are chained one at a time, so the checks below cannot race
+    // each other; closing connections only lower the counts
+    Clock::time_point now = Clock::now();
+    Ticket ticket;
+    if (options_.maxConnections > 0 && connections_.load(std::memory_order_relaxed) >= options_.maxConnections) {
+        verdict = AdmissionVerdict::TooManyConnections;
+        return ticket;
+    }
+    if (options_.maxHandshakes > 0 && handshakes_.load(std::memory_order_relaxed) >= options_.maxHandshakes) {
+        verdict = AdmissionVerdict::TooManyHandshakes;
+        return ticket;
+    }
+
+    if (trackSources_) {
+        AddressKey key = address.is_v4()
+            ? net::ip::make_address_v6(net::ip::v4_mapped, address.to_v4()).to_bytes()
+            : address.to_v6().to_bytes();
+
+        TracedLock<std::mutex> lock(mutex_, "admission");
+        std::shared_ptr<Source>& source = sources_[key];
+        if (!source) {
+            source = std::make_shared<Source>();
+            source->connects = TokenBucket(options_.connectRatePerIp, options_.connectBurstPerIp, now);
+            source->messages = TokenBucket(options_.messageRatePerIp, options_.messageBurstPerIp, now);
+        }
+        {
+            TracedLock<std::mutex> sourceLock(source->mutex, "admission source");
+            if (options_.maxConnectionsPerIp > 0 && source->connections >= options_.maxConnectionsPerIp) {
+                verdict = AdmissionVerdict::TooManyFromAddress;
+                return ticket;
+            }
+            if (!source->connects.take(now)) {
+                verdict = AdmissionVerdict::ConnectRate;
+                return ticket;
+            }
+            ++source->connections;
+        }
+        ticket.source_ = source;
+        if (sources_.size() >= pruneAt_) {
+            prune(now);
+        }
+    }
+
+    connections_.fetch_add(1, std::memory_order_relaxed);
+    handshakes_.fetch_add(1, std::memory_order_relaxed);
+    ticket.control_ = this;
+    ticket.messages_ = TokenBucket(options_.messageRate, options_.messageBurst, now);
+    ticket.handshaking_ = true;
+    verdict = AdmissionVerdict::Admitted;
+    return ticket;
+}
+
+const AdmissionOptions& AdmissionControl::options() const {
+    return options_;
+}
+
+std::size_t AdmissionControl::connections() const {
+    return connections_.load(std::memory_order_relaxed);
+}
+
+std::size_t AdmissionControl::handshakes() const {
+    return handshakes_.load(std::memory_order_relaxed);
+}
+
+std::size_t AdmissionControl::sources() const {
+    TracedLock<std::mutex> lock(mutex_, "admission");
+    return sources_.size();
+}
+
+std::size_t AdmissionControl::AddressHash::operator()(const AddressKey& key) const {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char byte : key) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+void AdmissionControl::prune(Clock::time_point now) {
+    for (auto it = sources_.begin(); it != sources_.end();) {
+        bool idle;
+        {
+            // No ticket can take a reference while mutex_ is held
+            Source& source = *it->second;
+            TracedLock<std::mutex> lock(source.mutex, "admission source");
+            idle = source.connections == 0 && source.connects.full(now) && source.messages.full(now);
+        }
+        if (idle) {
+            it = sources_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    pruneAt_ = std::max<std::size_t>(1024, 2 * sources_.size());
+}
@@ -0,0 +1,230 @@
+/**
+ * @file admission.hpp
+ * @brief Connection caps and request rate limits applied before any work
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <boost/asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace net = boost::asio;
+
+/**
+ * @struct AdmissionOptions
+ * @brief Limits on connections and on the messages they may send
+ *
+ * Limits set to 0 are off. Per-address limits are off by default because
+ * clients behind one NAT, and load generators, share an address.
+ */
+struct AdmissionOptions {
+    std::size_t maxConnections = 50000;                  ///< Open connections in total
+    std::size_t maxConnectionsPerIp = 0;                 ///< Open connections per source address
+    std::size_t maxHandshakes = 4096;                    ///< Connections still in their opening handshake
+    std::chrono::milliseconds handshakeTimeout{10000};   ///< Time from accept to a completed WebSocket handshake
+    double connectRatePerIp = 0;                         ///< New connections per second per source address
+    double connectBurstPerIp = 50;                       ///< Connections an address may open at once
+    double messageRate = 200;                            ///< Messages per second per session
+    double messageBurst = 400;                           ///< Messages a session may send at once
+    double messageRatePerIp = 0;                         ///< Messages per second over all sessions of an address
+    double messageBurstPerIp = 4000;                     ///< Messages an address may send at once
+    std::size_t maxRefusedMessages = 200;                ///< Messages refused in a row before the session is closed
+    std::size_t maxMessageBytes = 1 << 20;               ///< Largest message a client may send
+};
+
+/**
+ * @class TokenBucket
+ * @brief Rate limit allowing bursts, refilled continuously
+ *
+ * @note Not thread-safe; callers serialize access
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Constructor
+     * @param perSecond Sustained rate, 0 or less for no limit
+     * @param burst Bucket size, starts full
+     * @param now Time of construction
+     */
+    explicit TokenBucket(double perSecond = 0, double burst = 0, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Take one token if available
+     * @param now Current time
+     * @return true if the event is within the rate
+     */
+    bool take(Clock::time_point now);
+
+    /**
+     * @brief Check whether the bucket refilled completely
+     * @param now Current time
+     * @return true if a limiter in this state carries no history
+     */
+    bool full(Clock::time_point now) const;
+
+private:
+    double perSecond_;          ///< Refill rate
+    double burst_;              ///< Bucket size
+    double tokens_;             ///< Tokens at last_
+    Clock::time_point last_;    ///< Time of the last refill
+};
+
+/**
+ * @enum AdmissionVerdict
+ * @brief Outcome of AdmissionControl::admit()
+ */
+enum class AdmissionVerdict {
+    Admitted,             ///< Connection may proceed
+    TooManyConnections,   ///< AdmissionOptions::maxConnections reached
+    TooManyFromAddress,   ///< AdmissionOptions::maxConnectionsPerIp reached
+    ConnectRate,          ///< Address exceeded AdmissionOptions::connectRatePerIp
+    TooManyHandshakes     ///< AdmissionOptions::maxHandshakes reached
+};
+
+/**
+ * @class AdmissionControl
+ * @brief Decides at accept time whether a connection is served at all
+ *
+ * Every admitted connection holds a Ticket until it closes. The ticket
+ * counts it against the caps and carries the session's message bucket,
+ * so overload is refused before a request is parsed or answered.
+ *
+ * @par Source Addresses
+ * Addresses are only tracked when a per-address limit is set. Each has a
+ * small state with its own mutex, shared by the tickets of its sessions;
+ * the address table lock is only taken at accept and close. Entries of
+ * addresses without connections are dropped once their buckets refill.
+ *
+ * @par Thread Safety
+ * admit() may be called from any thread. A Ticket is used from its
+ * session's strand only.
+ */
+class AdmissionControl {
+private:
+    struct Source {
+        std::mutex mutex;                 ///< Protects the fields below
+        std::size_t connections = 0;      ///< Open connections of the address
+        TokenBucket connects;             ///< New connection rate
+        TokenBucket messages;             ///< Message rate over its sessions
+    };
+
+public:
+    using Clock = TokenBucket::Clock;
+
+    /**
+     * @class Ticket
+     * @brief An admitted connection, released when destroyed
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(Ticket&& other) noexcept;
+        Ticket& operator=(Ticket&& other) noexcept;
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        ~Ticket();
+
+        /**
+         * @brief Check whether the connection was admitted
+         */
+        explicit operator bool() const;
+
+        /**
+         * @brief Free the handshake slot once the connection is established
+         * @note Safe to call more than once
+         */
+        void handshakeDone();
+
+        /**
+         * @brief Charge one message to the session and its address
+         * @param now Current time
+         * @return false if either is over its rate and the message should
+         *         be refused
+         */
+        bool allowMessage(Clock::time_point now = Clock::now());
+
+    private:
+        friend class AdmissionControl;
+
+        void release();
+
+        AdmissionControl* control_ = nullptr;     ///< Issuer, null if not admitted
+        std::shared_ptr<Source> source_;          ///< Address state, null if not tracked
+        TokenBucket messages_;                    ///< Session message rate
+        bool handshaking_ = false;                ///< Holds a handshake slot
+    };
+
+    /**
+     * @brief Constructor
+     * @param options Limits to enforce
+     */
+    explicit AdmissionControl(AdmissionOptions options = {});
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    /**
+     * @brief Admit or refuse a new connection
+     * @param address Remote address of the connection
+     * @param verdict Output: why the connection was refused, or Admitted
+     * @return Ticket of the connection, empty if refused
+     * @note Tickets must not outlive this object
+     */
+    Ticket admit(const net::ip::address& address, AdmissionVerdict& verdict);
+
+    /**
+     * @brief Get the enforced limits
+     * @return Options given at construction
+     */
+    const AdmissionOptions& options() const;
+
+    /**
+     * @brief Count admitted connections still open
+     */
+    std::size_t connections() const;
+
+    /**
+     * @brief Count admitted connections still in their handshake
+     */
+    std::size_t handshakes() const;
+
+    /**
+     * @brief Count tracked source addresses
+     */
+    std::size_t sources() const;
+
+private:
+    using AddressKey = std::array<unsigned char, 16>;
+
+    struct AddressHash {
+        std::size_t operator()(const AddressKey& key) const;
+    };
+
+    /**
+     * @brief Drop address entries that carry no connections and no history
+     * @param now Current time
+     * @note Called with mutex_ held
+     */
+    void prune(Clock::time_point now);
+
+    AdmissionOptions options_;                       ///< Enforced limits
+    bool trackSources_;                              ///< A per-address limit is set
+    std::atomic<std::size_t> connections_{0};        ///< Open admitted connections
+    std::atomic<std::size_t> handshakes_{0};         ///< Admitted connections in their handshake
+
+    mutable std::mutex mutex_;                       ///< Protects sources_
+    std::unordered_map<AddressKey, std::shared_ptr<Source>, AddressHash> sources_;  ///< State per address (IPv4 mapped to IPv6)
+    std::size_t pruneAt_ = 1024;                     ///< Table size that triggers the next prune
+};
@@ -0,0 +1,243 @@
+#include "availability.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace {
+
+constexpr std::string_view QUERY_USAGE =
+    "ERROR: Invalid query. Use: query:[movie=<title>][,theater=<name>][,after=<date time>|<HH:MM>]"
+    "[,before=<date time>|<HH:MM>][,seats=<n>][,limit=<n>]";
+
+/**
+ * @brief Time of day of a "YYYY-MM-DD HH:MM" date/time
+ */
+std::string_view timeOfDay(std::string_view dateTime) {
+    size_t space = dateTime.rfind(' ');
+    return space == std::string_view::npos ? dateTime : dateTime.substr(space + 1);
+}
+
+/**
+ * @brief Check that a value is a time of day in "HH:MM" form
+ */
+bool isTimeOfDay(std::string_view value) {
+    return value.size() == 5 && value[2] == ':' &&
+           std::all_of(value.begin(), value.begin() + 2, [](char c) { return c >= '0' && c <= '9'; }) &&
+           std::all_of(value.begin() + 3, value.end(), [](char c) { return c >= '0' && c <= '9'; }) &&
+           value.substr(0, 2) < "24" && value.substr(3) < "60";
+}
+
+/**
+ * @brief Hour of a show, or -1 if its time is not "HH:MM"
+ */
+int hourOf(std::string_view dateTime) {
+    std::string_view time = timeOfDay(dateTime);
+    return isTimeOfDay(time) ? (time[0] - '0') * 10 + (time[1] - '0') : -1;
+}
+
+bool parseCount(std::string_view value, size_t& count) {
+    auto [end, err] = std::from_chars(value.data(), value.data() + value.size(), count);
+    return err == std::errc() && end == value.data() + value.size();
+}
+
+} // namespace
+
+std::optional<std::string> AvailabilityQuery::parse(std::string_view parameters, AvailabilityQuery& query) {
+    query = {};
+    while (!parameters.empty()) {
+        size_t comma = parameters.find(',');
+        std::string_view item = parameters.substr(0, comma);
+        parameters = comma == std::string_view::npos ? std::string_view{} : parameters.substr(comma + 1);
+
+        size_t equals = item.find('=');
+        if (equals == std::string_view::npos || equals + 1 == item.size()) {
+            return std::string(QUERY_USAGE);
+        }
+        std::string_view key = item.substr(0, equals);
+        std::string_view value = item.substr(equals + 1);
+        bool timeBound = value.find('-') == std::string_view::npos;
+
+        if (key == "movie") {
+            query.movie = value;
+        } else if (key == "theater") {
+            query.theater = value;
+        } else if (key == "after" || key == "before") {
+            if (timeBound && !isTimeOfDay(value)) {
+                return std::string(QUERY_USAGE);
+            }
+            std::string& bound = key == "after" ? (timeBound ? query.afterTime : query.after)
+                                                : (timeBound ? query.beforeTime : query.before);
+            bound = value;
+        } else if (key == "seats") {
+            if (!parseCount(value, query.seats) || query.seats > std::numeric_limits<SeatNumber>::max()) {
+                return std::string(QUERY_USAGE);
+            }
+        } else if (key == "limit") {
+            if (!parseCount(value, query.limit) || query.limit == 0) {
+                return std::string(QUERY_USAGE);
+            }
+            query.limit = std::min(query.limit, MAX_LIMIT);
+        } else {
+            return std::string(QUERY_USAGE);
+        }
+    }
+    return std::nullopt;
+}
+
+AvailabilityIndex::AvailabilityIndex(const ShowStore& shows)
+    : shows_(shows) {
+    byTime_.resize(shows.size());
+    for (size_t id = 0; id < shows.size(); ++id) {
+        byTime_[id] = static_cast<ShowId>(id);
+    }
+    std::stable_sort(byTime_.begin(), byTime_.end(), [&shows](ShowId a, ShowId b) {
+        return shows[a].dateTime < shows[b].dateTime;
+    });
+
+    // Every other list is filled from the time order, so it is sorted too
+    timeRank_.resize(shows.size());
+    for (size_t rank = 0; rank < byTime_.size(); ++rank) {
+        ShowId id = byTime_[rank];
+        const Shows& show = shows[id];
+        timeRank_[id] = static_cast<uint32_t>(rank);
+        byMovie_[show.movie].push_back(id);
+        byTheater_[show.theater].push_back(id);
+        int hour = hourOf(show.dateTime);
+        if (hour >= 0) {
+            byHour_[hour].push_back(id);
+        }
+    }
+}
+
+bool AvailabilityIndex::isQuery(std::string_view message) {
+    return message.substr(0, QUERY_PREFIX.size()) == QUERY_PREFIX;
+}
+
+SharedPayload AvailabilityIndex::handleMessage(std::string_view message) const {
+    ServerMetrics& metrics = ServerMetrics::instance();
+    AvailabilityQuery query;
+    if (auto error = AvailabilityQuery::parse(message.substr(QUERY_PREFIX.size()), query)) {
+        metrics.queriesRejected.inc();
+        return std::make_shared<const std::string>(std::move(*error));
+    }
+
+    size_t total = 0;
+    std::vector<Match> found = find(query, total);
+    metrics.queriesAnswered.inc();
+
+    std::string reply = "SHOWS: " + std::to_string(found.size()) + " of " + std::to_string(total);
+    reply.reserve(reply.size() + found.size() * 64);
+    for (const Match& match : found) {
+        const Shows& show = shows_[match.id];
+        reply.append("\n").append(std::to_string(match.id));
+        reply.append("|").append(show.theater).append("|").append(show.movie);
+        reply.append("|").append(show.dateTime).append("|").append(std::to_string(match.freeSeats));
+        if (match.firstSeat) {
+            reply.append("|").append(std::to_string(match.firstSeat)).append("-");
+            reply.append(std::to_string(match.firstSeat + query.seats - 1));
+        }
+    }
+    return std::make_shared<const std::string>(std::move(reply));
+}
+
+std::vector<AvailabilityIndex::Match> AvailabilityIndex::find(const AvailabilityQuery& query, size_t& total) const {
+    // Shortest candidate list; all but the hour buckets are in time order
+    static const ShowList none;
+    const ShowId* first = byTime_.data();
+    const ShowId* last = first + byTime_.size();
+    auto consider = [&first, &last](const ShowList& list) {
+        if (list.size() < static_cast<size_t>(last - first)) {
+            first = list.data();
+            last = first + list.size();
+        }
+    };
+    if (!query.movie.empty()) {
+        auto it = byMovie_.find(query.movie);
+        consider(it == byMovie_.end() ? none : it->second);
+    }
+    if (!query.theater.empty()) {
+        auto it = byTheater_.find(query.theater);
+        consider(it == byTheater_.end() ? none : it->second);
+    }
+    if (!query.after.empty() || !query.before.empty()) {
+        const ShowId* begin = byTime_.data();
+        const ShowId* end = begin + byTime_.size();
+        if (!query.after.empty()) {
+            begin = std::lower_bound(begin, end, std::string_view(query.after),
+                                     [this](ShowId id, std::string_view bound) { return shows_[id].dateTime < bound; });
+        }
+        if (!query.before.empty()) {
+            end = std::max(begin, std::lower_bound(begin, end, std::string_view(query.before),
+                                                   [this](ShowId id, std::string_view bound) {
+                                                       return shows_[id].dateTime < bound;
+                                                   }));
+        }
+        if (end - begin < last - first) {
+            first = begin;
+            last = end;
+        }
+    }
+
+    ShowList hourCandidates;
+    if (!query.afterTime.empty() || !query.beforeTime.empty()) {
+        int fromHour = query.afterTime.empty() ? 0 : hourOf(query.afterTime);
+        int toHour = query.beforeTime.empty() ? 23 : hourOf(query.beforeTime);
+        size_t size = 0;
+        for (int hour = fromHour; hour <= toHour; ++hour) {
+            size += byHour_[hour].size();
+        }
+        if (size < static_cast<size_t>(last - first)) {
+            hourCandidates.reserve(size);
+            for (int hour = fromHour; hour <= toHour; ++hour) {
+                hourCandidates.insert(hourCandidates.end(), byHour_[hour].begin(), byHour_[hour].end());
+            }
+            first = hourCandidates.data();
+            last = first + hourCandidates.size();
+        }
+    }
+
+    std::vector<Match> found;
+    total = 0;
+    bool ordered = hourCandidates.empty() || first != hourCandidates.data();
+    for (const ShowId* it = first; it != last; ++it) {
+        Match match{*it, 0, 0};
+        if (!matches(shows_[*it], query, match)) {
+            continue;
+        }
+        ++total;
+        if (!ordered || found.size() < query.limit) {
+            found.push_back(match);
+        }
+    }
+    if (!ordered) {
+        std::sort(found.begin(), found.end(),
+                  [this](const Match& a, const Match& b) { return timeRank_[a.id] < timeRank_[b.id]; });
+        found.resize(std::min(found.size(), query.limit));
+    }
+    for (Match& match : found) {
+        match.freeSeats = shows_[match.id].availableSeatCount();
+    }
+    return found;
+}
+
+bool AvailabilityIndex::matches(const Shows& show, const AvailabilityQuery& query, Match& match) const {
+    if ((!query.movie.empty() && show.movie != query.movie) ||
+        (!query.theater.empty() && show.theater != query.theater) ||
+        (!query.after.empty() && show.dateTime < query.after) ||
+        (!query.before.empty() && show.dateTime >= query.before)) {
+        return false;
+    }
+    if (!query.afterTime.empty() || !query.beforeTime.empty()) {
+        std::string_view time = timeOfDay(show.dateTime);
+        if (!isTimeOfDay(time) || (!query.afterTime.empty() && time < query.afterTime) ||
+            (!query.beforeTime.empty() && time >= query.beforeTime)) {
+            return false;
+        }
+    }
+    if (query.seats > 0) {
+        match.firstSeat = show.seats.findFreeRun(query.seats);
+        return match.firstSeat != 0;
+    }
+    return true;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file availability.hpp
+ * @brief Server-side show search by movie, theater, time and free seats
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cinema.hpp"
+
+/**
+ * @struct AvailabilityQuery
+ * @brief Filter of an availability request, see AvailabilityIndex
+ */
+struct AvailabilityQuery {
+    static constexpr size_t DEFAULT_LIMIT = 100;   ///< Shows listed when no limit is given
+    static constexpr size_t MAX_LIMIT = 1000;      ///< Most shows one reply lists
+
+    std::string movie;           ///< Exact movie title, empty for any
+    std::string theater;         ///< Exact theater name, empty for any
+    std::string after;           ///< Earliest date/time or date prefix, empty for none
+    std::string before;          ///< Date/time the show must start before, empty for none
+    std::string afterTime;       ///< Earliest time of day ("HH:MM"), empty for none
+    std::string beforeTime;      ///< Time of day the show must start before, empty for none
+    size_t seats = 0;            ///< Adjacent free seats required, 0 for any
+    size_t limit = DEFAULT_LIMIT;  ///< Shows to list
+
+    /**
+     * @brief Parse the parameters of a "query:" request
+     * @param parameters Text after "query:", see AvailabilityIndex
+     * @param query Output: the filter
+     * @return Error reply, or nullopt on success
+     */
+    static std::optional<std::string> parse(std::string_view parameters, AvailabilityQuery& query);
+};
+
+/**
+ * @class AvailabilityIndex
+ * @brief Secondary indexes over the catalogue answering availability queries
+ *
+ * Lets clients ask for the few shows they can book instead of pulling the
+ * whole catalogue and filtering it locally.
+ *
+ * @par Message Format
+ * "query:key=value,..." with any of
+ * - movie=<title>, theater=<name>: exact names
+ * - after=<date time>, before=<date time>: start time range; a value
+ *   without a date, such as after=18:00, bounds the time of day instead
+ * - seats=<n>: at least n adjacent free seats
+ * - limit=<n>: shows to list (default 100, at most 1000)
+ *
+ * The reply is "SHOWS: <listed> of <matching>" followed by one
+ * "<id>|<theater>|<movie>|<date time>|<free seats>" line per show in start
+ * time order; with seats=n each line ends with "|<first>-<last>", the
+ * lowest block of n adjacent free seats. Malformed queries get an ERROR:
+ * line.
+ *
+ * @par Indexes
+ * Shows are listed by start time overall, per movie, per theater and per
+ * hour of day. A query walks the shortest candidate list: the movie's or
+ * theater's shows, the slice of the time order inside a date range, or the
+ * hour buckets of a time-of-day range. Names and times never change after
+ * startup, so the indexes are built once; seats are read live from the
+ * lock-free seat maps.
+ *
+ * @par Thread Safety
+ * All queries run concurrently without locks.
+ */
+class AvailabilityIndex {
+public:
+    static constexpr std::string_view QUERY_PREFIX = "query:";   ///< Starts every query message
+
+    /**
+     * @brief Build the indexes
+     * @param shows Shows to index, must outlive this
+     */
+    explicit AvailabilityIndex(const ShowStore& shows);
+
+    AvailabilityIndex(const AvailabilityIndex&) = delete;
+    AvailabilityIndex& operator=(const AvailabilityIndex&) = delete;
+
+    /**
+     * @brief Check whether a message is an availability query
+     * @param message Raw message received from a client
+     */
+    static bool isQuery(std::string_view message);
+
+    /**
+     * @brief Answer a query message
+     * @param message Message starting with QUERY_PREFIX
+     * @return Reply, see Message Format
+     */
+    SharedPayload handleMessage(std::string_view message) const;
+
+    /**
+     * @brief Match of a query
+     */
+    struct Match {
+        ShowId id;              ///< Matching show
+        size_t freeSeats;       ///< Free seats of the show
+        SeatNumber firstSeat;   ///< First seat of the free block, 0 without AvailabilityQuery::seats
+    };
+
+    /**
+     * @brief Run a query
+     * @param query Filter
+     * @param total Output: number of matching shows
+     * @return The first query.limit matches in start time order
+     */
+    std::vector<Match> find(const AvailabilityQuery& query, size_t& total) const;
+
+private:
+    using ShowList = std::vector<ShowId>;
+
+    /**
+     * @brief Check the filters not implied by the candidate list
+     */
+    bool matches(const Shows& show, const AvailabilityQuery& query, Match& match) const;
+
+    const ShowStore& shows_;                                  ///< Indexed shows
+    ShowList byTime_;                                         ///< All shows in start time order
+    std::vector<uint32_t> timeRank_;                          ///< Position of each show in byTime_
+    std::unordered_map<std::string_view, ShowList> byMovie_;  ///< Movie -> shows in time order
+    std::unordered_map<std::string_view, ShowList> byTheater_;  ///< Theater -> shows in time order
+    std::array<ShowList, 24> byHour_;                         ///< Hour of day -> shows in time order
+};
@@ -0,0 +1,567 @@
+#include "booking_journal.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::little,
+              "snapshot bitmaps are stored in host order and must be little-endian");
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'C', 'I', 'N', 'S', 'N', 'A', 'P', '1'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+constexpr size_t SNAPSHOT_HEADER_SIZE = 32;   // magic, version, showCount, nextGeneration, fingerprint
+constexpr char JOURNAL_MAGIC[8] = {'C', 'I', 'N', 'J', 'R', 'N', 'L', '2'};
+constexpr size_t JOURNAL_HEADER_SIZE = 16;    // magic, fingerprint
+constexpr size_t SHOW_HEADER_SIZE = 8;        // seatCount, wordCount
+constexpr size_t RECORD_HEADER_SIZE = 6;      // showId, count
+constexpr size_t CRC_SIZE = 4;
+constexpr std::string_view JOURNAL_PREFIX = "journal.";
+
+constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+constexpr auto CRC_TABLE = makeCrcTable();
+
+uint32_t crc32(const char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void putU32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void putU64(std::string& out, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+uint64_t getLE(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return value;
+}
+
+/**
+ * @brief Hash the identity of every show, in ShowId order
+ * @return FNV-1a over "theater|movie|date time|seats" lines
+ */
+uint64_t fingerprintOf(const ShowStore& shows) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](std::string_view text) {
+        for (char c : text) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+    };
+    for (const auto& show : shows) {
+        mix(show.theater);
+        mix("|");
+        mix(show.movie);
+        mix("|");
+        mix(show.dateTime);
+        mix("|");
+        mix(std::to_string(show.seats.size()));
+        mix("\n");
+    }
+    return hash;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+BookingJournal::BookingJournal(ShowStore& shows, JournalOptions options)
+    : shows_(shows), options_(std::move(options)) {}
+
+BookingJournal::~BookingJournal() {
+    stop();
+}
+
+RecoveryStats BookingJournal::recover() {
+    auto started = std::chrono::steady_clock::now();
+    RecoveryStats stats;
+
+    std::error_code ec;
+    std::filesystem::create_directories(options_.directory, ec);
+    if (ec) {
+        throw std::runtime_error("cannot create journal directory " + options_.directory + ": " + ec.message());
+    }
+
+    fingerprint_ = fingerprintOf(shows_);
+    uint64_t nextGeneration = 1;
+    stats.snapshotLoaded = loadSnapshot(nextGeneration, stats);
+    generation_ = std::max(generation_, nextGeneration - 1);
+
+    for (uint64_t generation : listGenerations()) {
+        if (generation < nextGeneration) {
+            // Left behind by a snapshot that was interrupted before cleanup
+            std::filesystem::remove(journalPath(generation), ec);
+            continue;
+        }
+        replayJournal(generation, stats);
+        generation_ = std::max(generation_, generation);
+    }
+
+    stats.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+    return stats;
+}
+
+void BookingJournal::start() {
+    if (committer_.joinable()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(options_.directory, ec);
+    for (uint64_t generation : listGenerations()) {
+        generation_ = std::max(generation_, generation);
+    }
+
+    fingerprint_ = fingerprintOf(shows_);
+
+    // Always start a fresh generation so a torn tail is never appended to
+    ++generation_;
+    fileSize_ = 0;
+    fd_ = openGeneration(generation_);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot open " + journalPath(generation_) + ": " + std::strerror(errno));
+    }
+    syncDirectory();
+
+    stopping_ = false;
+    committer_ = std::thread([this]() { run(); });
+}
+
+void BookingJournal::stop() {
+    {
+        TracedLock<std::mutex> lock(mutex_, "journal");
+        if (!committer_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    committer_.join();
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t BookingJournal::append(ShowId showId, const std::vector<SeatNumber>& seats) {
+    return append(showId, seats.data(), seats.size());
+}
+
+uint64_t BookingJournal::append(ShowId showId, const SeatNumber* seats, size_t seatCount) {
+    size_t count = std::min<size_t>(seatCount, UINT16_MAX);
+    bool wakeCommitter;
+    uint64_t sequence;
+    {
+        TracedLock<std::mutex> lock(mutex_, "journal");
+        size_t start = pending_.size();
+        putU32(pending_, showId);
+        putU16(pending_, static_cast<uint16_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            putU16(pending_, seats[i]);
+        }
+        putU32(pending_, crc32(pending_.data() + start, pending_.size() - start));
+
+        wakeCommitter = start == 0;
+        sequence = ++appended_;
+    }
+    if (wakeCommitter) {
+        wake_.notify_one();
+    }
+    return sequence;
+}
+
+void BookingJournal::whenDurable(std::function<void(bool durable)> callback) {
+    bool durable;
+    {
+        TracedLock<std::mutex> lock(mutex_, "journal");
+        if (!failed_ && durable_ < appended_) {
+            waiters_.push_back({appended_, std::move(callback)});
+            return;
+        }
+        durable = !failed_;
+    }
+    callback(durable);
+}
+
+void BookingJournal::requestSnapshot() {
+    {
+        TracedLock<std::mutex> lock(mutex_, "journal");
+        snapshotRequested_ = true;
+    }
+    wake_.notify_one();
+}
+
+uint64_t BookingJournal::durableSequence() const {
+    TracedLock<std::mutex> lock(mutex_, "journal");
+    return durable_;
+}
+
+bool BookingJournal::failed() const {
+    TracedLock<std::mutex> lock(mutex_, "journal");
+    return failed_;
+}
+
+void BookingJournal::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    lastSnapshot_ = std::chrono::steady_clock::now();
+    auto hasWork = [this]() { return stopping_ || snapshotRequested_ || !pending_.empty(); };
+
+    while (true) {
+        if (options_.snapshotInterval.count() > 0) {
+            wake_.wait_until(lock, lastSnapshot_ + options_.snapshotInterval, hasWork);
+        } else {
+            wake_.wait(lock, hasWork);
+        }
+
+        // Let more bookings join the batch before paying for the sync
+        if (options_.commitDelay.count() > 0 && !pending_.empty() && !stopping_) {
+            wake_.wait_for(lock, options_.commitDelay, [this]() { return stopping_; });
+        }
+
+        commit(lock);
+
+        if (failed_) {
+            // The shows hold bookings that were refused; they must not be snapshotted
+            snapshotRequested_ = false;
+            sinceSnapshot_ = 0;
+        } else if (snapshotDue() || (stopping_ && sinceSnapshot_ > 0)) {
+            writeSnapshot(lock);
+        }
+        if (stopping_ && pending_.empty()) {
+            break;
+        }
+    }
+}
+
+void BookingJournal::commit(std::unique_lock<std::mutex>& lock) {
+    if (pending_.empty()) {
+        return;
+    }
+
+    batch_.swap(pending_);
+    if (fileSize_ == 0) {
+        // A generation's first write carries its header
+        std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        putU64(header, fingerprint_);
+        batch_.insert(0, header);
+    }
+    uint64_t target = appended_;
+    bool failed = failed_;
+    lock.unlock();
+
+    bool ok = !failed && writeAll(fd_, batch_.data(), batch_.size());
+    if (ok && options_.sync) {
+        ok = ::fdatasync(fd_) == 0;
+    }
+    if (ok) {
+        fileSize_ += batch_.size();
+    } else if (!failed) {
+        int error = errno;
+        Logger::log(LogLevel::Error, "Journal write to ", journalPath(generation_), " failed: ", std::strerror(error),
+                    "; bookings are refused until restart");
+        // Cut off the part of the batch that reached the file, so replay
+        // never stops at a torn record
+        if (::ftruncate(fd_, static_cast<off_t>(fileSize_)) != 0) {
+            Logger::log(LogLevel::Error, "Cannot truncate ", journalPath(generation_), ": ", std::strerror(errno));
+        }
+    }
+    batch_.clear();
+
+    lock.lock();
+    if (ok) {
+        sinceSnapshot_ += target - durable_;
+        durable_ = target;
+    } else {
+        failed_ = true;
+    }
+
+    auto firstPending = std::partition(waiters_.begin(), waiters_.end(),
+                                       [target](const Waiter& w) { return w.sequence <= target; });
+    std::vector<Waiter> ready(std::make_move_iterator(waiters_.begin()), std::make_move_iterator(firstPending));
+    waiters_.erase(waiters_.begin(), firstPending);
+    lock.unlock();
+
+    for (auto& waiter : ready) {
+        waiter.callback(ok);
+    }
+    lock.lock();
+}
+
+bool BookingJournal::snapshotDue() const {
+    if (snapshotRequested_) {
+        return true;
+    }
+    if (sinceSnapshot_ == 0) {
+        return false;
+    }
+    if (options_.snapshotRecords > 0 && sinceSnapshot_ >= options_.snapshotRecords) {
+        return true;
+    }
+    return options_.snapshotInterval.count() > 0 &&
+           std::chrono::steady_clock::now() >= lastSnapshot_ + options_.snapshotInterval;
+}
+
+void BookingJournal::writeSnapshot(std::unique_lock<std::mutex>& lock) {
+    snapshotRequested_ = false;
+    sinceSnapshot_ = 0;
+    lastSnapshot_ = std::chrono::steady_clock::now();
+    lock.unlock();
+
+    // Records appended from here on go to the new generation. Everything in
+    // the old one was applied to the shows before it was appended, so the
+    // bitmaps copied below contain it.
+    uint64_t nextGeneration = generation_ + 1;
+    int nextFd = openGeneration(nextGeneration);
+    if (nextFd < 0) {
+        Logger::log(LogLevel::Error, "Cannot open ", journalPath(nextGeneration), ": ", std::strerror(errno));
+        lock.lock();
+        return;
+    }
+    ::close(fd_);
+    fd_ = nextFd;
+    generation_ = nextGeneration;
+    fileSize_ = 0;
+
+    std::string data;
+    data.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    putU32(data, SNAPSHOT_VERSION);
+    putU32(data, static_cast<uint32_t>(shows_.size()));
+    putU64(data, nextGeneration);
+    putU64(data, fingerprint_);
+
+    std::vector<uint64_t> words;
+    for (const auto& show : shows_) {
+        words.resize(show.seats.wordCount());
+        show.seats.loadBookedWords(words.data());
+        putU32(data, static_cast<uint32_t>(show.seats.size()));
+        putU32(data, static_cast<uint32_t>(words.size()));
+        data.append(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+    }
+    putU32(data, crc32(data.data(), data.size()));
+
+    std::string tmpPath = snapshotPath() + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, data.data(), data.size()) && (!options_.sync || ::fsync(fd) == 0);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    ok = ok && ::rename(tmpPath.c_str(), snapshotPath().c_str()) == 0;
+    if (!ok) {
+        Logger::log(LogLevel::Error, "Snapshot write failed: ", std::strerror(errno));
+        lock.lock();
+        return;
+    }
+    syncDirectory();
+
+    std::error_code ec;
+    for (uint64_t generation : listGenerations()) {
+        if (generation < nextGeneration) {
+            std::filesystem::remove(journalPath(generation), ec);
+        }
+    }
+
+    Logger::log(LogLevel::Debug, "Snapshot written, journal generation ", nextGeneration);
+    lock.lock();
+}
+
+int BookingJournal::openGeneration(uint64_t generation) const {
+    return ::open(journalPath(generation).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+std::string BookingJournal::journalPath(uint64_t generation) const {
+    return options_.directory + "/" + std::string(JOURNAL_PREFIX) + std::to_string(generation);
+}
+
+std::string BookingJournal::snapshotPath() const {
+    return options_.directory + "/snapshot";
+}
+
+std::vector<uint64_t> BookingJournal::listGenerations() const {
+    std::vector<uint64_t> generations;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(options_.directory, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= JOURNAL_PREFIX.size() || name.compare(0, JOURNAL_PREFIX.size(), JOURNAL_PREFIX) != 0) {
+            continue;
+        }
+        uint64_t generation = 0;
+        const char* first = name.data() + JOURNAL_PREFIX.size();
+        const char* last = name.data() + name.size();
+        auto [end, err] = std::from_chars(first, last, generation);
+        if (err == std::errc() && end == last) {
+            generations.push_back(generation);
+        }
+    }
+    std::sort(generations.begin(), generations.end());
+    return generations;
+}
+
+bool BookingJournal::loadSnapshot(uint64_t& nextGeneration, RecoveryStats& stats) {
+    int fd = ::open(snapshotPath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < SNAPSHOT_HEADER_SIZE + CRC_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const char* data = static_cast<const char*>(mapping);
+
+    bool valid = std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                 crc32(data, size - CRC_SIZE) == getLE(data + size - CRC_SIZE, 4);
+    if (valid && (getLE(data + 8, 4) != SNAPSHOT_VERSION || getLE(data + 24, 8) != fingerprint_)) {
+        ::munmap(mapping, size);
+        throw std::runtime_error(snapshotPath() + " was written for a different catalogue or version");
+    }
+    if (valid) {
+        size_t showCount = getLE(data + 12, 4);
+        nextGeneration = std::max<uint64_t>(1, getLE(data + 16, 8));
+
+        size_t offset = SNAPSHOT_HEADER_SIZE;
+        size_t end = size - CRC_SIZE;
+        for (size_t i = 0; i < showCount && offset + SHOW_HEADER_SIZE <= end; ++i) {
+            size_t seatCount = getLE(data + offset, 4);
+            size_t wordCount = getLE(data + offset + 4, 4);
+            offset += SHOW_HEADER_SIZE;
+            if (wordCount > (end - offset) / sizeof(uint64_t)) {
+                break;
+            }
+            // Headers are multiples of 8 bytes, so the words are aligned in the mapping
+            if (i < shows_.size() && seatCount == shows_[i].seats.size() &&
+                wordCount == shows_[i].seats.wordCount()) {
+                shows_[i].restoreSeats(reinterpret_cast<const uint64_t*>(data + offset), wordCount);
+                ++stats.snapshotShows;
+            }
+            offset += wordCount * sizeof(uint64_t);
+        }
+    }
+
+    ::munmap(mapping, size);
+    return valid;
+}
+
+void BookingJournal::replayJournal(uint64_t generation, RecoveryStats& stats) {
+    std::string path = journalPath(generation);
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ++stats.journalFiles;
+
+    // Records name shows by position, so they only fit the catalogue they were written for
+    size_t offset = std::min(data.size(), JOURNAL_HEADER_SIZE);
+    if (data.size() >= JOURNAL_HEADER_SIZE &&
+        (std::memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+         getLE(data.data() + sizeof(JOURNAL_MAGIC), 8) != fingerprint_)) {
+        throw std::runtime_error(path + " was written for a different catalogue or version");
+    }
+    if (data.size() < JOURNAL_HEADER_SIZE) {
+        offset = 0;  // torn header, nothing was committed
+    }
+    std::vector<uint64_t> words;
+    while (offset + RECORD_HEADER_SIZE <= data.size()) {
+        const char* record = data.data() + offset;
+        auto showId = static_cast<ShowId>(getLE(record, 4));
+        size_t count = getLE(record + 4, 2);
+        size_t recordSize = RECORD_HEADER_SIZE + count * sizeof(SeatNumber) + CRC_SIZE;
+        if (offset + recordSize > data.size() ||
+            crc32(record, recordSize - CRC_SIZE) != getLE(record + recordSize - CRC_SIZE, 4)) {
+            break;
+        }
+
+        if (showId < shows_.size()) {
+            Shows& show = shows_[showId];
+            words.assign(show.seats.wordCount(), 0);
+            for (size_t i = 0; i < count; ++i) {
+                auto seat = static_cast<SeatNumber>(getLE(record + RECORD_HEADER_SIZE + i * sizeof(SeatNumber), 2));
+                if (seat >= 1 && seat <= show.seats.size()) {
+                    words[(seat - 1u) / SeatMap::WORD_BITS] |= uint64_t{1} << ((seat - 1u) % SeatMap::WORD_BITS);
+                }
+            }
+            show.restoreSeats(words.data(), words.size());
+        }
+        ++stats.journalRecords;
+        offset += recordSize;
+    }
+
+    // A crash mid-write leaves a partial record; cut it off so the file
+    // stays a clean sequence of records
+    if (offset < data.size()) {
+        stats.truncatedBytes += data.size() - offset;
+        if (::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+            Logger::log(LogLevel::Warn, "Cannot truncate ", path, ": ", std::strerror(errno));
+        }
+    }
+}
+
+void BookingJournal::syncDirectory() const {
+    if (!options_.sync) {
+        return;
+    }
+    int fd = ::open(options_.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
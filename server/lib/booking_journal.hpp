@@ -0,0 +1,215 @@
+/**
+ * @file booking_journal.hpp
+ * @brief Persistent booking journal with group commit and snapshots
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cinema.hpp"
+
+/**
+ * @struct JournalOptions
+ * @brief Location and commit policy of a BookingJournal
+ */
+struct JournalOptions {
+    std::string directory = "data";                        ///< Directory for journal and snapshot files
+    bool sync = true;                                      ///< fdatasync every commit batch
+    std::chrono::microseconds commitDelay{0};              ///< Extra wait to let a batch grow
+    std::chrono::seconds snapshotInterval{60};             ///< Longest time between snapshots
+    uint64_t snapshotRecords = 100000;                     ///< Records that trigger an early snapshot
+};
+
+/**
+ * @struct RecoveryStats
+ * @brief What BookingJournal::recover() found on disk
+ */
+struct RecoveryStats {
+    bool snapshotLoaded = false;                ///< A valid snapshot was applied
+    uint64_t snapshotShows = 0;                 ///< Shows restored from the snapshot
+    uint64_t journalFiles = 0;                  ///< Journal files replayed
+    uint64_t journalRecords = 0;                ///< Booking records replayed
+    uint64_t truncatedBytes = 0;                ///< Torn or corrupt tail bytes cut off
+    std::chrono::microseconds elapsed{0};       ///< Time spent recovering
+};
+
+/**
+ * @class BookingJournal
+ * @brief Append-only log of bookings plus periodic seat bitmap snapshots
+ *
+ * Every successful booking is appended as a small checksummed record.
+ * Records are buffered in memory and written by a committer thread, which
+ * writes and fsyncs everything that queued up during the previous commit in
+ * one go (group commit), so I/O threads never touch the disk.
+ *
+ * @par Files
+ * - journal.<generation>: a header with the catalogue fingerprint, then
+ *   records "u32 showId, u16 count, u16 seats[count], u32 crc32",
+ *   little-endian
+ * - snapshot: header, every show's seat bitmap and a trailing crc32; it
+ *   names the first journal generation not contained in it and carries
+ *   the catalogue fingerprint
+ *
+ * Shows are stored by position, so both files carry a fingerprint of
+ * every show's theater, movie, date time and seat count. Files written
+ * for another catalogue (a line inserted or moved in CATALOGUE_FILE) are
+ * refused instead of moving sold seats to other shows.
+ *
+ * @par Snapshots
+ * The committer switches to a new journal generation, copies the seat
+ * bitmaps without unconfirmed holds, writes the snapshot to a temporary
+ * file and renames it into place, then deletes the older generations. Bookings are applied in
+ * memory before they are journaled, so the copy contains every record of
+ * the older generations.
+ *
+ * @par Recovery
+ * recover() maps the snapshot, merges its bitmaps into the shows, then
+ * replays the newer journals. Bookings only ever add seats, so replay is a
+ * plain union and records already contained in the snapshot are harmless.
+ * A torn record at a journal's end is cut off.
+ *
+ * @par Write Failures
+ * If a batch cannot be written or synced, the part that reached the file
+ * is truncated away and the journal stops: the batch's waiters and every
+ * later one are told the records are not durable, nothing more is written
+ * and no snapshot is taken, so bookings that were never confirmed cannot
+ * reach the disk later. A restart recovers the last durable state.
+ *
+ * @par Thread Safety
+ * append() and whenDurable() may be called from any thread once start()
+ * has run. recover() must run before start() and before the shows are
+ * shared.
+ */
+class BookingJournal {
+public:
+    /**
+     * @brief Constructor
+     * @param shows Shows vector the journal restores and snapshots, must outlive it
+     * @param options Directory and commit policy
+     * @post Nothing is read or written until recover() or start()
+     */
+    BookingJournal(ShowStore& shows, JournalOptions options);
+
+    /**
+     * @brief Destructor
+     * @post Everything appended is committed and the committer has stopped
+     */
+    ~BookingJournal();
+
+    BookingJournal(const BookingJournal&) = delete;
+    BookingJournal& operator=(const BookingJournal&) = delete;
+
+    /**
+     * @brief Restore seat state from the snapshot and journals on disk
+     * @return Summary of what was applied
+     * @throws std::runtime_error if the directory cannot be created, or
+     *         the snapshot or a journal was written for another catalogue
+     * @note Records for unknown shows are ignored
+     */
+    RecoveryStats recover();
+
+    /**
+     * @brief Open a new journal generation and start the committer thread
+     * @throws std::runtime_error if the journal file cannot be opened
+     */
+    void start();
+
+    /**
+     * @brief Stop the committer after committing everything appended
+     * @post Waiting whenDurable() callbacks have run
+     */
+    void stop();
+
+    /**
+     * @brief Queue a booking record
+     * @param showId Show the seats were booked in
+     * @param seats Seats that were booked
+     * @return Sequence number of the record
+     * @note Never blocks on I/O
+     */
+    uint64_t append(ShowId showId, const std::vector<SeatNumber>& seats);
+    
+    /**
+     * @brief Queue a booking record
+     * @param showId Show the seats were booked in
+     * @param seats Seats that were booked
+     * @param count Number of seats in @p seats
+     * @return Sequence number of the record
+     * @note Never blocks on I/O
+     */
+    uint64_t append(ShowId showId, const SeatNumber* seats, size_t count);
+
+    /**
+     * @brief Run a callback once every record appended so far is on disk
+     * @param callback Called with true once they are, or false if a write
+     *        failed (see Write Failures); on the committer thread, or
+     *        immediately if nothing is pending or the journal has failed
+     */
+    void whenDurable(std::function<void(bool durable)> callback);
+
+    /**
+     * @brief Ask the committer to write a snapshot soon
+     */
+    void requestSnapshot();
+
+    /**
+     * @brief Get the sequence number of the last committed record
+     * @return Records known to be on disk
+     */
+    uint64_t durableSequence() const;
+
+    /**
+     * @brief Check whether a write failed and the journal stopped
+     * @return true once a commit failed, see Write Failures
+     */
+    bool failed() const;
+
+private:
+    struct Waiter {
+        uint64_t sequence;                ///< Record that must be durable
+        std::function<void(bool)> callback;   ///< Run once it is, or the write failed
+    };
+
+    void run();
+    void commit(std::unique_lock<std::mutex>& lock);
+    bool snapshotDue() const;
+    void writeSnapshot(std::unique_lock<std::mutex>& lock);
+    int openGeneration(uint64_t generation) const;
+    std::string journalPath(uint64_t generation) const;
+    std::string snapshotPath() const;
+    std::vector<uint64_t> listGenerations() const;
+    void replayJournal(uint64_t generation, RecoveryStats& stats);
+    bool loadSnapshot(uint64_t& nextGeneration, RecoveryStats& stats);
+    void syncDirectory() const;
+
+    ShowStore& shows_;                    ///< Shows restored and snapshotted
+    JournalOptions options_;              ///< Directory and commit policy
+    int fd_ = -1;                         ///< Current journal generation file
+    uint64_t generation_ = 0;             ///< Generation fd_ writes to
+    uint64_t fileSize_ = 0;               ///< Bytes of committed records in fd_, committer only
+    uint64_t fingerprint_ = 0;            ///< Hash of the show identities, see Files
+    std::chrono::steady_clock::time_point lastSnapshot_;  ///< When the last snapshot was written
+
+    mutable std::mutex mutex_;            ///< Protects the fields below
+    std::condition_variable wake_;        ///< Signals the committer
+    std::string pending_;                 ///< Encoded records not yet written
+    std::string batch_;                   ///< Records being written, committer only
+    uint64_t appended_ = 0;               ///< Sequence of the last appended record
+    uint64_t durable_ = 0;                ///< Sequence of the last committed record
+    uint64_t sinceSnapshot_ = 0;          ///< Records committed since the last snapshot
+    std::vector<Waiter> waiters_;         ///< Callbacks waiting for a commit
+    bool snapshotRequested_ = false;      ///< requestSnapshot() was called
+    bool stopping_ = false;               ///< stop() was called
+    bool failed_ = false;                 ///< A commit failed, nothing is written any more
+    std::thread committer_;               ///< Writes, syncs and snapshots
+};
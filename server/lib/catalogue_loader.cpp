@@ -0,0 +1,314 @@
+#include "catalogue_loader.hpp"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t MIN_CHUNK_BYTES = 64 * 1024;  ///< Smaller inputs are not worth another thread
+constexpr std::size_t MAX_FIELDS = 5;
+
+constexpr std::string_view DEMO_CATALOGUE =
+    "# theater|movie|date time|seats|booked seats\n"
+    "PVR|Inception|2025-09-11 19:30|20|1-2,5,10-11,14-15,19\n"
+    "PVR|Interstellar|2025-09-11 19:30|20|2,4,6,8-9,12-13,16-17,20\n"
+    "PVR|Tenet|2025-09-11 19:30|20|1,3-5,7-8,10-11,13-15,18-20\n"
+    "IMAX|Inception|2025-09-11 19:30|20|1-2,5,10-11,14-15,19\n"
+    "IMAX|Interstellar|2025-09-11 19:30|20|2,4,6,8-9,12-13,16-17,20\n"
+    "IMAX|Tenet|2025-09-11 19:30|20|1,3-5,7-8,10-11,13-15,18-20\n"
+    "Cinepolis|Inception|2025-09-11 19:30|20|1-2,5,10-11,14-15,19\n"
+    "Cinepolis|Interstellar|2025-09-11 19:30|20|2,4,6,8-9,12-13,16-17,20\n"
+    "Cinepolis|Tenet|2025-09-11 19:30|20|1,3-5,7-8,10-11,13-15,18-20\n";
+
+/**
+ * @brief One show as it appears in the text
+ */
+struct Record {
+    std::string_view theater;
+    std::string_view movie;
+    std::string_view dateTime;
+    std::string_view booked;
+    std::size_t seatCount;
+};
+
+/**
+ * @brief Lines parsed by one thread
+ */
+struct Chunk {
+    std::string_view text;
+    std::vector<Record> records;
+    std::size_t lines = 0;          ///< Lines in text, or up to the bad one
+    std::size_t firstShow = 0;      ///< Id of records[0]
+    std::string error;              ///< First error, empty if none
+};
+
+/**
+ * @brief Read-only mapping of a whole file
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open catalogue " + path + ": " + std::strerror(errno));
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot stat catalogue " + path + ": " + std::strerror(error));
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                throw std::runtime_error("Cannot map catalogue " + path + ": " + std::strerror(error));
+            }
+            data_ = static_cast<const char*>(mapping);
+            ::madvise(mapping, size_, MADV_WILLNEED);
+        } else {
+            ::close(fd);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view text() const {
+        return {data_, size_};
+    }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/**
+ * @brief Call @p seat for every seat of a booked list such as "1-2,5"
+ * @return Error message, empty if the list is valid
+ */
+template <typename Seat>
+std::string forEachBooked(std::string_view list, std::size_t seatCount, Seat&& seat) {
+    const char* pos = list.data();
+    const char* end = pos + list.size();
+    while (pos < end) {
+        std::size_t first = 0;
+        auto [next, err] = std::from_chars(pos, end, first);
+        std::size_t last = first;
+        if (err == std::errc() && next < end && *next == '-') {
+            auto [rangeEnd, rangeErr] = std::from_chars(next + 1, end, last);
+            err = rangeErr;
+            next = rangeEnd;
+        }
+        if (err != std::errc() || (next < end && *next != ',')) {
+            return "malformed booked seats \"" + std::string(list.substr(0, 32)) + "\"";
+        }
+        if (first == 0 || first > last || last > seatCount) {
+            return "booked seats " + std::to_string(first) + "-" + std::to_string(last) +
+                   " outside 1-" + std::to_string(seatCount);
+        }
+        for (std::size_t number = first; number <= last; ++number) {
+            seat(number);
+        }
+        pos = next < end ? next + 1 : end;
+    }
+    return {};
+}
+
+/**
+ * @brief Parse one non-comment line
+ * @return Error message, empty on success
+ */
+std::string parseLine(std::string_view line, Record& record) {
+    std::string_view fields[MAX_FIELDS];
+    std::size_t count = 0;
+    while (true) {
+        std::size_t separator = line.find(CatalogueLoader::FIELD_SEPARATOR);
+        if (count == MAX_FIELDS) {
+            return "more than " + std::to_string(MAX_FIELDS) + " fields";
+        }
+        fields[count++] = line.substr(0, separator);
+        if (separator == std::string_view::npos) {
+            break;
+        }
+        line.remove_prefix(separator + 1);
+    }
+    if (count < 3 || fields[0].empty() || fields[1].empty() || fields[2].empty()) {
+        return "expected theater|movie|date time[|seats[|booked seats]]";
+    }
+
+    record = Record{fields[0], fields[1], fields[2], count > 4 ? fields[4] : std::string_view{},
+                    Shows::DEFAULT_SEAT_COUNT};
+    if (count > 3 && !fields[3].empty()) {
+        const char* end = fields[3].data() + fields[3].size();
+        auto [next, err] = std::from_chars(fields[3].data(), end, record.seatCount);
+        if (err != std::errc() || next != end || record.seatCount == 0 ||
+            record.seatCount > std::numeric_limits<SeatNumber>::max()) {
+            return "invalid seat count \"" + std::string(fields[3].substr(0, 16)) + "\"";
+        }
+    }
+    return forEachBooked(record.booked, record.seatCount, [](std::size_t) {});
+}
+
+void parseChunk(Chunk& chunk) {
+    std::string_view text = chunk.text;
+    while (!text.empty()) {
+        std::size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        ++chunk.lines;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line.front() == CatalogueLoader::COMMENT) {
+            continue;
+        }
+        Record record;
+        chunk.error = parseLine(line, record);
+        if (!chunk.error.empty()) {
+            return;
+        }
+        chunk.records.push_back(record);
+    }
+}
+
+/**
+ * @brief Run work(chunk) for every chunk, the first on the calling thread
+ */
+template <typename Work>
+void forEachChunk(std::vector<Chunk>& chunks, Work&& work) {
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size() - 1);
+    for (std::size_t i = 1; i < chunks.size(); ++i) {
+        workers.emplace_back([&work, &chunks, i] { work(chunks[i]); });
+    }
+    work(chunks[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace
+
+ShowStore CatalogueLoader::loadFile(const std::string& path, unsigned threads, CatalogueStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    try {
+        ShowStore shows = parse(file.text(), threads, stats);
+        if (stats) {
+            stats->elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+        }
+        return shows;
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(path + ":" + e.what());
+    }
+}
+
+ShowStore CatalogueLoader::parse(std::string_view text, unsigned threads, CatalogueStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t chunkCount = std::clamp<std::size_t>(text.size() / MIN_CHUNK_BYTES, 1, threads);
+
+    // Split at line boundaries; a chunk may end up empty on long lines
+    std::vector<Chunk> chunks(chunkCount);
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < chunkCount; ++i) {
+        std::size_t end = text.size();
+        if (i + 1 < chunkCount) {
+            end = std::max(begin, text.size() * (i + 1) / chunkCount);
+            std::size_t newline = text.find('\n', end);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        chunks[i].text = text.substr(begin, end - begin);
+        begin = end;
+    }
+
+    forEachChunk(chunks, parseChunk);
+
+    std::size_t total = 0;
+    std::size_t seats = 0;
+    std::size_t line = 0;
+    for (auto& chunk : chunks) {
+        if (!chunk.error.empty()) {
+            throw std::runtime_error(std::to_string(line + chunk.lines) + ": " + chunk.error);
+        }
+        chunk.firstShow = total;
+        total += chunk.records.size();
+        line += chunk.lines;
+        for (const auto& record : chunk.records) {
+            seats += record.seatCount;
+        }
+    }
+    if (total >= ALL_SHOWS) {
+        throw std::runtime_error(std::to_string(total) + " shows exceed the show id range");
+    }
+
+    // Records and seats are allocated once; names are interned from the views
+    ShowStore shows;
+    shows.reserve(total, total ? (seats + total - 1) / total : 0);
+    for (const auto& chunk : chunks) {
+        for (const auto& record : chunk.records) {
+            shows.emplace_back(record.movie, record.dateTime, record.theater, record.seatCount);
+        }
+    }
+
+    // Seat maps of different shows are independent, so chunks fill their own
+    std::vector<std::size_t> booked(chunkCount, 0);
+    forEachChunk(chunks, [&shows, &booked, &chunks](Chunk& chunk) {
+        std::vector<uint64_t> words;
+        std::size_t marked = 0;
+        for (std::size_t i = 0; i < chunk.records.size(); ++i) {
+            const Record& record = chunk.records[i];
+            if (record.booked.empty()) {
+                continue;
+            }
+            SeatMap& seats = shows[chunk.firstShow + i].seats;
+            words.assign(seats.wordCount(), 0);
+            forEachBooked(record.booked, record.seatCount, [&words](std::size_t number) {
+                words[(number - 1) / SeatMap::WORD_BITS] |= uint64_t{1} << ((number - 1) % SeatMap::WORD_BITS);
+            });
+            seats.merge(words.data(), words.size());
+            for (uint64_t word : words) {
+                marked += static_cast<std::size_t>(std::popcount(word));
+            }
+        }
+        booked[static_cast<std::size_t>(&chunk - chunks.data())] = marked;
+    });
+
+    if (stats) {
+        stats->shows = shows.size();
+        stats->bookedSeats = 0;
+        for (std::size_t marked : booked) {
+            stats->bookedSeats += marked;
+        }
+        stats->bytes = text.size();
+        stats->threads = static_cast<unsigned>(chunkCount);
+        stats->elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+    }
+    return shows;
+}
+
+std::string_view CatalogueLoader::demoCatalogue() {
+    return DEMO_CATALOGUE;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file catalogue_loader.hpp
+ * @brief Builds the show list from a schedule file at startup
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cinema.hpp"
+
+/**
+ * @struct CatalogueStats
+ * @brief What CatalogueLoader did, for the startup log
+ */
+struct CatalogueStats {
+    std::size_t shows = 0;                 ///< Shows loaded
+    std::size_t bookedSeats = 0;           ///< Seats marked booked by the file
+    std::size_t bytes = 0;                 ///< Size of the parsed text
+    unsigned threads = 0;                  ///< Threads the text was parsed on
+    std::chrono::microseconds elapsed{0};  ///< Time spent loading
+};
+
+/**
+ * @class CatalogueLoader
+ * @brief Parser of the compact schedule format
+ *
+ * One show per line, fields separated by '|':
+ *
+ *     # theater|movie|date time|seats|booked seats
+ *     PVR|Inception|2025-09-11 19:30|20|1-2,5,10-11,14-15,19
+ *
+ * The seat count may be empty for Shows::DEFAULT_SEAT_COUNT and the
+ * booked list, single seats and ranges, may be left out. Blank lines and
+ * lines starting with '#' are skipped. Shows get their ids in file order.
+ *
+ * @par Loading
+ * The file is memory-mapped and split at line boundaries into one chunk
+ * per thread. Chunks are parsed and validated in parallel into views of
+ * the mapping, so the ShowStore is reserved once at its final size and
+ * filled in order. Booked seats are written straight
+ * into the seat map and do not advance Shows::stateVersion().
+ *
+ * @par Errors
+ * Malformed input throws std::runtime_error naming the first bad line;
+ * nothing is loaded in that case.
+ */
+class CatalogueLoader {
+public:
+    static constexpr char FIELD_SEPARATOR = '|';   ///< Separates the fields of a line
+    static constexpr char COMMENT = '#';           ///< Starts a comment line
+
+    /**
+     * @brief Load a schedule file
+     * @param path File to read
+     * @param threads Parse threads, 0 for one per core
+     * @param stats Output: optional load statistics
+     * @return Shows in file order
+     * @throws std::runtime_error if the file cannot be read or is malformed
+     */
+    static ShowStore loadFile(const std::string& path, unsigned threads = 0,
+                              CatalogueStats* stats = nullptr);
+
+    /**
+     * @brief Parse a schedule held in memory
+     * @param text Schedule, see class description
+     * @param threads Parse threads, 0 for one per core; small inputs use fewer
+     * @param stats Output: optional load statistics
+     * @return Shows in text order
+     * @throws std::runtime_error if @p text is malformed
+     */
+    static ShowStore parse(std::string_view text, unsigned threads = 1,
+                           CatalogueStats* stats = nullptr);
+
+    /**
+     * @brief Get the schedule served when no file is configured
+     * @return Three movies in three theaters with 20 seats each, partly booked
+     */
+    static std::string_view demoCatalogue();
+};
@@ -1,171 +1,1543 @@
 #include "cinema.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 #include <thread>
 #include <chrono>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <charconv>
+#include <memory>
+#include <new>
+#include <unordered_set>
+#include <utility>
 
-Shows::Shows(const std::string& m, const std::string& dt, const std::string& t) 
-    : movie(m), dateTime(dt), theater(t), seatsMutex(std::make_shared<std::shared_mutex>()) {
-    seats.resize(20, false);
+std::atomic<uint64_t> Shows::stateVersion_{0};
+
+namespace {
+
+using CinemaProtocol::BATCH_REQUEST;
+using CinemaProtocol::BATCH_RESULT_PREFIX;
+
+void putU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
 }
 
-std::vector<uint8_t> Shows::getAvailableSeats() const {
-    std::shared_lock<std::shared_mutex> lock(*seatsMutex);
-    std::vector<uint8_t> availableSeats;
-    for (int i = 0; i < seats.size(); ++i) {
-        if (!seats[i]) {
-            availableSeats.push_back(static_cast<uint8_t>(i + 1));
-        }
+void putU32(std::string& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
     }
-    return availableSeats;
 }
 
-bool Shows::bookSeats(const std::vector<uint8_t>& seatNumbers) {
-    std::unique_lock<std::shared_mutex> lock(*seatsMutex);
+void putU64(std::string& out, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
 
-    for (uint8_t seat : seatNumbers) {
-        if (seat < 1 || seat > seats.size() || seats[seat - 1]) {
-            return false;
+void putString(std::string& out, std::string_view value) {
+    size_t length = std::min<size_t>(value.size(), std::numeric_limits<uint16_t>::max());
+    putU16(out, static_cast<uint16_t>(length));
+    out.append(value.data(), length);
+}
+
+void putHeader(std::string& out, uint8_t type) {
+    out.push_back(static_cast<char>(BinaryProtocol::MAGIC));
+    out.push_back(static_cast<char>(BinaryProtocol::VERSION));
+    out.push_back(static_cast<char>(type));
+}
+
+std::string_view seatChangePrefix(SeatChange change) {
+    switch (change) {
+    case SeatChange::Held:
+        return CinemaProtocol::SEAT_HELD_PREFIX;
+    case SeatChange::Freed:
+        return CinemaProtocol::SEAT_FREED_PREFIX;
+    default:
+        return CinemaProtocol::SEAT_DELTA_PREFIX;
+    }
+}
+
+/**
+ * @brief Decimal text of one seat number
+ */
+struct SeatText {
+    char text[3];
+    uint8_t size;
+};
+
+constexpr size_t SEAT_TEXT_COUNT = 600;  ///< Seats whose text is looked up instead of converted
+
+constexpr std::array<SeatText, SEAT_TEXT_COUNT + 1> SEAT_TEXT = [] {
+    std::array<SeatText, SEAT_TEXT_COUNT + 1> table{};
+    for (size_t seat = 0; seat < table.size(); ++seat) {
+        SeatText& entry = table[seat];
+        if (seat >= 100) {
+            entry.text[entry.size++] = static_cast<char>('0' + seat / 100);
         }
+        if (seat >= 10) {
+            entry.text[entry.size++] = static_cast<char>('0' + seat / 10 % 10);
+        }
+        entry.text[entry.size++] = static_cast<char>('0' + seat % 10);
     }
-    for (uint8_t seat : seatNumbers) {
-        seats[seat - 1] = true;
+    return table;
+}();
+
+constexpr size_t MAX_DIGITS = std::numeric_limits<uint64_t>::digits10 + 1;  ///< Longest decimal number written
+
+/// Words of the largest seat map a show can have
+constexpr size_t MAX_SEAT_WORDS =
+    (std::numeric_limits<SeatNumber>::max() + SeatMap::WORD_BITS - 1) / SeatMap::WORD_BITS;
+
+size_t digitCount(uint64_t value) {
+    size_t digits = 1;
+    for (; value >= 10; value /= 10) {
+        ++digits;
     }
-    return true;
+    return digits;
+}
+
+/*
+ * The put helpers write into a buffer already sized for the whole message
+ * and return the end of what they wrote.
+ */
+
+char* put(char* out, std::string_view text) {
+    return std::copy(text.begin(), text.end(), out);
 }
 
-std::string CinemaService::formatCinemaData(const std::vector<Shows>& shows) {
-    std::stringstream ss;
-    ss << "=== CINEMA DATA STREAM ===\n";
+char* putNumber(char* out, uint64_t value) {
+    return std::to_chars(out, out + MAX_DIGITS, value).ptr;
+}
+
+char* putSeat(char* out, size_t seat) {
+    if (seat <= SEAT_TEXT_COUNT) {
+        const SeatText& entry = SEAT_TEXT[seat];
+        return std::copy(entry.text, entry.text + entry.size, out);
+    }
+    return putNumber(out, seat);
+}
+
+/**
+ * @brief Format a text data stream in one allocation
+ * @tparam Kind Stream to format, see CinemaProtocol::CatalogueLayout
+ *
+ * A first pass over the registry sizes the buffer for the longest text
+ * every show could produce, the second writes into it and trims the rest.
+ */
+template <CinemaProtocol::Catalogue Kind>
+std::string formatCatalogue(const ShowStore& shows, const ShowRegistry& registry) {
+    using namespace CinemaProtocol;
+    using Layout = CatalogueLayout<Kind>;
     
-    std::vector<std::string> theaters;
-    for (const auto& show : shows) {
-        if (std::find(theaters.begin(), theaters.end(), show.theater) == theaters.end()) {
-            theaters.push_back(show.theater);
+    size_t bound = Layout::HEADER.size() + MAX_DIGITS + LINE_END.size() + Layout::FOOTER.size();
+    for (size_t t = 0; t < registry.theaterCount(); ++t) {
+        bound += Layout::THEATER_FIXED_SIZE + registry.theaterName(t).size();
+        for (ShowId id : registry.theaterShows(t)) {
+            const auto& show = shows[id];
+            size_t seatCount = show.seats.size();
+            size_t seatDigits = digitCount(seatCount);
+            bound += Layout::SHOW_FIXED_SIZE + show.movie.size() + show.dateTime.size() + MAX_DIGITS +
+                     2 * seatDigits + std::max(SOLD_OUT.size(), seatCount * (seatDigits + SEAT_SEPARATOR.size()));
         }
     }
     
-    for (const auto& theaterName : theaters) {
-        ss << "Theater: " << theaterName << "\n";
-        for (const auto& show : shows) {
-            if (show.theater == theaterName) {
-                ss << "  Movie: " << show.movie << " (" << show.dateTime << ")\n";
-                ss << "    Available seats: ";
-                auto availableSeats = show.getAvailableSeats();
-                if (availableSeats.empty()) {
-                    ss << "SOLD OUT";
-                } else {
-                    for (size_t i = 0; i < availableSeats.size(); ++i) {
-                        ss << static_cast<int>(availableSeats[i]);
-                        if (i < availableSeats.size() - 1) ss << ", ";
+    std::string out(bound, '\0');
+    char* at = put(out.data(), Layout::HEADER);
+    at = putNumber(at, Shows::stateVersion());
+    at = put(at, LINE_END);
+    
+    std::array<uint64_t, MAX_SEAT_WORDS> words;
+    for (size_t t = 0; t < registry.theaterCount(); ++t) {
+        at = put(at, THEATER_PREFIX);
+        at = put(at, registry.theaterName(t));
+        at = put(at, LINE_END);
+        for (ShowId id : registry.theaterShows(t)) {
+            const auto& show = shows[id];
+            at = put(at, MOVIE_PREFIX);
+            at = put(at, show.movie);
+            at = put(at, Layout::DATE_OPEN);
+            at = put(at, show.dateTime);
+            at = put(at, Layout::CLOSE_LINE);
+            at = put(at, SHOW_ID_PREFIX);
+            at = putNumber(at, id);
+            at = put(at, LINE_END);
+            at = put(at, AVAILABLE_SEATS_PREFIX);
+            
+            size_t seatCount = show.seats.size();
+            size_t wordCount = show.seats.wordCount();
+            show.seats.loadWords(words.data());
+            size_t available = 0;
+            for (size_t w = 0; w < wordCount; ++w) {
+                uint64_t free = ~words[w];
+                size_t tail = seatCount - w * SeatMap::WORD_BITS;
+                if (tail < SeatMap::WORD_BITS) {
+                    free &= (uint64_t{1} << tail) - 1;
+                }
+                for (; free != 0; free &= free - 1) {
+                    if (available++ > 0) {
+                        at = put(at, SEAT_SEPARATOR);
                     }
+                    at = putSeat(at, w * SeatMap::WORD_BITS + std::countr_zero(free) + 1);
                 }
-                ss << " (Total: " << availableSeats.size() << "/20)\n";
+            }
+            if (available == 0) {
+                at = put(at, SOLD_OUT);
+            }
+            at = put(at, TOTAL_PREFIX);
+            at = putNumber(at, available);
+            at = put(at, Layout::TOTAL_SEPARATOR);
+            at = putNumber(at, seatCount);
+            at = put(at, Layout::CLOSE_LINE);
+        }
+        at = put(at, LINE_END);
+    }
+    at = put(at, Layout::FOOTER);
+    out.resize(static_cast<size_t>(at - out.data()));
+    return out;
+}
+
+}
+
+SeatMap::SeatMap(size_t seatCount)
+    : SeatMap(seatCount, nullptr) {
+}
+
+SeatMap::SeatMap(size_t seatCount, std::atomic<uint64_t>* storage)
+    : seatCount_(seatCount),
+      wordCount_((seatCount + WORD_BITS - 1) / WORD_BITS) {
+    attach(storage);
+}
+
+SeatMap::SeatMap(const SeatMap& other)
+    : seatCount_(other.seatCount_),
+      wordCount_(other.wordCount_) {
+    attach(nullptr);
+    copyFrom(other);
+}
+
+SeatMap& SeatMap::operator=(const SeatMap& other) {
+    if (this != &other) {
+        if (wordCount_ != other.wordCount_) {
+            wordCount_ = other.wordCount_;
+            attach(nullptr);
+        }
+        seatCount_ = other.seatCount_;
+        copyFrom(other);
+    }
+    return *this;
+}
+
+SeatMap& SeatMap::operator=(const std::vector<bool>& pattern) {
+    size_t wordCount = (pattern.size() + WORD_BITS - 1) / WORD_BITS;
+    seatCount_ = pattern.size();
+    if (wordCount != wordCount_) {
+        wordCount_ = wordCount;
+        attach(nullptr);
+    }
+    for (size_t w = 0; w < wordCount_; ++w) {
+        held_[w].store(0, std::memory_order_relaxed);
+        uint64_t word = 0;
+        for (size_t bit = 0; bit < WORD_BITS && w * WORD_BITS + bit < seatCount_; ++bit) {
+            if (pattern[w * WORD_BITS + bit]) {
+                word |= uint64_t{1} << bit;
             }
         }
-        ss << "\n";
+        words_[w].store(word, std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+size_t SeatMap::storageWords(size_t seatCount) {
+    return 2 * ((seatCount + WORD_BITS - 1) / WORD_BITS);
+}
+
+void SeatMap::attach(std::atomic<uint64_t>* storage) {
+    if (storage) {
+        owned_.reset();
+    } else {
+        owned_ = std::make_unique<std::atomic<uint64_t>[]>(2 * wordCount_);
+        storage = owned_.get();
+    }
+    words_ = storage;
+    held_ = storage + wordCount_;
+    for (size_t i = 0; i < 2 * wordCount_; ++i) {
+        storage[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool SeatMap::operator[](size_t index) const {
+    uint64_t word = words_[index / WORD_BITS].load(std::memory_order_acquire);
+    return (word >> (index % WORD_BITS)) & 1;
+}
+
+size_t SeatMap::size() const {
+    return seatCount_;
+}
+
+size_t SeatMap::availableCount() const {
+    size_t count = 0;
+    scan([&count]() { count = 0; },
+         [this, &count](size_t w, uint64_t word) {
+             count += static_cast<size_t>(std::popcount(~word & validMask(w)));
+         });
+    return count;
+}
+
+std::vector<SeatNumber> SeatMap::availableSeats() const {
+    std::vector<SeatNumber> seats;
+    scan([&seats]() { seats.clear(); },
+         [this, &seats](size_t w, uint64_t word) {
+             uint64_t free = ~word & validMask(w);
+             while (free) {
+                 seats.push_back(static_cast<SeatNumber>(w * WORD_BITS + std::countr_zero(free) + 1));
+                 free &= free - 1;
+             }
+         });
+    return seats;
+}
+
+SeatNumber SeatMap::findFreeRun(size_t length) const {
+    length = std::max<size_t>(length, 1);
+    size_t found = 0;
+    size_t carry = 0;        // free seats ending at the top of the previous word
+    size_t carryStart = 0;   // index of the first of them
+    scan([&found, &carry]() { found = 0; carry = 0; },
+         [this, length, &found, &carry, &carryStart](size_t w, uint64_t word) {
+             if (found) {
+                 return;
+             }
+             uint64_t free = ~word & validMask(w);
+             size_t base = w * WORD_BITS;
+             if (carry > 0) {
+                 size_t low = static_cast<size_t>(std::countr_one(free));
+                 if (carry + low >= length) {
+                     found = carryStart + 1;
+                     return;
+                 }
+                 if (low == WORD_BITS) {
+                     carry += WORD_BITS;
+                     return;
+                 }
+             }
+             if (length <= WORD_BITS) {
+                 // Bit i survives if seats i .. i+length-1 are all free
+                 uint64_t starts = free;
+                 for (size_t covered = 1; covered < length && starts;) {
+                     size_t shift = std::min(covered, length - covered);
+                     starts &= starts >> shift;
+                     covered += shift;
+                 }
+                 if (starts) {
+                     found = base + static_cast<size_t>(std::countr_zero(starts)) + 1;
+                     return;
+                 }
+             }
+             carry = static_cast<size_t>(std::countl_one(free));
+             carryStart = base + WORD_BITS - carry;
+         });
+    return static_cast<SeatNumber>(found);
+}
+
+template <typename Update>
+void SeatMap::write(Update&& update) {
+    // Readers retry while this counter is non-zero or the generation moved,
+    // so they never observe a half-claimed or rolled back booking
+    TraceScope trace("seats", "seat write");
+    activeWriters_.fetch_add(1, std::memory_order_seq_cst);
+    update();
+    generation_.fetch_add(1, std::memory_order_seq_cst);
+    activeWriters_.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+bool SeatMap::tryBook(const SeatNumber* seatNumbers, size_t count) {
+    return claimSeats(seatNumbers, count, false);
+}
+
+bool SeatMap::tryHold(const SeatNumber* seatNumbers, size_t count) {
+    return claimSeats(seatNumbers, count, true);
+}
+
+bool SeatMap::releaseHeld(const SeatNumber* seatNumbers, size_t count) {
+    bool released = false;
+    write([&]() {
+        for (size_t i = 0; i < count; ++i) {
+            if (seatNumbers[i] < 1 || seatNumbers[i] > seatCount_) {
+                continue;
+            }
+            size_t index = seatNumbers[i] - 1u;
+            uint64_t bit = uint64_t{1} << (index % WORD_BITS);
+            if (held_[index / WORD_BITS].fetch_and(~bit, std::memory_order_acq_rel) & bit) {
+                words_[index / WORD_BITS].fetch_and(~bit, std::memory_order_acq_rel);
+                released = true;
+            }
+        }
+    });
+    return released;
+}
+
+bool SeatMap::confirmHeld(const SeatNumber* seatNumbers, size_t count) {
+    std::vector<uint64_t> masks(wordCount_, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (seatNumbers[i] < 1 || seatNumbers[i] > seatCount_) {
+            return false;
+        }
+        size_t index = seatNumbers[i] - 1u;
+        masks[index / WORD_BITS] |= uint64_t{1} << (index % WORD_BITS);
+    }
+
+    bool confirmed = true;
+    write([&]() {
+        size_t cleared = 0;
+        for (; cleared < masks.size(); ++cleared) {
+            if (!masks[cleared]) {
+                continue;
+            }
+            uint64_t previous = held_[cleared].fetch_and(~masks[cleared], std::memory_order_acq_rel);
+            if ((previous & masks[cleared]) != masks[cleared]) {
+                // Put back the holds of this word that were cleared, then the earlier words
+                held_[cleared].fetch_or(previous & masks[cleared], std::memory_order_acq_rel);
+                confirmed = false;
+                break;
+            }
+        }
+        for (size_t w = 0; !confirmed && w < cleared; ++w) {
+            if (masks[w]) {
+                held_[w].fetch_or(masks[w], std::memory_order_acq_rel);
+            }
+        }
+    });
+    return confirmed;
+}
+
+bool SeatMap::settle(const SeatNumber* seatNumbers, size_t count) {
+    std::vector<uint64_t> masks(wordCount_, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (seatNumbers[i] >= 1 && seatNumbers[i] <= seatCount_) {
+            size_t index = seatNumbers[i] - 1u;
+            masks[index / WORD_BITS] |= uint64_t{1} << (index % WORD_BITS);
+        }
     }
     
-    ss << "=== END CINEMA DATA ===\n";
-    return ss.str();
+    bool changed = false;
+    write([&]() {
+        for (size_t w = 0; w < masks.size(); ++w) {
+            if (!masks[w]) {
+                continue;
+            }
+            uint64_t taken = words_[w].fetch_or(masks[w], std::memory_order_acq_rel);
+            uint64_t held = held_[w].fetch_and(~masks[w], std::memory_order_acq_rel);
+            changed |= (~taken & masks[w]) != 0 || (held & masks[w]) != 0;
+        }
+    });
+    return changed;
+}
+
+size_t SeatMap::heldCount() const {
+    size_t count = 0;
+    scan([&count]() { count = 0; },
+         [this, &count](size_t w, uint64_t) {
+             count += static_cast<size_t>(std::popcount(held_[w].load(std::memory_order_acquire)));
+         });
+    return count;
 }
 
-std::string CinemaService::formatUpdateData(const std::vector<Shows>& shows) {
-    std::stringstream ss;
-    ss << "BOOKING_UPDATE:\n=== UPDATED CINEMA DATA ===\n";
+bool SeatMap::claimSeats(const SeatNumber* seatNumbers, size_t count, bool hold) {
+    if (count == 0) {
+        return true;
+    }
     
-    // Group shows by theater for display
-    std::vector<std::string> theaters;
-    for (const auto& show : shows) {
-        if (std::find(theaters.begin(), theaters.end(), show.theater) == theaters.end()) {
-            theaters.push_back(show.theater);
+    size_t firstWord = wordCount_;
+    size_t lastWord = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (seatNumbers[i] < 1 || seatNumbers[i] > seatCount_) {
+            return false;
         }
+        size_t w = (seatNumbers[i] - 1u) / WORD_BITS;
+        firstWord = std::min(firstWord, w);
+        lastWord = std::max(lastWord, w);
     }
     
-    for (const auto& theaterName : theaters) {
-        ss << "Theater: " << theaterName << "\n";
-        for (const auto& show : shows) {
-            if (show.theater == theaterName) {
-                ss << "  Movie: " << show.movie << " (" << show.dateTime << ")\n";
-                ss << "    Available seats: ";
-                auto availableSeats = show.getAvailableSeats();
-                if (availableSeats.empty()) {
-                    ss << "SOLD OUT";
-                } else {
-                    for (size_t i = 0; i < availableSeats.size(); ++i) {
-                        ss << static_cast<int>(availableSeats[i]);
-                        if (i < availableSeats.size() - 1) ss << ", ";
-                    }
-                }
-                ss << " (Total: " << availableSeats.size() << "/20)\n";
+    // Common case: every seat sits in one word, one CAS books them all.
+    // Holds update two words and always take the writer path.
+    if (firstWord == lastWord && !hold) {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < count; ++i) {
+            mask |= uint64_t{1} << ((seatNumbers[i] - 1u) % WORD_BITS);
+        }
+        return claim(firstWord, mask);
+    }
+    
+    std::vector<uint64_t> masks(lastWord - firstWord + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = seatNumbers[i] - 1u;
+        masks[index / WORD_BITS - firstWord] |= uint64_t{1} << (index % WORD_BITS);
+    }
+    
+    bool booked = true;
+    write([&]() {
+        size_t claimed = 0;
+        for (; claimed < masks.size(); ++claimed) {
+            if (masks[claimed] && !claim(firstWord + claimed, masks[claimed])) {
+                booked = false;
+                break;
+            }
+        }
+        for (size_t i = 0; i < claimed; ++i) {
+            if (masks[i] && !booked) {
+                words_[firstWord + i].fetch_and(~masks[i], std::memory_order_acq_rel);
+            } else if (masks[i] && hold) {
+                held_[firstWord + i].fetch_or(masks[i], std::memory_order_acq_rel);
+            }
+        }
+    });
+    return booked;
+}
+
+size_t SeatMap::wordCount() const {
+    return wordCount_;
+}
+
+void SeatMap::loadWords(uint64_t* out) const {
+    scan([]() {},
+         [out](size_t w, uint64_t word) {
+             out[w] = word;
+         });
+}
+
+void SeatMap::loadBookedWords(uint64_t* out) const {
+    scan([]() {},
+         [this, out](size_t w, uint64_t word) {
+             out[w] = word & ~held_[w].load(std::memory_order_acquire);
+         });
+}
+
+bool SeatMap::merge(const uint64_t* words, size_t count) {
+    count = std::min(count, wordCount_);
+    bool changed = false;
+    
+    write([&]() {
+        for (size_t w = 0; w < count; ++w) {
+            uint64_t bits = words[w] & validMask(w);
+            if (bits) {
+                uint64_t previous = words_[w].fetch_or(bits, std::memory_order_acq_rel);
+                changed |= (previous | bits) != previous;
             }
         }
-        ss << "\n";
+    });
+    return changed;
+}
+
+uint64_t SeatMap::validMask(size_t wordIndex) const {
+    size_t bits = std::min(WORD_BITS, seatCount_ - wordIndex * WORD_BITS);
+    return bits == WORD_BITS ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+bool SeatMap::claim(size_t wordIndex, uint64_t mask) {
+    auto& word = words_[wordIndex];
+    uint64_t current = word.load(std::memory_order_relaxed);
+    do {
+        if (current & mask) {
+            return false;
+        }
+    } while (!word.compare_exchange_weak(current, current | mask,
+                                         std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+}
+
+template <typename Reset, typename Visit>
+void SeatMap::scan(Reset&& reset, Visit&& visit) const {
+    // Only a read that had to wait for a writer is traced
+    TraceStamp waitStarted = 0;
+    for (;;) {
+        uint64_t generation = generation_.load(std::memory_order_seq_cst);
+        if (activeWriters_.load(std::memory_order_seq_cst) != 0) {
+            if (waitStarted == 0 && Tracer::enabled()) {
+                waitStarted = Tracer::now();
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        
+        reset();
+        for (size_t w = 0; w < wordCount_; ++w) {
+            visit(w, words_[w].load(std::memory_order_acquire));
+        }
+        
+        if (activeWriters_.load(std::memory_order_seq_cst) == 0 &&
+            generation_.load(std::memory_order_seq_cst) == generation) {
+            if (waitStarted != 0) {
+                Tracer::complete("seats", "seat read retry", waitStarted, Tracer::now());
+            }
+            return;
+        }
+        if (waitStarted == 0 && Tracer::enabled()) {
+            waitStarted = Tracer::now();
+        }
+    }
+}
+
+void SeatMap::copyFrom(const SeatMap& other) {
+    other.scan([]() {},
+               [this, &other](size_t w, uint64_t word) {
+                   words_[w].store(word, std::memory_order_relaxed);
+                   held_[w].store(other.held_[w].load(std::memory_order_acquire), std::memory_order_relaxed);
+               });
+}
+
+namespace {
+
+/**
+ * @brief State behind NameTable
+ */
+struct NameArena {
+    std::mutex mutex;
+    std::unordered_set<std::string_view> names;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = 0;
+    size_t blockSize = 0;
+    size_t bytes = 0;
+};
+
+NameArena& nameArena() {
+    static NameArena arena;
+    return arena;
+}
+
+}
+
+std::string_view NameTable::intern(std::string_view name) {
+    NameArena& arena = nameArena();
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    auto it = arena.names.find(name);
+    if (it != arena.names.end()) {
+        return *it;
+    }
+    if (arena.blockSize - arena.blockUsed < name.size()) {
+        // Long names get a block of their own
+        arena.blockSize = std::max(BLOCK_BYTES, name.size());
+        arena.blocks.push_back(std::make_unique<char[]>(arena.blockSize));
+        arena.blockUsed = 0;
+    }
+    char* stored = arena.blocks.back().get() + arena.blockUsed;
+    std::copy(name.begin(), name.end(), stored);
+    arena.blockUsed += name.size();
+    arena.bytes += name.size();
+    return *arena.names.emplace(stored, name.size()).first;
+}
+
+size_t NameTable::size() {
+    NameArena& arena = nameArena();
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    return arena.names.size();
+}
+
+size_t NameTable::bytes() {
+    NameArena& arena = nameArena();
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    return arena.bytes;
+}
+
+Shows::Shows(std::string_view m, std::string_view dt, std::string_view t, size_t seatCount)
+    : seats(seatCount), movie(NameTable::intern(m)), dateTime(NameTable::intern(dt)), theater(NameTable::intern(t)) {
+}
+
+Shows::Shows(std::string_view m, std::string_view dt, std::string_view t, size_t seatCount,
+             std::atomic<uint64_t>* seatStorage)
+    : seats(seatCount, seatStorage), movie(NameTable::intern(m)), dateTime(NameTable::intern(dt)),
+      theater(NameTable::intern(t)) {
+}
+
+std::vector<SeatNumber> Shows::getAvailableSeats() const {
+    return seats.availableSeats();
+}
+
+size_t Shows::availableSeatCount() const {
+    return seats.availableCount();
+}
+
+bool Shows::bookSeats(const std::vector<SeatNumber>& seatNumbers) {
+    uint64_t version = 0;
+    return bookSeats(seatNumbers, version);
+}
+
+bool Shows::bookSeats(const std::vector<uint8_t>& seatNumbers) {
+    return bookSeats(std::vector<SeatNumber>(seatNumbers.begin(), seatNumbers.end()));
+}
+
+bool Shows::bookSeats(const std::vector<SeatNumber>& seatNumbers, uint64_t& version) {
+    return bookSeats(seatNumbers.data(), seatNumbers.size(), version);
+}
+
+bool Shows::bookSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version) {
+    if (!seats.tryBook(seatNumbers, count)) {
+        return false;
+    }
+    if (count > 0) {
+        version = stateVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    } else {
+        version = stateVersion();
+    }
+    return true;
+}
+
+bool Shows::holdSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version) {
+    if (count == 0 || !seats.tryHold(seatNumbers, count)) {
+        return false;
+    }
+    version = stateVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    return true;
+}
+
+bool Shows::releaseSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version) {
+    if (!seats.releaseHeld(seatNumbers, count)) {
+        return false;
+    }
+    version = stateVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    return true;
+}
+
+bool Shows::confirmSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version) {
+    if (count == 0 || !seats.confirmHeld(seatNumbers, count)) {
+        return false;
+    }
+    version = stateVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    return true;
+}
+
+bool Shows::settleSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version) {
+    if (!seats.settle(seatNumbers, count)) {
+        version = stateVersion();
+        return false;
+    }
+    version = stateVersion_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    return true;
+}
+
+bool Shows::restoreSeats(const uint64_t* words, size_t count) {
+    if (!seats.merge(words, count)) {
+        return false;
+    }
+    stateVersion_.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+}
+
+uint64_t Shows::stateVersion() {
+    return stateVersion_.load(std::memory_order_acquire);
+}
+
+ShowStore::ShowStore(std::initializer_list<Shows> shows) {
+    reserve(shows.size());
+    for (const Shows& show : shows) {
+        push_back(show);
+    }
+}
+
+ShowStore::ShowStore(ShowStore&& other) noexcept
+    : slabs_(std::move(other.slabs_)),
+      size_(std::exchange(other.size_, 0)),
+      seatBlocks_(std::move(other.seatBlocks_)),
+      seatBlockWords_(std::exchange(other.seatBlockWords_, 0)),
+      seatBlockUsed_(std::exchange(other.seatBlockUsed_, 0)),
+      reservedSeatWords_(std::exchange(other.reservedSeatWords_, 0)) {
+}
+
+ShowStore& ShowStore::operator=(ShowStore&& other) noexcept {
+    if (this != &other) {
+        clear();
+        slabs_ = std::move(other.slabs_);
+        size_ = std::exchange(other.size_, 0);
+        seatBlocks_ = std::move(other.seatBlocks_);
+        seatBlockWords_ = std::exchange(other.seatBlockWords_, 0);
+        seatBlockUsed_ = std::exchange(other.seatBlockUsed_, 0);
+        reservedSeatWords_ = std::exchange(other.reservedSeatWords_, 0);
     }
+    return *this;
+}
+
+ShowStore::~ShowStore() {
+    clear();
+}
+
+Shows& ShowStore::emplace_back(std::string_view movie, std::string_view dateTime, std::string_view theater,
+                               size_t seatCount) {
+    void* slot = nextRecord();
+    std::atomic<uint64_t>* seats = allocateSeats(SeatMap::storageWords(seatCount));
+    Shows* show = new (slot) Shows(movie, dateTime, theater, seatCount, seats);
+    ++size_;
+    return *show;
+}
+
+Shows& ShowStore::push_back(const Shows& show) {
+    Shows& copy = emplace_back(show.movie, show.dateTime, show.theater, show.seats.size());
+    copy.seats = show.seats;
+    return copy;
+}
+
+void ShowStore::reserve(size_t shows, size_t seatsPerShow) {
+    slabs_.reserve((shows + SLAB_SHOWS - 1) / SLAB_SHOWS);
+    while (slabs_.size() * SLAB_SHOWS < shows) {
+        slabs_.push_back(std::make_unique_for_overwrite<Slab>());
+    }
+    // One block for all of them, so their seats end up contiguous
+    size_t lineWords = CACHE_LINE_SIZE / sizeof(uint64_t);
+    size_t perShow = (SeatMap::storageWords(seatsPerShow) + lineWords - 1) / lineWords * lineWords;
+    size_t missing = shows > size_ ? (shows - size_) * perShow : 0;
+    if (missing > seatBlockWords_ - seatBlockUsed_) {
+        reservedSeatWords_ = missing;
+    }
+}
+
+void ShowStore::clear() {
+    for (size_t id = size_; id > 0; --id) {
+        record(id - 1).~Shows();
+    }
+    size_ = 0;
+    slabs_.clear();
+    seatBlocks_.clear();
+    seatBlockWords_ = 0;
+    seatBlockUsed_ = 0;
+    reservedSeatWords_ = 0;
+}
+
+void ShowStore::SeatBlockDeleter::operator()(std::atomic<uint64_t>* words) const {
+    ::operator delete[](words, std::align_val_t{CACHE_LINE_SIZE});
+}
+
+std::atomic<uint64_t>* ShowStore::allocateSeats(size_t words) {
+    // Whole cache lines per show keep bookings of neighbours apart
+    size_t lineWords = CACHE_LINE_SIZE / sizeof(uint64_t);
+    words = std::max<size_t>(1, (words + lineWords - 1) / lineWords) * lineWords;
+    if (seatBlockWords_ - seatBlockUsed_ < words) {
+        size_t blockWords = std::max({SEAT_BLOCK_WORDS, reservedSeatWords_, words});
+        reservedSeatWords_ = 0;
+        void* raw = ::operator new[](blockWords * sizeof(std::atomic<uint64_t>), std::align_val_t{CACHE_LINE_SIZE});
+        auto* block = static_cast<std::atomic<uint64_t>*>(raw);
+        std::uninitialized_value_construct_n(block, blockWords);
+        seatBlocks_.emplace_back(block);
+        seatBlockWords_ = blockWords;
+        seatBlockUsed_ = 0;
+    }
+    std::atomic<uint64_t>* seats = seatBlocks_.back().get() + seatBlockUsed_;
+    seatBlockUsed_ += words;
+    return seats;
+}
+
+void* ShowStore::nextRecord() {
+    if (size_ == slabs_.size() * SLAB_SHOWS) {
+        slabs_.push_back(std::make_unique_for_overwrite<Slab>());
+    }
+    return slabs_[size_ / SLAB_SHOWS]->bytes + (size_ % SLAB_SHOWS) * sizeof(Shows);
+}
+
+ShowRegistry::ShowRegistry(const ShowStore& shows)
+    : size_(shows.size()) {
+    theaterIds_.reserve(shows.size());
+    movieIds_.reserve(shows.size());
+    showsByTitle_.reserve(shows.size());
     
-    ss << "=== END UPDATED DATA ===\n";
-    return ss.str();
+    for (size_t i = 0; i < shows.size(); ++i) {
+        const auto& show = shows[i];
+        ShowId id = static_cast<ShowId>(i);
+        
+        auto [theater, newTheater] = theaterIds_.try_emplace(show.theater, static_cast<uint32_t>(theaterNames_.size()));
+        if (newTheater) {
+            theaterNames_.push_back(show.theater);
+            showsByTheater_.emplace_back();
+        }
+        auto movie = movieIds_.try_emplace(show.movie, static_cast<uint32_t>(movieIds_.size())).first;
+        
+        showsByTheater_[theater->second].push_back(id);
+        showsByTitle_[titleKey(theater->second, movie->second)].push_back({show.dateTime, id});
+    }
 }
 
-BookingService::BookingResult BookingService::processBooking(const std::string& message, std::vector<Shows>& shows) {
-    std::vector<std::string> parts;
-    std::stringstream ss(message);
-    std::string item;
+std::optional<ShowId> ShowRegistry::find(std::string_view theater, std::string_view movie, std::string_view dateTime) const {
+    const auto* entries = findTitle(theater, movie);
+    if (entries) {
+        for (const auto& entry : *entries) {
+            if (entry.dateTime == dateTime) {
+                return entry.id;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<ShowId> ShowRegistry::find(std::string_view theater, std::string_view movie) const {
+    size_t at = movie.rfind(CinemaProtocol::SHOWTIME_SEPARATOR);
+    if (at != std::string_view::npos) {
+        return find(theater, movie.substr(0, at), movie.substr(at + 1));
+    }
+    const auto* entries = findTitle(theater, movie);
+    if (entries) {
+        return entries->front().id;
+    }
+    return std::nullopt;
+}
+
+size_t ShowRegistry::theaterCount() const {
+    return theaterNames_.size();
+}
+
+std::string_view ShowRegistry::theaterName(size_t theaterIndex) const {
+    return theaterNames_[theaterIndex];
+}
+
+const std::vector<ShowId>& ShowRegistry::theaterShows(size_t theaterIndex) const {
+    return showsByTheater_[theaterIndex];
+}
+
+size_t ShowRegistry::size() const {
+    return size_;
+}
+
+uint64_t ShowRegistry::titleKey(uint32_t theaterId, uint32_t movieId) {
+    return (static_cast<uint64_t>(theaterId) << 32) | movieId;
+}
+
+const std::vector<ShowRegistry::TitleEntry>* ShowRegistry::findTitle(std::string_view theater, std::string_view movie) const {
+    auto theaterIt = theaterIds_.find(theater);
+    if (theaterIt == theaterIds_.end()) {
+        return nullptr;
+    }
+    auto movieIt = movieIds_.find(movie);
+    if (movieIt == movieIds_.end()) {
+        return nullptr;
+    }
+    auto it = showsByTitle_.find(titleKey(theaterIt->second, movieIt->second));
+    return it == showsByTitle_.end() ? nullptr : &it->second;
+}
+
+std::string CinemaService::formatCinemaData(const ShowStore& shows) {
+    return formatCinemaData(shows, ShowRegistry(shows));
+}
+
+std::string CinemaService::formatCinemaData(const ShowStore& shows, const ShowRegistry& registry) {
+    return formatCatalogue<CinemaProtocol::Catalogue::Full>(shows, registry);
+}
+
+std::string CinemaService::formatUpdateData(const ShowStore& shows) {
+    return formatUpdateData(shows, ShowRegistry(shows));
+}
+
+std::string CinemaService::formatUpdateData(const ShowStore& shows, const ShowRegistry& registry) {
+    return formatCatalogue<CinemaProtocol::Catalogue::Update>(shows, registry);
+}
+
+CinemaSnapshot::CinemaSnapshot(const ShowStore& shows)
+    : shows_(shows), registry_(nullptr) {
+}
+
+CinemaSnapshot::CinemaSnapshot(const ShowStore& shows, const ShowRegistry& registry)
+    : shows_(shows), registry_(&registry) {
+}
+
+SharedPayload CinemaSnapshot::cinemaData() {
+    return load(cinemaData_, Stream::Cinema);
+}
+
+SharedPayload CinemaSnapshot::updateData() {
+    return load(updateData_, Stream::Update);
+}
+
+SharedPayload CinemaSnapshot::binaryData() {
+    return load(binaryData_, Stream::Binary);
+}
+
+uint64_t CinemaSnapshot::version() const {
+    auto entry = cinemaData_.current.load(std::memory_order_acquire);
+    return entry ? entry->version : 0;
+}
+
+SharedPayload CinemaSnapshot::load(Slot& slot, Stream stream) {
+    auto entry = slot.current.load(std::memory_order_acquire);
+    if (entry && entry->version == Shows::stateVersion()) {
+        return entry->payload;
+    }
+    
+    TracedLock<std::mutex> lock(slot.rebuildMutex, "snapshot rebuild");
+    
+    // Another reader may have rebuilt while we waited for the lock
+    entry = slot.current.load(std::memory_order_acquire);
+    uint64_t version = Shows::stateVersion();
+    if (entry && entry->version == version) {
+        return entry->payload;
+    }
+    
+    // The version is read before formatting, so a booking racing with the
+    // rebuild only makes the entry look stale, never fresher than it is
+    auto started = std::chrono::steady_clock::now();
+    auto rebuilt = std::make_shared<const Entry>(Entry{version, std::make_shared<const std::string>(format(stream))});
+    ServerMetrics::instance().formatting.observe(std::chrono::steady_clock::now() - started);
+    slot.current.store(rebuilt, std::memory_order_release);
+    return rebuilt->payload;
+}
+
+std::string CinemaSnapshot::format(Stream stream) const {
+    TraceScope trace("format", stream == Stream::Binary   ? "binary catalogue"
+                               : stream == Stream::Update ? "update catalogue"
+                                                          : "text catalogue");
+    if (stream == Stream::Binary) {
+        return registry_ ? CinemaService::encodeCatalogue(shows_, *registry_)
+                         : CinemaService::encodeCatalogue(shows_, ShowRegistry(shows_));
+    }
+    if (registry_) {
+        return stream == Stream::Update ? CinemaService::formatUpdateData(shows_, *registry_)
+                                        : CinemaService::formatCinemaData(shows_, *registry_);
+    }
+    return stream == Stream::Update ? CinemaService::formatUpdateData(shows_)
+                                    : CinemaService::formatCinemaData(shows_);
+}
+
+std::string CinemaService::formatSeatDelta(uint64_t sequence, size_t showId, const std::vector<SeatNumber>& seatNumbers) {
+    return formatSeatDelta(sequence, showId, seatNumbers.data(), seatNumbers.size());
+}
+
+std::string CinemaService::formatSeatDelta(uint64_t sequence, size_t showId, const SeatNumber* seatNumbers, size_t count,
+                                           SeatChange change) {
+    std::string_view prefix = seatChangePrefix(change);
+    std::string delta(prefix.size() + 2 * (MAX_DIGITS + 1) + count * (MAX_DIGITS + 1), '\0');
+    char* at = put(delta.data(), prefix);
+    at = putNumber(at, sequence);
+    *at++ = ':';
+    at = putNumber(at, showId);
+    *at++ = ':';
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            *at++ = ',';
+        }
+        at = putSeat(at, seatNumbers[i]);
+    }
+    delta.resize(static_cast<size_t>(at - delta.data()));
+    return delta;
+}
+
+std::string CinemaService::encodeCatalogue(const ShowStore& shows, const ShowRegistry& registry) {
+    std::string frame;
+    putHeader(frame, BinaryProtocol::CATALOGUE);
+    putU64(frame, Shows::stateVersion());
+    putU32(frame, static_cast<uint32_t>(registry.theaterCount()));
     
-    while (std::getline(ss, item, ',')) {
-        parts.push_back(item);
+    std::vector<uint64_t> words;
+    for (size_t t = 0; t < registry.theaterCount(); ++t) {
+        putString(frame, registry.theaterName(t));
+        putU32(frame, static_cast<uint32_t>(registry.theaterShows(t).size()));
+        for (ShowId id : registry.theaterShows(t)) {
+            const auto& show = shows[id];
+            putU32(frame, id);
+            putString(frame, show.movie);
+            putString(frame, show.dateTime);
+            putU16(frame, static_cast<uint16_t>(show.seats.size()));
+            
+            words.resize(show.seats.wordCount());
+            show.seats.loadWords(words.data());
+            size_t byteCount = (show.seats.size() + 7) / 8;
+            for (size_t b = 0; b < byteCount; ++b) {
+                frame.push_back(static_cast<char>((words[b / 8] >> ((b % 8) * 8)) & 0xFF));
+            }
+        }
     }
+    return frame;
+}
+
+std::string CinemaService::encodeSeatDelta(uint64_t sequence, size_t showId, const std::vector<SeatNumber>& seatNumbers) {
+    return encodeSeatDelta(sequence, showId, seatNumbers.data(), seatNumbers.size());
+}
+
+std::string CinemaService::encodeSeatDelta(uint64_t sequence, size_t showId, const SeatNumber* seatNumbers, size_t count,
+                                           SeatChange change) {
+    std::string frame;
+    frame.reserve(BinaryProtocol::HEADER_SIZE + 14 + 2 * count);
+    putHeader(frame, change == SeatChange::Freed ? BinaryProtocol::SEAT_FREED : BinaryProtocol::SEAT_DELTA);
+    putU64(frame, sequence);
+    putU32(frame, static_cast<uint32_t>(showId));
+    putU16(frame, static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        putU16(frame, seatNumbers[i]);
+    }
+    return frame;
+}
+
+BookingService::BookingResult BookingService::processBooking(const std::string& message, ShowStore& shows) {
+    ShowRegistry registry(shows);
+    CinemaSnapshot snapshot(shows, registry);
+    return processBooking(message, shows, registry, snapshot);
+}
+
+BookingService::BookingResult BookingService::processBooking(const std::string& message, ShowStore& shows,
+                                                             const ShowRegistry& registry, CinemaSnapshot& snapshot,
+                                                             const BookingCallback& onBooked) {
+    BookingResult result = reserveSeats(message, shows, registry, onBooked);
+    if (result.success) {
+        result.message += "\n\n" + *snapshot.cinemaData();
+    }
+    return result;
+}
+
+std::optional<std::string> BookingService::parseBooking(std::string_view message, const ShowStore& shows,
+                                                        const ShowRegistry& registry, ParsedBooking& parsed) {
+    // Request text echoed in errors is cut short
+    auto quote = [](std::string_view token) { return std::string(token.substr(0, 16)); };
     
-    if (parts.size() < 3) {
-        return {false, "ERROR: Invalid booking format. Use: theater,movie,seat1,seat2,...\n\n" + CinemaService::formatCinemaData(shows), false};
+    size_t theaterEnd = message.find(',');
+    size_t movieEnd = theaterEnd == std::string_view::npos ? theaterEnd : message.find(',', theaterEnd + 1);
+    if (movieEnd == std::string_view::npos || movieEnd + 1 == message.size()) {
+        return "ERROR: Invalid booking format. Use: theater,movie,seat1,seat2,...";
     }
     
-    std::string theaterName = parts[0];
-    std::string movieName = parts[1];
+    parsed.theater = message.substr(0, theaterEnd);
+    parsed.movie = message.substr(theaterEnd + 1, movieEnd - theaterEnd - 1);
     
-    std::vector<uint8_t> seatNumbers;
-    for (size_t i = 2; i < parts.size(); ++i) {
-        try {
-            int seatNum = std::stoi(parts[i]);
-            if (seatNum > 0 && seatNum <= 20) {
-                seatNumbers.push_back(static_cast<uint8_t>(seatNum));
-            } else {
-                return {false, "ERROR: Invalid seat number " + parts[i] + ". Must be 1-20.\n\n" + CinemaService::formatCinemaData(shows), false};
+    std::string_view list = message.substr(movieEnd + 1);
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view token = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        
+        size_t first = token.find_first_not_of(' ');
+        token = first == std::string_view::npos ? std::string_view{} : token.substr(first, token.find_last_not_of(' ') - first + 1);
+        
+        unsigned seat = 0;
+        const char* last = token.data() + token.size();
+        auto [end, err] = std::from_chars(token.data() + (!token.empty() && token[0] == '-'), last, seat);
+        if (end != last || err == std::errc::invalid_argument) {
+            return "ERROR: Invalid seat number format: " + quote(token);
+        }
+        if (err != std::errc() || token[0] == '-' || seat == 0 || seat > std::numeric_limits<SeatNumber>::max()) {
+            return "ERROR: Invalid seat number " + quote(token) + ". Must be a positive seat number.";
+        }
+        if (!parsed.seats.push(static_cast<SeatNumber>(seat))) {
+            return "ERROR: Too many seats. At most " + std::to_string(SeatBuffer::CAPACITY) + " per booking.";
+        }
+    }
+    
+    auto id = registry.find(parsed.theater, parsed.movie);
+    if (!id) {
+        return "ERROR: Show not found - " + quote(parsed.movie) + " at " + quote(parsed.theater);
+    }
+    parsed.showId = *id;
+    
+    size_t seatCount = shows[*id].seats.size();
+    for (SeatNumber seat : parsed.seats) {
+        if (seat > seatCount) {
+            return "ERROR: Invalid seat number " + std::to_string(seat) + ". Must be 1-" + std::to_string(seatCount) + ".";
+        }
+    }
+    return std::nullopt;
+}
+
+std::string BookingService::describeSeats(const SeatNumber* seats, size_t count) {
+    std::string out;
+    out.reserve(count * 7);
+    char digits[8];
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out.append(", ");
+        }
+        auto [end, err] = std::to_chars(digits, digits + sizeof(digits), seats[i]);
+        out.append(digits, end);
+    }
+    return out;
+}
+
+BookingService::BookingResult BookingService::reserveSeats(std::string_view message, ShowStore& shows,
+                                                           const ShowRegistry& registry, const BookingCallback& onBooked) {
+    auto fail = [](std::string status, bool conflict = false) -> BookingResult {
+        ServerMetrics& metrics = ServerMetrics::instance();
+        (conflict ? metrics.bookingsConflicted : metrics.bookingsRejected).inc();
+        std::string message = status;
+        return {false, std::move(message), false, "", "", std::move(status)};
+    };
+    
+    ParsedBooking booking;
+    if (auto error = parseBooking(message, shows, registry, booking)) {
+        return fail(std::move(*error));
+    }
+    
+    uint64_t sequence = 0;
+    if (!shows[booking.showId].bookSeats(booking.seats.data(), booking.seats.size(), sequence)) {
+        return fail("ERROR: One or more seats are already booked or invalid", true);
+    }
+    
+    // "SUCCESS: Booked seats 3, 4 for <movie> at <theater>"
+    std::string status = "SUCCESS: Booked seats ";
+    status.append(describeSeats(booking.seats.data(), booking.seats.size()));
+    status.append(" for ").append(booking.movie).append(" at ").append(booking.theater);
+    
+    ServerMetrics::instance().bookingsSucceeded.inc();
+    if (onBooked) {
+        onBooked(booking.showId, booking.seats.data(), booking.seats.size());
+    }
+    std::string response = status;
+    return {true, std::move(response), true,
+            CinemaService::formatSeatDelta(sequence, booking.showId, booking.seats.data(), booking.seats.size()),
+            CinemaService::encodeSeatDelta(sequence, booking.showId, booking.seats.data(), booking.seats.size()),
+            std::move(status), booking.showId};
+}
+
+std::string MessageHandler::handleMessage(const std::string& received, ShowStore& shows, bool& shouldBroadcast) {
+    ShowRegistry registry(shows);
+    CinemaSnapshot snapshot(shows, registry);
+    BroadcastPayload broadcast;
+    SharedPayload response = handleMessage(received, shows, registry, snapshot, WireFormat::Text, broadcast);
+    shouldBroadcast = broadcast.text != nullptr;
+    return *response;
+}
+
+SharedPayload MessageHandler::handleMessage(const std::string& received, ShowStore& shows,
+                                            const ShowRegistry& registry, CinemaSnapshot& snapshot,
+                                            WireFormat format, BroadcastPayload& broadcast,
+                                            const BookingCallback& onBooked,
+                                            const BookingForwarder& forward,
+                                            const ReplyCallback& reply) {
+    broadcast = {};
+    bool binary = format == WireFormat::Binary;
+    
+    if (received == "get_data" || received == "refresh") {
+        return binary ? snapshot.binaryData() : snapshot.cinemaData();
+    } else if (received.compare(0, BATCH_REQUEST.size(), BATCH_REQUEST) == 0 &&
+               (received.size() == BATCH_REQUEST.size() || received[BATCH_REQUEST.size()] == '\n')) {
+        return handleBatch(received, shows, registry, broadcast, onBooked, forward, reply);
+    } else if (received.find(',') != std::string::npos) {
+        if (forward && reply) {
+            std::string_view request(received);
+            size_t theaterEnd = request.find(',');
+            size_t movieEnd = request.find(',', theaterEnd + 1);
+            if (movieEnd != std::string_view::npos) {
+                auto id = registry.find(request.substr(0, theaterEnd),
+                                        request.substr(theaterEnd + 1, movieEnd - theaterEnd - 1));
+                if (id && forward(*id, received, format, reply)) {
+                    return nullptr;
+                }
             }
-        } catch (const std::exception& e) {
-            return {false, "ERROR: Invalid seat number format: " + parts[i] + "\n\n" + CinemaService::formatCinemaData(shows), false};
         }
+        auto result = BookingService::processBooking(received, shows, registry, snapshot, onBooked);
+        if (result.shouldBroadcast) {
+            broadcast.text = std::make_shared<const std::string>(std::move(result.delta));
+            broadcast.binary = std::make_shared<const std::string>(std::move(result.binaryDelta));
+            broadcast.show = result.showId;
+        }
+        return std::make_shared<const std::string>(std::move(binary ? result.status : result.message));
+    } else if (binary) {
+        return std::make_shared<const std::string>("Echo: " + received);
+    } else {
+        return std::make_shared<const std::string>("Echo: " + received + "\n\n" + *snapshot.cinemaData());
+    }
+}
+
+SharedPayload MessageHandler::handleBatch(const std::string& received, ShowStore& shows,
+                                          const ShowRegistry& registry, BroadcastPayload& broadcast,
+                                          const BookingCallback& onBooked,
+                                          const BookingForwarder& forward,
+                                          const ReplyCallback& reply) {
+    broadcast = {};
+    
+    // Item lines after the "batch" line
+    std::vector<std::string_view> lines;
+    std::string_view rest(received);
+    rest.remove_prefix(std::min(rest.size(), BATCH_REQUEST.size() + 1));
+    while (!rest.empty() && lines.size() <= MAX_BATCH_ITEMS) {
+        size_t newline = rest.find('\n');
+        std::string_view line = rest.substr(0, newline);
+        rest = newline == std::string_view::npos ? std::string_view{} : rest.substr(newline + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty() || lines.size() > MAX_BATCH_ITEMS) {
+        ServerMetrics::instance().bookingsRejected.inc();
+        return std::make_shared<const std::string>(
+            "ERROR: Invalid batch. Use: batch, then one <id>:theater,movie,seat1,... line per booking (at most " +
+            std::to_string(MAX_BATCH_ITEMS) + ")");
     }
+    ServerMetrics::instance().batchedBookings.inc(lines.size());
     
-    for (auto& show : shows) {
-        if (show.theater == theaterName && show.movie == movieName) {
-            if (show.bookSeats(seatNumbers)) {
-                std::string response = "SUCCESS: Booked seats ";
-                for (size_t i = 0; i < seatNumbers.size(); ++i) {
-                    response += std::to_string(seatNumbers[i]);
-                    if (i < seatNumbers.size() - 1) response += ", ";
+    // Forwarded items are answered later; the result goes out once the last
+    // of them, or the local pass if it finishes last, is done
+    struct Pending {
+        std::mutex mutex;
+        std::vector<std::string> ids;
+        std::vector<std::string> results;
+        size_t outstanding = 1;
+        ReplyCallback reply;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->results.resize(lines.size());
+    pending->reply = reply;
+    for (std::string_view line : lines) {
+        pending->ids.emplace_back(line.substr(0, std::min(line.find(':'), line.size())));
+    }
+    auto compose = [](const Pending& batch) {
+        std::string out = std::string(BATCH_RESULT_PREFIX) + std::to_string(batch.results.size());
+        for (size_t i = 0; i < batch.results.size(); ++i) {
+            out += '\n';
+            out += batch.ids[i];
+            out += ':';
+            out += batch.results[i];
+        }
+        return std::make_shared<const std::string>(std::move(out));
+    };
+    
+    std::string text;
+    std::string binary;
+    ShowId show = ALL_SHOWS;
+    bool mixed = false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        size_t colon = lines[i].find(':');
+        if (colon == std::string_view::npos) {
+            ServerMetrics::instance().bookingsRejected.inc();
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->ids[i].clear();
+            pending->results[i] = "ERROR: Invalid batch item. Use: <id>:theater,movie,seat1,...";
+            continue;
+        }
+        std::string_view booking = lines[i].substr(colon + 1);
+        
+        if (forward && reply) {
+            size_t theaterEnd = booking.find(',');
+            size_t movieEnd = theaterEnd == std::string_view::npos ? theaterEnd : booking.find(',', theaterEnd + 1);
+            auto id = movieEnd == std::string_view::npos ? std::nullopt
+                    : registry.find(booking.substr(0, theaterEnd), booking.substr(theaterEnd + 1, movieEnd - theaterEnd - 1));
+            if (id) {
+                {
+                    std::lock_guard<std::mutex> lock(pending->mutex);
+                    ++pending->outstanding;
+                }
+                // The binary format makes the owner reply with the status line only
+                bool taken = forward(*id, std::string(booking), WireFormat::Binary, [pending, compose, i](SharedPayload answer) {
+                    std::unique_lock<std::mutex> lock(pending->mutex);
+                    pending->results[i] = answer->substr(0, answer->find('\n'));
+                    if (--pending->outstanding == 0) {
+                        SharedPayload result = compose(*pending);
+                        lock.unlock();
+                        pending->reply(std::move(result));
+                    }
+                });
+                if (taken) {
+                    continue;
                 }
-                response += " for " + movieName + " at " + theaterName + "\n\n";
-                response += CinemaService::formatCinemaData(shows);
-                return {true, response, true};
+                std::lock_guard<std::mutex> lock(pending->mutex);
+                --pending->outstanding;
+            }
+        }
+        
+        auto result = BookingService::reserveSeats(booking, shows, registry, onBooked);
+        if (result.shouldBroadcast) {
+            // Same layout as deltas merged in the outbound queue
+            if (!text.empty()) {
+                text += '\n';
+                binary.append(result.binaryDelta, BinaryProtocol::HEADER_SIZE, std::string::npos);
+            } else {
+                binary = std::move(result.binaryDelta);
+            }
+            text += result.delta;
+            mixed = mixed || (show != ALL_SHOWS && show != result.showId);
+            show = result.showId;
+        }
+        std::lock_guard<std::mutex> lock(pending->mutex);
+        pending->results[i] = std::move(result.status);
+    }
+    
+    if (!text.empty()) {
+        broadcast.text = std::make_shared<const std::string>(std::move(text));
+        broadcast.binary = std::make_shared<const std::string>(std::move(binary));
+        broadcast.show = mixed ? ALL_SHOWS : show;
+    }
+    
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    if (--pending->outstanding == 0) {
+        return compose(*pending);
+    }
+    return nullptr;
+}
+
+bool MessageHandler::isBookingRequest(std::string_view received) {
+    return received.find(',') != std::string_view::npos ||
+           (received.starts_with(BATCH_REQUEST) &&
+            (received.size() == BATCH_REQUEST.size() || received[BATCH_REQUEST.size()] == '\n'));
+}
+
+SharedPayload MessageHandler::unsavedReply(const SharedPayload& reply) {
+    constexpr std::string_view success = "SUCCESS";
+    constexpr std::string_view unsaved = CinemaProtocol::BOOKING_UNSAVED;
+    
+    std::string_view text(*reply);
+    std::string out;
+    // A forwarded reply keeps the prefix routing it to the original session
+    if (text.starts_with(CinemaProtocol::FORWARDED_PREFIX)) {
+        size_t idEnd = text.find(':', CinemaProtocol::FORWARDED_PREFIX.size());
+        if (idEnd != std::string_view::npos) {
+            out.append(text.substr(0, idEnd + 1));
+            text.remove_prefix(idEnd + 1);
+        }
+    }
+    
+    bool changed = false;
+    if (text.starts_with(BATCH_RESULT_PREFIX)) {
+        // "<id>:<status>" lines after the count line
+        size_t lineEnd = text.find('\n');
+        out.append(text.substr(0, lineEnd));
+        while (lineEnd != std::string_view::npos) {
+            text.remove_prefix(lineEnd + 1);
+            lineEnd = text.find('\n');
+            std::string_view line = text.substr(0, lineEnd);
+            size_t colon = line.find(':');
+            out += '\n';
+            if (colon != std::string_view::npos && line.substr(colon + 1).starts_with(success)) {
+                out.append(line.substr(0, colon + 1));
+                out.append(unsaved);
+                changed = true;
             } else {
-                return {false, "ERROR: One or more seats are already booked or invalid\n\n" + CinemaService::formatCinemaData(shows), false};
+                out.append(line);
             }
         }
+    } else if (text.starts_with(success)) {
+        out.append(unsaved);
+        changed = true;
+    }
+    return changed ? std::make_shared<const std::string>(std::move(out)) : reply;
+}
+
+bool MessageHandler::applyRelayedDelta(const std::string& delta, ShowStore& shows,
+                                       BroadcastPayload& broadcast, const BookingCallback& onBooked) {
+    broadcast = {};
+    SeatChange change = SeatChange::Booked;
+    std::string_view prefix;
+    for (SeatChange kind : {SeatChange::Booked, SeatChange::Held, SeatChange::Freed}) {
+        if (delta.compare(0, seatChangePrefix(kind).size(), seatChangePrefix(kind)) == 0) {
+            change = kind;
+            prefix = seatChangePrefix(kind);
+        }
+    }
+    if (prefix.empty()) {
+        return false;
+    }
+    
+    // SEAT_DELTA:<sequence>:<showId>:<seats>, the sender's sequence is not used
+    size_t sequenceEnd = delta.find(':', prefix.size());
+    size_t showEnd = sequenceEnd == std::string::npos ? std::string::npos : delta.find(':', sequenceEnd + 1);
+    if (showEnd == std::string::npos) {
+        return false;
+    }
+    
+    ShowId showId = 0;
+    const char* first = delta.data() + sequenceEnd + 1;
+    const char* last = delta.data() + showEnd;
+    auto [showPtr, showErr] = std::from_chars(first, last, showId);
+    if (showErr != std::errc() || showPtr != last || showId >= shows.size()) {
+        return false;
+    }
+    
+    Shows& show = shows[showId];
+    std::vector<SeatNumber> seatNumbers;
+    const char* cursor = delta.data() + showEnd + 1;
+    const char* end = delta.data() + delta.size();
+    while (cursor < end) {
+        SeatNumber seat = 0;
+        auto [next, err] = std::from_chars(cursor, end, seat);
+        if (err != std::errc() || seat == 0 || seat > show.seats.size()) {
+            return false;
+        }
+        seatNumbers.push_back(seat);
+        cursor = next;
+        if (cursor < end && *cursor++ != ',') {
+            return false;
+        }
+    }
+    if (seatNumbers.empty()) {
+        return false;
     }
     
-    return {false, "ERROR: Show not found - " + movieName + " at " + theaterName + "\n\n" + CinemaService::formatCinemaData(shows), false};
+    uint64_t sequence = 0;
+    if (change == SeatChange::Held) {
+        // Only the owner expires holds; a mirror that already sees some of
+        // the seats taken keeps them as they are
+        if (!show.holdSeats(seatNumbers.data(), seatNumbers.size(), sequence)) {
+            sequence = Shows::stateVersion();
+        }
+    } else if (change == SeatChange::Freed) {
+        if (!show.releaseSeats(seatNumbers.data(), seatNumbers.size(), sequence)) {
+            sequence = Shows::stateVersion();
+        }
+    } else if (!show.bookSeats(seatNumbers, sequence)) {
+        // Some seats were already known here, possibly as a confirmed hold;
+        // settle them all as one state change, so clients see no gap
+        show.settleSeats(seatNumbers.data(), seatNumbers.size(), sequence);
+    }
+    if (onBooked && change == SeatChange::Booked) {
+        onBooked(showId, seatNumbers.data(), seatNumbers.size());
+    }
+    ServerMetrics::instance().relayedDeltas.inc();
+    
+    broadcast.text = std::make_shared<const std::string>(
+        CinemaService::formatSeatDelta(sequence, showId, seatNumbers.data(), seatNumbers.size(), change));
+    broadcast.binary = std::make_shared<const std::string>(
+        CinemaService::encodeSeatDelta(sequence, showId, seatNumbers.data(), seatNumbers.size(), change));
+    broadcast.show = showId;
+    return true;
 }
 
-std::string MessageHandler::handleMessage(const std::string& received, std::vector<Shows>& shows, bool& shouldBroadcast) {
-    shouldBroadcast = false;
+std::optional<SubscriptionRequest> MessageHandler::parseSubscription(const std::string& received, const ShowRegistry& registry) {
+    constexpr std::string_view subscribePrefix = CinemaProtocol::SUBSCRIBE_PREFIX;
+    constexpr std::string_view unsubscribePrefix = CinemaProtocol::UNSUBSCRIBE_PREFIX;
     
-    if (received == "get_data" || received == "refresh") {
-        return CinemaService::formatCinemaData(shows);
-    } else if (received.find(',') != std::string::npos) {
-        auto result = BookingService::processBooking(received, shows);
-        shouldBroadcast = result.shouldBroadcast;
-        return result.message;
+    SubscriptionRequest request;
+    request.showCount = static_cast<ShowId>(registry.size());
+    std::string_view rest(received);
+    if (rest.substr(0, subscribePrefix.size()) == subscribePrefix) {
+        rest.remove_prefix(subscribePrefix.size());
+    } else if (rest.substr(0, unsubscribePrefix.size()) == unsubscribePrefix) {
+        request.subscribe = false;
+        rest.remove_prefix(unsubscribePrefix.size());
     } else {
-        return "Echo: " + received + "\n\n" + CinemaService::formatCinemaData(shows);
+        return std::nullopt;
+    }
+    
+    if (rest == "all") {
+        request.allShows = true;
+        return request;
     }
-}
\ No newline at end of file
+    
+    size_t colon = rest.find(':');
+    if (colon == std::string_view::npos) {
+        return std::nullopt;
+    }
+    std::string_view kind = rest.substr(0, colon);
+    std::string_view list = rest.substr(colon + 1);
+    if (kind != "show" && kind != "theater") {
+        return std::nullopt;
+    }
+    
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        
+        if (kind == "show") {
+            ShowId id = 0;
+            auto [end, err] = std::from_chars(item.data(), item.data() + item.size(), id);
+            if (err == std::errc() && end == item.data() + item.size() && id < registry.size()) {
+                request.shows.push_back(id);
+            }
+        } else {
+            for (size_t t = 0; t < registry.theaterCount(); ++t) {
+                if (registry.theaterName(t) == item) {
+                    const auto& ids = registry.theaterShows(t);
+                    request.shows.insert(request.shows.end(), ids.begin(), ids.end());
+                }
+            }
+        }
+    }
+    
+    if (request.shows.empty()) {
+        return std::nullopt;
+    }
+    return request;
+}
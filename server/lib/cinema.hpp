@@ -11,11 +11,386 @@
 #include <vector>
 #include <string>
 #include <cstdint>
-#include <shared_mutex>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <sstream>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <array>
+#include <compare>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include "cinema_protocol.hpp"
+
+/**
+ * @brief Immutable, reference-counted message payload
+ * 
+ * Lets one formatted payload be handed to many readers without copying it.
+ */
+using SharedPayload = std::shared_ptr<const std::string>;
+
+/**
+ * @brief Encoding a client session has negotiated for data streams
+ */
+enum class WireFormat : uint8_t {
+	Text,    ///< Human-readable text streams (default)
+	Binary   ///< Compact binary frames, see BinaryProtocol
+};
+
+/**
+ * @brief Dense show identifier: the show's index in the ShowStore
+ */
+using ShowId = uint32_t;
+
+/**
+ * @brief Alignment that keeps independently written data on separate cache lines
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief ShowId of a broadcast that concerns every show
+ */
+constexpr ShowId ALL_SHOWS = std::numeric_limits<ShowId>::max();
+
+/**
+ * @struct BroadcastPayload
+ * @brief One broadcast message encoded for every wire format
+ * 
+ * Each session picks the encoding it negotiated, so a delta is built once
+ * per format and shared by all sessions using it.
+ */
+struct BroadcastPayload {
+	SharedPayload text;    ///< Text encoding, null if nothing to broadcast
+	SharedPayload binary;  ///< Binary encoding, null to fall back to text
+	ShowId show = ALL_SHOWS;  ///< Show the update is about; only its subscribers get it
+};
+
+/**
+ * @brief What happened to the seats listed in a seat delta
+ * 
+ * Selects the text prefix (SEAT_DELTA:, SEAT_HELD:, SEAT_FREED:) and the
+ * binary message type of formatSeatDelta() and encodeSeatDelta().
+ */
+enum class SeatChange : uint8_t {
+	Booked,  ///< Seats were booked
+	Held,    ///< Seats were held, see SeatHolds; clients show them taken
+	Freed    ///< A hold was released or expired and the seats are free again
+};
+
+/**
+ * @struct SubscriptionRequest
+ * @brief Parsed subscribe or unsubscribe request of a client
+ * 
+ * Sessions start subscribed to every show. Subscribing to individual
+ * shows or theaters narrows that to the listed shows; "all" restores it.
+ */
+struct SubscriptionRequest {
+	bool subscribe = true;        ///< false to stop watching the shows
+	bool allShows = false;        ///< Applies to every show; @p shows is ignored
+	std::vector<ShowId> shows;    ///< Shows to start or stop watching
+	ShowId showCount = 0;         ///< Shows in the catalogue, to narrow "all" on unsubscribe
+};
+
+/**
+ * @brief 1-based seat number within a show
+ */
+using SeatNumber = uint16_t;
+
+/**
+ * @class SeatMap
+ * @brief Runtime-sized seat bitmap stored as atomic 64-bit words
+ * 
+ * Bit i of the map is set when seat i+1 is booked. Availability counts use
+ * popcount and free-seat lists are built with bit-scan over whole words.
+ * 
+ * @par Holds
+ * A held seat is booked in the map and also marked in a second bitmap, so
+ * it looks taken to everyone but can be released again or confirmed into a
+ * booking. Holding, releasing and confirming always go through the
+ * multi-word writer protocol below, so readers see both bitmaps change
+ * together; loadBookedWords() leaves held seats out.
+ * 
+ * @par Booking
+ * tryBook() is lock-free and all-or-nothing. Seats that fall in a single
+ * word (any 64 consecutive seats aligned to a word) are booked with one
+ * compare-and-swap. Bookings spanning several words CAS the words in
+ * ascending order and roll back already claimed words on conflict; while
+ * such a booking is in flight its seats can briefly look taken to a
+ * concurrent booker, but never to readers (see below).
+ * 
+ * @par Readers
+ * availableSeats() and availableCount() return a consistent view: they
+ * retry if a multi-word booking was in flight while they scanned, so a
+ * partially applied or rolled back booking is never observed.
+ * 
+ * @par Storage
+ * Both bitmaps sit in one block of storageWords() words, the held bits
+ * right after the booked ones. The map allocates the block itself unless
+ * given one, as ShowStore does to keep the seats of all shows together.
+ * 
+ * @par Thread Safety
+ * tryBook(), the query functions and copying are thread-safe.
+ * Assignment from a pattern rewrites the storage without the writer
+ * protocol and is meant for setup before the map is shared.
+ */
+class SeatMap {
+public:
+	static constexpr size_t WORD_BITS = 64;  ///< Seats per storage word
+	
+	/**
+	 * @brief Constructor
+	 * @param seatCount Number of seats in the auditorium
+	 * @pre seatCount fits SeatNumber
+	 * @post All seats are available
+	 */
+	explicit SeatMap(size_t seatCount);
+	
+	/**
+	 * @brief Constructor using storage owned by the caller
+	 * @param seatCount Number of seats in the auditorium
+	 * @param storage Block of storageWords(seatCount) words, outliving the map
+	 * @pre seatCount fits SeatNumber
+	 * @post All seats are available
+	 */
+	SeatMap(size_t seatCount, std::atomic<uint64_t>* storage);
+	
+	/**
+	 * @brief Get the storage a map of some size uses
+	 * @param seatCount Number of seats in the auditorium
+	 * @return Words of the booked and held bitmaps together
+	 */
+	static size_t storageWords(size_t seatCount);
+	
+	/**
+	 * @brief Copy constructor
+	 * @param other Map to copy a consistent view of
+	 */
+	SeatMap(const SeatMap& other);
+	
+	/**
+	 * @brief Copy assignment
+	 * @param other Map to copy a consistent view of
+	 * @return Reference to this map
+	 */
+	SeatMap& operator=(const SeatMap& other);
+	
+	/**
+	 * @brief Replace seat state with a pattern
+	 * @param pattern Seat status (false=available, true=booked); its size
+	 *        becomes the seat count
+	 * @return Reference to this map
+	 * @note Not thread-safe, meant for initialization
+	 */
+	SeatMap& operator=(const std::vector<bool>& pattern);
+	
+	/**
+	 * @brief Get booking state of a seat
+	 * @param index 0-based seat index
+	 * @return true if booked, false if available
+	 */
+	bool operator[](size_t index) const;
+	
+	/**
+	 * @brief Get number of seats
+	 * @return Seat count
+	 */
+	size_t size() const;
+	
+	/**
+	 * @brief Count available seats with popcount
+	 * @return Number of free seats
+	 */
+	size_t availableCount() const;
+	
+	/**
+	 * @brief List available seats with bit-scan
+	 * @return Ascending 1-based seat numbers of free seats
+	 */
+	std::vector<SeatNumber> availableSeats() const;
+	
+	/**
+	 * @brief Find the lowest run of adjacent free seats
+	 * @param length Seats in the run, at least 1
+	 * @return First seat number of the run, or 0 if there is none
+	 * @note Runs inside a word are found with shift-and folding over the
+	 *       whole word, runs across words by carrying the free bits at the
+	 *       top of each word into the next
+	 */
+	SeatNumber findFreeRun(size_t length) const;
+	
+	/**
+	 * @brief Book seats with compare-and-swap, all-or-nothing
+	 * @param seatNumbers 1-based seats to book; duplicates are allowed
+	 * @param count Number of entries in @p seatNumbers
+	 * @return true if every seat was free and is now booked
+	 * @retval false if any seat is out of range or already booked; no seat
+	 *         is modified in that case
+	 */
+	bool tryBook(const SeatNumber* seatNumbers, size_t count);
+	
+	/**
+	 * @brief Hold seats: book them and mark them held, all-or-nothing
+	 * @param seatNumbers 1-based seats to hold; duplicates are allowed
+	 * @param count Number of entries in @p seatNumbers
+	 * @return true if every seat was free and is now held
+	 */
+	bool tryHold(const SeatNumber* seatNumbers, size_t count);
+	
+	/**
+	 * @brief Make held seats available again
+	 * @param seatNumbers 1-based seats to release
+	 * @param count Number of entries in @p seatNumbers
+	 * @return true if any listed seat was held; seats not held are untouched
+	 */
+	bool releaseHeld(const SeatNumber* seatNumbers, size_t count);
+	
+	/**
+	 * @brief Turn held seats into permanent bookings, all-or-nothing
+	 * @param seatNumbers 1-based seats to confirm
+	 * @param count Number of entries in @p seatNumbers
+	 * @return true if every listed seat was held; otherwise no hold changes
+	 */
+	bool confirmHeld(const SeatNumber* seatNumbers, size_t count);
+	
+	/**
+	 * @brief Book seats for good whether they are free or held
+	 * @param seatNumbers 1-based seats; out-of-range entries are ignored
+	 * @param count Number of entries in @p seatNumbers
+	 * @return true if any seat was booked or had its hold confirmed
+	 * @note Readers never see a seat booked but still held in between
+	 */
+	bool settle(const SeatNumber* seatNumbers, size_t count);
+	
+	/**
+	 * @brief Count held seats
+	 * @return Seats booked by a hold that is not confirmed yet
+	 */
+	size_t heldCount() const;
+	
+	/**
+	 * @brief Get number of storage words
+	 * @return ceil(size() / WORD_BITS)
+	 */
+	size_t wordCount() const;
+	
+	/**
+	 * @brief Copy a consistent view of the seat bits
+	 * @param out Destination for wordCount() words, bit set = booked
+	 */
+	void loadWords(uint64_t* out) const;
+	
+	/**
+	 * @brief Copy a consistent view of the booked seats, without holds
+	 * @param out Destination for wordCount() words, bit set = booked for good
+	 * @note Used for snapshots, which must not persist unconfirmed holds
+	 */
+	void loadBookedWords(uint64_t* out) const;
+	
+	/**
+	 * @brief Mark seats booked from a bitmap, keeping seats already booked
+	 * @param words Bit set = booked, bits beyond size() are ignored
+	 * @param count Number of words in @p words; extra words are ignored
+	 * @return true if any seat changed from available to booked
+	 * @note Thread-safe; used to restore persisted state
+	 */
+	bool merge(const uint64_t* words, size_t count);
+
+private:
+	size_t seatCount_;                                 ///< Number of seats
+	size_t wordCount_;                                 ///< Number of storage words
+	std::unique_ptr<std::atomic<uint64_t>[]> owned_;   ///< Storage allocated by the map, null if external
+	std::atomic<uint64_t>* words_;                     ///< Seat bits, 1 = booked
+	std::atomic<uint64_t>* held_;                      ///< Subset of words_ that is only held
+	mutable std::atomic<uint32_t> activeWriters_{0};   ///< Multi-word bookings in flight
+	mutable std::atomic<uint64_t> generation_{0};      ///< Completed multi-word bookings
+	
+	/**
+	 * @brief Point the bitmaps at a new block of cleared storage
+	 * @param storage Block of storageWords() words, or null to allocate one
+	 */
+	void attach(std::atomic<uint64_t>* storage);
+	
+	/**
+	 * @brief Mask of the bits of a word that map to real seats
+	 * @param wordIndex Storage word index
+	 */
+	uint64_t validMask(size_t wordIndex) const;
+	
+	/**
+	 * @brief Claim bits in one word with a CAS loop
+	 * @return false if any bit of @p mask is already set
+	 */
+	bool claim(size_t wordIndex, uint64_t mask);
+	
+	/**
+	 * @brief Claim seats in every word they touch, all-or-nothing
+	 * @param hold Also mark the seats held
+	 * @return false if any seat is out of range or already booked
+	 */
+	bool claimSeats(const SeatNumber* seatNumbers, size_t count, bool hold);
+	
+	/**
+	 * @brief Run an update of several words inside the writer protocol
+	 * @param update Called with no arguments while readers are held off
+	 */
+	template <typename Update>
+	void write(Update&& update);
+	
+	/**
+	 * @brief Read every word inside a consistent window
+	 * @param reset Called before each scan attempt
+	 * @param visit Called as visit(wordIndex, word) for every word
+	 * @note Retries while multi-word bookings overlap the scan
+	 */
+	template <typename Reset, typename Visit>
+	void scan(Reset&& reset, Visit&& visit) const;
+	
+	/**
+	 * @brief Copy a consistent view of another map's words into this one
+	 * @param other Source map
+	 */
+	void copyFrom(const SeatMap& other);
+};
+
+/**
+ * @class NameTable
+ * @brief Process-wide arena of interned show names
+ * 
+ * Movie, theater and date strings repeat across thousands of shows, so
+ * each distinct string is stored once in large blocks and shows keep
+ * views of it. Interned names never move and live until the process
+ * exits, which also makes them safe keys for indexes such as ShowRegistry.
+ * 
+ * @par Thread Safety
+ * intern() takes a mutex; reading an interned name needs no lock.
+ */
+class NameTable {
+public:
+	static constexpr size_t BLOCK_BYTES = 64 * 1024;  ///< Arena block size
+	
+	/**
+	 * @brief Get the interned copy of a name
+	 * @param name Name to look up or add
+	 * @return View of the stored name, the same for equal names
+	 */
+	static std::string_view intern(std::string_view name);
+	
+	/**
+	 * @brief Count distinct interned names
+	 */
+	static size_t size();
+	
+	/**
+	 * @brief Get the arena bytes taken by interned names
+	 */
+	static size_t bytes();
+};
 
 /**
  * @class Shows
@@ -25,19 +400,37 @@
  * Provides thread-safe operations for managing seat availability and bookings.
  * 
  * @par Thread Safety
- * All operations are thread-safe using shared_mutex for concurrent access.
+ * Seats live in a lock-free SeatMap, so booking and availability queries
+ * never take a lock.
+ * 
+ * @par Seat Count
+ * Sized at construction (DEFAULT_SEAT_COUNT unless given), so auditoriums
+ * of any capacity up to the SeatNumber range are supported.
+ * 
+ * @par State Versioning
+ * Every booking that changes seat state bumps a process-wide version
+ * counter, which lets caches such as CinemaSnapshot tell whether their
+ * formatted data is still current. Writing to @c seats directly bypasses
+ * the counter.
+ * 
+ * @par Layout
+ * A show is cache-line aligned with the seat map, written by bookings,
+ * first and the names, only read, after it. Names are interned in
+ * NameTable, so copying a show copies no strings.
  * 
  * @see Shows in cinema_Client.hpp for detailed documentation
  */
-class Shows {
+class alignas(CACHE_LINE_SIZE) Shows {
 public:
-	std::string movie;               ///< Movie title
-	std::string dateTime;            ///< Show date and time
-	std::string theater;             ///< Theater name
-	std::vector<bool> seats;         ///< Seat availability (false=available, true=booked)
+	static constexpr size_t DEFAULT_SEAT_COUNT = 20;  ///< Seats when no capacity is given
+	
+	SeatMap seats;                   ///< Seat availability (false=available, true=booked)
+	std::string_view movie;          ///< Movie title, interned
+	std::string_view dateTime;       ///< Show date and time, interned
+	std::string_view theater;        ///< Theater name, interned
 	
 private:
-	mutable std::shared_ptr<std::shared_mutex> seatsMutex; ///< Thread safety for seat operations
+	static std::atomic<uint64_t> stateVersion_;            ///< Global seat state version
 	
 public:
 	/**
@@ -45,25 +438,439 @@ public:
 	 * @param m Movie title
 	 * @param dt Date and time string
 	 * @param t Theater name
-	 * @post All 20 seats are initially available
+	 * @param seatCount Auditorium capacity
+	 * @post All seats are initially available
+	 */
+	Shows(std::string_view m, std::string_view dt, std::string_view t,
+	      size_t seatCount = DEFAULT_SEAT_COUNT);
+	
+	/**
+	 * @brief Constructor placing the seats in storage owned by the caller
+	 * @param m Movie title
+	 * @param dt Date and time string
+	 * @param t Theater name
+	 * @param seatCount Auditorium capacity
+	 * @param seatStorage Block of SeatMap::storageWords(seatCount) words,
+	 *        outliving the show
+	 * @post All seats are initially available
 	 */
-	Shows(const std::string& m, const std::string& dt, const std::string& t);
+	Shows(std::string_view m, std::string_view dt, std::string_view t,
+	      size_t seatCount, std::atomic<uint64_t>* seatStorage);
 	
 	/**
 	 * @brief Get list of available seat numbers
-	 * @return Vector of available seat numbers (1-20)
+	 * @return Vector of available seat numbers (1-based)
 	 * @note Thread-safe operation
 	 */
-	std::vector<uint8_t> getAvailableSeats() const;
+	std::vector<SeatNumber> getAvailableSeats() const;
+	
+	/**
+	 * @brief Count available seats
+	 * @return Number of free seats
+	 * @note Thread-safe operation
+	 */
+	size_t availableSeatCount() const;
 	
 	/**
 	 * @brief Book specific seats atomically
-	 * @param seatNumbers Vector of seat numbers to book (1-20)
+	 * @param seatNumbers Vector of seat numbers to book (1 to seats.size())
 	 * @return true if ALL seats were successfully booked
-	 * @note Thread-safe operation
+	 * @note Thread-safe, lock-free operation
 	 * @note All-or-nothing operation
+	 * @post On success with at least one seat: stateVersion() is incremented
+	 */
+	bool bookSeats(const std::vector<SeatNumber>& seatNumbers);
+	
+	/**
+	 * @brief Book specific seats given as 8-bit seat numbers
+	 * @param seatNumbers Vector of seat numbers to book (1 to seats.size())
+	 * @return true if ALL seats were successfully booked
+	 * @note Convenience overload for small auditoriums
 	 */
 	bool bookSeats(const std::vector<uint8_t>& seatNumbers);
+	
+	/**
+	 * @brief Book specific seats atomically and report the resulting state version
+	 * @param seatNumbers Vector of seat numbers to book (1 to seats.size())
+	 * @param version Output: stateVersion() value produced by this booking
+	 * @return true if ALL seats were successfully booked
+	 * @note Thread-safe operation
+	 * @note @p version is only written on success; it is the sequence number
+	 *       carried by the SEAT_DELTA message for this booking
+	 */
+	bool bookSeats(const std::vector<SeatNumber>& seatNumbers, uint64_t& version);
+	
+	/**
+	 * @brief Book seats given as an array and report the resulting state version
+	 * @param seatNumbers Seat numbers to book (1 to seats.size())
+	 * @param count Number of seats in @p seatNumbers
+	 * @param version Output: stateVersion() value produced by this booking
+	 * @return true if ALL seats were successfully booked
+	 * @note Same as the vector overload, for callers that keep seats on the stack
+	 */
+	bool bookSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version);
+	
+	/**
+	 * @brief Hold seats until they are confirmed or released
+	 * @param seatNumbers Seat numbers to hold (1 to seats.size())
+	 * @param count Number of seats in @p seatNumbers
+	 * @param version Output: stateVersion() value produced by this hold
+	 * @return true if ALL seats were free and are now held
+	 * @note Held seats look booked to readers and other bookings, but are
+	 *       left out of persisted snapshots (SeatMap::loadBookedWords())
+	 * @see SeatHolds for deadlines and the hold protocol
+	 */
+	bool holdSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version);
+	
+	/**
+	 * @brief Make held seats available again
+	 * @param seatNumbers Held seats to release
+	 * @param count Number of seats in @p seatNumbers
+	 * @param version Output: stateVersion() value produced by the release
+	 * @return true if any seat was released
+	 */
+	bool releaseSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version);
+	
+	/**
+	 * @brief Turn held seats into bookings
+	 * @param seatNumbers Held seats to confirm
+	 * @param count Number of seats in @p seatNumbers
+	 * @param version Output: stateVersion() value produced by the confirmation,
+	 *        untouched on failure
+	 * @return true if every seat was held; otherwise nothing changes and
+	 *         stateVersion() is not incremented
+	 */
+	bool confirmSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version);
+	
+	/**
+	 * @brief Mark seats booked whatever state they are in
+	 * @param seatNumbers Seats a booking elsewhere took; free ones are
+	 *        booked, held ones confirmed
+	 * @param count Number of seats in @p seatNumbers
+	 * @param version Output: stateVersion() value produced by the change,
+	 *        or the current one if nothing changed
+	 * @return true if any seat changed
+	 * @post stateVersion() is incremented once if any seat changed
+	 */
+	bool settleSeats(const SeatNumber* seatNumbers, size_t count, uint64_t& version);
+	
+	/**
+	 * @brief Mark seats booked that a persisted booking recorded
+	 * @param words Seat bitmap in SeatMap::loadWords() layout
+	 * @param count Number of words in @p words
+	 * @return true if any seat changed
+	 * @post stateVersion() is incremented if any seat changed
+	 * @note Unlike bookSeats(), already booked seats are not a conflict
+	 */
+	bool restoreSeats(const uint64_t* words, size_t count);
+	
+	/**
+	 * @brief Get the global seat state version
+	 * @return Counter incremented by every state-changing booking on any show
+	 * @note Thread-safe operation
+	 */
+	static uint64_t stateVersion();
+};
+
+/**
+ * @class ShowStore
+ * @brief Show records allocated from slabs, with addresses that never move
+ * 
+ * Shows are placed in fixed slabs of SLAB_SHOWS cache-line aligned
+ * records, so growing the store never relocates a show and references
+ * handed out stay valid until the store is cleared or destroyed. Seat
+ * bitmaps are carved in order from separate seat blocks, one cache line
+ * or more per show: a scan over all shows walks both the records and the
+ * seats sequentially, while bookings on different shows never write to
+ * the same cache line.
+ * 
+ * The interface follows std::vector where callers need it: indexing by
+ * ShowId, iteration in id order, size() and emplace_back().
+ * 
+ * @par Thread Safety
+ * Adding shows is not thread-safe and is meant for startup; the shows
+ * themselves are thread-safe as documented for Shows.
+ */
+class ShowStore {
+public:
+	static constexpr size_t SLAB_SHOWS = 256;          ///< Records per slab
+	static constexpr size_t SEAT_BLOCK_WORDS = 8192;   ///< Words per seat block (64 KiB)
+	
+	/**
+	 * @brief Random-access iterator over the shows in id order
+	 */
+	template <typename Store, typename Value>
+	class Iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Shows;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Value*;
+		using reference = Value&;
+		
+		Iterator() = default;
+		Iterator(Store* store, size_t index) : store_(store), index_(index) {}
+		
+		reference operator*() const { return (*store_)[index_]; }
+		pointer operator->() const { return &(*store_)[index_]; }
+		reference operator[](difference_type n) const { return (*store_)[index_ + n]; }
+		Iterator& operator++() { ++index_; return *this; }
+		Iterator operator++(int) { Iterator copy = *this; ++index_; return copy; }
+		Iterator& operator--() { --index_; return *this; }
+		Iterator operator--(int) { Iterator copy = *this; --index_; return copy; }
+		Iterator& operator+=(difference_type n) { index_ += n; return *this; }
+		Iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+		Iterator operator+(difference_type n) const { return Iterator(store_, index_ + n); }
+		Iterator operator-(difference_type n) const { return Iterator(store_, index_ - n); }
+		difference_type operator-(const Iterator& other) const {
+			return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+		}
+		bool operator==(const Iterator& other) const { return index_ == other.index_; }
+		auto operator<=>(const Iterator& other) const { return index_ <=> other.index_; }
+		
+	private:
+		Store* store_ = nullptr;
+		size_t index_ = 0;
+	};
+	
+	using iterator = Iterator<ShowStore, Shows>;
+	using const_iterator = Iterator<const ShowStore, const Shows>;
+	
+	ShowStore() = default;
+	
+	/**
+	 * @brief Constructor copying shows, seat state included
+	 * @param shows Shows in id order
+	 */
+	ShowStore(std::initializer_list<Shows> shows);
+	
+	ShowStore(ShowStore&& other) noexcept;
+	ShowStore& operator=(ShowStore&& other) noexcept;
+	ShowStore(const ShowStore&) = delete;
+	ShowStore& operator=(const ShowStore&) = delete;
+	~ShowStore();
+	
+	/**
+	 * @brief Add a show
+	 * @param movie Movie title
+	 * @param dateTime Date and time string
+	 * @param theater Theater name
+	 * @param seatCount Auditorium capacity
+	 * @return The new show, id size() - 1, all seats available
+	 */
+	Shows& emplace_back(std::string_view movie, std::string_view dateTime, std::string_view theater,
+	                    size_t seatCount = Shows::DEFAULT_SEAT_COUNT);
+	
+	/**
+	 * @brief Add a copy of a show, seat state included
+	 * @param show Show to copy
+	 * @return The new show
+	 */
+	Shows& push_back(const Shows& show);
+	
+	/**
+	 * @brief Allocate storage for shows about to be added
+	 * @param shows Total shows the store will hold
+	 * @param seatsPerShow Typical auditorium capacity, sizes the seat blocks
+	 */
+	void reserve(size_t shows, size_t seatsPerShow = Shows::DEFAULT_SEAT_COUNT);
+	
+	/**
+	 * @brief Remove every show and free the storage
+	 * @post References to shows of this store are invalid
+	 */
+	void clear();
+	
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	
+	/**
+	 * @brief Get a show by id
+	 * @param id Show id, less than size()
+	 */
+	Shows& operator[](size_t id) { return record(id); }
+	const Shows& operator[](size_t id) const { return record(id); }
+	
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, size_); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, size_); }
+	
+private:
+	/**
+	 * @brief SLAB_SHOWS records of raw, cache-line aligned storage
+	 */
+	struct Slab {
+		alignas(Shows) unsigned char bytes[SLAB_SHOWS * sizeof(Shows)];
+	};
+	
+	struct SeatBlockDeleter {
+		void operator()(std::atomic<uint64_t>* words) const;
+	};
+	
+	using SeatBlock = std::unique_ptr<std::atomic<uint64_t>[], SeatBlockDeleter>;
+	
+	Shows& record(size_t id) const {
+		return std::launder(reinterpret_cast<Shows*>(slabs_[id / SLAB_SHOWS]->bytes))[id % SLAB_SHOWS];
+	}
+	
+	/**
+	 * @brief Get storage for the next show's seats
+	 * @param words SeatMap::storageWords() of the show
+	 * @return Cache-line aligned, zeroed words
+	 */
+	std::atomic<uint64_t>* allocateSeats(size_t words);
+	
+	/**
+	 * @brief Get the address of the next record, adding a slab if needed
+	 */
+	void* nextRecord();
+	
+	std::vector<std::unique_ptr<Slab>> slabs_;   ///< Record storage, SLAB_SHOWS each
+	size_t size_ = 0;                            ///< Constructed records
+	std::vector<SeatBlock> seatBlocks_;          ///< Seat storage, in allocation order
+	size_t seatBlockWords_ = 0;                  ///< Size of the last seat block
+	size_t seatBlockUsed_ = 0;                   ///< Words taken from the last seat block
+	size_t reservedSeatWords_ = 0;               ///< Size of the next seat block, 0 for the default
+};
+
+/**
+ * @brief Called after a booking has been applied in memory
+ * @param showId Show the seats were booked in
+ * @param seats Seats that were booked
+ * @param count Number of seats in @p seats
+ * @note Runs on the booking thread; used to append to the BookingJournal
+ */
+using BookingCallback = std::function<void(ShowId showId, const SeatNumber* seats, size_t count)>;
+
+/**
+ * @brief Receives a reply produced after handleMessage() has returned
+ * @param reply Payload to send to the client that made the request
+ */
+using ReplyCallback = std::function<void(SharedPayload reply)>;
+
+/**
+ * @brief Hands a booking for a show owned by another node to that node
+ * @param showId Show the booking is for
+ * @param message Booking request as received
+ * @param format Wire format of the requesting session
+ * @param reply Called with the owner's reply, on any thread
+ * @return true if the booking was taken over, false to book it locally
+ */
+using BookingForwarder = std::function<bool(ShowId showId, const std::string& message,
+                                            WireFormat format, ReplyCallback reply)>;
+
+/**
+ * @class ShowRegistry
+ * @brief Hash index over a ShowStore
+ * 
+ * Built in one pass over the shows, the registry interns theater and movie
+ * names to small integer ids and provides expected O(1) lookup of a show
+ * by (theater, movie, dateTime) or by (theater, movie). It also keeps the
+ * theater -> shows grouping precomputed, in first-appearance order, so
+ * formatters can walk it directly instead of deduplicating theaters.
+ * 
+ * @par Thread Safety
+ * Immutable after construction; all const operations are thread-safe.
+ * 
+ * @note The registry indexes the catalogue layout, not seat state. It must
+ *       be rebuilt if shows are added, removed or renamed.
+ */
+class ShowRegistry {
+public:
+    /**
+     * @brief Build the index for a ShowStore
+     * @param shows Shows to index; ShowId values are indices into it
+     * @post Every show is reachable through find() and theaterShows()
+     */
+    explicit ShowRegistry(const ShowStore& shows);
+    
+    /**
+     * @brief Look up a show by theater, movie and date/time
+     * @param theater Theater name
+     * @param movie Movie title
+     * @param dateTime Show date and time
+     * @return ShowId of the matching show, or std::nullopt
+     */
+    std::optional<ShowId> find(std::string_view theater, std::string_view movie, std::string_view dateTime) const;
+    
+    /**
+     * @brief Look up a show of a movie at a theater
+     * @param theater Theater name
+     * @param movie Movie title, optionally followed by
+     *        CinemaProtocol::SHOWTIME_SEPARATOR and the show date/time
+     * @return ShowId of the show at that date/time, or of the first
+     *         registered one if none is given; std::nullopt if not found
+     * @note Matches the "theater,movie,seats" booking format, where
+     *       "movie@date time" picks one of several showtimes
+     */
+    std::optional<ShowId> find(std::string_view theater, std::string_view movie) const;
+    
+    /**
+     * @brief Get number of distinct theaters
+     * @return Theater count
+     */
+    size_t theaterCount() const;
+    
+    /**
+     * @brief Get interned theater name
+     * @param theaterIndex Theater index in [0, theaterCount())
+     * @return Theater name
+     */
+    std::string_view theaterName(size_t theaterIndex) const;
+    
+    /**
+     * @brief Get the shows playing at a theater
+     * @param theaterIndex Theater index in [0, theaterCount())
+     * @return ShowIds in original vector order
+     */
+    const std::vector<ShowId>& theaterShows(size_t theaterIndex) const;
+    
+    /**
+     * @brief Get number of indexed shows
+     * @return Show count
+     */
+    size_t size() const;
+
+private:
+    /**
+     * @struct NameHash
+     * @brief Transparent string hash allowing lookups by std::string_view
+     */
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    
+    /**
+     * @struct TitleEntry
+     * @brief Show of a (theater, movie) pair, distinguished by date/time
+     */
+    struct TitleEntry {
+        std::string_view dateTime;  ///< Show date and time
+        ShowId id;                  ///< Show index
+    };
+    
+    // Keys view the shows' names, which NameTable keeps alive
+    using NameIndex = std::unordered_map<std::string_view, uint32_t, NameHash, std::equal_to<>>;
+    
+    NameIndex theaterIds_;                                   ///< Interned theater name -> theater index
+    NameIndex movieIds_;                                     ///< Interned movie title -> movie index
+    std::vector<std::string_view> theaterNames_;             ///< Theater names by theater index
+    std::vector<std::vector<ShowId>> showsByTheater_;        ///< Theater index -> shows
+    std::unordered_map<uint64_t, std::vector<TitleEntry>> showsByTitle_; ///< (theater, movie) key -> shows
+    size_t size_;                                            ///< Number of indexed shows
+    
+    /**
+     * @brief Combine interned theater and movie ids into one hash key
+     */
+    static uint64_t titleKey(uint32_t theaterId, uint32_t movieId);
+    
+    /**
+     * @brief Find the shows of a (theater, movie) pair
+     * @return Matching entries, or nullptr if none
+     */
+    const std::vector<TitleEntry>* findTitle(std::string_view theater, std::string_view movie) const;
 };
 
 /**
@@ -77,6 +884,9 @@ public:
  * @par Output Format
  * Generates structured text output with theater grouping, movie listings,
  * and seat availability information in a human-readable format.
+ * Full streams start with a "Sequence: N" line giving the state version
+ * they reflect, and every show carries a "Show ID: N" line with its index
+ * in the ShowStore, which is how SEAT_DELTA messages refer to it.
  */
 class CinemaService {
 public:
@@ -88,7 +898,18 @@ public:
      * @note Groups shows by theater for organized display
      * @note Includes availability information for each show
      */
-    static std::string formatCinemaData(const std::vector<Shows>& shows);
+    static std::string formatCinemaData(const ShowStore& shows);
+    
+    /**
+     * @brief Format complete cinema data using a prebuilt show registry
+     * @param shows Vector of all available shows
+     * @param registry Registry built from @p shows
+     * @return Same output as formatCinemaData(shows)
+     * @note Walks the registry's theater grouping directly
+     * @note Sizes the result up front and writes it in one allocation;
+     *       the layout is CinemaProtocol::CatalogueLayout
+     */
+    static std::string formatCinemaData(const ShowStore& shows, const ShowRegistry& registry);
     
     /**
      * @brief Format booking update data for client notification
@@ -98,7 +919,215 @@ public:
      * @note Used for real-time client synchronization after bookings
      * @note Similar format to formatCinemaData but with update headers
      */
-    static std::string formatUpdateData(const std::vector<Shows>& shows);
+    static std::string formatUpdateData(const ShowStore& shows);
+    
+    /**
+     * @brief Format booking update data using a prebuilt show registry
+     * @param shows Vector of updated shows data
+     * @param registry Registry built from @p shows
+     * @return Same output as formatUpdateData(shows)
+     */
+    static std::string formatUpdateData(const ShowStore& shows, const ShowRegistry& registry);
+    
+    /**
+     * @brief Format a seat delta message for a single booking
+     * @param sequence State version produced by the booking
+     * @param showId Index of the booked show in the ShowStore
+     * @param seatNumbers Seats that changed from available to booked
+     * @return Delta message "SEAT_DELTA:<sequence>:<showId>:<seat1>,<seat2>,..."
+     * @note Lets clients patch their cached shows in place instead of
+     *       receiving the complete catalogue after every booking
+     */
+    static std::string formatSeatDelta(uint64_t sequence, size_t showId, const std::vector<SeatNumber>& seatNumbers);
+    
+    /**
+     * @brief Format a seat delta message from a seat array
+     * @param sequence State version produced by the booking
+     * @param showId Index of the booked show in the ShowStore
+     * @param seatNumbers Seats that changed from available to booked
+     * @param count Number of seats in @p seatNumbers
+     * @param change Booked for SEAT_DELTA:, Held for SEAT_HELD: or Freed for
+     *        SEAT_FREED:, all with the same fields
+     * @return Delta message, see the vector overload
+     */
+    static std::string formatSeatDelta(uint64_t sequence, size_t showId, const SeatNumber* seatNumbers, size_t count,
+                                       SeatChange change = SeatChange::Booked);
+    
+    /**
+     * @brief Encode the complete catalogue as a binary frame
+     * @param shows Vector of all available shows
+     * @param registry Registry built from @p shows
+     * @return BinaryProtocol::CATALOGUE frame
+     * @note Carries the same data as formatCinemaData with seat maps as bits
+     */
+    static std::string encodeCatalogue(const ShowStore& shows, const ShowRegistry& registry);
+    
+    /**
+     * @brief Encode a seat delta as a binary frame
+     * @param sequence State version produced by the booking
+     * @param showId Index of the booked show in the ShowStore
+     * @param seatNumbers Seats that changed from available to booked
+     * @return BinaryProtocol::SEAT_DELTA frame
+     */
+    static std::string encodeSeatDelta(uint64_t sequence, size_t showId, const std::vector<SeatNumber>& seatNumbers);
+    
+    /**
+     * @brief Encode a seat delta from a seat array as a binary frame
+     * @param sequence State version produced by the booking
+     * @param showId Index of the booked show in the ShowStore
+     * @param seatNumbers Seats that changed from available to booked
+     * @param count Number of seats in @p seatNumbers
+     * @param change Kind of change; held seats are encoded as booked
+     * @return BinaryProtocol::SEAT_DELTA frame, or SEAT_FREED for Freed
+     */
+    static std::string encodeSeatDelta(uint64_t sequence, size_t showId, const SeatNumber* seatNumbers, size_t count,
+                                       SeatChange change = SeatChange::Booked);
+};
+
+/**
+ * @class CinemaSnapshot
+ * @brief Version-stamped cache of the formatted cinema data streams
+ * 
+ * Keeps the output of CinemaService::formatCinemaData and
+ * CinemaService::formatUpdateData for one ShowStore, stamped with the
+ * Shows::stateVersion() it was built from. A payload is only re-formatted
+ * when a booking has changed state since it was built, so repeated reads
+ * cost one atomic load and no formatting or allocation.
+ * 
+ * @par Thread Safety
+ * All operations are thread-safe. Readers never block each other; a
+ * rebuild is serialized so concurrent readers of a stale payload format
+ * it only once.
+ * 
+ * @note The referenced ShowStore must outlive the snapshot
+ */
+class CinemaSnapshot {
+public:
+    /**
+     * @brief Constructor
+     * @param shows Shows vector the snapshot formats
+     * @post No payload is built until first requested
+     */
+    explicit CinemaSnapshot(const ShowStore& shows);
+    
+    /**
+     * @brief Constructor using a prebuilt show registry for formatting
+     * @param shows Shows vector the snapshot formats
+     * @param registry Registry built from @p shows, must outlive the snapshot
+     * @post No payload is built until first requested
+     */
+    CinemaSnapshot(const ShowStore& shows, const ShowRegistry& registry);
+    
+    /**
+     * @brief Get the current cinema data stream
+     * @return Shared payload equal to CinemaService::formatCinemaData(shows)
+     * @note Re-formats only if seat state changed since the last build
+     */
+    SharedPayload cinemaData();
+    
+    /**
+     * @brief Get the current booking update stream
+     * @return Shared payload equal to CinemaService::formatUpdateData(shows)
+     * @note Re-formats only if seat state changed since the last build
+     */
+    SharedPayload updateData();
+    
+    /**
+     * @brief Get the current catalogue as a binary frame
+     * @return Shared payload equal to CinemaService::encodeCatalogue(shows, registry)
+     * @note Re-encodes only if seat state changed since the last build
+     */
+    SharedPayload binaryData();
+    
+    /**
+     * @brief Get the version of the most recently built cinema data payload
+     * @return Shows::stateVersion() value the payload was built from
+     */
+    uint64_t version() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief Formatted payload together with the state version it reflects
+     */
+    struct Entry {
+        uint64_t version;       ///< Shows::stateVersion() before formatting
+        SharedPayload payload;  ///< Formatted data
+    };
+    
+    /**
+     * @struct Slot
+     * @brief Cached entry for one kind of payload
+     */
+    struct Slot {
+        std::atomic<std::shared_ptr<const Entry>> current; ///< Latest built entry
+        std::mutex rebuildMutex;                           ///< Serializes rebuilds
+    };
+    
+    /**
+     * @brief Kind of payload held by a slot
+     */
+    enum class Stream {
+        Cinema,  ///< formatCinemaData
+        Update,  ///< formatUpdateData
+        Binary   ///< encodeCatalogue
+    };
+    
+    const ShowStore& shows_;           ///< Shows being formatted
+    const ShowRegistry* registry_;     ///< Optional registry of shows_
+    Slot cinemaData_;                  ///< Cached formatCinemaData output
+    Slot updateData_;                  ///< Cached formatUpdateData output
+    Slot binaryData_;                  ///< Cached encodeCatalogue output
+    
+    /**
+     * @brief Return slot payload, rebuilding it first if stale
+     * @param slot Slot to read
+     * @param stream Formatter used to rebuild the slot
+     * @return Payload at least as new as the current state version
+     */
+    SharedPayload load(Slot& slot, Stream stream);
+    
+    /**
+     * @brief Run the formatter for a slot
+     * @param stream Formatter to run
+     * @return Freshly formatted stream
+     */
+    std::string format(Stream stream) const;
+};
+
+/**
+ * @class SeatBuffer
+ * @brief Fixed-capacity list of the seats named by one booking request
+ * 
+ * Kept on the stack by the booking parser, so parsing a request never
+ * allocates; requests naming more than CAPACITY seats are rejected.
+ */
+class SeatBuffer {
+public:
+	static constexpr size_t CAPACITY = 128;  ///< Seats accepted per booking
+	
+	/**
+	 * @brief Append a seat
+	 * @param seat Seat number to append
+	 * @return false if the buffer is full and @p seat was dropped
+	 */
+	bool push(SeatNumber seat) {
+		if (size_ == CAPACITY) {
+			return false;
+		}
+		seats_[size_++] = seat;
+		return true;
+	}
+	
+	const SeatNumber* data() const { return seats_.data(); }       ///< First seat
+	size_t size() const { return size_; }                          ///< Number of seats
+	bool empty() const { return size_ == 0; }                      ///< true if no seat was added
+	const SeatNumber* begin() const { return seats_.data(); }      ///< Iteration start
+	const SeatNumber* end() const { return seats_.data() + size_; } ///< Iteration end
+	
+private:
+	std::array<SeatNumber, CAPACITY> seats_;  ///< Storage, first size_ entries valid
+	size_t size_ = 0;                         ///< Seats appended
 };
 
 /**
@@ -122,29 +1151,100 @@ public:
         bool success;           ///< Whether booking succeeded
         std::string message;    ///< Response message for client
         bool shouldBroadcast;   ///< Whether to notify other clients
+        std::string delta;      ///< SEAT_DELTA message for other clients (empty if none)
+        std::string binaryDelta; ///< Binary SEAT_DELTA frame (empty if none)
+        std::string status;     ///< First line of message, without the appended catalogue
+        ShowId showId = ALL_SHOWS; ///< Show that was booked (ALL_SHOWS if none)
+    };
+    
+    /**
+     * @struct ParsedBooking
+     * @brief A validated "theater,movie,seat1,seat2,..." request
+     */
+    struct ParsedBooking {
+        ShowId showId = ALL_SHOWS;   ///< Show the request names
+        std::string_view theater;    ///< Theater as written, points into the request
+        std::string_view movie;      ///< Movie as written, points into the request
+        SeatBuffer seats;            ///< Requested seats, all within the show
     };
     
     /**
      * @brief Process a booking request message
      * @param message Raw booking request string from client
-     * @param shows Reference to shows vector to modify
+     * @param shows Shows to modify
      * @return BookingResult with operation outcome
      * @pre message format: "theater,movie,seat1,seat2,..."
-     * @pre shows vector contains valid show data
-     * @post On success: specified seats are booked, shows vector updated
-     * @post On failure: no changes made to shows vector
+     * @pre shows contains valid show data
+     * @post On success: specified seats are booked, shows updated
+     * @post On failure: no changes made to shows
+     * @note Only successful replies append the catalogue; errors are the
+     *       status line alone
      * 
      * @par Message Format
      * Expected format: "TheaterName,MovieTitle,SeatNumber1,SeatNumber2,..."
-     * Example: "PVR,Inception,1,2,3"
+     * Example: "PVR,Inception,1,2,3"; "PVR,Inception@2025-09-11 22:00,1"
+     * books a later showtime
      * 
      * @par Validation
-     * - Verifies show exists (theater + movie combination)
-     * - Validates all seat numbers are in range [1,20]
+     * - Verifies show exists (theater + movie combination, first showtime
+     *   unless one is named)
+     * - Validates all seat numbers are in range [1, seat count of the show]
      * - Checks all seats are available before booking
      * - Provides detailed error messages for failures
      */
-    static BookingResult processBooking(const std::string& message, std::vector<Shows>& shows);
+    static BookingResult processBooking(const std::string& message, ShowStore& shows);
+    
+    /**
+     * @brief Process a booking request using a show registry and cached snapshot
+     * @param message Raw booking request string from client
+     * @param shows Shows to modify
+     * @param registry Registry of @p shows used to find the show in O(1)
+     * @param snapshot Snapshot of @p shows used for the data appended to replies
+     * @param onBooked Called with the show and seats after a successful booking
+     * @return BookingResult with operation outcome
+     * @note Same behaviour as processBooking(message, shows) without
+     *       scanning the shows or re-formatting the catalogue on every reply
+     */
+    static BookingResult processBooking(const std::string& message, ShowStore& shows,
+                                        const ShowRegistry& registry, CinemaSnapshot& snapshot,
+                                        const BookingCallback& onBooked = {});
+    
+    /**
+     * @brief Process a booking request without appending the catalogue
+     * @param message Raw booking request "theater,movie,seat1,seat2,..."
+     * @param shows Shows to modify
+     * @param registry Registry of @p shows used to find the show in O(1)
+     * @param onBooked Called with the show and seats after a successful booking
+     * @return BookingResult whose message is the status line only
+     * @note Used for batch items, which would otherwise rebuild the
+     *       catalogue after every booking
+     * @note Parses in place with std::from_chars into a SeatBuffer: no
+     *       allocation and no exceptions until the reply is built. Spaces
+     *       around seat numbers are ignored.
+     */
+    static BookingResult reserveSeats(std::string_view message, ShowStore& shows,
+                                      const ShowRegistry& registry, const BookingCallback& onBooked = {});
+    
+    /**
+     * @brief Parse and validate a booking request without booking anything
+     * @param message Request "theater,movie,seat1,seat2,..."
+     * @param shows Shows the request is checked against
+     * @param registry Registry of @p shows
+     * @param parsed Output: the request, valid only if nothing is returned
+     * @return nullopt if valid, otherwise the ERROR: status to reply with
+     * @note Shared by reserveSeats() and SeatHolds, so holds accept exactly
+     *       the requests a booking does
+     */
+    static std::optional<std::string> parseBooking(std::string_view message, const ShowStore& shows,
+                                                   const ShowRegistry& registry, ParsedBooking& parsed);
+    
+    /**
+     * @brief List seats the way replies do
+     * @param seats Seat numbers
+     * @param count Number of seats in @p seats
+     * @return "3, 4, 7"
+     */
+    static std::string describeSeats(const SeatNumber* seats, size_t count);
 };
 
 /**
@@ -160,16 +1260,17 @@ public:
     /**
      * @brief Handle any client message and generate appropriate response
      * @param received Raw message received from client
-     * @param shows Reference to shows vector (may be modified)
+     * @param shows Shows (may be modified)
      * @param shouldBroadcast Output parameter indicating if response should be broadcast
      * @return Response message to send back to client
      * @pre received contains valid client message
      * @post shouldBroadcast indicates whether other clients should receive response
-     * @post shows vector may be modified for booking operations
+     * @post shows may be modified for booking operations
      * 
      * @par Message Types Handled
      * - "get_data" - Returns formatted cinema data
      * - Booking requests - Processes seat bookings
+     * - Batch requests - Processes many bookings, see handleBatch()
      * - Unknown messages - Returns error response
      * 
      * @par Broadcast Logic
@@ -177,6 +1278,120 @@ public:
      * - Successful bookings: broadcast update to all clients
      * - Failed bookings: no broadcast needed
      */
-    static std::string handleMessage(const std::string& received, std::vector<Shows>& shows, bool& shouldBroadcast);
+    static std::string handleMessage(const std::string& received, ShowStore& shows, bool& shouldBroadcast);
+    
+    /**
+     * @brief Handle client message using a show registry and cached snapshot
+     * @param received Raw message received from client
+     * @param shows Shows (may be modified)
+     * @param registry Registry of @p shows used for booking lookups
+     * @param snapshot Snapshot of @p shows used for data responses
+     * @param format Wire format negotiated by the sending session
+     * @param broadcast Output: SEAT_DELTA payload in both encodings to send
+     *        to all clients, empty if nothing changed
+     * @param onBooked Called after a successful booking, see BookingCallback
+     * @param forward Offered every booking first, see BookingForwarder
+     * @param reply Receives the reply of a forwarded booking
+     * @return Shared response payload to send back to client, or null if
+     *         the booking was forwarded and the reply goes to @p reply
+     * @note Data requests return the cached payload itself, without
+     *       formatting or copying
+     * @note Binary sessions get the binary catalogue for data requests and
+     *       only the status line for other replies, since their seat state
+     *       is kept current by the broadcast deltas
+     * @note Bookings are only forwarded if both @p forward and @p reply are
+     *       set; requests forwarded by another node pass no @p reply, so a
+     *       request is never forwarded twice
+     */
+    static SharedPayload handleMessage(const std::string& received, ShowStore& shows,
+                                       const ShowRegistry& registry, CinemaSnapshot& snapshot,
+                                       WireFormat format, BroadcastPayload& broadcast,
+                                       const BookingCallback& onBooked = {},
+                                       const BookingForwarder& forward = {},
+                                       const ReplyCallback& reply = {});
+    
+    /**
+     * @brief Check whether handleMessage() would book seats for a message
+     * @param received Raw message received from a client
+     * @return true for bookings and batches
+     * @note Queries and other requests with commas must be routed first
+     */
+    static bool isBookingRequest(std::string_view received);
+    
+    static constexpr size_t MAX_BATCH_ITEMS = CinemaProtocol::MAX_BATCH_ITEMS;  ///< Bookings accepted in one batch request
+    
+    /**
+     * @brief Handle a batch of independent booking requests
+     * @param received Batch request, see Message Format
+     * @param shows Shows (may be modified)
+     * @param registry Registry of @p shows used for booking lookups
+     * @param broadcast Output: SEAT_DELTA of every successful item merged into
+     *        one payload (lines or records in item order), empty if none
+     *        succeeded; addressed to ALL_SHOWS if the items span shows
+     * @param onBooked Called after every successful booking
+     * @param forward Offered every item first, see BookingForwarder
+     * @param reply Receives the result once forwarded items are answered
+     * @return Result of every item, or null if some items were forwarded and
+     *         the result goes to @p reply
+     * 
+     * @par Message Format
+     * Request: "batch" followed by one "<id>:theater,movie,seat1,..." line
+     * per booking; ids are chosen by the client and must not contain ':'.
+     * Reply: "BATCH_RESULT:<count>" followed by one "<id>:<status>" line per
+     * item in request order, where status is the SUCCESS: or ERROR: line a
+     * single booking would get.
+     * 
+     * @note Items are independent: each books all of its seats or none, and
+     *       a failed item does not affect the others
+     * @note The reply carries no catalogue; clients stay current through
+     *       the broadcast deltas
+     */
+    static SharedPayload handleBatch(const std::string& received, ShowStore& shows,
+                                     const ShowRegistry& registry, BroadcastPayload& broadcast,
+                                     const BookingCallback& onBooked = {},
+                                     const BookingForwarder& forward = {},
+                                     const ReplyCallback& reply = {});
+    
+    /**
+     * @brief Turn a booking reply into the reply for a booking that was not persisted
+     * @param reply Reply produced by handleMessage() or handleBatch(),
+     *        possibly with a "FORWARDED:<id>:" prefix
+     * @return @p reply with every SUCCESS status replaced by an ERROR, or
+     *         @p reply itself if it has none
+     * @note Used when the booking journal failed to write the booking
+     */
+    static SharedPayload unsavedReply(const SharedPayload& reply);
+    
+    /**
+     * @brief Apply a seat delta relayed from the node owning the show
+     * @param delta Text delta "SEAT_DELTA:<sequence>:<showId>:<seats>", or
+     *        the same with SEAT_HELD: or SEAT_FREED:
+     * @param shows Shows to update
+     * @param broadcast Output: the delta re-sequenced for local clients,
+     *        empty if @p delta was malformed
+     * @param onBooked Called with booked seats, see BookingCallback; holds
+     *        and releases are not journaled
+     * @return true if @p delta was valid and applied
+     * @note Seats are merged, so a relay repeating seats already booked
+     *       here is harmless; the sender's sequence number is dropped
+     * @note A SEAT_DELTA for seats held here confirms the hold
+     */
+    static bool applyRelayedDelta(const std::string& delta, ShowStore& shows,
+                                  BroadcastPayload& broadcast, const BookingCallback& onBooked = {});
+    
+    /**
+     * @brief Parse a subscription request
+     * @param received Raw message received from client
+     * @param registry Registry used to resolve theater names
+     * @return Parsed request, or nullopt if @p received is not one or names
+     *         no known show
+     * 
+     * @par Message Format
+     * - "subscribe:all" / "unsubscribe:all"
+     * - "subscribe:show:<id>,<id>,..." (ids as in "Show ID:" lines)
+     * - "subscribe:theater:<name>,<name>,..."
+     * - the same with "unsubscribe:" to stop watching
+     */
+    static std::optional<SubscriptionRequest> parseSubscription(const std::string& received, const ShowRegistry& registry);
 };
 
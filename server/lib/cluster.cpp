@@ -0,0 +1,394 @@
+#include "cluster.hpp"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <unordered_map>
+
+std::vector<ClusterMember> ClusterOptions::parseMembers(std::string_view nodes) {
+    std::vector<ClusterMember> members;
+    while (!nodes.empty()) {
+        size_t end = nodes.find(',');
+        std::string_view entry = nodes.substr(0, end);
+        nodes = end == std::string_view::npos ? std::string_view{} : nodes.substr(end + 1);
+
+        size_t equals = entry.find('=');
+        size_t colon = entry.rfind(':');
+        if (equals == std::string_view::npos || colon == std::string_view::npos || colon < equals ||
+            equals == 0 || colon == equals + 1 || colon + 1 == entry.size()) {
+            continue;
+        }
+        members.push_back({std::string(entry.substr(0, equals)),
+                           std::string(entry.substr(equals + 1, colon - equals - 1)),
+                           std::string(entry.substr(colon + 1))});
+    }
+    return members;
+}
+
+ShardRing::ShardRing(std::vector<std::string> nodes, std::size_t virtualNodes)
+    : nodes_(std::move(nodes)) {
+    virtualNodes = std::max<std::size_t>(1, virtualNodes);
+    points_.reserve(nodes_.size() * virtualNodes);
+    for (uint32_t node = 0; node < nodes_.size(); ++node) {
+        for (std::size_t v = 0; v < virtualNodes; ++v) {
+            points_.emplace_back(hash(nodes_[node] + "#" + std::to_string(v)), node);
+        }
+    }
+    // Ties are broken by node name so every member builds the same ring
+    std::sort(points_.begin(), points_.end(), [this](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : nodes_[a.second] < nodes_[b.second];
+    });
+}
+
+std::size_t ShardRing::ownerIndex(std::string_view key) const {
+    uint64_t h = hash(key);
+    auto it = std::lower_bound(points_.begin(), points_.end(), h,
+                               [](const auto& point, uint64_t value) { return point.first < value; });
+    if (it == points_.end()) {
+        it = points_.begin();
+    }
+    return it->second;
+}
+
+const std::string& ShardRing::owner(std::string_view key) const {
+    return nodes_[ownerIndex(key)];
+}
+
+const std::vector<std::string>& ShardRing::nodes() const {
+    return nodes_;
+}
+
+std::string ShardRing::showKey(const Shows& show) {
+    std::string key;
+    key.reserve(show.theater.size() + 1 + show.movie.size());
+    return key.append(show.theater).append("/").append(show.movie);
+}
+
+uint64_t ShardRing::hash(std::string_view value) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : value) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ull;
+    }
+    // FNV alone clusters similar keys; mix the bits before placing them
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @class PeerLink
+ * @brief WebSocket connection from this node to one other node
+ *
+ * Introduces itself with CinemaProtocol::PEER_HELLO and the cluster
+ * secret, then carries forwarded bookings out and their replies and the
+ * peer's published deltas in. A replica's link also asks for the seat
+ * state after every handshake. A lost connection fails the bookings
+ * waiting on it and is retried after ClusterOptions::retryDelay.
+ *
+ * @par Thread Safety
+ * Every member is used on the link's strand; forward() and stop() post there.
+ */
+class PeerLink : public std::enable_shared_from_this<PeerLink> {
+public:
+    PeerLink(net::io_context& ioc, ClusterMember member, std::chrono::milliseconds retryDelay,
+             std::string secret, ClusterNode::RelayCallback onRelay, ClusterNode::SyncCallback onSync)
+        : strand_(net::make_strand(ioc)), resolver_(strand_), retryTimer_(strand_),
+          member_(std::move(member)), retryDelay_(retryDelay), secret_(std::move(secret)), onRelay_(std::move(onRelay)),
+          onSync_(std::move(onSync)) {}
+
+    void start() {
+        net::dispatch(strand_, [self = shared_from_this()]() { self->connect(); });
+    }
+
+    void stop() {
+        net::dispatch(strand_, [self = shared_from_this()]() {
+            self->stopped_ = true;
+            self->retryTimer_.cancel();
+            self->resolver_.cancel();
+            self->disconnect();
+        });
+    }
+
+    void forward(const std::string& message, WireFormat format, ReplyCallback reply) {
+        net::post(strand_, [self = shared_from_this(), message, format, reply = std::move(reply)]() mutable {
+            if (!self->connected_) {
+                reply(self->unavailable());
+                return;
+            }
+            uint64_t id = ++self->nextId_;
+            self->pending_.emplace(id, std::move(reply));
+            self->queue(std::string(CinemaProtocol::FORWARD_PREFIX) + std::to_string(id) + ":" +
+                        (format == WireFormat::Binary ? "b" : "t") + ":" + message);
+        });
+    }
+
+private:
+    using Stream = websocket::stream<beast::tcp_stream>;
+
+    void connect() {
+        if (stopped_) {
+            return;
+        }
+        ++epoch_;
+        resolver_.async_resolve(member_.host, member_.port,
+            [self = shared_from_this(), epoch = epoch_](beast::error_code ec, tcp::resolver::results_type results) {
+                if (epoch != self->epoch_) {
+                    return;
+                }
+                if (ec) {
+                    return self->fail(ec, "resolve");
+                }
+                self->ws_ = std::make_unique<Stream>(self->strand_);
+                beast::get_lowest_layer(*self->ws_).expires_after(std::chrono::seconds(10));
+                beast::get_lowest_layer(*self->ws_).async_connect(results,
+                    [self, epoch](beast::error_code ec, const tcp::endpoint&) {
+                        if (epoch == self->epoch_) {
+                            self->on_connect(ec);
+                        }
+                    });
+            });
+    }
+
+    void on_connect(beast::error_code ec) {
+        if (ec) {
+            return fail(ec, "connect");
+        }
+        beast::get_lowest_layer(*ws_).expires_never();
+        ws_->set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        ws_->async_handshake(member_.host + ":" + member_.port, "/",
+            [self = shared_from_this(), epoch = epoch_](beast::error_code ec) {
+                if (epoch == self->epoch_) {
+                    self->on_handshake(ec);
+                }
+            });
+    }
+
+    void on_handshake(beast::error_code ec) {
+        if (ec) {
+            return fail(ec, "handshake");
+        }
+        connected_ = true;
+        Logger::log(LogLevel::Info, "Connected to cluster node ", member_.id, " at ", member_.host, ":", member_.port);
+        queue(std::string(CinemaProtocol::PEER_HELLO) + ":" + secret_);
+        if (onSync_) {
+            // Asked after the hello, so every delta the reply misses is published to this link
+            queue(std::string(CinemaProtocol::SYNC_REQUEST));
+        }
+        do_read();
+    }
+
+    void do_read() {
+        ws_->async_read(buffer_,
+            [self = shared_from_this(), epoch = epoch_](beast::error_code ec, std::size_t) {
+                if (epoch == self->epoch_) {
+                    self->on_read(ec);
+                }
+            });
+    }
+
+    void on_read(beast::error_code ec) {
+        if (ec) {
+            return fail(ec, "read");
+        }
+        std::string message = beast::buffers_to_string(buffer_.data());
+        buffer_.consume(buffer_.size());
+
+        const std::string_view forwarded = CinemaProtocol::FORWARDED_PREFIX;
+        const std::string_view delta = CinemaProtocol::SEAT_PREFIX;
+        const std::string_view state = CinemaProtocol::STATE_SYNC_PREFIX;
+        if (message.compare(0, forwarded.size(), forwarded) == 0) {
+            uint64_t id = 0;
+            const char* first = message.data() + forwarded.size();
+            const char* last = message.data() + message.size();
+            auto [end, err] = std::from_chars(first, last, id);
+            auto it = pending_.find(id);
+            if (err == std::errc() && end < last && *end == ':' && it != pending_.end()) {
+                ReplyCallback reply = std::move(it->second);
+                pending_.erase(it);
+                reply(std::make_shared<const std::string>(message.substr(end + 1 - message.data())));
+            }
+        } else if (message.compare(0, delta.size(), delta) == 0) {
+            // SEAT_DELTA, SEAT_HELD or SEAT_FREED; a batch publishes its
+            // deltas as one multi-line message
+            size_t start = 0;
+            while (start < message.size()) {
+                size_t end = std::min(message.find('\n', start), message.size());
+                onRelay_(message.substr(start, end - start));
+                start = end + 1;
+            }
+        } else if (onSync_ && message.compare(0, state.size(), state) == 0) {
+            onSync_(message);
+        }
+        // Anything else (the catalogue sent on connect) is not needed here
+
+        do_read();
+    }
+
+    void queue(std::string message) {
+        outbound_.push_back(std::move(message));
+        if (!writing_) {
+            do_write();
+        }
+    }
+
+    void do_write() {
+        writing_ = true;
+        ws_->text(true);
+        ws_->async_write(net::buffer(outbound_.front()),
+            [self = shared_from_this(), epoch = epoch_](beast::error_code ec, std::size_t) {
+                if (epoch != self->epoch_) {
+                    return;
+                }
+                if (ec) {
+                    return self->fail(ec, "write");
+                }
+                self->outbound_.pop_front();
+                if (self->outbound_.empty()) {
+                    self->writing_ = false;
+                } else {
+                    self->do_write();
+                }
+            });
+    }
+
+    void fail(beast::error_code ec, const char* what) {
+        if (!stopped_ && ec != net::error::operation_aborted) {
+            Logger::log(LogLevel::Warn, "Cluster link to ", member_.id, " ", what, " failed: ", ec.message());
+        }
+        disconnect();
+        if (stopped_) {
+            return;
+        }
+        retryTimer_.expires_after(retryDelay_);
+        retryTimer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (!ec) {
+                self->connect();
+            }
+        });
+    }
+
+    void disconnect() {
+        // Handlers of the old connection see a different epoch and do nothing
+        ++epoch_;
+        connected_ = false;
+        writing_ = false;
+        outbound_.clear();
+        buffer_.consume(buffer_.size());
+        if (ws_) {
+            beast::error_code ignored;
+            beast::get_lowest_layer(*ws_).socket().close(ignored);
+        }
+
+        auto pending = std::move(pending_);
+        pending_.clear();
+        for (auto& [id, reply] : pending) {
+            reply(unavailable());
+        }
+    }
+
+    SharedPayload unavailable() const {
+        return std::make_shared<const std::string>("ERROR: Show is managed by node " + member_.id +
+                                                   ", which is unavailable. Try again later.");
+    }
+
+    net::strand<net::io_context::executor_type> strand_;  ///< Serializes everything below
+    tcp::resolver resolver_;                               ///< Resolves member_.host
+    net::steady_timer retryTimer_;                         ///< Delays reconnects
+    std::unique_ptr<Stream> ws_;                           ///< Current connection, null before the first
+    beast::flat_buffer buffer_;                            ///< Incoming message
+    std::deque<std::string> outbound_;                     ///< Messages to send, front is in flight
+    std::unordered_map<uint64_t, ReplyCallback> pending_;  ///< Forwarded bookings by request id
+    ClusterMember member_;                                 ///< Node at the other end
+    std::chrono::milliseconds retryDelay_;                 ///< Wait before reconnecting
+    std::string secret_;                                   ///< Proves to the other node that this is a peer
+    ClusterNode::RelayCallback onRelay_;                   ///< Receives published deltas
+    ClusterNode::SyncCallback onSync_;                     ///< Receives the seat state, set on replicas only
+    uint64_t nextId_ = 0;                                  ///< Last request id used
+    uint64_t epoch_ = 0;                                   ///< Bumped per connection attempt
+    bool connected_ = false;                               ///< Handshake done, requests may be sent
+    bool writing_ = false;                                 ///< A write is in flight
+    bool stopped_ = false;                                 ///< stop() was called
+};
+
+ClusterNode::ClusterNode(net::io_context& ioc, ClusterOptions options, const ShowStore& shows,
+                         RelayCallback onRelay, SyncCallback onSync)
+    : options_(std::move(options)),
+      ring_([this]() {
+          std::vector<std::string> names;
+          for (const auto& member : options_.members) {
+              names.push_back(member.id);
+          }
+          return names;
+      }(), options_.virtualNodes) {
+    const auto& names = ring_.nodes();
+    auto self = std::find(names.begin(), names.end(), options_.nodeId);
+    if (options_.replica) {
+        // Not on the ring, so no show is owned here
+        self_ = names.size();
+    } else if (self == names.end()) {
+        throw std::invalid_argument("node " + options_.nodeId + " is not a cluster member");
+    } else {
+        self_ = static_cast<std::size_t>(self - names.begin());
+    }
+
+    owners_.reserve(shows.size());
+    for (const auto& show : shows) {
+        owners_.push_back(static_cast<uint32_t>(ring_.ownerIndex(ShardRing::showKey(show))));
+    }
+
+    links_.resize(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (i != self_) {
+            links_[i] = std::make_shared<PeerLink>(ioc, options_.members[i], options_.retryDelay, options_.secret, onRelay,
+                                                   options_.replica ? onSync : SyncCallback{});
+        }
+    }
+}
+
+ClusterNode::~ClusterNode() {
+    stop();
+}
+
+void ClusterNode::start() {
+    for (auto& link : links_) {
+        if (link) {
+            link->start();
+        }
+    }
+}
+
+void ClusterNode::stop() {
+    for (auto& link : links_) {
+        if (link) {
+            link->stop();
+        }
+    }
+}
+
+bool ClusterNode::owns(ShowId showId) const {
+    return showId >= owners_.size() || owners_[showId] == self_;
+}
+
+const std::string& ClusterNode::ownerOf(ShowId showId) const {
+    return showId < owners_.size() ? ring_.nodes()[owners_[showId]] : options_.nodeId;
+}
+
+bool ClusterNode::forward(ShowId showId, const std::string& message, WireFormat format, ReplyCallback reply) {
+    if (owns(showId)) {
+        return false;
+    }
+    ServerMetrics::instance().bookingsForwarded.inc();
+    links_[owners_[showId]]->forward(message, format, std::move(reply));
+    return true;
+}
+
+const ShardRing& ClusterNode::ring() const {
+    return ring_;
+}
+
+bool ClusterNode::replica() const {
+    return options_.replica;
+}
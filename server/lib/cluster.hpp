@@ -0,0 +1,237 @@
+/**
+ * @file cluster.hpp
+ * @brief Show ownership across nodes and the links between them
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "cinema.hpp"
+#include "websocket_server.hpp"
+
+/**
+ * @struct ClusterMember
+ * @brief One node of the cluster and where its WebSocket listener is
+ */
+struct ClusterMember {
+    std::string id;     ///< Node name, the same on every node
+    std::string host;   ///< Host name or address
+    std::string port;   ///< Listener port
+};
+
+/**
+ * @struct ClusterOptions
+ * @brief Membership of the cluster as seen by one node
+ */
+struct ClusterOptions {
+    std::string nodeId;                      ///< Name of this node
+    std::vector<ClusterMember> members;      ///< Every node, including this one
+    std::size_t virtualNodes = 128;          ///< Ring points per node
+    std::chrono::milliseconds retryDelay{1000};  ///< Wait before reconnecting a lost link
+    bool replica = false;                    ///< Own no shows and resync from the members, see ClusterNode
+    std::string secret;                      ///< Shared secret sent in the peer hello, see WebSocketServer::setPeerSecret()
+
+    /**
+     * @brief Parse a member list
+     * @param nodes Comma-separated "id=host:port" entries
+     * @return Members in the given order, malformed entries skipped
+     */
+    static std::vector<ClusterMember> parseMembers(std::string_view nodes);
+};
+
+/**
+ * @class ShardRing
+ * @brief Consistent hash ring mapping show keys to nodes
+ *
+ * Every node is placed on a 64-bit ring at several pseudo-random points
+ * (virtual nodes); a key belongs to the first point at or after its hash.
+ * Adding or removing a node only moves the keys next to its points, about
+ * 1/N of them, and every node computes the same owners from the same
+ * member names.
+ *
+ * @par Thread Safety
+ * Immutable after construction.
+ */
+class ShardRing {
+public:
+    /**
+     * @brief Constructor
+     * @param nodes Node names, order does not matter
+     * @param virtualNodes Points per node, more gives a more even split
+     * @pre nodes is not empty
+     */
+    explicit ShardRing(std::vector<std::string> nodes, std::size_t virtualNodes = 128);
+
+    /**
+     * @brief Find the node owning a key
+     * @param key Show key, see showKey()
+     * @return Index into nodes()
+     */
+    std::size_t ownerIndex(std::string_view key) const;
+
+    /**
+     * @brief Find the node owning a key
+     * @param key Show key, see showKey()
+     * @return Name of the owning node
+     */
+    const std::string& owner(std::string_view key) const;
+
+    /**
+     * @brief Get the node names
+     * @return Names given at construction
+     */
+    const std::vector<std::string>& nodes() const;
+
+    /**
+     * @brief Key shows are placed by
+     * @param show Show to place
+     * @return "theater/movie", the pair bookings name a show by
+     */
+    static std::string showKey(const Shows& show);
+
+    /**
+     * @brief Hash used for keys and ring points
+     * @param value Bytes to hash
+     * @return FNV-1a with a final avalanche step
+     */
+    static uint64_t hash(std::string_view value);
+
+private:
+    std::vector<std::string> nodes_;                      ///< Node names
+    std::vector<std::pair<uint64_t, uint32_t>> points_;   ///< Sorted ring points and their node
+};
+
+class PeerLink;
+
+/**
+ * @class ClusterNode
+ * @brief This node's view of the cluster
+ *
+ * Assigns every show to a node with a ShardRing and keeps a WebSocket
+ * link to each other node. Bookings for shows owned elsewhere travel over
+ * the owner's link as CinemaProtocol::FORWARD requests; the owner answers
+ * with FORWARDED. Every node publishes the SEAT_DELTA of its own bookings
+ * to the peers subscribed to it (WebSocketServer::publish()), and each
+ * link hands the deltas it receives to the relay callback, which applies
+ * them to the local copy and broadcasts them to local clients.
+ *
+ * @par Consistency
+ * Only the owner books a show, so seats are never double-booked across
+ * nodes. Other nodes mirror the show through the relayed deltas; a delta
+ * published while a link was down is missed until the mirror sees the
+ * next one for that seat, which affects displayed availability only.
+ *
+ * @par Replicas
+ * With ClusterOptions::replica the node is not on the ring: it owns no
+ * show, so every booking, hold and best-seat request is forwarded, while
+ * get_data, refresh, queries and subscriptions are answered from its own
+ * mirror. options.nodeId need not be a member. Each link asks its node
+ * for the full seat state (CinemaProtocol::SYNC_REQUEST) on every
+ * connect and hands the reply to the sync callback, so the mirror
+ * catches up on whatever was booked before it started or while the link
+ * was down. Members need no configuration for their replicas.
+ *
+ * @par Thread Safety
+ * owns(), ownerOf() and forward() may be called from any thread. Each
+ * link runs on its own strand; replies and relays are delivered there.
+ */
+class ClusterNode {
+public:
+    /**
+     * @brief Callback receiving a SEAT_DELTA published by another node
+     */
+    using RelayCallback = std::function<void(const std::string& delta)>;
+
+    /**
+     * @brief Callback receiving the seat state a replica asked for, see ReplicaSync
+     */
+    using SyncCallback = std::function<void(const std::string& state)>;
+
+    /**
+     * @brief Constructor
+     * @param ioc I/O context the links run on
+     * @param options Membership; options.nodeId must be one of the members
+     * @param shows Catalogue, identical on every node
+     * @param onRelay Called for every delta published by another node
+     * @param onSync Called with each seat state received by a replica
+     * @throws std::invalid_argument if options.nodeId is not a member of a
+     *         node that is not a replica
+     * @post Ownership is computed; links are not connected until start()
+     */
+    ClusterNode(net::io_context& ioc, ClusterOptions options, const ShowStore& shows, RelayCallback onRelay,
+                SyncCallback onSync = {});
+
+    /**
+     * @brief Destructor
+     * @post Links are stopped
+     */
+    ~ClusterNode();
+
+    ClusterNode(const ClusterNode&) = delete;
+    ClusterNode& operator=(const ClusterNode&) = delete;
+
+    /**
+     * @brief Connect to every other node, reconnecting when a link drops
+     */
+    void start();
+
+    /**
+     * @brief Close every link
+     */
+    void stop();
+
+    /**
+     * @brief Check whether this node books a show
+     * @param showId Show to check
+     * @return true if this node owns @p showId
+     */
+    bool owns(ShowId showId) const;
+
+    /**
+     * @brief Name the node owning a show
+     * @param showId Show to look up
+     * @return Owner's node name
+     */
+    const std::string& ownerOf(ShowId showId) const;
+
+    /**
+     * @brief Send a booking to the node owning its show
+     * @param showId Show the booking is for
+     * @param message Booking request as received
+     * @param format Wire format of the requesting session
+     * @param reply Called with the owner's reply, or an error if the owner
+     *        cannot be reached
+     * @return false if this node owns the show, in which case @p reply is
+     *         not used; compatible with BookingForwarder
+     */
+    bool forward(ShowId showId, const std::string& message, WireFormat format, ReplyCallback reply);
+
+    /**
+     * @brief Get the owner assignment
+     * @return Ring built from the members
+     */
+    const ShardRing& ring() const;
+
+    /**
+     * @brief Check whether this node is a replica
+     * @return true if it owns no shows, see Replicas
+     */
+    bool replica() const;
+
+private:
+    ClusterOptions options_;                        ///< Membership
+    ShardRing ring_;                                ///< Owner assignment
+    std::size_t self_;                              ///< Index of this node in ring_.nodes(), past the end for a replica
+    std::vector<uint32_t> owners_;                  ///< Owner index per ShowId
+    std::vector<std::shared_ptr<PeerLink>> links_;  ///< Link per node index, null for this node
+};
@@ -0,0 +1,208 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+std::atomic<LogLevel> Logger::threshold_{LogLevel::Info};
+
+namespace {
+
+/**
+ * @class LogSink
+ * @brief Ring buffer of pending lines and the thread that writes them
+ */
+class LogSink {
+public:
+    static constexpr std::size_t CAPACITY = 8192;                      ///< Pending lines kept at most
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{50};     ///< Longest delay before writing
+    
+    LogSink() : ring_(CAPACITY), writer_([this]() { run(); }) {}
+    
+    ~LogSink() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+    
+    static LogSink& instance() {
+        static LogSink sink;
+        return sink;
+    }
+    
+    void push(LogLevel level, std::string message) {
+        auto now = std::chrono::system_clock::now();
+        bool wakeWriter = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size_ == CAPACITY) {
+                ++dropped_;
+                return;
+            }
+            Entry& entry = ring_[(head_ + size_) % CAPACITY];
+            entry.level = level;
+            entry.time = now;
+            entry.message.swap(message);
+            ++size_;
+            ++queued_;
+            wakeWriter = size_ == CAPACITY / 2;
+        }
+        if (wakeWriter) {
+            wake_.notify_one();
+        }
+    }
+    
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = queued_;
+        wake_.notify_one();
+        written_cv_.wait(lock, [&]() { return written_ >= target || stopping_; });
+    }
+
+private:
+    struct Entry {
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+    
+    void run() {
+        std::vector<Entry> batch;
+        batch.reserve(CAPACITY);
+        std::string out;
+        std::string err;
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait_for(lock, FLUSH_INTERVAL, [&]() { return stopping_ || size_ > 0; });
+            
+            uint64_t dropped = std::exchange(dropped_, 0);
+            std::size_t count = size_;
+            for (std::size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(ring_[(head_ + i) % CAPACITY]));
+                ring_[(head_ + i) % CAPACITY].message.clear();
+            }
+            head_ = (head_ + count) % CAPACITY;
+            size_ = 0;
+            bool stopping = stopping_;
+            lock.unlock();
+            
+            // Formatting and console I/O happen outside the lock
+            for (const Entry& entry : batch) {
+                std::string& target = entry.level >= LogLevel::Warn ? err : out;
+                appendLine(target, entry);
+            }
+            if (dropped > 0) {
+                err += "[WARN] " + std::to_string(dropped) + " log line(s) dropped, log buffer full\n";
+            }
+            if (!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+            if (!err.empty()) {
+                std::fwrite(err.data(), 1, err.size(), stderr);
+                std::fflush(stderr);
+                err.clear();
+            }
+            batch.clear();
+            
+            lock.lock();
+            written_ += count;
+            written_cv_.notify_all();
+            if (stopping && size_ == 0) {
+                return;
+            }
+        }
+    }
+    
+    static void appendLine(std::string& out, const Entry& entry) {
+        static constexpr const char* NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+        
+        std::time_t seconds = std::chrono::system_clock::to_time_t(entry.time);
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            entry.time.time_since_epoch()).count() % 1000;
+        std::tm local{};
+        localtime_r(&seconds, &local);
+        
+        char stamp[32];
+        std::size_t length = std::strftime(stamp, sizeof(stamp), "%H:%M:%S", &local);
+        std::snprintf(stamp + length, sizeof(stamp) - length, ".%03d", static_cast<int>(millis));
+        
+        out += stamp;
+        out += " [";
+        out += NAMES[static_cast<std::size_t>(entry.level)];
+        out += "] ";
+        out += entry.message;
+        out += '\n';
+    }
+    
+    std::vector<Entry> ring_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    uint64_t queued_ = 0;
+    uint64_t written_ = 0;
+    uint64_t dropped_ = 0;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_cv_;
+    std::thread writer_;
+};
+
+}
+
+void Logger::setLevel(LogLevel level) {
+    threshold_.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::level() {
+    return threshold_.load(std::memory_order_relaxed);
+}
+
+void Logger::submit(LogLevel level, std::string message) {
+    LogSink::instance().push(level, std::move(message));
+}
+
+void Logger::flush() {
+    LogSink::instance().flush();
+}
+
+LogLevel Logger::parseLevel(std::string_view name, LogLevel fallback) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "debug") return LogLevel::Debug;
+    if (lower == "info") return LogLevel::Info;
+    if (lower == "warn" || lower == "warning") return LogLevel::Warn;
+    if (lower == "error") return LogLevel::Error;
+    if (lower == "off") return LogLevel::Off;
+    return fallback;
+}
+
+LogRateLimiter::LogRateLimiter(double perSecond, double burst)
+    : perSecond_(perSecond), burst_(burst), tokens_(burst), last_(Clock::now()) {}
+
+bool LogRateLimiter::allow() {
+    auto now = Clock::now();
+    tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * perSecond_);
+    last_ = now;
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        return true;
+    }
+    ++suppressed_;
+    return false;
+}
+
+uint64_t LogRateLimiter::takeSuppressed() {
+    return std::exchange(suppressed_, 0);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file logger.hpp
+ * @brief Asynchronous leveled logging for the Cinema server
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief Severity of a log line
+ */
+enum class LogLevel : uint8_t {
+    Debug,  ///< Per-message tracing
+    Info,   ///< Connections, startup and other notable events
+    Warn,   ///< Recoverable problems such as slow consumers
+    Error,  ///< Failed operations
+    Off     ///< Disables logging when used as the threshold
+};
+
+/**
+ * @class Logger
+ * @brief Process-wide asynchronous log sink
+ * 
+ * Callers format their line and hand it to a bounded ring buffer; a
+ * background thread writes batches to stdout (Debug/Info) or stderr
+ * (Warn/Error) and flushes once per batch, so I/O threads never block on
+ * the console.
+ * 
+ * @par Overflow
+ * When the ring is full new lines are dropped rather than blocking the
+ * caller; the number dropped is reported by the flusher.
+ * 
+ * @par Thread Safety
+ * All methods may be called from any thread. Lines from one thread keep
+ * their order.
+ */
+class Logger {
+public:
+    /**
+     * @brief Set the minimum level that is logged
+     * @param level New threshold, LogLevel::Off disables logging
+     */
+    static void setLevel(LogLevel level);
+    
+    /**
+     * @brief Get the minimum level that is logged
+     * @return Current threshold
+     */
+    static LogLevel level();
+    
+    /**
+     * @brief Check whether a level would be logged
+     * @param level Level to check
+     * @return true if lines of @p level pass the threshold
+     * @note Use before building expensive messages
+     */
+    static bool enabled(LogLevel level) {
+        LogLevel threshold = threshold_.load(std::memory_order_relaxed);
+        return level != LogLevel::Off && level >= threshold;
+    }
+    
+    /**
+     * @brief Format and queue one line
+     * @param level Severity of the line
+     * @param args Values streamed into the line with operator<<
+     * @note Nothing is formatted if @p level is below the threshold
+     */
+    template <typename... Args>
+    static void log(LogLevel level, const Args&... args) {
+        if (!enabled(level)) {
+            return;
+        }
+        std::ostringstream ss;
+        (ss << ... << args);
+        submit(level, ss.str());
+    }
+    
+    /**
+     * @brief Queue an already formatted line
+     * @param level Severity of the line
+     * @param message Line without trailing newline
+     */
+    static void submit(LogLevel level, std::string message);
+    
+    /**
+     * @brief Wait until every line queued so far has been written
+     */
+    static void flush();
+    
+    /**
+     * @brief Parse a level name
+     * @param name "debug", "info", "warn", "error" or "off" (any case)
+     * @param fallback Level returned for unknown names
+     * @return Parsed level
+     */
+    static LogLevel parseLevel(std::string_view name, LogLevel fallback);
+
+private:
+    static std::atomic<LogLevel> threshold_;  ///< Minimum level logged
+};
+
+/**
+ * @class LogRateLimiter
+ * @brief Token bucket limiting how often one source may log
+ * 
+ * Used per session so a single noisy client cannot flood the log. Lines
+ * refused by allow() are counted and reported with the next allowed one.
+ * 
+ * @note Not thread-safe; each session uses its own limiter on its strand
+ */
+class LogRateLimiter {
+public:
+    /**
+     * @brief Constructor
+     * @param perSecond Sustained lines per second
+     * @param burst Lines allowed at once after a quiet period
+     */
+    explicit LogRateLimiter(double perSecond = 5.0, double burst = 20.0);
+    
+    /**
+     * @brief Take one token if available
+     * @return true if the line may be logged
+     */
+    bool allow();
+    
+    /**
+     * @brief Get and reset the number of refused lines
+     * @return Lines refused since the last call
+     */
+    uint64_t takeSuppressed();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    double perSecond_;          ///< Refill rate
+    double burst_;              ///< Bucket size
+    double tokens_;             ///< Tokens currently available
+    Clock::time_point last_;    ///< Time of the last refill
+    uint64_t suppressed_ = 0;   ///< Refused lines not yet reported
+};
@@ -0,0 +1,164 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Shard of the calling thread
+ * @return Index assigned round-robin on the thread's first metric update
+ */
+std::size_t threadShard() {
+    static std::atomic<std::size_t> nextShard{0};
+    thread_local std::size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+std::string formatNumber(double value) {
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+}
+
+void MetricCounter::inc(uint64_t n) {
+    shards_[threadShard()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricHistogram::MetricHistogram(std::vector<uint64_t> bounds) : bounds_(std::move(bounds)) {
+    if (bounds_.size() > MAX_BOUNDS) {
+        bounds_.resize(MAX_BOUNDS);
+    }
+}
+
+void MetricHistogram::observe(uint64_t value) {
+    std::size_t bucket = static_cast<std::size_t>(
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+    Shard& shard = shards_[threadShard()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void MetricHistogram::observe(std::chrono::steady_clock::duration elapsed) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    observe(static_cast<uint64_t>(std::max<int64_t>(0, ns)));
+}
+
+const std::vector<uint64_t>& MetricHistogram::bounds() const {
+    return bounds_;
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const {
+    Snapshot result;
+    result.counts.assign(bounds_.size() + 1, 0);
+    for (const auto& shard : shards_) {
+        for (std::size_t b = 0; b <= bounds_.size(); ++b) {
+            result.counts[b] += shard.counts[b].load(std::memory_order_relaxed);
+        }
+        result.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    for (uint64_t count : result.counts) {
+        result.count += count;
+    }
+    return result;
+}
+
+std::vector<uint64_t> MetricHistogram::latencyBounds() {
+    return {1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+            1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000,
+            100'000'000, 250'000'000, 500'000'000, 1'000'000'000, 2'500'000'000};
+}
+
+std::vector<uint64_t> MetricHistogram::depthBounds() {
+    return {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+}
+
+ServerMetrics& ServerMetrics::instance() {
+    static ServerMetrics metrics;
+    return metrics;
+}
+
+std::string ServerMetrics::render() const {
+    std::string out;
+    renderCounter(out, "cinema_messages_total", "Client messages handled", messages.value());
+    
+    out += "# HELP cinema_bookings_total Booking requests by outcome\n";
+    out += "# TYPE cinema_bookings_total counter\n";
+    out += "cinema_bookings_total{result=\"success\"} " + std::to_string(bookingsSucceeded.value()) + "\n";
+    out += "cinema_bookings_total{result=\"conflict\"} " + std::to_string(bookingsConflicted.value()) + "\n";
+    out += "cinema_bookings_total{result=\"rejected\"} " + std::to_string(bookingsRejected.value()) + "\n";
+    
+    renderCounter(out, "cinema_broadcasts_total", "Broadcasts sent to all sessions", broadcasts.value());
+    renderCounter(out, "cinema_bookings_forwarded_total", "Bookings sent to the node owning the show", bookingsForwarded.value());
+    renderCounter(out, "cinema_relayed_deltas_total", "Seat deltas applied from other nodes", relayedDeltas.value());
+    renderCounter(out, "cinema_replica_syncs_total", "Seat states applied from a primary", replicaSyncs.value());
+    renderCounter(out, "cinema_batched_bookings_total", "Bookings received in batch requests", batchedBookings.value());
+    renderCounter(out, "cinema_broadcast_deltas_batched_total", "Seat deltas held back and merged into a batch", deltasBatched.value());
+    out += "# HELP cinema_holds_total Seat holds by outcome\n";
+    out += "# TYPE cinema_holds_total counter\n";
+    out += "cinema_holds_total{result=\"placed\"} " + std::to_string(holdsPlaced.value()) + "\n";
+    out += "cinema_holds_total{result=\"confirmed\"} " + std::to_string(holdsConfirmed.value()) + "\n";
+    out += "cinema_holds_total{result=\"released\"} " + std::to_string(holdsReleased.value()) + "\n";
+    out += "cinema_holds_total{result=\"expired\"} " + std::to_string(holdsExpired.value()) + "\n";
+    out += "# HELP cinema_queries_total Availability queries by outcome\n";
+    out += "# TYPE cinema_queries_total counter\n";
+    out += "cinema_queries_total{result=\"answered\"} " + std::to_string(queriesAnswered.value()) + "\n";
+    out += "cinema_queries_total{result=\"invalid\"} " + std::to_string(queriesRejected.value()) + "\n";
+    out += "# HELP cinema_best_seat_retries_total Best-seat blocks lost to a concurrent booking\n";
+    out += "# TYPE cinema_best_seat_retries_total counter\n";
+    out += "cinema_best_seat_retries_total " + std::to_string(bestSeatRetries.value()) + "\n";
+    out += "# HELP cinema_connections_refused_total Connections shed by admission control\n";
+    out += "# TYPE cinema_connections_refused_total counter\n";
+    out += "cinema_connections_refused_total{reason=\"connections\"} " + std::to_string(refusedConnectionCap.value()) + "\n";
+    out += "cinema_connections_refused_total{reason=\"address\"} " + std::to_string(refusedAddressCap.value()) + "\n";
+    out += "cinema_connections_refused_total{reason=\"connect_rate\"} " + std::to_string(refusedConnectRate.value()) + "\n";
+    out += "cinema_connections_refused_total{reason=\"handshakes\"} " + std::to_string(refusedHandshakeCap.value()) + "\n";
+    renderCounter(out, "cinema_messages_refused_total", "Messages refused by the rate limits", messagesRefused.value());
+    renderCounter(out, "cinema_flooding_clients_dropped_total", "Sessions closed for staying over the rate limit", floodingClientsDropped.value());
+    
+    renderCounter(out, "cinema_slow_consumers_dropped_total", "Sessions closed for not keeping up", slowConsumersDropped.value());
+    renderHistogram(out, "cinema_message_handling_seconds", "Time to handle one client message", messageHandling, 1e-9);
+    renderHistogram(out, "cinema_format_seconds", "Time to rebuild a cached catalogue payload", formatting, 1e-9);
+    renderHistogram(out, "cinema_broadcast_fanout_seconds", "Time to queue one broadcast on every session", broadcastFanOut, 1e-9);
+    renderHistogram(out, "cinema_outbound_queue_depth", "Frames queued on a session, sampled on enqueue", outboundQueueDepth, 1.0);
+    return out;
+}
+
+void ServerMetrics::renderCounter(std::string& out, const std::string& name, const std::string& help, uint64_t value) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " counter\n";
+    out += name + " " + std::to_string(value) + "\n";
+}
+
+void ServerMetrics::renderGauge(std::string& out, const std::string& name, const std::string& help, uint64_t value) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " gauge\n";
+    out += name + " " + std::to_string(value) + "\n";
+}
+
+void ServerMetrics::renderHistogram(std::string& out, const std::string& name, const std::string& help,
+                                    const MetricHistogram& histogram, double scale) {
+    MetricHistogram::Snapshot snap = histogram.snapshot();
+    const auto& bounds = histogram.bounds();
+    
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " histogram\n";
+    uint64_t cumulative = 0;
+    for (std::size_t b = 0; b < bounds.size(); ++b) {
+        cumulative += snap.counts[b];
+        out += name + "_bucket{le=\"" + formatNumber(static_cast<double>(bounds[b]) * scale) + "\"} " +
+               std::to_string(cumulative) + "\n";
+    }
+    out += name + "_bucket{le=\"+Inf\"} " + std::to_string(snap.count) + "\n";
+    out += name + "_sum " + formatNumber(static_cast<double>(snap.sum) * scale) + "\n";
+    out += name + "_count " + std::to_string(snap.count) + "\n";
+}
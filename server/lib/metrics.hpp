@@ -0,0 +1,227 @@
+/**
+ * @file metrics.hpp
+ * @brief Low-overhead counters and histograms exposed in Prometheus format
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Number of per-thread shards of every metric
+ *
+ * Threads are assigned to shards round-robin on first use, so up to this
+ * many I/O threads update a metric without sharing a cache line.
+ */
+constexpr std::size_t METRIC_SHARDS = 16;
+
+/**
+ * @class MetricCounter
+ * @brief Monotonic counter split into per-thread shards
+ *
+ * @par Thread Safety
+ * inc() is a relaxed atomic add on the calling thread's shard and never
+ * blocks; value() sums the shards.
+ */
+class MetricCounter {
+public:
+    /**
+     * @brief Add to the counter
+     * @param n Amount to add
+     */
+    void inc(uint64_t n = 1);
+
+    /**
+     * @brief Get the current total
+     * @return Sum over all shards
+     */
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, METRIC_SHARDS> shards_;  ///< One shard per thread slot
+};
+
+/**
+ * @class MetricHistogram
+ * @brief Fixed-bucket histogram split into per-thread shards
+ *
+ * Values are unsigned integers in a base unit (nanoseconds for durations)
+ * and are counted in the first bucket whose upper bound is not below them;
+ * values above the last bound land in the +Inf bucket.
+ *
+ * @par Thread Safety
+ * observe() only does relaxed atomic adds on the calling thread's shard.
+ * snapshot() may run concurrently and sees each add either fully or not.
+ */
+class MetricHistogram {
+public:
+    static constexpr std::size_t MAX_BOUNDS = 24;  ///< Largest number of finite buckets
+
+    /**
+     * @struct Snapshot
+     * @brief Totals of a histogram at one point in time
+     */
+    struct Snapshot {
+        std::vector<uint64_t> counts;  ///< Per-bucket counts, last one is +Inf
+        uint64_t sum = 0;              ///< Sum of observed values
+        uint64_t count = 0;            ///< Number of observed values
+    };
+
+    /**
+     * @brief Constructor
+     * @param bounds Ascending bucket upper bounds, at most MAX_BOUNDS
+     */
+    explicit MetricHistogram(std::vector<uint64_t> bounds);
+
+    /**
+     * @brief Record one value
+     * @param value Value in the histogram's base unit
+     */
+    void observe(uint64_t value);
+
+    /**
+     * @brief Record a duration in nanoseconds
+     * @param elapsed Duration to record
+     */
+    void observe(std::chrono::steady_clock::duration elapsed);
+
+    /**
+     * @brief Get the bucket upper bounds
+     * @return Bounds given at construction
+     */
+    const std::vector<uint64_t>& bounds() const;
+
+    /**
+     * @brief Sum all shards
+     * @return Current totals
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Bounds from 1us to 2.5s for latencies in nanoseconds
+     */
+    static std::vector<uint64_t> latencyBounds();
+
+    /**
+     * @brief Powers of two from 1 to 1024 for queue depths
+     */
+    static std::vector<uint64_t> depthBounds();
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, MAX_BOUNDS + 1> counts{};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    std::vector<uint64_t> bounds_;                 ///< Finite bucket upper bounds
+    std::array<Shard, METRIC_SHARDS> shards_;      ///< One shard per thread slot
+};
+
+/**
+ * @class ServerMetrics
+ * @brief Process-wide metrics of the Cinema server
+ *
+ * Updated from the hot paths (message handling, booking, formatting and
+ * broadcasting) and rendered for the HTTP /metrics route.
+ *
+ * @par Metrics
+ * - cinema_messages_total: client messages handled
+ * - cinema_bookings_total{result}: success, conflict (seat taken) or rejected
+ * - cinema_message_handling_seconds: time in the message callback
+ * - cinema_format_seconds: time to rebuild a cached catalogue
+ * - cinema_broadcast_fanout_seconds: time to queue a broadcast on every session
+ * - cinema_outbound_queue_depth: frames queued on a session, sampled on enqueue
+ * - cinema_slow_consumers_dropped_total: sessions closed by backpressure
+ * - cinema_bookings_forwarded_total: bookings sent to the owning cluster node
+ * - cinema_relayed_deltas_total: seat deltas applied from other nodes
+ * - cinema_holds_total{result}: holds placed, confirmed, released or expired
+ * - cinema_queries_total{result}: availability queries answered or invalid
+ * - cinema_best_seat_retries_total: best-seat blocks lost to a concurrent booking
+ * - cinema_connections_refused_total{reason}: connections shed by admission control
+ * - cinema_messages_refused_total: messages over the rate limits
+ * - cinema_flooding_clients_dropped_total: sessions closed for flooding
+ */
+class ServerMetrics {
+public:
+    MetricCounter messages;                 ///< Client messages handled
+    MetricCounter broadcasts;               ///< Broadcasts sent
+    MetricCounter bookingsSucceeded;        ///< Bookings that reserved their seats
+    MetricCounter bookingsConflicted;       ///< Bookings that lost to an earlier one
+    MetricCounter bookingsRejected;         ///< Malformed or invalid bookings
+    MetricCounter slowConsumersDropped;     ///< Sessions closed as slow consumers
+    MetricCounter bookingsForwarded;        ///< Bookings sent to the owning cluster node
+    MetricCounter relayedDeltas;            ///< Seat deltas applied from other nodes
+    MetricCounter batchedBookings;          ///< Bookings received in batch requests
+    MetricCounter deltasBatched;            ///< Seat deltas held back and merged into a batch
+    MetricCounter holdsPlaced;              ///< Seat holds granted
+    MetricCounter holdsConfirmed;           ///< Seat holds turned into bookings
+    MetricCounter holdsReleased;            ///< Seat holds given up by the client
+    MetricCounter holdsExpired;             ///< Seat holds released by their deadline
+    MetricCounter queriesAnswered;          ///< Availability queries answered
+    MetricCounter queriesRejected;          ///< Malformed availability queries
+    MetricCounter bestSeatRetries;          ///< Best-seat blocks taken by another booking mid-allocation
+    MetricCounter replicaSyncs;             ///< Seat states applied from a primary
+    MetricCounter refusedConnectionCap;     ///< Connections refused at the total cap
+    MetricCounter refusedAddressCap;        ///< Connections refused at the per-address cap
+    MetricCounter refusedConnectRate;       ///< Connections refused by the per-address connect rate
+    MetricCounter refusedHandshakeCap;      ///< Connections refused with too many handshakes pending
+    MetricCounter messagesRefused;          ///< Messages refused by the rate limits
+    MetricCounter floodingClientsDropped;   ///< Sessions closed for staying over the rate limit
+    MetricHistogram messageHandling{MetricHistogram::latencyBounds()};   ///< ns per message
+    MetricHistogram formatting{MetricHistogram::latencyBounds()};        ///< ns per catalogue rebuild
+    MetricHistogram broadcastFanOut{MetricHistogram::latencyBounds()};   ///< ns per broadcast
+    MetricHistogram outboundQueueDepth{MetricHistogram::depthBounds()};  ///< Frames per session queue
+
+    /**
+     * @brief Get the process-wide instance
+     * @return Metrics shared by all servers and services
+     */
+    static ServerMetrics& instance();
+
+    /**
+     * @brief Render all metrics in the Prometheus text format
+     * @return Exposition text, version 0.0.4
+     */
+    std::string render() const;
+
+    /**
+     * @brief Append one counter in the Prometheus text format
+     * @param out Text to append to
+     * @param name Metric name
+     * @param help HELP line text
+     * @param value Counter value
+     */
+    static void renderCounter(std::string& out, const std::string& name, const std::string& help, uint64_t value);
+
+    /**
+     * @brief Append one gauge in the Prometheus text format
+     * @param out Text to append to
+     * @param name Metric name
+     * @param help HELP line text
+     * @param value Gauge value
+     */
+    static void renderGauge(std::string& out, const std::string& name, const std::string& help, uint64_t value);
+
+    /**
+     * @brief Append one histogram in the Prometheus text format
+     * @param out Text to append to
+     * @param name Metric name
+     * @param help HELP line text
+     * @param histogram Histogram to render
+     * @param scale Factor converting the base unit (1e-9 for ns to seconds)
+     */
+    static void renderHistogram(std::string& out, const std::string& name, const std::string& help,
+                                const MetricHistogram& histogram, double scale);
+};
@@ -0,0 +1,193 @@
+#include "replica_sync.hpp"
+#include "metrics.hpp"
+#include "websocket_server.hpp"
+#include <bit>
+#include <charconv>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Append words as comma-separated hex
+ */
+void appendWords(std::string& out, const uint64_t* words, size_t count) {
+    char text[16];
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        auto [end, err] = std::to_chars(text, text + sizeof(text), words[i], 16);
+        out.append(text, end);
+    }
+}
+
+/**
+ * @brief Parse exactly @p count comma-separated hex words
+ * @return false if the text holds another number of words or anything else
+ */
+bool parseWords(std::string_view text, uint64_t* words, size_t count) {
+    const char* cursor = text.data();
+    const char* end = text.data() + text.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0 && (cursor == end || *cursor++ != ',')) {
+            return false;
+        }
+        auto [next, err] = std::from_chars(cursor, end, words[i], 16);
+        if (err != std::errc()) {
+            return false;
+        }
+        cursor = next;
+    }
+    return cursor == end;
+}
+
+/**
+ * @brief Collect the 1-based seats whose bit is set in @p words
+ */
+std::vector<SeatNumber> seatsOf(const std::vector<uint64_t>& words, size_t seatCount) {
+    std::vector<SeatNumber> seats;
+    for (size_t word = 0; word < words.size(); ++word) {
+        for (uint64_t bits = words[word]; bits != 0; bits &= bits - 1) {
+            size_t index = word * SeatMap::WORD_BITS + static_cast<size_t>(std::countr_zero(bits));
+            if (index < seatCount) {
+                seats.push_back(static_cast<SeatNumber>(index + 1));
+            }
+        }
+    }
+    return seats;
+}
+
+} // namespace
+
+bool ReplicaSync::isSyncRequest(std::string_view message) {
+    return message == CinemaProtocol::SYNC_REQUEST;
+}
+
+bool ReplicaSync::isState(std::string_view message) {
+    return message.substr(0, CinemaProtocol::STATE_SYNC_PREFIX.size()) ==
+           CinemaProtocol::STATE_SYNC_PREFIX;
+}
+
+SharedPayload ReplicaSync::formatState(const ShowStore& shows, const ShowFilter& include) {
+    std::string out = std::string(CinemaProtocol::STATE_SYNC_PREFIX) + std::to_string(shows.size());
+    std::vector<uint64_t> taken;
+    std::vector<uint64_t> booked;
+    for (ShowId id = 0; id < shows.size(); ++id) {
+        if (include && !include(id)) {
+            continue;
+        }
+        const SeatMap& seats = shows[id].seats;
+        size_t words = seats.wordCount();
+        taken.resize(words);
+        booked.resize(words);
+        // A seat changing between the two loads looks held; the delta
+        // announcing the change follows and corrects it
+        seats.loadBookedWords(booked.data());
+        seats.loadWords(taken.data());
+
+        bool any = false;
+        bool held = false;
+        for (size_t w = 0; w < words; ++w) {
+            taken[w] &= ~booked[w];
+            any = any || booked[w] != 0 || taken[w] != 0;
+            held = held || taken[w] != 0;
+        }
+        // An empty show still gets its line, so the replica frees holds it missed the release of
+        out += '\n';
+        out += std::to_string(id);
+        out += ':';
+        if (!any) {
+            continue;
+        }
+        appendWords(out, booked.data(), words);
+        if (held) {
+            out += ';';
+            appendWords(out, taken.data(), words);
+        }
+    }
+    return std::make_shared<const std::string>(std::move(out));
+}
+
+bool ReplicaSync::applyState(std::string_view state, ShowStore& shows, const BookingCallback& onBooked,
+                             size_t& changed) {
+    changed = 0;
+    if (!isState(state)) {
+        return false;
+    }
+    state.remove_prefix(CinemaProtocol::STATE_SYNC_PREFIX.size());
+    size_t headerEnd = state.find('\n');
+    std::string_view header = state.substr(0, headerEnd);
+    size_t showCount = 0;
+    auto [countEnd, countErr] = std::from_chars(header.data(), header.data() + header.size(), showCount);
+    if (countErr != std::errc() || countEnd != header.data() + header.size() || showCount != shows.size()) {
+        return false;
+    }
+    state = headerEnd == std::string_view::npos ? std::string_view{} : state.substr(headerEnd + 1);
+
+    std::vector<uint64_t> remoteBooked;
+    std::vector<uint64_t> remoteHeld;
+    std::vector<uint64_t> localTaken;
+    std::vector<uint64_t> localBooked;
+    while (!state.empty()) {
+        size_t lineEnd = state.find('\n');
+        std::string_view line = state.substr(0, lineEnd);
+        state = lineEnd == std::string_view::npos ? std::string_view{} : state.substr(lineEnd + 1);
+
+        size_t colon = line.find(':');
+        ShowId id = 0;
+        auto [idEnd, idErr] = std::from_chars(line.data(), line.data() + (colon == std::string_view::npos ? 0 : colon), id);
+        if (colon == std::string_view::npos || idErr != std::errc() || idEnd != line.data() + colon ||
+            id >= shows.size()) {
+            return false;
+        }
+        Shows& show = shows[id];
+        size_t words = show.seats.wordCount();
+        std::string_view rest = line.substr(colon + 1);
+        size_t semicolon = rest.find(';');
+        remoteBooked.assign(words, 0);
+        remoteHeld.assign(words, 0);
+        if ((!rest.empty() && !parseWords(rest.substr(0, semicolon), remoteBooked.data(), words)) ||
+            (semicolon != std::string_view::npos &&
+             !parseWords(rest.substr(semicolon + 1), remoteHeld.data(), words))) {
+            return false;
+        }
+
+        localTaken.resize(words);
+        localBooked.resize(words);
+        show.seats.loadBookedWords(localBooked.data());
+        show.seats.loadWords(localTaken.data());
+
+        // Per word: newly booked, newly held,
+        // and holds the primary no longer has
+        std::vector<uint64_t> book(words), hold(words), release(words);
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t localHeld = localTaken[w] & ~localBooked[w];
+            book[w] = remoteBooked[w] & ~localBooked[w];
+            hold[w] = remoteHeld[w] & ~localTaken[w] & ~remoteBooked[w];
+            release[w] = localHeld & ~remoteHeld[w] & ~remoteBooked[w];
+        }
+
+        bool updated = false;
+        uint64_t version = 0;
+        std::vector<SeatNumber> seats = seatsOf(book, show.seats.size());
+        if (!seats.empty()) {
+            // Books free seats and confirms ones held here in one state change
+            show.settleSeats(seats.data(), seats.size(), version);
+            if (onBooked) {
+                onBooked(id, seats.data(), seats.size());
+            }
+            updated = true;
+        }
+        seats = seatsOf(hold, show.seats.size());
+        if (!seats.empty()) {
+            updated = show.holdSeats(seats.data(), seats.size(), version) || updated;
+        }
+        seats = seatsOf(release, show.seats.size());
+        if (!seats.empty()) {
+            updated = show.releaseSeats(seats.data(), seats.size(), version) || updated;
+        }
+        changed += updated ? 1 : 0;
+    }
+    ServerMetrics::instance().replicaSyncs.inc();
+    return true;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file replica_sync.hpp
+ * @brief Full seat state exchanged when a replica (re)connects
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "cinema.hpp"
+
+/**
+ * @class ReplicaSync
+ * @brief Formats and applies the seat state a replica catches up from
+ *
+ * A replica (ClusterOptions::replica) mirrors the shows of its primary
+ * through the relayed seat deltas, which only carry changes: whatever was
+ * booked before the replica started, or while its link was down, is
+ * missing. On every connect the replica therefore sends
+ * CinemaProtocol::SYNC_REQUEST after PEER_HELLO, and the primary answers
+ * with its current seat state. Deltas already published to the replica
+ * are either older than that state or arrive after it and apply on top.
+ *
+ * @par Message Format
+ * "STATE_SYNC:<show count>" followed by one line per reported show,
+ * "<show id>:<booked words>[;<held words>]", or just "<show id>:" when no
+ * seat is taken. Words are the show's SeatMap words in hex, comma
+ * separated; booked words leave held seats out and the held part is
+ * omitted when nothing is held.
+ *
+ * @par Applying
+ * Bookings are never undone, so booked seats are merged. Holds follow the
+ * primary: seats it holds are held here, holds it no longer has are freed.
+ *
+ * @par Thread Safety
+ * Both sides read and write the seat maps with their thread-safe
+ * operations and may run alongside bookings and relayed deltas.
+ */
+class ReplicaSync {
+public:
+    /**
+     * @brief Selects the shows a node reports, e.g. the ones it owns
+     */
+    using ShowFilter = std::function<bool(ShowId)>;
+
+    /**
+     * @brief Check whether a message asks for the seat state
+     * @param message Raw message received from a session
+     */
+    static bool isSyncRequest(std::string_view message);
+
+    /**
+     * @brief Check whether a message carries a seat state
+     * @param message Raw message received from the primary
+     */
+    static bool isState(std::string_view message);
+
+    /**
+     * @brief Format the current seat state
+     * @param shows Shows to report
+     * @param include Returns false for shows to leave out; empty reports all
+     * @return STATE_SYNC message, see Message Format
+     */
+    static SharedPayload formatState(const ShowStore& shows, const ShowFilter& include = {});
+
+    /**
+     * @brief Bring the local seats up to a primary's state
+     * @param state STATE_SYNC message
+     * @param shows Local copy of the same catalogue
+     * @param onBooked Called with the seats newly booked here, e.g. for the journal
+     * @param changed Output: shows whose seats changed
+     * @return false if the message is malformed or lists another number of
+     *         shows; lines before the error are kept
+     */
+    static bool applyState(std::string_view state, ShowStore& shows, const BookingCallback& onBooked,
+                           size_t& changed);
+};
@@ -0,0 +1,205 @@
+#include "seat_allocator.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+
+namespace {
+
+constexpr std::string_view BEST_USAGE = "ERROR: Invalid request. Use: book_best,theater,movie,count";
+
+SharedPayload makeReply(std::string text) {
+    return std::make_shared<const std::string>(std::move(text));
+}
+
+/**
+ * @brief Check a block against a copy of the seat words
+ * @param words Seat bits, 1 = booked
+ * @param first 0-based first seat
+ * @param length Seats in the block, at most SeatMap::WORD_BITS
+ */
+bool blockFree(const uint64_t* words, size_t first, size_t length) {
+    size_t word = first / SeatMap::WORD_BITS;
+    size_t bit = first % SeatMap::WORD_BITS;
+    uint64_t mask = length == SeatMap::WORD_BITS ? ~uint64_t{0} : (uint64_t{1} << length) - 1;
+    uint64_t taken = (words[word] >> bit) & mask;
+    if (bit + length > SeatMap::WORD_BITS) {
+        taken |= words[word + 1] & (mask >> (SeatMap::WORD_BITS - bit));
+    }
+    return taken == 0;
+}
+
+} // namespace
+
+SeatLayout::SeatLayout(size_t seatCount)
+    : seatCount_(seatCount), scores_(seatCount) {
+    size_t rows = (seatCount + ROW_SEATS - 1) / ROW_SEATS;
+    size_t preferredRow = rows > 0 ? (rows - 1) * 2 / 3 : 0;
+    for (size_t index = 0; index < seatCount; ++index) {
+        size_t row = index / ROW_SEATS;
+        size_t width = std::min(ROW_SEATS, seatCount - row * ROW_SEATS);
+        size_t column = index % ROW_SEATS;
+        // In half seats, so the middle of an even row is not favoured to one side
+        size_t fromCentre = column * 2 > width - 1 ? column * 2 - (width - 1) : (width - 1) - column * 2;
+        size_t fromRow = row > preferredRow ? row - preferredRow : preferredRow - row;
+        scores_[index] = static_cast<uint32_t>(fromCentre + fromRow * ROW_WEIGHT);
+    }
+
+    std::vector<uint64_t> prefix(seatCount + 1, 0);
+    for (size_t index = 0; index < seatCount; ++index) {
+        prefix[index + 1] = prefix[index] + scores_[index];
+    }
+    blocks_.resize(maxBlock());
+    std::vector<uint64_t> blockScores(seatCount, 0);
+    for (size_t length = 1; length <= blocks_.size(); ++length) {
+        std::vector<SeatNumber>& ranking = blocks_[length - 1];
+        for (size_t rowStart = 0; rowStart < seatCount; rowStart += ROW_SEATS) {
+            size_t rowEnd = std::min(rowStart + ROW_SEATS, seatCount);
+            for (size_t first = rowStart; first + length <= rowEnd; ++first) {
+                blockScores[first] = prefix[first + length] - prefix[first];
+                ranking.push_back(static_cast<SeatNumber>(first));
+            }
+        }
+        std::stable_sort(ranking.begin(), ranking.end(), [&blockScores](SeatNumber a, SeatNumber b) {
+            return blockScores[a] < blockScores[b];
+        });
+    }
+}
+
+size_t SeatLayout::seatCount() const {
+    return seatCount_;
+}
+
+size_t SeatLayout::maxBlock() const {
+    return std::min(seatCount_, ROW_SEATS);
+}
+
+const std::vector<SeatNumber>& SeatLayout::blocks(size_t length) const {
+    return blocks_[length - 1];
+}
+
+uint32_t SeatLayout::score(size_t index) const {
+    return scores_[index];
+}
+
+SeatAllocator::SeatAllocator(ShowStore& shows, const ShowRegistry& registry)
+    : shows_(shows), registry_(registry) {
+    showLayouts_.reserve(shows.size());
+    for (const Shows& show : shows) {
+        auto& layout = layouts_[show.seats.size()];
+        if (!layout) {
+            layout = std::make_unique<SeatLayout>(show.seats.size());
+        }
+        showLayouts_.push_back(layout.get());
+    }
+}
+
+bool SeatAllocator::isBestRequest(std::string_view message) {
+    return message.substr(0, BEST_PREFIX.size()) == BEST_PREFIX;
+}
+
+SharedPayload SeatAllocator::handleMessage(const std::string& message, BroadcastPayload& broadcast,
+                                           const BookingCallback& onBooked, const BookingForwarder& forward,
+                                           const ReplyCallback& reply) {
+    broadcast = {};
+    ServerMetrics& metrics = ServerMetrics::instance();
+    auto quote = [](std::string_view token) { return std::string(token.substr(0, 16)); };
+
+    std::string_view request(message);
+    request.remove_prefix(BEST_PREFIX.size());
+    size_t theaterEnd = request.find(',');
+    size_t movieEnd = theaterEnd == std::string_view::npos ? theaterEnd : request.find(',', theaterEnd + 1);
+    if (movieEnd == std::string_view::npos) {
+        metrics.bookingsRejected.inc();
+        return makeReply(std::string(BEST_USAGE));
+    }
+    std::string_view theater = request.substr(0, theaterEnd);
+    std::string_view movie = request.substr(theaterEnd + 1, movieEnd - theaterEnd - 1);
+    std::string_view countText = request.substr(movieEnd + 1);
+
+    size_t count = 0;
+    auto [end, err] = std::from_chars(countText.data(), countText.data() + countText.size(), count);
+    if (err != std::errc() || end != countText.data() + countText.size() || count == 0) {
+        metrics.bookingsRejected.inc();
+        return makeReply(std::string(BEST_USAGE));
+    }
+
+    auto id = registry_.find(theater, movie);
+    if (!id) {
+        metrics.bookingsRejected.inc();
+        return makeReply("ERROR: Show not found - " + quote(movie) + " at " + quote(theater));
+    }
+    if (forward && reply && forward(*id, message, WireFormat::Text, reply)) {
+        return nullptr;
+    }
+
+    size_t maxBlock = layout(*id).maxBlock();
+    if (count > maxBlock) {
+        metrics.bookingsRejected.inc();
+        return makeReply("ERROR: At most " + std::to_string(maxBlock) + " adjacent seats per booking for " +
+                         quote(movie) + " at " + quote(theater));
+    }
+
+    SeatBuffer seats;
+    uint64_t sequence = 0;
+    if (!allocate(*id, count, seats, sequence)) {
+        metrics.bookingsConflicted.inc();
+        return makeReply("ERROR: No " + std::to_string(count) + " adjacent seats available for " +
+                         quote(movie) + " at " + quote(theater));
+    }
+
+    metrics.bookingsSucceeded.inc();
+    if (onBooked) {
+        onBooked(*id, seats.data(), seats.size());
+    }
+    broadcast.text = std::make_shared<const std::string>(
+        CinemaService::formatSeatDelta(sequence, *id, seats.data(), seats.size()));
+    broadcast.binary = std::make_shared<const std::string>(
+        CinemaService::encodeSeatDelta(sequence, *id, seats.data(), seats.size()));
+    broadcast.show = *id;
+
+    std::string status = "SUCCESS: Booked seats ";
+    status.append(BookingService::describeSeats(seats.data(), seats.size()));
+    status.append(" for ").append(movie).append(" at ").append(theater);
+    return makeReply(std::move(status));
+}
+
+bool SeatAllocator::allocate(ShowId show, size_t count, SeatBuffer& seats, uint64_t& sequence) {
+    Shows& target = shows_[show];
+    const SeatLayout& seatLayout = layout(show);
+    if (count == 0 || count > seatLayout.maxBlock()) {
+        return false;
+    }
+
+    // Auditoriums up to 1024 seats are copied to the stack
+    std::array<uint64_t, 16> local;
+    std::vector<uint64_t> large;
+    uint64_t* words = local.data();
+    if (target.seats.wordCount() > local.size()) {
+        large.resize(target.seats.wordCount());
+        words = large.data();
+    }
+    target.seats.loadWords(words);
+    const std::vector<SeatNumber>& ranking = seatLayout.blocks(count);
+    for (size_t i = 0; i < ranking.size();) {
+        if (!blockFree(words, ranking[i], count)) {
+            ++i;
+            continue;
+        }
+        seats = SeatBuffer();
+        for (size_t seat = 0; seat < count; ++seat) {
+            seats.push(static_cast<SeatNumber>(ranking[i] + seat + 1));
+        }
+        if (target.bookSeats(seats.data(), seats.size(), sequence)) {
+            return true;
+        }
+        // Lost the block to a concurrent booking: look again from here
+        ServerMetrics::instance().bestSeatRetries.inc();
+        target.seats.loadWords(words);
+    }
+    return false;
+}
+
+const SeatLayout& SeatAllocator::layout(ShowId show) const {
+    return *showLayouts_[show];
+}
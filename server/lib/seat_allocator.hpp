@@ -0,0 +1,155 @@
+/**
+ * @file seat_allocator.hpp
+ * @brief Server-side choice of the best free block of seats
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cinema.hpp"
+
+/**
+ * @class SeatLayout
+ * @brief Rows of an auditorium and its seat blocks ranked best first
+ *
+ * Seats are numbered row by row, ROW_SEATS to a row (the last row may be
+ * shorter). A seat scores its distance from the centre of its row plus
+ * ROW_WEIGHT per row away from the preferred row, two thirds of the way
+ * back; a block scores the sum of its seats. Blocks never span rows.
+ *
+ * The ranking of every block length is computed once per seat count, so
+ * picking seats is a walk down a precomputed list.
+ */
+class SeatLayout {
+public:
+    static constexpr size_t ROW_SEATS = 20;      ///< Seats per row
+    static constexpr uint32_t ROW_WEIGHT = 3;    ///< Score of one row away from the preferred row, in half seats
+
+    /**
+     * @brief Build the ranking of an auditorium
+     * @param seatCount Seats in the auditorium
+     */
+    explicit SeatLayout(size_t seatCount);
+
+    /**
+     * @brief Get the number of seats
+     */
+    size_t seatCount() const;
+
+    /**
+     * @brief Get the longest block that fits in a row
+     */
+    size_t maxBlock() const;
+
+    /**
+     * @brief Get the blocks of a length, best first
+     * @param length Seats in the block, 1 to maxBlock()
+     * @return 0-based first seats; ties keep the lower seat first
+     */
+    const std::vector<SeatNumber>& blocks(size_t length) const;
+
+    /**
+     * @brief Score a seat, lower is better
+     * @param index 0-based seat index
+     */
+    uint32_t score(size_t index) const;
+
+private:
+    size_t seatCount_;                              ///< Seats in the auditorium
+    std::vector<uint32_t> scores_;                  ///< Score of every seat
+    std::vector<std::vector<SeatNumber>> blocks_;   ///< blocks_[length - 1]: first seats, best first
+};
+
+/**
+ * @class SeatAllocator
+ * @brief Books the best block of adjacent free seats in one request
+ *
+ * Instead of naming seats, which loses to anyone who picked the same ones
+ * first, a client asks for a number of seats and the server takes the
+ * best block still free.
+ *
+ * @par Message Format
+ * "book_best,theater,movie,count" replies the SUCCESS: line of a booking
+ * naming the seats taken, or an ERROR: line if the show has no such block.
+ * The catalogue is not appended; the SEAT_DELTA broadcast carries the
+ * change.
+ *
+ * @par Allocation
+ * The seat map is copied once and the show's ranking walked until a
+ * block is free in the copy, which is then booked with compare-and-swap.
+ * If another booking takes one of its seats first, the copy is refreshed
+ * and the walk goes on from the same block, so a contended request costs
+ * one more pass over the words instead of a round-trip to the client.
+ *
+ * @par Cluster
+ * Requests for shows owned by another node are forwarded like bookings.
+ *
+ * @par Thread Safety
+ * handleMessage() and allocate() may be called from any thread; the
+ * layouts are built at construction and only read afterwards.
+ */
+class SeatAllocator {
+public:
+    static constexpr std::string_view BEST_PREFIX = "book_best,";   ///< Starts every request
+
+    /**
+     * @brief Build the layout of every auditorium size in a catalogue
+     * @param shows Shows to book, must outlive this
+     * @param registry Registry of @p shows, must outlive this
+     */
+    SeatAllocator(ShowStore& shows, const ShowRegistry& registry);
+
+    SeatAllocator(const SeatAllocator&) = delete;
+    SeatAllocator& operator=(const SeatAllocator&) = delete;
+
+    /**
+     * @brief Check whether a message is a best-seat request
+     * @param message Raw message received from a client
+     */
+    static bool isBestRequest(std::string_view message);
+
+    /**
+     * @brief Handle a best-seat request
+     * @param message Request, see Message Format
+     * @param broadcast Output: the SEAT_DELTA to send, empty on failure
+     * @param onBooked Called with the seats taken, see BookingCallback
+     * @param forward Offered the request first, see BookingForwarder
+     * @param reply Receives the reply of a forwarded request
+     * @return Reply to send back, or null if the request was forwarded
+     */
+    SharedPayload handleMessage(const std::string& message, BroadcastPayload& broadcast,
+                                const BookingCallback& onBooked = {},
+                                const BookingForwarder& forward = {},
+                                const ReplyCallback& reply = {});
+
+    /**
+     * @brief Book the best free block of a show
+     * @param show Show to book
+     * @param count Adjacent seats wanted
+     * @param seats Output: the seats booked, in order
+     * @param sequence Output: broadcast sequence of the booking
+     * @return false if no block of @p count seats is free
+     */
+    bool allocate(ShowId show, size_t count, SeatBuffer& seats, uint64_t& sequence);
+
+    /**
+     * @brief Get the layout a show is booked by
+     * @param show Show id
+     */
+    const SeatLayout& layout(ShowId show) const;
+
+private:
+    ShowStore& shows_;                                                  ///< Shows to book
+    const ShowRegistry& registry_;                                      ///< Resolves theater and movie
+    std::unordered_map<size_t, std::unique_ptr<SeatLayout>> layouts_;   ///< Seat count -> layout
+    std::vector<const SeatLayout*> showLayouts_;                        ///< Layout of every show
+};
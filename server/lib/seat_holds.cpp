@@ -0,0 +1,325 @@
+#include "seat_holds.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+namespace {
+
+constexpr std::string_view HOLD_PREFIX = "hold:";
+constexpr std::string_view CONFIRM_PREFIX = "confirm:";
+constexpr std::string_view RELEASE_PREFIX = "release:";
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+/**
+ * @brief Split a "<showId>-<n>" token
+ * @return false if @p token is malformed
+ */
+bool parseToken(std::string_view token, ShowId& show, uint64_t& id) {
+    const char* last = token.data() + token.size();
+    auto [dash, showErr] = std::from_chars(token.data(), last, show);
+    if (showErr != std::errc() || dash == last || *dash != '-') {
+        return false;
+    }
+    auto [end, idErr] = std::from_chars(dash + 1, last, id);
+    return idErr == std::errc() && end == last;
+}
+
+/**
+ * @brief Find the colon ending an optional "<seconds>:" before a booking
+ * @return Its position, or npos if @p request starts with the booking;
+ *         a showtime such as "movie@2025-09-11 22:00" has colons too
+ */
+size_t ttlEnd(std::string_view request) {
+    size_t colon = request.find(':');
+    if (colon == 0 || colon == std::string_view::npos || colon > request.find(',')) {
+        return std::string_view::npos;
+    }
+    bool digits = std::all_of(request.begin(), request.begin() + colon, [](char c) { return c >= '0' && c <= '9'; });
+    return digits ? colon : std::string_view::npos;
+}
+
+SharedPayload makeReply(std::string text) {
+    return std::make_shared<const std::string>(std::move(text));
+}
+
+void announce(BroadcastPayload& broadcast, uint64_t sequence, ShowId show, const std::vector<SeatNumber>& seats,
+              SeatChange change) {
+    broadcast.text = std::make_shared<const std::string>(
+        CinemaService::formatSeatDelta(sequence, show, seats.data(), seats.size(), change));
+    broadcast.binary = std::make_shared<const std::string>(
+        CinemaService::encodeSeatDelta(sequence, show, seats.data(), seats.size(), change));
+    broadcast.show = show;
+}
+
+} // namespace
+
+SeatHolds::SeatHolds(net::io_context& ioc, ShowStore& shows, const ShowRegistry& registry,
+                     HoldOptions options, ExpiryCallback onExpired)
+    : shows_(shows),
+      registry_(registry),
+      options_(options),
+      onExpired_(std::move(onExpired)),
+      epoch_(std::chrono::steady_clock::now()),
+      strand_(net::make_strand(ioc)),
+      timer_(strand_) {
+    std::random_device device;
+    idSource_.seed((static_cast<uint64_t>(device()) << 32) | device());
+    options_.tick = std::max(options_.tick, std::chrono::milliseconds(1));
+    options_.maxTtl = std::max(options_.maxTtl, std::chrono::seconds(1));
+    options_.defaultTtl = std::clamp(options_.defaultTtl, std::chrono::seconds(1), options_.maxTtl);
+}
+
+void SeatHolds::start() {
+    running_ = true;
+    net::post(strand_, [this] { armTimer(); });
+}
+
+void SeatHolds::stop() {
+    running_ = false;
+    net::post(strand_, [this] { timer_.cancel(); });
+}
+
+bool SeatHolds::isHoldRequest(std::string_view message) {
+    return startsWith(message, HOLD_PREFIX) || startsWith(message, CONFIRM_PREFIX) ||
+           startsWith(message, RELEASE_PREFIX);
+}
+
+bool SeatHolds::isReleaseRequest(std::string_view message) {
+    return startsWith(message, RELEASE_PREFIX);
+}
+
+SharedPayload SeatHolds::handleMessage(const std::string& message, BroadcastPayload& broadcast,
+                                       const BookingCallback& onBooked, const BookingForwarder& forward,
+                                       const ReplyCallback& reply) {
+    broadcast = {};
+    std::string_view request(message);
+    bool isHold = startsWith(request, HOLD_PREFIX);
+
+    // The show decides which node keeps the hold
+    ShowId show = ALL_SHOWS;
+    uint64_t id = 0;
+    std::string_view token;
+    if (isHold) {
+        request.remove_prefix(HOLD_PREFIX.size());
+        size_t colon = ttlEnd(request);
+        std::string_view booking = request.substr(colon == std::string_view::npos ? 0 : colon + 1);
+        size_t theaterEnd = booking.find(',');
+        size_t movieEnd = theaterEnd == std::string_view::npos ? theaterEnd : booking.find(',', theaterEnd + 1);
+        if (movieEnd != std::string_view::npos) {
+            show = registry_.find(booking.substr(0, theaterEnd), booking.substr(theaterEnd + 1, movieEnd - theaterEnd - 1))
+                       .value_or(ALL_SHOWS);
+        }
+    } else {
+        token = request.substr(request.find(':') + 1);
+        if (!parseToken(token, show, id) || show >= shows_.size()) {
+            return makeReply("ERROR: Invalid hold token. Use: confirm:<token> or release:<token>");
+        }
+    }
+
+    if (show != ALL_SHOWS && forward && reply && forward(show, message, WireFormat::Text, reply)) {
+        return nullptr;
+    }
+
+    if (isHold) {
+        return hold(request, broadcast);
+    }
+    if (startsWith(message, CONFIRM_PREFIX)) {
+        return confirm(show, id, std::string(token), broadcast, onBooked);
+    }
+    return release(show, id, std::string(token), broadcast);
+}
+
+SharedPayload SeatHolds::hold(std::string_view request, BroadcastPayload& broadcast) {
+    ServerMetrics& metrics = ServerMetrics::instance();
+
+    // Optional "<seconds>:" before the booking
+    std::chrono::seconds ttl = options_.defaultTtl;
+    size_t colon = ttlEnd(request);
+    if (colon != std::string_view::npos) {
+        unsigned seconds = 0;
+        auto [end, err] = std::from_chars(request.data(), request.data() + colon, seconds);
+        if (err != std::errc() || end != request.data() + colon || seconds == 0) {
+            metrics.bookingsRejected.inc();
+            return makeReply("ERROR: Invalid hold. Use: hold:[<seconds>:]theater,movie,seat1,seat2,...");
+        }
+        ttl = std::min(std::chrono::seconds(seconds), options_.maxTtl);
+        request.remove_prefix(colon + 1);
+    }
+
+    BookingService::ParsedBooking booking;
+    if (auto error = BookingService::parseBooking(request, shows_, registry_, booking)) {
+        metrics.bookingsRejected.inc();
+        return makeReply(std::move(*error));
+    }
+
+    Shows& show = shows_[booking.showId];
+    uint64_t sequence = 0;
+    if (!show.holdSeats(booking.seats.data(), booking.seats.size(), sequence)) {
+        metrics.bookingsConflicted.inc();
+        return makeReply("ERROR: One or more seats are already booked or invalid");
+    }
+
+    std::vector<SeatNumber> seats(booking.seats.begin(), booking.seats.end());
+    uint64_t id = 0;
+    {
+        TracedLock<std::mutex> lock(mutex_, "holds");
+        if (holds_.size() < options_.maxHolds) {
+            // 0 means no hold was placed
+            do {
+                id = idSource_();
+            } while (id == 0 || holds_.count(id) != 0);
+            uint64_t ticks = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(ttl).count() / options_.tick.count());
+            holds_.emplace(id, Hold{booking.showId, seats});
+            wheel_.schedule(id, currentTick() + std::max<uint64_t>(ticks, 1));
+        }
+    }
+    if (id == 0) {
+        show.releaseSeats(seats.data(), seats.size(), sequence);
+        metrics.bookingsRejected.inc();
+        return makeReply("ERROR: Too many seats on hold, try again later");
+    }
+
+    metrics.holdsPlaced.inc();
+    announce(broadcast, sequence, booking.showId, seats, SeatChange::Held);
+
+    std::string token = std::to_string(booking.showId) + "-" + std::to_string(id);
+    std::string status = "HELD: " + token + " seats " + BookingService::describeSeats(seats.data(), seats.size());
+    status.append(" for ").append(booking.movie).append(" at ").append(booking.theater);
+    status += ", expires in " + std::to_string(ttl.count()) + "s";
+    return makeReply(std::move(status));
+}
+
+SharedPayload SeatHolds::confirm(ShowId show, uint64_t id, const std::string& token, BroadcastPayload& broadcast,
+                                 const BookingCallback& onBooked) {
+    Hold held;
+    {
+        TracedLock<std::mutex> lock(mutex_, "holds");
+        auto it = holds_.find(id);
+        if (it == holds_.end() || it->second.show != show) {
+            ServerMetrics::instance().bookingsRejected.inc();
+            return makeReply("ERROR: Unknown or expired hold " + token.substr(0, 24));
+        }
+        held = std::move(it->second);
+        holds_.erase(it);
+    }
+
+    uint64_t sequence = 0;
+    if (!shows_[held.show].confirmSeats(held.seats.data(), held.seats.size(), sequence)) {
+        // Some seats were freed or taken behind the hold's back; the hold is
+        // gone, so the seats it still has go back on sale
+        const SeatMap& map = shows_[held.show].seats;
+        std::vector<uint64_t> taken(map.wordCount());
+        std::vector<uint64_t> booked(map.wordCount());
+        map.loadWords(taken.data());
+        map.loadBookedWords(booked.data());
+        std::vector<SeatNumber> stillHeld;
+        for (SeatNumber seat : held.seats) {
+            size_t index = seat - 1u;
+            uint64_t bit = uint64_t{1} << (index % SeatMap::WORD_BITS);
+            if ((taken[index / SeatMap::WORD_BITS] & ~booked[index / SeatMap::WORD_BITS]) & bit) {
+                stillHeld.push_back(seat);
+            }
+        }
+        if (!stillHeld.empty() &&
+            shows_[held.show].releaseSeats(stillHeld.data(), stillHeld.size(), sequence)) {
+            announce(broadcast, sequence, held.show, stillHeld, SeatChange::Freed);
+        }
+        ServerMetrics::instance().bookingsConflicted.inc();
+        return makeReply("ERROR: Hold " + token.substr(0, 24) + " no longer holds its seats");
+    }
+
+    ServerMetrics& metrics = ServerMetrics::instance();
+    metrics.holdsConfirmed.inc();
+    metrics.bookingsSucceeded.inc();
+    if (onBooked) {
+        onBooked(held.show, held.seats.data(), held.seats.size());
+    }
+    announce(broadcast, sequence, held.show, held.seats, SeatChange::Booked);
+
+    std::string status = "SUCCESS: Booked seats " + BookingService::describeSeats(held.seats.data(), held.seats.size());
+    status.append(" for ").append(shows_[held.show].movie).append(" at ").append(shows_[held.show].theater);
+    return makeReply(std::move(status));
+}
+
+SharedPayload SeatHolds::release(ShowId show, uint64_t id, const std::string& token, BroadcastPayload& broadcast) {
+    Hold held;
+    {
+        TracedLock<std::mutex> lock(mutex_, "holds");
+        auto it = holds_.find(id);
+        if (it == holds_.end() || it->second.show != show) {
+            return makeReply("ERROR: Unknown or expired hold " + token.substr(0, 24));
+        }
+        held = std::move(it->second);
+        holds_.erase(it);
+    }
+
+    uint64_t sequence = 0;
+    if (shows_[held.show].releaseSeats(held.seats.data(), held.seats.size(), sequence)) {
+        announce(broadcast, sequence, held.show, held.seats, SeatChange::Freed);
+    }
+    ServerMetrics::instance().holdsReleased.inc();
+    return makeReply("RELEASED: " + token);
+}
+
+std::size_t SeatHolds::expire(uint64_t tick) {
+    // Seats of every hold due this tick, grouped per show
+    std::map<ShowId, std::vector<SeatNumber>> freed;
+    std::size_t expired = 0;
+    {
+        TracedLock<std::mutex> lock(mutex_, "holds");
+        for (uint64_t id : wheel_.advance(tick)) {
+            auto it = holds_.find(id);
+            if (it == holds_.end()) {
+                continue;  // confirmed or released before its deadline
+            }
+            auto& seats = freed[it->second.show];
+            seats.insert(seats.end(), it->second.seats.begin(), it->second.seats.end());
+            holds_.erase(it);
+            ++expired;
+        }
+    }
+    if (expired == 0) {
+        return 0;
+    }
+
+    ServerMetrics::instance().holdsExpired.inc(expired);
+    for (const auto& [show, seats] : freed) {
+        uint64_t sequence = 0;
+        if (shows_[show].releaseSeats(seats.data(), seats.size(), sequence) && onExpired_) {
+            BroadcastPayload broadcast;
+            announce(broadcast, sequence, show, seats, SeatChange::Freed);
+            onExpired_(std::move(broadcast));
+        }
+    }
+    return expired;
+}
+
+uint64_t SeatHolds::currentTick() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch_);
+    return static_cast<uint64_t>(elapsed.count() / options_.tick.count());
+}
+
+std::size_t SeatHolds::size() const {
+    TracedLock<std::mutex> lock(mutex_, "holds");
+    return holds_.size();
+}
+
+void SeatHolds::armTimer() {
+    if (!running_) {
+        return;
+    }
+    timer_.expires_after(options_.tick);
+    timer_.async_wait([this](boost::system::error_code ec) {
+        if (ec) {
+            return;
+        }
+        expire(currentTick());
+        armTimer();
+    });
+}
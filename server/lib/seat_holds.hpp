@@ -0,0 +1,187 @@
+/**
+ * @file seat_holds.hpp
+ * @brief Temporary seat holds that expire unless confirmed
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cinema.hpp"
+#include "timer_wheel.hpp"
+
+namespace net = boost::asio;
+
+/**
+ * @struct HoldOptions
+ * @brief Lifetime limits of seat holds
+ */
+struct HoldOptions {
+    std::chrono::seconds defaultTtl{300};        ///< Lifetime when the request names none
+    std::chrono::seconds maxTtl{1800};           ///< Longest lifetime a request may ask for
+    std::chrono::milliseconds tick{100};         ///< Expiry resolution
+    std::size_t maxHolds = 100000;               ///< Holds open at once before new ones are refused
+};
+
+/**
+ * @class SeatHolds
+ * @brief Seats reserved for a while during checkout, then confirmed or freed
+ *
+ * A hold takes its seats like a booking does (Shows::holdSeats()), so
+ * nobody else can book them, but it is not journaled. The client confirms
+ * it into a booking or releases it; otherwise it expires. Deadlines live
+ * in a TimerWheel advanced by one timer every HoldOptions::tick, so any
+ * number of holds cost one timer and expiry is O(1) per hold.
+ *
+ * @par Message Format
+ * - "hold:[<seconds>:]theater,movie,seat1,..." replies
+ *   "HELD: <token> seats 3, 4 for <movie> at <theater>, expires in <n>s"
+ * - "confirm:<token>" replies the SUCCESS: line of a booking
+ * - "release:<token>" replies "RELEASED: <token>"
+ * - failures reply an ERROR: line
+ *
+ * Tokens are "<showId>-<n>", so any node can tell which show, and thus
+ * which owner, a token belongs to. n is a random 64-bit number, so a
+ * client cannot guess the token of another client's hold.
+ *
+ * @par Broadcasts
+ * Holds broadcast SEAT_HELD (binary SEAT_DELTA, since clients show held
+ * seats taken), confirmations SEAT_DELTA and releases and expiries
+ * SEAT_FREED. Expiries of one tick are merged into one SEAT_FREED per
+ * show.
+ *
+ * @par Cluster
+ * Holds are kept by the node owning the show; requests for other shows
+ * are forwarded there like bookings. Mirrors apply the relayed SEAT_HELD
+ * and SEAT_FREED deltas but never expire holds themselves.
+ *
+ * @par Thread Safety
+ * handleMessage() may be called from any thread. The hold table is
+ * guarded by a mutex only held for map and wheel updates; seats are
+ * changed outside of it through the lock-free SeatMap.
+ */
+class SeatHolds {
+public:
+    /**
+     * @brief Called with the SEAT_FREED broadcast of expired holds
+     * @note Runs on the expiry strand, once per show per tick
+     */
+    using ExpiryCallback = std::function<void(BroadcastPayload freed)>;
+
+    /**
+     * @brief Constructor
+     * @param ioc I/O context the expiry timer runs on
+     * @param shows Shows holds are placed in, must outlive this
+     * @param registry Registry of @p shows, must outlive this
+     * @param options Lifetime limits
+     * @param onExpired Receives the broadcast of every expiry
+     * @post No timer runs until start()
+     */
+    SeatHolds(net::io_context& ioc, ShowStore& shows, const ShowRegistry& registry,
+              HoldOptions options, ExpiryCallback onExpired);
+
+    SeatHolds(const SeatHolds&) = delete;
+    SeatHolds& operator=(const SeatHolds&) = delete;
+
+    /**
+     * @brief Start expiring holds every tick
+     */
+    void start();
+
+    /**
+     * @brief Stop the expiry timer; open holds stay as they are
+     */
+    void stop();
+
+    /**
+     * @brief Check whether a message is a hold, confirm or release request
+     * @param message Raw message received from a client
+     * @return true if handleMessage() should handle @p message
+     */
+    static bool isHoldRequest(std::string_view message);
+
+    /**
+     * @brief Check whether a hold request only gives seats back
+     * @param message Raw message received from a client
+     * @return true for release requests, which journal nothing
+     */
+    static bool isReleaseRequest(std::string_view message);
+
+    /**
+     * @brief Handle a hold, confirm or release request
+     * @param message Request, see Message Format
+     * @param broadcast Output: the seat change to send to clients, empty if
+     *        nothing changed
+     * @param onBooked Called for confirmed seats, see BookingCallback
+     * @param forward Offered requests for every show first, see
+     *        BookingForwarder
+     * @param reply Receives the reply of a forwarded request
+     * @return Reply to send back, or null if the request was forwarded
+     * @note As with bookings, requests are only forwarded if both
+     *       @p forward and @p reply are set
+     */
+    SharedPayload handleMessage(const std::string& message, BroadcastPayload& broadcast,
+                                const BookingCallback& onBooked = {},
+                                const BookingForwarder& forward = {},
+                                const ReplyCallback& reply = {});
+
+    /**
+     * @brief Release every hold due at or before a tick
+     * @param tick Tick to expire up to, see currentTick()
+     * @return Holds expired
+     * @note Called by the expiry timer; public so tests can move time on
+     */
+    std::size_t expire(uint64_t tick);
+
+    /**
+     * @brief Get the tick the clock is at
+     * @return Ticks since construction
+     */
+    uint64_t currentTick() const;
+
+    /**
+     * @brief Count open holds
+     * @return Holds neither confirmed, released nor expired
+     */
+    std::size_t size() const;
+
+private:
+    struct Hold {
+        ShowId show;                       ///< Show the seats are in
+        std::vector<SeatNumber> seats;     ///< Held seats
+    };
+
+    SharedPayload hold(std::string_view request, BroadcastPayload& broadcast);
+    SharedPayload confirm(ShowId show, uint64_t id, const std::string& token, BroadcastPayload& broadcast,
+                          const BookingCallback& onBooked);
+    SharedPayload release(ShowId show, uint64_t id, const std::string& token, BroadcastPayload& broadcast);
+    void armTimer();
+
+    ShowStore& shows_;                                   ///< Shows holds are placed in
+    const ShowRegistry& registry_;                       ///< Resolves theater and movie
+    HoldOptions options_;                                ///< Lifetime limits
+    ExpiryCallback onExpired_;                           ///< Receives expiry broadcasts
+    std::chrono::steady_clock::time_point epoch_;        ///< Tick 0
+    net::strand<net::io_context::executor_type> strand_; ///< Runs the expiry timer
+    net::steady_timer timer_;                            ///< Fires every tick
+    std::atomic<bool> running_{false};                   ///< start() called, stop() not yet
+
+    mutable std::mutex mutex_;                           ///< Protects the fields below
+    std::unordered_map<uint64_t, Hold> holds_;           ///< Open holds by id
+    TimerWheel wheel_;                                   ///< Deadlines of the holds, cancelled lazily
+    std::mt19937_64 idSource_;                           ///< Draws hold ids
+};
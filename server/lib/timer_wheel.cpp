@@ -0,0 +1,65 @@
+#include "timer_wheel.hpp"
+#include <utility>
+
+TimerWheel::TimerWheel(uint64_t now) : now_(now) {}
+
+void TimerWheel::schedule(uint64_t id, uint64_t deadline) {
+    place({id, deadline > now_ ? deadline : now_ + 1});
+    ++size_;
+}
+
+std::vector<uint64_t> TimerWheel::advance(uint64_t now) {
+    std::vector<uint64_t> due;
+    while (now_ < now) {
+        if (size_ == 0) {
+            now_ = now;
+            break;
+        }
+        ++now_;
+
+        // Coarser slots reaching this tick move their entries down, top
+        // level first so they can cascade again within the same tick
+        if ((now_ & ((uint64_t{1} << (LEVELS * SLOT_BITS)) - 1)) == 0) {
+            for (const Entry& entry : std::exchange(overflow_, {})) {
+                place(entry);
+            }
+        }
+        for (std::size_t level = LEVELS - 1; level > 0; --level) {
+            if ((now_ & ((uint64_t{1} << (level * SLOT_BITS)) - 1)) != 0) {
+                continue;
+            }
+            auto& slot = slots_[level][(now_ >> (level * SLOT_BITS)) & (SLOTS - 1)];
+            for (const Entry& entry : std::exchange(slot, {})) {
+                place(entry);
+            }
+        }
+
+        auto& slot = slots_[0][now_ & (SLOTS - 1)];
+        for (const Entry& entry : slot) {
+            due.push_back(entry.id);
+        }
+        size_ -= slot.size();
+        slot.clear();
+    }
+    return due;
+}
+
+uint64_t TimerWheel::now() const {
+    return now_;
+}
+
+std::size_t TimerWheel::size() const {
+    return size_;
+}
+
+void TimerWheel::place(const Entry& entry) {
+    // Lowest level whose coarser digits the deadline shares with now
+    for (std::size_t level = 0; level < LEVELS; ++level) {
+        std::size_t shift = (level + 1) * SLOT_BITS;
+        if ((entry.deadline >> shift) == (now_ >> shift)) {
+            slots_[level][(entry.deadline >> (level * SLOT_BITS)) & (SLOTS - 1)].push_back(entry);
+            return;
+        }
+    }
+    overflow_.push_back(entry);
+}
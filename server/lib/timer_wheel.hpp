@@ -0,0 +1,91 @@
+/**
+ * @file timer_wheel.hpp
+ * @brief Hierarchical timer wheel for many coarse deadlines
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Deadlines counted in ticks, scheduled and expired in O(1)
+ *
+ * Four levels of 64 slots each cover 2^24 ticks ahead of now(); a level
+ * L slot spans 64^L ticks. An entry goes into the lowest level whose
+ * coarser digits it still shares with now(), and moves down a level each
+ * time the wheel reaches its slot (cascading), so every entry is touched
+ * at most once per level. Deadlines further out wait in an overflow list
+ * that is re-examined every 2^24 ticks.
+ *
+ * @par Cancellation
+ * Entries cannot be removed. Owners cancel lazily: they forget the id and
+ * ignore it when advance() reports it, which keeps scheduling a plain
+ * push_back.
+ *
+ * @par Thread Safety
+ * Not thread-safe; callers serialize access.
+ */
+class TimerWheel {
+public:
+    static constexpr std::size_t LEVELS = 4;        ///< Wheel levels
+    static constexpr std::size_t SLOT_BITS = 6;     ///< log2 of the slots per level
+    static constexpr std::size_t SLOTS = std::size_t{1} << SLOT_BITS;  ///< Slots per level
+
+    /**
+     * @brief Constructor
+     * @param now Tick the wheel starts at
+     */
+    explicit TimerWheel(uint64_t now = 0);
+
+    /**
+     * @brief Schedule an id to expire at a tick
+     * @param id Caller's identifier, reported back by advance()
+     * @param deadline Tick at which @p id is due; deadlines not after now()
+     *        are due on the next tick
+     */
+    void schedule(uint64_t id, uint64_t deadline);
+
+    /**
+     * @brief Move the wheel forward and collect what became due
+     * @param now New current tick; earlier ticks are ignored
+     * @return Ids whose deadline is at or before @p now, in no particular
+     *         order, including lazily cancelled ones
+     */
+    std::vector<uint64_t> advance(uint64_t now);
+
+    /**
+     * @brief Get the current tick
+     * @return Last tick passed to advance(), or the starting tick
+     */
+    uint64_t now() const;
+
+    /**
+     * @brief Count scheduled entries
+     * @return Entries not reported by advance() yet
+     */
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        uint64_t id;         ///< Caller's identifier
+        uint64_t deadline;   ///< Tick the entry is due at
+    };
+
+    /**
+     * @brief Put an entry into the slot matching its deadline
+     * @param entry Entry with a deadline after now_
+     */
+    void place(const Entry& entry);
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots_;  ///< Entries per level and slot
+    std::vector<Entry> overflow_;    ///< Entries beyond the top level
+    uint64_t now_;                   ///< Current tick
+    std::size_t size_ = 0;           ///< Scheduled entries
+};
@@ -0,0 +1,231 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief One recorded event; names point to string literals
+ */
+struct Event {
+    const char* category;
+    const char* name;
+    TraceStamp start;
+    TraceStamp duration;
+    uint64_t id;
+    char phase;   ///< 'X' span, 'i' instant, 'b'/'e' async begin and end
+};
+
+/**
+ * @brief Events of one thread, kept after the thread exits
+ */
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    const char* name = nullptr;
+    std::mutex mutex;             ///< Only contended while the trace is written
+    std::vector<Event> events;
+    std::size_t dropped = 0;      ///< Events refused at maxEventsPerThread
+};
+
+struct TraceState {
+    std::mutex mutex;                                    ///< Protects the fields below
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    TraceOptions options;
+    std::atomic<std::size_t> maxEvents{TraceOptions{}.maxEventsPerThread};
+    std::atomic<uint32_t> sampleEvery{TraceOptions{}.sampleEvery};
+    std::atomic<uint64_t> sampled{0};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+TraceState& state() {
+    static TraceState instance;
+    return instance;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceState& trace = state();
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = trace.buffers.back().get();
+        buffer->tid = static_cast<uint32_t>(trace.buffers.size());
+    }
+    return *buffer;
+}
+
+void record(const Event& event) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= state().maxEvents.load(std::memory_order_relaxed)) {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events.push_back(event);
+}
+
+/**
+ * @brief Append nanoseconds as the microseconds Chrome traces use
+ */
+void appendMicros(std::string& out, TraceStamp nanos) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%llu.%03u", static_cast<unsigned long long>(nanos / 1000),
+                               static_cast<unsigned>(nanos % 1000));
+    out.append(text, static_cast<std::size_t>(length));
+}
+
+void appendString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        out += *c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+
+void Tracer::start(TraceOptions options) {
+    TraceState& trace = state();
+    {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.maxEvents.store(options.maxEventsPerThread, std::memory_order_relaxed);
+        trace.sampleEvery.store(std::max<uint32_t>(1, options.sampleEvery), std::memory_order_relaxed);
+        trace.options = std::move(options);
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+bool Tracer::stop() {
+    enabled_.store(false, std::memory_order_relaxed);
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(state().mutex);
+        path = state().options.path;
+    }
+    if (path.empty()) {
+        return true;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << toJson();
+    return static_cast<bool>(out.flush());
+}
+
+TraceStamp Tracer::now() {
+    // Never 0, which marks untraced stamps
+    return static_cast<TraceStamp>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - state().epoch).count()) + 1;
+}
+
+uint64_t Tracer::sample() {
+    TraceState& trace = state();
+    uint64_t n = trace.sampled.fetch_add(1, std::memory_order_relaxed) + 1;
+    return n % trace.sampleEvery.load(std::memory_order_relaxed) == 0 ? n : 0;
+}
+
+void Tracer::nameThread(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Tracer::complete(const char* category, const char* name, TraceStamp start, TraceStamp end, uint64_t id) {
+    record({category, name, start, end > start ? end - start : 0, id, 'X'});
+}
+
+void Tracer::instant(const char* category, const char* name, uint64_t id) {
+    record({category, name, now(), 0, id, 'i'});
+}
+
+void Tracer::asyncBegin(const char* name, uint64_t id, TraceStamp at) {
+    record({"request", name, at, 0, id, 'b'});
+}
+
+void Tracer::asyncEnd(const char* name, uint64_t id, TraceStamp at) {
+    record({"request", name, at, 0, id, 'e'});
+}
+
+std::string Tracer::toJson() {
+    TraceState& trace = state();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) {
+            out += ",\n";
+        }
+        first = false;
+    };
+    for (const auto& buffer : trace.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        std::string tid = std::to_string(buffer->tid);
+
+        separator();
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":";
+        appendString(out, buffer->name ? buffer->name : ("thread " + tid).c_str());
+        out += "}}";
+        if (buffer->dropped > 0) {
+            separator();
+            out += "{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"trace\",\"name\":\"events dropped\",\"ts\":0,\"pid\":1,\"tid\":" +
+                   tid + ",\"args\":{\"count\":" + std::to_string(buffer->dropped) + "}}";
+        }
+
+        for (const Event& event : buffer->events) {
+            separator();
+            out += "{\"ph\":\"";
+            out += event.phase;
+            out += "\",\"cat\":";
+            appendString(out, event.category);
+            out += ",\"name\":";
+            appendString(out, event.name);
+            out += ",\"ts\":";
+            appendMicros(out, event.start);
+            if (event.phase == 'X') {
+                out += ",\"dur\":";
+                appendMicros(out, event.duration);
+            } else if (event.phase == 'i') {
+                out += ",\"s\":\"t\"";
+            } else {
+                out += ",\"id\":" + std::to_string(event.id);
+            }
+            out += ",\"pid\":1,\"tid\":" + tid;
+            if (event.id != 0) {
+                out += ",\"args\":{\"request\":" + std::to_string(event.id) + "}";
+            }
+            out += '}';
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+std::size_t Tracer::eventCount() {
+    TraceState& trace = state();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    std::size_t count = 0;
+    for (const auto& buffer : trace.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+void Tracer::clear() {
+    TraceState& trace = state();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    for (const auto& buffer : trace.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
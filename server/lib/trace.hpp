@@ -0,0 +1,228 @@
+/**
+ * @file trace.hpp
+ * @brief Opt-in lock and pipeline tracing in Chrome trace format
+ * @author Jorge Royon
+ * @date 2025-09-18
+ * @version 1.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef CINEMA_TRACING
+#define CINEMA_TRACING 0   ///< Set by the CINEMA_TRACING CMake option
+#endif
+
+/**
+ * @brief Nanoseconds since the tracer's epoch
+ */
+using TraceStamp = uint64_t;
+
+/**
+ * @struct TraceOptions
+ * @brief Where and how much the tracer records
+ */
+struct TraceOptions {
+    std::string path;                        ///< Trace file written by Tracer::stop()
+    uint32_t sampleEvery = 100;              ///< Trace one request or queued frame in this many
+    std::size_t maxEventsPerThread = 1 << 20;  ///< Events kept per thread before new ones are dropped
+};
+
+/**
+ * @class Tracer
+ * @brief Process-wide recorder of timed events
+ *
+ * Records what the metrics only summarize: how long threads wait for and
+ * hold each lock, and where the time of a single request goes. Events are
+ * written as Chrome trace JSON ("Trace Event Format"), which
+ * chrome://tracing and ui.perfetto.dev open directly.
+ *
+ * @par Events
+ * - lock.wait / lock.hold: wait for and hold of every TracedLock, named
+ *   after the lock
+ * - seats: multi-word seat map writes (the window readers wait out) and
+ *   seat map reads that had to retry behind one
+ * - pipeline: read, handleMessage and write of sampled requests, with
+ *   the request id in args, and an async "request" span from read to write
+ *   done
+ * - queue: time a sampled frame spent in a session's outbound queue
+ * - format: catalogue rebuilds
+ *
+ * @par Cost
+ * Everything is compiled out unless the build sets CINEMA_TRACING (CMake
+ * option of the same name): enabled() is then a constant false and the
+ * guards and helpers below reduce to the plain operations. Built in but
+ * not started, each trace point costs one relaxed load. When running,
+ * events go to a per-thread buffer under an uncontended mutex; only
+ * every sampleEvery-th request records its pipeline stages.
+ *
+ * @par Thread Safety
+ * All methods may be called from any thread.
+ */
+class Tracer {
+public:
+    static constexpr bool COMPILED = CINEMA_TRACING != 0;   ///< Trace points are built in
+
+    /**
+     * @brief Start recording
+     * @param options Output file and sampling
+     * @post enabled() is true if tracing is compiled in
+     */
+    static void start(TraceOptions options);
+
+    /**
+     * @brief Stop recording and write the trace file
+     * @return false if the file could not be written
+     * @post Recorded events are kept until clear()
+     */
+    static bool stop();
+
+    /**
+     * @brief Check whether events are being recorded
+     */
+    static bool enabled() {
+        return COMPILED && enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the current time on the trace clock
+     */
+    static TraceStamp now();
+
+    /**
+     * @brief Decide whether to trace one request or frame
+     * @return Non-zero trace id if it is sampled, 0 otherwise
+     */
+    static uint64_t sample();
+
+    /**
+     * @brief Name the calling thread in the trace
+     * @param name Label shown for the thread, kept as given
+     */
+    static void nameThread(const char* name);
+
+    /**
+     * @brief Record a span on the calling thread
+     * @param category Event category, a string literal
+     * @param name Event name, a string literal
+     * @param start Start of the span
+     * @param end End of the span
+     * @param id Request id shown in the event's args, 0 for none
+     */
+    static void complete(const char* category, const char* name, TraceStamp start, TraceStamp end, uint64_t id = 0);
+
+    /**
+     * @brief Record a point in time on the calling thread
+     */
+    static void instant(const char* category, const char* name, uint64_t id = 0);
+
+    /**
+     * @brief Open an async span followed across threads by its id
+     */
+    static void asyncBegin(const char* name, uint64_t id, TraceStamp at);
+
+    /**
+     * @brief Close an async span opened by asyncBegin()
+     */
+    static void asyncEnd(const char* name, uint64_t id, TraceStamp at);
+
+    /**
+     * @brief Render every recorded event
+     * @return Chrome trace JSON object
+     */
+    static std::string toJson();
+
+    /**
+     * @brief Count recorded events
+     * @return Events held in all thread buffers
+     */
+    static std::size_t eventCount();
+
+    /**
+     * @brief Drop every recorded event
+     */
+    static void clear();
+
+private:
+    static std::atomic<bool> enabled_;   ///< Recording between start() and stop()
+};
+
+/**
+ * @class TraceScope
+ * @brief Records the lifetime of a scope as a span
+ */
+class TraceScope {
+public:
+    /**
+     * @param category Event category, a string literal
+     * @param name Event name, a string literal
+     * @param id Request id, 0 for none
+     */
+    TraceScope(const char* category, const char* name, uint64_t id = 0)
+        : category_(category), name_(name), id_(id), start_(Tracer::enabled() ? Tracer::now() : 0) {}
+
+    ~TraceScope() {
+        if (start_ != 0 && Tracer::enabled()) {
+            Tracer::complete(category_, name_, start_, Tracer::now(), id_);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    uint64_t id_;
+    TraceStamp start_;
+};
+
+/**
+ * @class TracedLock
+ * @brief std::lock_guard that records its wait and hold times
+ * @tparam Mutex Lockable type
+ *
+ * The lock is taken in the constructor and released in the destructor;
+ * without tracing it is exactly a lock_guard.
+ */
+template <typename Mutex>
+class TracedLock {
+public:
+    /**
+     * @param mutex Mutex to lock
+     * @param name Name of the lock in the trace, a string literal
+     */
+    TracedLock(Mutex& mutex, const char* name)
+        : mutex_(mutex), name_(name), acquired_(0) {
+        if (Tracer::enabled()) {
+            TraceStamp requested = Tracer::now();
+            mutex_.lock();
+            acquired_ = Tracer::now();
+            Tracer::complete("lock.wait", name_, requested, acquired_);
+        } else {
+            mutex_.lock();
+        }
+    }
+
+    ~TracedLock() {
+        if (acquired_ != 0) {
+            TraceStamp released = Tracer::now();
+            mutex_.unlock();
+            Tracer::complete("lock.hold", name_, acquired_, released);
+        } else {
+            mutex_.unlock();
+        }
+    }
+
+    TracedLock(const TracedLock&) = delete;
+    TracedLock& operator=(const TracedLock&) = delete;
+
+private:
+    Mutex& mutex_;
+    const char* name_;
+    TraceStamp acquired_;   ///< When the lock was taken, 0 if not traced
+};
@@ -1,32 +1,289 @@
 #include "websocket_server.hpp"
-#include <iostream>
 #include <sstream>
 #include <algorithm>
 
-WebSocketSession::WebSocketSession(tcp::socket&& socket, WebSocketServer* server)
-    : ws_(std::move(socket)), server_(server), writing_(false) {}
+WebSocketSession::WebSocketSession(tcp::socket&& socket, WebSocketServer* server, AdmissionControl::Ticket ticket)
+    : ws_(TrafficMeter(&server->traffic()), std::move(socket)), server_(server), writing_(true),
+      format_(WireFormat::Text), queuedBytes_(0), overloaded_(false), closing_(false),
+      closeTimer_(ws_.get_executor()), peer_(false), ticket_(std::move(ticket)), refusedInRow_(0) {}
 
 void WebSocketSession::run() {
+    net::dispatch(
+        ws_.get_executor(),
+        beast::bind_front_handler(
+            &WebSocketSession::on_run,
+            shared_from_this()));
+}
+
+void WebSocketSession::on_run() {
+    beast::get_lowest_layer(ws_).expires_after(server_->admission().options().handshakeTimeout);
+    http::async_read(
+        ws_.next_layer(),
+        buffer_,
+        request_,
+        beast::bind_front_handler(
+            &WebSocketSession::on_read_request,
+            shared_from_this()));
+}
+
+void WebSocketSession::on_read_request(beast::error_code ec, std::size_t) {
+    if (ec) {
+        return;
+    }
+    
+    if (!websocket::is_upgrade(request_)) {
+        serve_http();
+        return;
+    }
+    
+    // The WebSocket stream keeps its own timeouts from here on
+    const AdmissionOptions& admission = server_->admission().options();
+    beast::get_lowest_layer(ws_).expires_never();
+    websocket::stream_base::timeout timeouts{};
+    timeouts.handshake_timeout = admission.handshakeTimeout;
+    timeouts.idle_timeout = websocket::stream_base::none();
+    timeouts.keep_alive_pings = false;
+    ws_.set_option(timeouts);
+    ws_.read_message_max(admission.maxMessageBytes);
     server_->addSession(shared_from_this());
     
+    const CompressionOptions& compression = server_->compression();
+    websocket::permessage_deflate deflate;
+    deflate.server_enable = compression.enabled;
+    deflate.server_max_window_bits = compression.windowBits;
+    deflate.memLevel = compression.memLevel;
+    deflate.compLevel = compression.compLevel;
+#if BOOST_VERSION >= 108100
+    deflate.msg_size_threshold = compression.minSize;
+#endif
+    ws_.set_option(deflate);
+    
     ws_.async_accept(
+        request_,
         beast::bind_front_handler(
             &WebSocketSession::on_accept,
             shared_from_this()));
 }
 
-void WebSocketSession::sendBroadcastMessage(const std::string& message) {
-    send_message(message);
+void WebSocketSession::serve_http() {
+    response_.version(request_.version());
+    response_.keep_alive(false);
+    if (request_.method() == http::verb::get && request_.target() == beast::string_view(CinemaProtocol::METRICS_PATH.data(), CinemaProtocol::METRICS_PATH.size())) {
+        response_.result(http::status::ok);
+        response_.set(http::field::content_type, "text/plain; version=0.0.4");
+        response_.body() = server_->renderMetrics();
+    } else {
+        response_.result(http::status::not_found);
+        response_.set(http::field::content_type, "text/plain");
+        response_.body() = "Not found\n";
+    }
+    response_.prepare_payload();
+    
+    http::async_write(
+        ws_.next_layer(),
+        response_,
+        [self = shared_from_this()](beast::error_code, std::size_t) {
+            beast::error_code ignored;
+            beast::get_lowest_layer(self->ws_).socket().shutdown(tcp::socket::shutdown_send, ignored);
+        });
+}
+
+void WebSocketSession::sendBroadcastMessage(BroadcastPayload message, bool fullState) {
+    net::post(
+        ws_.get_executor(),
+        beast::bind_front_handler(
+            &WebSocketSession::send_broadcast,
+            shared_from_this(),
+            std::move(message),
+            fullState));
+}
+
+void WebSocketSession::sendPeerMessage(SharedPayload message) {
+    net::post(
+        ws_.get_executor(),
+        [self = shared_from_this(), message = std::move(message)]() mutable {
+            self->send_message(std::move(message));
+        });
 }
 
-void WebSocketSession::send_message(const std::string& message) {
-    message_queue_.push(message);
+void WebSocketSession::send_broadcast(BroadcastPayload message, bool fullState) {
+    FrameKind kind = fullState ? FrameKind::FullState : FrameKind::Delta;
+    if (format_ == WireFormat::Binary && message.binary) {
+        send_message(std::move(message.binary), true, kind);
+    } else {
+        send_message(std::move(message.text), false, kind);
+    }
+}
+
+void WebSocketSession::switch_format(WireFormat format) {
+    format_ = format;
+    send_message(server_->getInitialData(format_), format_ == WireFormat::Binary, FrameKind::FullState);
+}
+
+void WebSocketSession::send_message(SharedPayload message, bool binary, FrameKind kind, uint64_t traceId) {
+    if (closing_) {
+        return;
+    }
     
-    if (!writing_) {
+    queuedBytes_ += message->size();
+    message_queue_.push_back({std::move(message), binary, kind});
+    if (Tracer::enabled()) {
+        OutboundFrame& frame = message_queue_.back();
+        frame.traceId = traceId != 0 || kind == FrameKind::Reply ? traceId : Tracer::sample();
+        frame.enqueued = frame.traceId != 0 ? Tracer::now() : 0;
+    }
+    ServerMetrics::instance().outboundQueueDepth.observe(static_cast<uint64_t>(message_queue_.size()));
+    apply_backpressure(kind);
+    
+    if (!writing_ && !closing_) {
         do_write();
     }
 }
 
+void WebSocketSession::apply_backpressure(FrameKind kind) {
+    const QueueLimits& limits = server_->queueLimits();
+    if (queuedBytes_ <= limits.highWaterBytes) {
+        overloaded_ = false;
+        return;
+    }
+    
+    // The newest full state makes every older pending one redundant;
+    // the front frame is left alone since it may be in flight
+    if (kind == FrameKind::FullState) {
+        size_t keepFrom = writing_ ? 1 : 0;
+        for (size_t i = message_queue_.size() - 1; i-- > keepFrom; ) {
+            if (message_queue_[i].kind == FrameKind::FullState) {
+                queuedBytes_ -= message_queue_[i].payload->size();
+                message_queue_.erase(message_queue_.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+        if (queuedBytes_ <= limits.highWaterBytes) {
+            overloaded_ = false;
+            return;
+        }
+    }
+    
+    auto now = Clock::now();
+    if (!overloaded_) {
+        overloaded_ = true;
+        overloadedSince_ = now;
+    }
+    if (queuedBytes_ >= limits.hardLimitBytes || now - overloadedSince_ >= limits.overloadTimeout) {
+        drop_slow_consumer();
+    }
+}
+
+void WebSocketSession::drop_slow_consumer() {
+    if (closing_) {
+        return;
+    }
+    ServerMetrics::instance().slowConsumersDropped.inc();
+    log(LogLevel::Warn, "Dropping slow client with ", queuedBytes_, " bytes queued");
+    begin_close(websocket::close_reason(websocket::close_code::try_again_later, "slow consumer"));
+}
+
+void WebSocketSession::drop_flooding_client() {
+    if (closing_) {
+        return;
+    }
+    ServerMetrics::instance().floodingClientsDropped.inc();
+    log(LogLevel::Warn, "Dropping client after ", refusedInRow_, " messages over the rate limit");
+    begin_close(websocket::close_reason(websocket::close_code::policy_error, "rate limit"));
+}
+
+void WebSocketSession::begin_close(websocket::close_reason reason) {
+    closing_ = true;
+    closeReason_ = std::move(reason);
+    
+    // Everything but the in-flight frame is discarded
+    while (message_queue_.size() > (writing_ ? 1u : 0u)) {
+        queuedBytes_ -= message_queue_.back().payload->size();
+        message_queue_.pop_back();
+    }
+    
+    // A client that stopped reading may never let the close go out
+    closeTimer_.expires_after(server_->queueLimits().overloadTimeout);
+    closeTimer_.async_wait(
+        [self = shared_from_this()](beast::error_code ec) {
+            if (!ec) {
+                beast::error_code ignored;
+                beast::get_lowest_layer(self->ws_).socket().close(ignored);
+            }
+        });
+    
+    if (!writing_) {
+        do_close();
+    }
+}
+
+void WebSocketSession::do_close() {
+    writing_ = true;
+    ws_.async_close(
+        closeReason_,
+        beast::bind_front_handler(
+            &WebSocketSession::on_close,
+            shared_from_this()));
+}
+
+void WebSocketSession::on_close(beast::error_code ec) {
+    closeTimer_.cancel();
+    if (ec) {
+        log(LogLevel::Error, "WebSocket close error: ", ec.message());
+    }
+    server_->removeSession(shared_from_this());
+}
+
+void WebSocketSession::coalesce_front() {
+    const OutboundFrame& front = message_queue_.front();
+    if (front.kind != FrameKind::Delta) {
+        return;
+    }
+    
+    const size_t limit = server_->queueLimits().coalesceBytes;
+    const size_t skip = front.binary ? BinaryProtocol::HEADER_SIZE : 0;
+    size_t count = 1;
+    size_t total = front.payload->size();
+    while (count < message_queue_.size()) {
+        const OutboundFrame& next = message_queue_[count];
+        // Binary records only share a header of the same message type
+        if (next.kind != FrameKind::Delta || next.binary != front.binary ||
+            (front.binary && (*next.payload)[BinaryProtocol::HEADER_SIZE - 1] !=
+                             (*front.payload)[BinaryProtocol::HEADER_SIZE - 1]) ||
+            total + next.payload->size() > limit) {
+            break;
+        }
+        total += next.payload->size() - skip + (front.binary ? 0 : 1);
+        ++count;
+    }
+    if (count == 1) {
+        return;
+    }
+    
+    // Text deltas become one multi-line message, binary delta records share
+    // the first frame's header
+    auto merged = std::make_shared<std::string>();
+    merged->reserve(total);
+    for (size_t i = 0; i < count; ++i) {
+        const std::string& payload = *message_queue_[i].payload;
+        if (i == 0) {
+            merged->append(payload);
+        } else if (front.binary) {
+            merged->append(payload, skip, std::string::npos);
+        } else {
+            merged->push_back('\n');
+            merged->append(payload);
+        }
+        queuedBytes_ -= payload.size();
+    }
+    
+    bool binary = front.binary;
+    uint64_t traceId = front.traceId;
+    TraceStamp enqueued = front.enqueued;
+    message_queue_.erase(message_queue_.begin(), message_queue_.begin() + static_cast<std::ptrdiff_t>(count));
+    queuedBytes_ += merged->size();
+    message_queue_.push_front({std::move(merged), binary, FrameKind::Delta, traceId, enqueued});
+}
+
 void WebSocketSession::do_write() {
     if (message_queue_.empty()) {
         writing_ = false;
@@ -34,11 +291,19 @@ void WebSocketSession::do_write() {
     }
     
     writing_ = true;
-    std::string message = message_queue_.front();
-    message_queue_.pop();
+    coalesce_front();
+    
+    const OutboundFrame& front = message_queue_.front();
+    if (front.traceId != 0 && Tracer::enabled()) {
+        writeStarted_ = Tracer::now();
+        Tracer::complete("queue", "queued", front.enqueued, writeStarted_, front.traceId);
+    }
     
+    // The payload stays at the front of the queue until on_write, which keeps
+    // the buffer alive for the whole asynchronous write
+    ws_.binary(message_queue_.front().binary);
     ws_.async_write(
-        net::buffer(message),
+        net::buffer(*message_queue_.front().payload),
         beast::bind_front_handler(
             &WebSocketSession::on_write,
             shared_from_this()));
@@ -54,29 +319,59 @@ void WebSocketSession::do_read() {
 
 void WebSocketSession::on_accept(beast::error_code ec) {
     if (ec) {
-        std::cerr << "WebSocket accept error: " << ec.message() << std::endl;
+        log(LogLevel::Error, "WebSocket accept error: ", ec.message());
         server_->removeSession(shared_from_this());
         return;
     }
+    ticket_.handshakeDone();
 
-    send_message(server_->getInitialData());
+    // Broadcasts queued during the handshake follow the initial data; the
+    // catalogue already reflects them, so clients drop them by sequence
+    SharedPayload initialData = server_->getInitialData();
+    queuedBytes_ += initialData->size();
+    message_queue_.push_front({std::move(initialData), false, FrameKind::FullState});
+    
+    if (closing_) {
+        do_close();
+    } else {
+        do_write();
+    }
     do_read();
 }
 
 void WebSocketSession::on_write(beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
-    
     if (ec) {
-        std::cerr << "WebSocket write error: " << ec.message() << std::endl;
+        log(LogLevel::Error, "WebSocket write error: ", ec.message());
         server_->removeSession(shared_from_this());
         return;
     }
+    
+    server_->traffic().payloadBytesSent.fetch_add(bytes_transferred, std::memory_order_relaxed);
+
+    const OutboundFrame& front = message_queue_.front();
+    if (front.traceId != 0 && writeStarted_ != 0 && Tracer::enabled()) {
+        TraceStamp done = Tracer::now();
+        Tracer::complete("pipeline", "write", writeStarted_, done, front.traceId);
+        if (front.kind == FrameKind::Reply) {
+            Tracer::asyncEnd("request", front.traceId, done);
+        }
+    }
+    writeStarted_ = 0;
 
+    queuedBytes_ -= message_queue_.front().payload->size();
+    message_queue_.pop_front();
+    if (queuedBytes_ <= server_->queueLimits().highWaterBytes) {
+        overloaded_ = false;
+    }
+    
+    if (closing_) {
+        do_close();
+        return;
+    }
     do_write();
 }
 
 void WebSocketSession::on_read(beast::error_code ec, std::size_t bytes_transferred) {
-    boost::ignore_unused(bytes_transferred);
     
     if (ec == websocket::error::closed) {
         server_->removeSession(shared_from_this());
@@ -84,59 +379,210 @@ void WebSocketSession::on_read(beast::error_code ec, std::size_t bytes_transferr
     }
 
     if (ec) {
-        std::cerr << "WebSocket read error: " << ec.message() << std::endl;
+        log(LogLevel::Error, "WebSocket read error: ", ec.message());
         server_->removeSession(shared_from_this());
         return;
     }
 
+    server_->traffic().payloadBytesReceived.fetch_add(bytes_transferred, std::memory_order_relaxed);
+    
+    // Over the rate: refused before the message is even copied out
+    if (!peer_ && !ticket_.allowMessage()) {
+        buffer_.consume(buffer_.size());
+        ServerMetrics::instance().messagesRefused.inc();
+        std::size_t maxRefused = server_->admission().options().maxRefusedMessages;
+        if (maxRefused > 0 && ++refusedInRow_ >= maxRefused) {
+            drop_flooding_client();
+            return;
+        }
+        static const SharedPayload refused = std::make_shared<const std::string>(CinemaProtocol::RATE_LIMITED);
+        send_message(refused);
+        do_read();
+        return;
+    }
+    refusedInRow_ = 0;
+    
+    // Sampled requests are followed from here to the end of their reply's write
+    uint64_t traceId = 0;
+    if (Tracer::enabled() && (traceId = Tracer::sample()) != 0) {
+        TraceStamp readAt = Tracer::now();
+        Tracer::asyncBegin("request", traceId, readAt);
+        Tracer::instant("pipeline", "read", traceId);
+    }
+    
     std::string received = beast::buffers_to_string(buffer_.data());
     buffer_.consume(buffer_.size());
     
-    std::cout << "WebSocket received: " << received << std::endl;
+    // A peer hello carries the cluster secret, which stays out of the log
+    log(LogLevel::Debug, "WebSocket received: ",
+        received.starts_with(CinemaProtocol::PEER_HELLO) ? CinemaProtocol::PEER_HELLO : std::string_view(received));
     
-    bool shouldBroadcast = false;
-    std::string response = server_->handleMessage(received, shouldBroadcast);
+    if (received == CinemaProtocol::BINARY_HELLO || received == CinemaProtocol::TEXT_HELLO) {
+        switch_format(received == CinemaProtocol::BINARY_HELLO ? WireFormat::Binary : WireFormat::Text);
+        do_read();
+        return;
+    }
     
-    send_message(response);
+    if (!peer_ && received.starts_with(CinemaProtocol::PEER_HELLO)) {
+        // Peers skip the rate limits, so only nodes knowing the secret become one
+        if (!server_->acceptsPeer(received)) {
+            log(LogLevel::Warn, "Refused cluster peer hello without the shared secret");
+            static const SharedPayload refused =
+                std::make_shared<const std::string>("ERROR: Not a cluster peer");
+            send_message(refused);
+            do_read();
+            return;
+        }
+        peer_ = true;
+        server_->markPeer(shared_from_this());
+        log(LogLevel::Info, "Cluster peer connected");
+        do_read();
+        return;
+    }
     
-    if (shouldBroadcast) {
-        server_->broadcastUpdate();
+    if (!peer_) {
+        if (SharedPayload reply = server_->subscribe(shared_from_this(), received)) {
+            send_message(std::move(reply));
+            do_read();
+            return;
+        }
     }
     
-    do_read();
+    // A booking forwarded by another node: FORWARD:<id>:<t|b>:<booking>
+    WireFormat format = format_;
+    std::string replyPrefix;
+    ReplyCallback deferred;
+    const std::string_view forwardPrefix = CinemaProtocol::FORWARD_PREFIX;
+    if (peer_ && received.compare(0, forwardPrefix.size(), forwardPrefix) == 0) {
+        size_t idEnd = received.find(':', forwardPrefix.size());
+        if (idEnd == std::string::npos || idEnd + 3 > received.size() || received[idEnd + 2] != ':') {
+            log(LogLevel::Warn, "Malformed forwarded request from peer");
+            do_read();
+            return;
+        }
+        replyPrefix = std::string(CinemaProtocol::FORWARDED_PREFIX) +
+                      received.substr(forwardPrefix.size(), idEnd - forwardPrefix.size()) + ":";
+        format = received[idEnd + 1] == 'b' ? WireFormat::Binary : WireFormat::Text;
+        received.erase(0, idEnd + 3);
+    } else {
+        // A batch may have booked items here before the deferred reply, so
+        // it waits for them to be durable as well
+        deferred = [self = shared_from_this(), traceId](SharedPayload reply) {
+            self->server_->whenDurable([self, traceId, reply = std::move(reply)](bool durable) mutable {
+                if (!durable) {
+                    reply = MessageHandler::unsavedReply(reply);
+                }
+                net::post(self->ws_.get_executor(), [self, traceId, reply = std::move(reply)]() mutable {
+                    self->send_reply(std::move(reply), traceId);
+                    self->do_read();
+                });
+            });
+        };
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    BroadcastPayload broadcast;
+    TraceStamp handleStarted = traceId != 0 ? Tracer::now() : 0;
+    SharedPayload response = server_->handleMessage(received, format, broadcast, deferred);
+    if (handleStarted != 0) {
+        Tracer::complete("pipeline", "handleMessage", handleStarted, Tracer::now(), traceId);
+    }
+    ServerMetrics& metrics = ServerMetrics::instance();
+    metrics.messageHandling.observe(std::chrono::steady_clock::now() - started);
+    metrics.messages.inc();
+    
+    // Forwarded to the owning node; the deferred reply resumes reading
+    if (!response && !broadcast.text) {
+        return;
+    }
+    if (response && !replyPrefix.empty()) {
+        response = std::make_shared<const std::string>(replyPrefix + *response);
+    }
+    
+    if (!broadcast.text) {
+        send_reply(std::move(response), traceId);
+        do_read();
+        return;
+    }
+    
+    // Without a response, part of a batch was forwarded and the deferred
+    // reply resumes reading; the items booked here are announced now
+    auto finish = [self = shared_from_this(), traceId, response = std::move(response),
+                   broadcast = std::move(broadcast)](bool durable) mutable {
+        bool replied = response != nullptr;
+        if (replied && !durable) {
+            // The seats stay taken in memory, so the delta still goes out
+            response = MessageHandler::unsavedReply(response);
+        }
+        if (replied) {
+            self->send_reply(std::move(response), traceId);
+        }
+        SharedPayload delta = broadcast.text;
+        self->server_->broadcast(std::move(broadcast));
+        self->server_->publish(std::move(delta));
+        if (replied) {
+            self->do_read();
+        }
+    };
+    if (!server_->persistsBookings()) {
+        finish(true);
+        return;
+    }
+    
+    // A booking is only confirmed once it is durable. Reading pauses until
+    // then, so replies keep the order of the requests.
+    server_->whenDurable([executor = ws_.get_executor(), finish = std::move(finish)](bool durable) mutable {
+        net::post(executor, [finish = std::move(finish), durable]() mutable { finish(durable); });
+    });
+}
+
+void WebSocketSession::send_reply(SharedPayload reply, uint64_t traceId) {
+    bool binary = format_ == WireFormat::Binary && !reply->empty() &&
+                  static_cast<uint8_t>(reply->front()) == BinaryProtocol::MAGIC;
+    send_message(std::move(reply), binary, FrameKind::Reply, traceId);
 }
 
 WebSocketServer::WebSocketServer(net::io_context& ioc, const tcp::endpoint& endpoint,
                                MessageCallback messageCallback,
                                InitialDataCallback initialDataCallback,
-                               BroadcastDataCallback broadcastDataCallback)
+                               BroadcastDataCallback broadcastDataCallback,
+                               CompressionOptions compression,
+                               QueueLimits queueLimits,
+                               BatchingOptions batching,
+                               AdmissionOptions admission)
     : ioc_(ioc), acceptor_(ioc), 
+      compression_(compression),
+      queueLimits_(queueLimits),
+      batching_(batching),
+      admission_(admission),
       messageCallback_(messageCallback),
       initialDataCallback_(initialDataCallback),
-      broadcastDataCallback_(broadcastDataCallback) {
+      broadcastDataCallback_(broadcastDataCallback),
+      batchStrand_(net::make_strand(ioc)),
+      batchTimer_(batchStrand_) {
     beast::error_code ec;
 
     acceptor_.open(endpoint.protocol(), ec);
     if (ec) {
-        std::cerr << "Failed to open acceptor: " << ec.message() << std::endl;
+        Logger::log(LogLevel::Error, "Failed to open acceptor: ", ec.message());
         return;
     }
 
     acceptor_.set_option(net::socket_base::reuse_address(true), ec);
     if (ec) {
-        std::cerr << "Failed to set reuse_address: " << ec.message() << std::endl;
+        Logger::log(LogLevel::Error, "Failed to set reuse_address: ", ec.message());
         return;
     }
 
     acceptor_.bind(endpoint, ec);
     if (ec) {
-        std::cerr << "Failed to bind: " << ec.message() << std::endl;
+        Logger::log(LogLevel::Error, "Failed to bind: ", ec.message());
         return;
     }
 
     acceptor_.listen(net::socket_base::max_listen_connections, ec);
     if (ec) {
-        std::cerr << "Failed to listen: " << ec.message() << std::endl;
+        Logger::log(LogLevel::Error, "Failed to listen: ", ec.message());
         return;
     }
 }
@@ -147,6 +593,7 @@ void WebSocketServer::run() {
 
 void WebSocketServer::do_accept() {
     acceptor_.async_accept(
+        net::make_strand(ioc_),
         beast::bind_front_handler(
             &WebSocketServer::on_accept,
             this));
@@ -154,37 +601,427 @@ void WebSocketServer::do_accept() {
 
 void WebSocketServer::on_accept(beast::error_code ec, tcp::socket socket) {
     if (ec) {
-        std::cerr << "Accept error: " << ec.message() << std::endl;
+        Logger::log(LogLevel::Error, "Accept error: ", ec.message());
+        do_accept();
+        return;
+    }
+    
+    beast::error_code endpointError;
+    tcp::endpoint remote = socket.remote_endpoint(endpointError);
+    AdmissionVerdict verdict = AdmissionVerdict::Admitted;
+    AdmissionControl::Ticket ticket;
+    if (!endpointError) {
+        ticket = admission_.admit(remote.address(), verdict);
+    }
+    if (ticket) {
+        std::make_shared<WebSocketSession>(std::move(socket), this, std::move(ticket))->run();
     } else {
-        std::make_shared<WebSocketSession>(std::move(socket), this)->run();
+        // Shed before any handshake work; logged at debug so a flood can't fill the log
+        ServerMetrics& metrics = ServerMetrics::instance();
+        switch (verdict) {
+            case AdmissionVerdict::TooManyConnections: metrics.refusedConnectionCap.inc(); break;
+            case AdmissionVerdict::TooManyFromAddress: metrics.refusedAddressCap.inc(); break;
+            case AdmissionVerdict::ConnectRate: metrics.refusedConnectRate.inc(); break;
+            case AdmissionVerdict::TooManyHandshakes: metrics.refusedHandshakeCap.inc(); break;
+            case AdmissionVerdict::Admitted: break;
+        }
+        Logger::log(LogLevel::Debug, "Refused connection from ", remote);
+        beast::error_code ignored;
+        socket.close(ignored);
     }
 
     do_accept();
 }
 
 void WebSocketServer::addSession(std::shared_ptr<WebSocketSession> session) {
-    sessions_.insert(session);
-    std::cout << "WebSocket client connected. Total clients: " << sessions_.size() << std::endl;
+    std::size_t total;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        sessions_.insert(session);
+        allShowsWatchers_.insert(session);
+        total = sessions_.size();
+    }
+    Logger::log(LogLevel::Info, "WebSocket client connected. Total clients: ", total);
 }
 
 void WebSocketServer::removeSession(std::shared_ptr<WebSocketSession> session) {
-    sessions_.erase(session);
-    std::cout << "WebSocket client disconnected. Total clients: " << sessions_.size() << std::endl;
+    std::size_t total;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        sessions_.erase(session);
+        peers_.erase(session);
+        clearWatches(session);
+        total = sessions_.size();
+    }
+    Logger::log(LogLevel::Info, "WebSocket client disconnected. Total clients: ", total);
+    
+    // Server-wide totals; per disconnect only worth it when debugging, the
+    // same counters are exported on /metrics
+    if (Logger::enabled(LogLevel::Debug)) {
+        TrafficStats traffic = stats();
+        Logger::log(LogLevel::Debug, "Traffic: sent ", traffic.payloadBytesSent, " payload bytes as ",
+                    traffic.wireBytesSent, " wire bytes, received ",
+                    traffic.payloadBytesReceived, " payload bytes as ",
+                    traffic.wireBytesReceived, " wire bytes");
+    }
 }
 
 void WebSocketServer::broadcastUpdate() {
-    std::string updateMessage = broadcastDataCallback_();
+    broadcast({broadcastDataCallback_(WireFormat::Text), broadcastDataCallback_(WireFormat::Binary)}, true);
+}
+
+namespace {
+
+/**
+ * @brief Append a delta to the ones collected in a window
+ * @param pending Collected so far, binary cleared if a delta lacks one or
+ *        its message type differs (SEAT_FREED after SEAT_DELTA)
+ * @param message Delta to append, text encoding required
+ * @note Same layout as WebSocketSession::coalesce_front() produces
+ */
+template <typename Pending>
+void appendDelta(Pending& pending, const BroadcastPayload& message) {
+    if (pending.count > 0) {
+        pending.text.push_back('\n');
+    }
+    pending.text.append(*message.text);
+    constexpr size_t type = BinaryProtocol::HEADER_SIZE - 1;
+    if (!message.binary || (pending.count > 0 && pending.binary.empty()) ||
+        (pending.count > 0 && (*message.binary)[type] != pending.binary[type])) {
+        pending.binary.clear();
+    } else if (pending.count == 0) {
+        pending.binary.append(*message.binary);
+    } else {
+        pending.binary.append(*message.binary, BinaryProtocol::HEADER_SIZE, std::string::npos);
+    }
+    ++pending.count;
+}
+
+/**
+ * @brief Turn collected deltas into one broadcast
+ * @param pending Collected deltas, moved from
+ * @param show Show the broadcast is about
+ * @return Payload without a binary encoding if a delta had none
+ */
+template <typename Pending>
+BroadcastPayload toPayload(Pending& pending, ShowId show) {
+    BroadcastPayload message;
+    message.text = std::make_shared<const std::string>(std::move(pending.text));
+    if (!pending.binary.empty()) {
+        message.binary = std::make_shared<const std::string>(std::move(pending.binary));
+    }
+    message.show = show;
+    return message;
+}
+
+} // namespace
+
+void WebSocketServer::broadcast(BroadcastPayload message, bool fullState) {
+    if (fullState || message.show == ALL_SHOWS || !message.text || batching_.window.count() <= 0) {
+        deliver(message, fullState, watchersOf(message.show));
+        return;
+    }
+    
+    PendingDeltas all;
+    std::unordered_map<ShowId, PendingDeltas> shows;
+    {
+        TracedLock<std::mutex> lock(batchMutex_, "batch");
+        if (windowOpen_) {
+            appendDelta(pendingAll_, message);
+            appendDelta(pendingShows_[message.show], message);
+            ServerMetrics::instance().deltasBatched.inc();
+            if (pendingAll_.text.size() + pendingAll_.binary.size() < batching_.flushBytes) {
+                return;
+            }
+            // A burst big enough to fill a frame goes out without waiting
+            // for the timer, which keeps the window open
+            all = std::exchange(pendingAll_, {});
+            shows = std::exchange(pendingShows_, {});
+        } else {
+            windowOpen_ = true;
+        }
+    }
     
-    std::cout << "Broadcasting update to " << sessions_.size() << " clients" << std::endl;
-    for (auto session : sessions_) {
-        session->sendBroadcastMessage(updateMessage);
+    if (all.count > 0) {
+        flushDeltas(std::move(all), std::move(shows));
+        return;
     }
+    
+    // First delta after a quiet period: send it now and collect the ones
+    // that follow it
+    deliver(message, false, watchersOf(message.show));
+    net::post(batchStrand_, [this] { armBatchTimer(); });
 }
 
-std::string WebSocketServer::handleMessage(const std::string& message, bool& shouldBroadcast) {
-    return messageCallback_(message, shouldBroadcast);
+void WebSocketServer::armBatchTimer() {
+    batchTimer_.expires_after(batching_.window);
+    batchTimer_.async_wait([this](beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        PendingDeltas all;
+        std::unordered_map<ShowId, PendingDeltas> shows;
+        {
+            TracedLock<std::mutex> lock(batchMutex_, "batch");
+            if (pendingAll_.count == 0) {
+                windowOpen_ = false;
+                return;
+            }
+            all = std::exchange(pendingAll_, {});
+            shows = std::exchange(pendingShows_, {});
+        }
+        flushDeltas(std::move(all), std::move(shows));
+        armBatchTimer();
+    });
 }
 
-std::string WebSocketServer::getInitialData() {
-    return initialDataCallback_();
-}
\ No newline at end of file
+void WebSocketServer::flushDeltas(PendingDeltas all, std::unordered_map<ShowId, PendingDeltas> shows) {
+    std::vector<std::shared_ptr<WebSocketSession>> allTargets;
+    std::vector<std::pair<BroadcastPayload, std::vector<std::shared_ptr<WebSocketSession>>>> showTargets;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        allTargets.assign(allShowsWatchers_.begin(), allShowsWatchers_.end());
+        for (auto& [show, pending] : shows) {
+            auto watchers = showWatchers_.find(show);
+            if (watchers != showWatchers_.end() && !watchers->second.empty()) {
+                showTargets.emplace_back(toPayload(pending, show),
+                                         std::vector<std::shared_ptr<WebSocketSession>>(
+                                             watchers->second.begin(), watchers->second.end()));
+            }
+        }
+    }
+    
+    Logger::log(LogLevel::Debug, "Flushing ", all.count, " batched deltas");
+    if (!allTargets.empty()) {
+        deliver(toPayload(all, ALL_SHOWS), false, allTargets);
+    }
+    for (auto& [message, targets] : showTargets) {
+        deliver(message, false, targets);
+    }
+}
+
+std::vector<std::shared_ptr<WebSocketSession>> WebSocketServer::watchersOf(ShowId show) {
+    std::vector<std::shared_ptr<WebSocketSession>> targets;
+    TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+    if (show == ALL_SHOWS) {
+        targets.assign(sessions_.begin(), sessions_.end());
+    } else {
+        // Only sessions watching the show are woken; the two sets are disjoint
+        auto watchers = showWatchers_.find(show);
+        targets.reserve(allShowsWatchers_.size() + (watchers != showWatchers_.end() ? watchers->second.size() : 0));
+        targets.assign(allShowsWatchers_.begin(), allShowsWatchers_.end());
+        if (watchers != showWatchers_.end()) {
+            targets.insert(targets.end(), watchers->second.begin(), watchers->second.end());
+        }
+    }
+    return targets;
+}
+
+void WebSocketServer::deliver(const BroadcastPayload& message, bool fullState,
+                              const std::vector<std::shared_ptr<WebSocketSession>>& targets) {
+    auto started = std::chrono::steady_clock::now();
+    Logger::log(LogLevel::Debug, "Broadcasting update to ", targets.size(), " clients");
+    for (auto& session : targets) {
+        session->sendBroadcastMessage(message, fullState);
+    }
+    
+    ServerMetrics& metrics = ServerMetrics::instance();
+    metrics.broadcastFanOut.observe(std::chrono::steady_clock::now() - started);
+    metrics.broadcasts.inc();
+}
+
+void WebSocketServer::markPeer(std::shared_ptr<WebSocketSession> session) {
+    TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+    if (sessions_.erase(session) > 0) {
+        clearWatches(session);
+        peers_.insert(std::move(session));
+    }
+}
+
+void WebSocketServer::setSubscriptionCallback(SubscriptionCallback callback) {
+    subscriptionCallback_ = std::move(callback);
+}
+
+void WebSocketServer::setPeerSecret(std::string secret) {
+    peerSecret_ = std::move(secret);
+}
+
+bool WebSocketServer::acceptsPeer(std::string_view hello) const {
+    std::string_view prefix = CinemaProtocol::PEER_HELLO;
+    if (peerSecret_.empty() || hello.size() != prefix.size() + 1 + peerSecret_.size() ||
+        !hello.starts_with(prefix) || hello[prefix.size()] != ':') {
+        return false;
+    }
+    std::string_view secret = hello.substr(prefix.size() + 1);
+    unsigned char diff = 0;
+    for (size_t i = 0; i < secret.size(); ++i) {
+        diff |= static_cast<unsigned char>(secret[i] ^ peerSecret_[i]);
+    }
+    return diff == 0;
+}
+
+SharedPayload WebSocketServer::subscribe(const std::shared_ptr<WebSocketSession>& session, const std::string& message) {
+    const std::string_view subscribe = CinemaProtocol::SUBSCRIBE_PREFIX;
+    const std::string_view unsubscribe = CinemaProtocol::UNSUBSCRIBE_PREFIX;
+    if (!subscriptionCallback_ ||
+        (message.compare(0, subscribe.size(), subscribe) != 0 && message.compare(0, unsubscribe.size(), unsubscribe) != 0)) {
+        return nullptr;
+    }
+    
+    std::optional<SubscriptionRequest> request = subscriptionCallback_(message);
+    if (!request) {
+        return std::make_shared<const std::string>("ERROR: Unknown subscription. Use subscribe:all, "
+                                                   "subscribe:show:<id>,... or subscribe:theater:<name>,...");
+    }
+    
+    bool allShows;
+    std::size_t watched;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        if (sessions_.count(session) == 0) {
+            return nullptr;
+        }
+        
+        if (request->allShows) {
+            clearWatches(session);
+            if (request->subscribe) {
+                allShowsWatchers_.insert(session);
+            }
+        } else {
+            std::set<ShowId>& shows = watchedShows_[session];
+            if (allShowsWatchers_.erase(session) > 0 && !request->subscribe) {
+                // Narrowing "every show": watch all of them except the listed ones
+                for (ShowId id = 0; id < request->showCount; ++id) {
+                    shows.insert(id);
+                    showWatchers_[id].insert(session);
+                }
+            }
+            for (ShowId id : request->shows) {
+                if (request->subscribe) {
+                    shows.insert(id);
+                    showWatchers_[id].insert(session);
+                } else if (shows.erase(id) > 0) {
+                    auto watchers = showWatchers_.find(id);
+                    watchers->second.erase(session);
+                    if (watchers->second.empty()) {
+                        showWatchers_.erase(watchers);
+                    }
+                }
+            }
+        }
+        
+        allShows = allShowsWatchers_.count(session) > 0;
+        auto it = watchedShows_.find(session);
+        watched = it != watchedShows_.end() ? it->second.size() : 0;
+        if (it != watchedShows_.end() && it->second.empty()) {
+            watchedShows_.erase(it);
+        }
+    }
+    
+    if (allShows) {
+        return std::make_shared<const std::string>(CinemaProtocol::SUBSCRIBED_ALL);
+    }
+    return std::make_shared<const std::string>(std::string(CinemaProtocol::SUBSCRIBED_PREFIX) +
+                                               std::to_string(watched) + " show(s)");
+}
+
+void WebSocketServer::clearWatches(const std::shared_ptr<WebSocketSession>& session) {
+    allShowsWatchers_.erase(session);
+    auto it = watchedShows_.find(session);
+    if (it == watchedShows_.end()) {
+        return;
+    }
+    for (ShowId id : it->second) {
+        auto watchers = showWatchers_.find(id);
+        if (watchers != showWatchers_.end()) {
+            watchers->second.erase(session);
+            if (watchers->second.empty()) {
+                showWatchers_.erase(watchers);
+            }
+        }
+    }
+    watchedShows_.erase(it);
+}
+
+void WebSocketServer::publish(SharedPayload delta) {
+    std::vector<std::shared_ptr<WebSocketSession>> targets;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        if (peers_.empty()) {
+            return;
+        }
+        targets.assign(peers_.begin(), peers_.end());
+    }
+    
+    for (auto& peer : targets) {
+        peer->sendPeerMessage(delta);
+    }
+}
+
+SharedPayload WebSocketServer::handleMessage(const std::string& message, WireFormat format, BroadcastPayload& broadcast,
+                                             const ReplyCallback& reply) {
+    return messageCallback_(message, format, broadcast, reply);
+}
+
+void WebSocketServer::setDurabilityCallback(DurabilityCallback callback) {
+    durabilityCallback_ = std::move(callback);
+}
+
+bool WebSocketServer::persistsBookings() const {
+    return static_cast<bool>(durabilityCallback_);
+}
+
+void WebSocketServer::whenDurable(std::function<void(bool durable)> done) {
+    if (durabilityCallback_) {
+        durabilityCallback_(std::move(done));
+    } else {
+        done(true);
+    }
+}
+
+SharedPayload WebSocketServer::getInitialData(WireFormat format) {
+    return initialDataCallback_(format);
+}
+
+const CompressionOptions& WebSocketServer::compression() const {
+    return compression_;
+}
+
+AdmissionControl& WebSocketServer::admission() {
+    return admission_;
+}
+
+const QueueLimits& WebSocketServer::queueLimits() const {
+    return queueLimits_;
+}
+
+TrafficCounters& WebSocketServer::traffic() {
+    return traffic_;
+}
+
+TrafficStats WebSocketServer::stats() const {
+    TrafficStats result;
+    result.payloadBytesSent = traffic_.payloadBytesSent.load(std::memory_order_relaxed);
+    result.wireBytesSent = traffic_.wireBytesSent.load(std::memory_order_relaxed);
+    result.payloadBytesReceived = traffic_.payloadBytesReceived.load(std::memory_order_relaxed);
+    result.wireBytesReceived = traffic_.wireBytesReceived.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::string WebSocketServer::renderMetrics() {
+    std::size_t sessionCount = 0;
+    {
+        TracedLock<std::mutex> lock(sessionsMutex_, "sessions");
+        sessionCount = sessions_.size();
+    }
+    TrafficStats traffic = stats();
+    
+    std::string out = ServerMetrics::instance().render();
+    ServerMetrics::renderGauge(out, "cinema_sessions", "Connected WebSocket sessions", sessionCount);
+    ServerMetrics::renderGauge(out, "cinema_handshakes_pending", "Admitted connections still in their handshake", admission_.handshakes());
+    ServerMetrics::renderCounter(out, "cinema_payload_bytes_sent_total", "Message bytes before compression", traffic.payloadBytesSent);
+    ServerMetrics::renderCounter(out, "cinema_wire_bytes_sent_total", "Bytes written to sockets", traffic.wireBytesSent);
+    ServerMetrics::renderCounter(out, "cinema_payload_bytes_received_total", "Message bytes after decompression", traffic.payloadBytesReceived);
+    ServerMetrics::renderCounter(out, "cinema_wire_bytes_received_total", "Bytes read from sockets", traffic.wireBytesReceived);
+    return out;
+}
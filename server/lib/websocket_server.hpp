@@ -10,56 +10,185 @@
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/version.hpp>
 #include <memory>
+#include <atomic>
+#include <limits>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <set>
-#include <queue>
+#include <optional>
+#include <unordered_map>
+#include <deque>
+#include <chrono>
 #include <functional>
 #include "cinema.hpp"
+#include "metrics.hpp"
+#include "logger.hpp"
+#include "admission.hpp"
+#include "trace.hpp"
 
 namespace beast = boost::beast;
 namespace websocket = beast::websocket;
+namespace http = beast::http;
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
 /**
  * @brief Callback for handling client messages
  * @param message The received message
- * @param shouldBroadcast Output parameter indicating if response should be broadcast
- * @return Response message to send back
+ * @param format Wire format negotiated by the sending session
+ * @param broadcast Output payload to send to all clients, empty if none
+ * @param reply Receives the response later if none is returned, empty for
+ *        requests that must be answered immediately
+ * @return Shared response payload to send back, or null if it will be
+ *         delivered through @p reply
  */
-using MessageCallback = std::function<std::string(const std::string&, bool&)>;
+using MessageCallback = std::function<SharedPayload(const std::string&, WireFormat, BroadcastPayload&, const ReplyCallback&)>;
 
 /**
  * @brief Callback for getting initial data to send to new clients
- * @return Initial data string
+ * @param format Wire format the data is sent in
+ * @return Shared initial data payload
  */
-using InitialDataCallback = std::function<std::string()>;
+using InitialDataCallback = std::function<SharedPayload(WireFormat)>;
 
 /**
  * @brief Callback for getting broadcast data after updates
- * @return Broadcast data string
+ * @param format Wire format the data is sent in
+ * @return Shared broadcast data payload
  */
-using BroadcastDataCallback = std::function<std::string()>;
+using BroadcastDataCallback = std::function<SharedPayload(WireFormat)>;
 
 /**
- * @namespace CinemaProtocol
- * @brief Server-side protocol constants for Cinema communication
+ * @brief Callback resolving a client's subscription request
+ * @param message Message starting with CinemaProtocol::SUBSCRIBE_PREFIX or UNSUBSCRIBE_PREFIX
+ * @return Shows to start or stop watching, nullopt if the request is invalid
+ */
+using SubscriptionCallback = std::function<std::optional<SubscriptionRequest>(const std::string& message)>;
+
+/**
+ * @brief Callback that defers work until state changes are durable
+ * @param done Function to call, on any thread, with true once everything
+ *        recorded so far has been persisted, or false if it could not be
+ */
+using DurabilityCallback = std::function<void(std::function<void(bool durable)> done)>;
+
+/**
+ * @struct CompressionOptions
+ * @brief permessage-deflate settings offered to clients
+ * 
+ * @note minSize requires Boost 1.81 or newer (permessage_deflate's
+ *       msg_size_threshold); older Boost compresses every message
+ */
+struct CompressionOptions {
+    bool enabled = true;          ///< Offer permessage-deflate during the handshake
+    int windowBits = 15;          ///< Server LZ77 window size in bits (9-15)
+    int memLevel = 4;             ///< zlib memory level (1-9)
+    int compLevel = 6;            ///< zlib compression level (0-9)
+    std::size_t minSize = 256;    ///< Messages smaller than this are sent uncompressed
+};
+
+/**
+ * @struct TrafficStats
+ * @brief Snapshot of the byte counters of a server
+ * 
+ * Payload bytes are WebSocket message sizes before compression; wire bytes
+ * are what actually crossed the TCP sockets, including frame headers.
+ */
+struct TrafficStats {
+    uint64_t payloadBytesSent = 0;      ///< Message bytes handed to WebSocket writes
+    uint64_t wireBytesSent = 0;         ///< Bytes written to sockets
+    uint64_t payloadBytesReceived = 0;  ///< Message bytes delivered by WebSocket reads
+    uint64_t wireBytesReceived = 0;     ///< Bytes read from sockets
+};
+
+/**
+ * @struct TrafficCounters
+ * @brief Server-wide atomic byte counters updated by every session
+ */
+struct TrafficCounters {
+    std::atomic<uint64_t> payloadBytesSent{0};      ///< See TrafficStats
+    std::atomic<uint64_t> wireBytesSent{0};         ///< See TrafficStats
+    std::atomic<uint64_t> payloadBytesReceived{0};  ///< See TrafficStats
+    std::atomic<uint64_t> wireBytesReceived{0};     ///< See TrafficStats
+};
+
+/**
+ * @class TrafficMeter
+ * @brief Beast rate policy that never limits and only counts socket bytes
+ * 
+ * Plugged into the session's beast::basic_stream so the bytes seen by the
+ * TCP layer (after compression) are added to the server's TrafficCounters.
+ */
+class TrafficMeter {
+public:
+    /**
+     * @brief Constructor
+     * @param counters Counters to add to, must outlive the meter
+     */
+    explicit TrafficMeter(TrafficCounters* counters) : counters_(counters) {}
+
+private:
+    friend class beast::rate_policy_access;
+    
+    TrafficCounters* counters_;  ///< Server-wide counters
+    
+    std::size_t available_read_bytes() const noexcept {
+        return (std::numeric_limits<std::size_t>::max)();
+    }
+    
+    std::size_t available_write_bytes() const noexcept {
+        return (std::numeric_limits<std::size_t>::max)();
+    }
+    
+    void transfer_read_bytes(std::size_t n) noexcept {
+        counters_->wireBytesReceived.fetch_add(n, std::memory_order_relaxed);
+    }
+    
+    void transfer_write_bytes(std::size_t n) noexcept {
+        counters_->wireBytesSent.fetch_add(n, std::memory_order_relaxed);
+    }
+    
+    void on_timer() noexcept {}
+};
+
+/**
+ * @struct QueueLimits
+ * @brief Per-session outbound queue limits
  * 
- * Defines headers, footers, and constants used in server-client communication.
+ * Above highWaterBytes a session collapses pending full-state updates into
+ * the newest one. A session that stays above it for overloadTimeout, or
+ * reaches hardLimitBytes, is closed with close_code::try_again_later.
  */
-namespace CinemaProtocol {
-    constexpr const char* CINEMA_DATA_HEADER = "=== CINEMA DATA STREAM ===";   ///< Cinema data stream header
-    constexpr const char* CINEMA_DATA_FOOTER = "=== END CINEMA DATA ===";     ///< Cinema data stream footer
-    constexpr const char* UPDATE_DATA_HEADER = "=== UPDATED CINEMA DATA ==="; ///< Update data header
-    constexpr const char* UPDATE_DATA_FOOTER = "=== END UPDATED DATA ===";    ///< Update data footer
-    constexpr const char* BOOKING_UPDATE_PREFIX = "BOOKING_UPDATE:\n";        ///< Booking update prefix
-    constexpr int MAX_SEATS = 20;                                            ///< Maximum seats per show
-}
+struct QueueLimits {
+    std::size_t highWaterBytes = 1 << 20;                  ///< Queued bytes that mark a session as slow
+    std::size_t hardLimitBytes = 8 << 20;                  ///< Queued bytes that drop a session at once
+    std::chrono::milliseconds overloadTimeout{5000};       ///< Time allowed above the high-water mark
+    std::size_t coalesceBytes = 16 * 1024;                 ///< Largest merged write of queued deltas
+};
+
+/**
+ * @struct BatchingOptions
+ * @brief Window in which seat deltas are collected before broadcasting
+ * 
+ * The first delta after a quiet period is broadcast at once and opens a
+ * window; deltas arriving during it are merged per show and broadcast
+ * together when it closes, and the window stays open while deltas keep
+ * coming. Broadcast work is then bounded by time instead of booking rate,
+ * while an isolated booking is not delayed.
+ */
+struct BatchingOptions {
+    std::chrono::milliseconds window{20};   ///< Collection window, 0 broadcasts every delta at once
+    std::size_t flushBytes = 16 * 1024;     ///< Pending delta bytes that close the window early
+};
 
 class WebSocketServer;
 
@@ -85,29 +214,131 @@ class WebSocketServer;
  * - Participates in broadcast messages to all clients
  * 
  * @par Thread Safety
- * Uses Boost.Beast's async operations for thread-safe message handling.
+ * The underlying socket is bound to its own strand, so every completion
+ * handler of a session runs serialized even when the io_context is driven
+ * by several threads. Messages coming from other sessions (broadcasts) are
+ * posted onto that strand before touching the write queue.
  * Write operations are queued to prevent overlapping sends.
+ * 
+ * @par Outbound Queue
+ * The queue holds immutable, reference-counted payloads. A broadcast is
+ * formatted once and the same buffer is queued on every session; the
+ * queue keeps it alive until its async write has completed.
+ * 
+ * @par Compression
+ * permessage-deflate is offered with the server's CompressionOptions;
+ * replies below CompressionOptions::minSize skip compression.
+ * 
+ * @par Backpressure
+ * Queued bytes are tracked against the server's QueueLimits. Consecutive
+ * seat deltas waiting behind a write are merged into one message (text
+ * deltas joined by newlines, binary delta records concatenated). Above the
+ * high-water mark older full-state updates are dropped in favour of the
+ * newest; sessions that stay overloaded are closed as slow consumers.
+ * 
+ * @par Admission
+ * A session exists only if the server's AdmissionControl admitted its
+ * connection, and holds that ticket until it is destroyed. The opening
+ * request and the WebSocket handshake must complete within
+ * AdmissionOptions::handshakeTimeout. Every client message is charged to
+ * the ticket's token buckets first; a message over the rate is answered
+ * with the constant CinemaProtocol::RATE_LIMITED reply without being
+ * parsed, and a session that keeps flooding is closed with
+ * close_code::policy_error. Cluster peers are exempt from message limits.
+ * 
+ * @par HTTP Requests
+ * The first request on a connection is read as HTTP. Upgrade requests
+ * become WebSocket sessions; a plain GET of CinemaProtocol::METRICS_PATH
+ * is answered with the server's metrics and anything else with 404, after
+ * which the connection is closed.
+ * 
+ * @par Logging
+ * Session lines go through the async Logger and a per-session
+ * LogRateLimiter; received messages are only logged at LogLevel::Debug.
+ * 
+ * @par Wire Format
+ * Sessions start in text mode. A client that sends
+ * CinemaProtocol::BINARY_HELLO receives the binary catalogue and from then
+ * on binary data frames and deltas; TEXT_HELLO switches back. Requests
+ * from the client are always text.
+ * 
+ * @par Subscriptions
+ * Sessions start watching every show. CinemaProtocol::SUBSCRIBE_PREFIX
+ * and UNSUBSCRIBE_PREFIX requests narrow or widen that set (see
+ * MessageHandler::parseSubscription()), and the server only queues seat
+ * deltas of watched shows on the session. Full-state updates still reach
+ * every session.
+ * 
+ * @par Cluster Peers
+ * A session that sends CinemaProtocol::PEER_HELLO followed by ":" and the
+ * server's peer secret is another node of the cluster; a hello without it
+ * is refused and the session stays a rate-limited client. A peer stops
+ * receiving client broadcasts and instead gets the text SEAT_DELTA of
+ * every booking made here, and may send FORWARD requests, which are
+ * answered with FORWARDED replies. A client booking may be answered later
+ * (see MessageCallback); reading pauses until then.
  */
 class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
 private:
-    websocket::stream<tcp::socket> ws_;          ///< WebSocket stream for this connection
+    /**
+     * @brief What a queued payload carries, which decides how it may be merged or dropped
+     */
+    enum class FrameKind {
+        Reply,      ///< Response to a request, always delivered
+        Delta,      ///< Seat delta, may be merged with neighbouring deltas
+        FullState   ///< Complete catalogue, superseded by a newer one
+    };
+    
+    /**
+     * @struct OutboundFrame
+     * @brief Queued payload together with its WebSocket frame type
+     */
+    struct OutboundFrame {
+        SharedPayload payload;  ///< Data to send
+        bool binary;            ///< Send as a binary frame instead of text
+        FrameKind kind;         ///< Merge and drop policy
+        uint64_t traceId = 0;   ///< Sampled by the Tracer, 0 if not traced
+        TraceStamp enqueued = 0; ///< When a traced frame was queued
+    };
+    
+    using MeteredStream = beast::basic_stream<tcp, net::any_io_executor, TrafficMeter>;
+    using Clock = std::chrono::steady_clock;
+    
+    websocket::stream<MeteredStream> ws_;        ///< WebSocket stream for this connection
     beast::flat_buffer buffer_;                  ///< Buffer for incoming messages
+    http::request<http::string_body> request_;   ///< Opening HTTP request
+    http::response<http::string_body> response_; ///< Reply to a plain HTTP request
     WebSocketServer* server_;                    ///< Reference to parent server
-    std::queue<std::string> message_queue_;      ///< Queue for outgoing messages
-    bool writing_;                               ///< Flag to prevent overlapping writes
+    std::deque<OutboundFrame> message_queue_;    ///< Queue for outgoing messages, front is in flight
+    bool writing_;                               ///< Flag to prevent overlapping writes, set until the handshake completes
+    WireFormat format_;                          ///< Negotiated data encoding
+    std::size_t queuedBytes_;                    ///< Payload bytes in message_queue_
+    bool overloaded_;                            ///< queuedBytes_ is above the high-water mark
+    Clock::time_point overloadedSince_;          ///< When the session went above it
+    bool closing_;                               ///< Dropped as slow consumer, close pending
+    websocket::close_reason closeReason_;        ///< Sent by do_close()
+    net::steady_timer closeTimer_;               ///< Forces the socket shut if the close stalls
+    LogRateLimiter logLimiter_;                  ///< Keeps one client from flooding the log
+    bool peer_;                                  ///< Session is another cluster node
+    AdmissionControl::Ticket ticket_;            ///< Admission of this connection, held until it closes
+    std::size_t refusedInRow_;                   ///< Messages refused by the rate limit since the last accepted one
+    TraceStamp writeStarted_ = 0;                ///< Start of the traced write in flight
 
 public:
     /**
      * @brief Constructor
      * @param socket TCP socket from accepted connection
      * @param server Pointer to parent WebSocket server
+     * @param ticket Admission granted to the connection
      * @post Session is ready to begin WebSocket handshake
      */
-    explicit WebSocketSession(tcp::socket&& socket, WebSocketServer* server);
+    WebSocketSession(tcp::socket&& socket, WebSocketServer* server, AdmissionControl::Ticket ticket);
     
     /**
      * @brief Start the WebSocket session
-     * @post WebSocket handshake initiated
+     * @post Opening HTTP request read on the session strand; upgrade
+     *       requests register the session for broadcasts and start the handshake
+     * @note Broadcasts arriving before the handshake completes are queued
      * @post On success: initial data sent, read loop started
      * @post On failure: session cleans up automatically
      */
@@ -115,14 +346,46 @@ public:
     
     /**
      * @brief Send broadcast message to this client
-     * @param message Message to broadcast
-     * @post Message is queued for transmission
-     * @note Thread-safe operation
+     * @param message Broadcast in every encoding; the session picks its own
+     * @param fullState true if the message is a complete catalogue that
+     *        supersedes older ones, false for a seat delta
+     * @post Message is posted to the session strand and queued for transmission
+     * @note Thread-safe operation, may be called from any thread
      * @note Used for notifying client of booking updates
+     * @note The payload is shared, not copied
+     */
+    void sendBroadcastMessage(BroadcastPayload message, bool fullState = false);
+    
+    /**
+     * @brief Send a relayed booking to this cluster peer
+     * @param message Text SEAT_DELTA, queued as a reply so it is never merged
+     * @note Thread-safe operation, may be called from any thread
      */
-    void sendBroadcastMessage(const std::string& message);
+    void sendPeerMessage(SharedPayload message);
 
 private:
+    /**
+     * @brief Read the opening HTTP request
+     * @note Runs on the session strand
+     */
+    void on_run();
+    
+    /**
+     * @brief Route the opening HTTP request
+     * @param ec Error code from read operation
+     * @param bytes_transferred Number of bytes read
+     * @post Upgrade requests: session registered and handshake started
+     * @post Other requests: answered by serve_http()
+     */
+    void on_read_request(beast::error_code ec, std::size_t bytes_transferred);
+    
+    /**
+     * @brief Answer a plain HTTP request
+     * @post GET CinemaProtocol::METRICS_PATH: Prometheus text, otherwise 404
+     * @post Connection is shut down once the response is written
+     */
+    void serve_http();
+    
     /**
      * @brief Handle WebSocket handshake completion
      * @param ec Error code from handshake operation
@@ -135,6 +398,7 @@ private:
      * @brief Handle message write completion
      * @param ec Error code from write operation
      * @param bytes_transferred Number of bytes written
+     * @post Completed message is released from the queue
      * @post Next queued message sent if available
      * @post On error: session cleanup initiated
      */
@@ -158,18 +422,118 @@ private:
     
     /**
      * @brief Initiate asynchronous write operation
-     * @post Next queued message is sent
+     * @post Front queued message is sent; it stays queued until on_write
      * @note Only called when no write operation is in progress
      */
     void do_write();
     
     /**
      * @brief Queue message for transmission
-     * @param message Message to send
+     * @param message Shared payload to send
+     * @param binary Send as a binary frame
+     * @param kind Merge and drop policy of the payload
+     * @param traceId Sampled request the payload answers, 0 for none;
+     *        broadcasts are sampled here when tracing
      * @post Message added to send queue
      * @post Write operation initiated if not already in progress
+     * @post Above the high-water mark: older full-state frames are dropped
+     *       when @p kind is FrameKind::FullState, and a session overloaded
+     *       for too long is closed
+     * @note Must be called from the session strand
+     */
+    void send_message(SharedPayload message, bool binary = false, FrameKind kind = FrameKind::Reply,
+                      uint64_t traceId = 0);
+    
+    /**
+     * @brief Queue the encoding of a broadcast matching this session
+     * @param message Broadcast in every encoding
+     * @param fullState Queue as FrameKind::FullState instead of Delta
+     * @note Must be called from the session strand
+     */
+    void send_broadcast(BroadcastPayload message, bool fullState);
+    
+    /**
+     * @brief Queue a reply in the frame type its content calls for
+     * @param reply Response to a request of this session
+     * @param traceId Sampled request @p reply answers, 0 for none
+     * @note Catalogue replies to binary sessions are binary; status lines stay text
+     * @note Must be called from the session strand
+     */
+    void send_reply(SharedPayload reply, uint64_t traceId = 0);
+    
+    /**
+     * @brief Merge consecutive queued deltas behind the front frame
+     * @post Front frame is a single delta message of at most
+     *       QueueLimits::coalesceBytes, or unchanged if nothing to merge
+     * @note Must be called from the session strand with no write in flight
+     */
+    void coalesce_front();
+    
+    /**
+     * @brief Update overload tracking after the queue grew
+     * @post Older full-state frames are dropped if above the high-water mark
+     * @post Slow consumers are handed to drop_slow_consumer()
+     */
+    void apply_backpressure(FrameKind kind);
+    
+    /**
+     * @brief Drop this session as a slow consumer
+     * @post Pending frames are discarded and a close with
+     *       close_code::try_again_later is sent after the in-flight write
+     * @post The socket is shut if the close does not finish in time
+     */
+    void drop_slow_consumer();
+    
+    /**
+     * @brief Drop this session for sending faster than its rate limit
+     * @post Like drop_slow_consumer(), with close_code::policy_error
+     */
+    void drop_flooding_client();
+    
+    /**
+     * @brief Discard pending frames and close after the in-flight write
+     * @param reason Close frame to send
+     * @post The socket is shut if the close does not finish in time
+     */
+    void begin_close(websocket::close_reason reason);
+    
+    /**
+     * @brief Start the closing handshake of a dropped session
+     */
+    void do_close();
+    
+    /**
+     * @brief Handle closing handshake completion
+     * @param ec Error code from close operation
      */
-    void send_message(const std::string& message);
+    void on_close(beast::error_code ec);
+    
+    /**
+     * @brief Switch the session to a wire format and resend the catalogue
+     * @param format Format requested by the client
+     * @note Must be called from the session strand
+     */
+    void switch_format(WireFormat format);
+    
+    /**
+     * @brief Log a line about this session, subject to its rate limit
+     * @param level Severity of the line
+     * @param args Values streamed into the line
+     * @note Lines refused by the limiter are counted and reported with the
+     *       next line that gets through
+     */
+    template <typename... Args>
+    void log(LogLevel level, const Args&... args) {
+        if (!Logger::enabled(level) || !logLimiter_.allow()) {
+            return;
+        }
+        uint64_t suppressed = logLimiter_.takeSuppressed();
+        if (suppressed > 0) {
+            Logger::log(level, args..., " (", suppressed, " earlier line(s) suppressed)");
+        } else {
+            Logger::log(level, args...);
+        }
+    }
 };
 
 /**
@@ -186,20 +550,94 @@ private:
  * - Routes messages to business logic via callbacks
  * - Coordinates broadcast updates to all clients
  * 
+ * @par Threading Model
+ * The io_context may be run by any number of threads. Each accepted socket
+ * gets its own strand, and the session set is guarded by a mutex so sessions
+ * can join, leave and be broadcast to concurrently.
+ * 
  * @par Callback System
  * Uses function callbacks to decouple server infrastructure from business logic:
- * - MessageCallback: Handle individual client messages
+ * - MessageCallback: Handle individual client messages, optionally
+ *   producing a payload (e.g. a SEAT_DELTA) to broadcast
  * - InitialDataCallback: Get data for new clients
- * - BroadcastDataCallback: Get update data for broadcasts
+ * - BroadcastDataCallback: Get full-state update data for broadcastUpdate()
  */
 class WebSocketServer {
 private:
     net::io_context& ioc_;                           ///< Boost.Asio I/O context
     tcp::acceptor acceptor_;                         ///< TCP acceptor for new connections
-    std::set<std::shared_ptr<WebSocketSession>> sessions_; ///< Active client sessions
+    using SessionSet = std::set<std::shared_ptr<WebSocketSession>>;
+    
+    SessionSet sessions_;                            ///< Active client sessions
+    SessionSet peers_;                               ///< Sessions of other cluster nodes
+    SessionSet allShowsWatchers_;                    ///< Client sessions watching every show
+    std::unordered_map<ShowId, SessionSet> showWatchers_;  ///< Sessions watching single shows, by show
+    std::unordered_map<std::shared_ptr<WebSocketSession>, std::set<ShowId>> watchedShows_;  ///< Single shows per session
+    std::mutex sessionsMutex_;                       ///< Protects the session sets and subscription index
+    CompressionOptions compression_;                 ///< permessage-deflate settings
+    QueueLimits queueLimits_;                        ///< Outbound queue limits per session
+    BatchingOptions batching_;                       ///< Delta collection window
+    AdmissionControl admission_;                     ///< Connection caps and rate limits
+    TrafficCounters traffic_;                        ///< Byte counters of all sessions
     MessageCallback messageCallback_;                ///< Handler for client messages
     InitialDataCallback initialDataCallback_;       ///< Provider of initial data
     BroadcastDataCallback broadcastDataCallback_;   ///< Provider of broadcast data
+    DurabilityCallback durabilityCallback_;         ///< Defers booking replies, empty if not persisted
+    SubscriptionCallback subscriptionCallback_;     ///< Resolves subscriptions, empty to ignore them
+    std::string peerSecret_;                        ///< Proves a session is a cluster peer, empty to accept none
+    
+    /**
+     * @struct PendingDeltas
+     * @brief Deltas merged during the current batching window
+     */
+    struct PendingDeltas {
+        std::string text;     ///< Text deltas joined by newlines
+        std::string binary;   ///< Binary delta records behind one frame header
+        uint64_t count = 0;   ///< Deltas merged
+    };
+    
+    std::mutex batchMutex_;                                  ///< Protects the batching fields below
+    bool windowOpen_ = false;                                ///< A delta went out within the window
+    PendingDeltas pendingAll_;                               ///< Every pending delta, for all-show watchers
+    std::unordered_map<ShowId, PendingDeltas> pendingShows_; ///< Pending deltas by show
+    net::strand<net::io_context::executor_type> batchStrand_;  ///< Runs the window timer
+    net::steady_timer batchTimer_;                           ///< Closes the batching window
+
+    /**
+     * @brief Remove a session from the subscription index
+     * @param session Session to remove
+     * @note Called with sessionsMutex_ held
+     */
+    void clearWatches(const std::shared_ptr<WebSocketSession>& session);
+    
+    /**
+     * @brief Collect the sessions watching a show
+     * @param show Show to look up, ALL_SHOWS for every session
+     * @return Sessions snapshotted under sessionsMutex_
+     */
+    std::vector<std::shared_ptr<WebSocketSession>> watchersOf(ShowId show);
+    
+    /**
+     * @brief Queue a payload on some sessions
+     * @param message Payload in every encoding
+     * @param fullState Queue as a full-state update instead of a delta
+     * @param targets Sessions to queue it on
+     */
+    void deliver(const BroadcastPayload& message, bool fullState,
+                 const std::vector<std::shared_ptr<WebSocketSession>>& targets);
+    
+    /**
+     * @brief Broadcast the deltas collected in the window
+     * @param all Deltas of every show, for sessions watching all shows
+     * @param shows Deltas by show, for sessions watching single shows
+     */
+    void flushDeltas(PendingDeltas all, std::unordered_map<ShowId, PendingDeltas> shows);
+    
+    /**
+     * @brief Close the batching window after BatchingOptions::window
+     * @note Runs on batchStrand_
+     */
+    void armBatchTimer();
 
 public:
     /**
@@ -209,12 +647,20 @@ public:
      * @param messageCallback Function to handle client messages
      * @param initialDataCallback Function to get initial data for new clients
      * @param broadcastDataCallback Function to get broadcast update data
+     * @param compression permessage-deflate settings offered to clients
+     * @param queueLimits Outbound queue limits applied to every session
+     * @param batching Window in which seat deltas are merged before broadcasting
+     * @param admission Connection caps, handshake timeout and rate limits
      * @post Server is configured but not yet accepting connections
      */
     WebSocketServer(net::io_context& ioc, const tcp::endpoint& endpoint,
                    MessageCallback messageCallback,
                    InitialDataCallback initialDataCallback,
-                   BroadcastDataCallback broadcastDataCallback);
+                   BroadcastDataCallback broadcastDataCallback,
+                   CompressionOptions compression = {},
+                   QueueLimits queueLimits = {},
+                   BatchingOptions batching = {},
+                   AdmissionOptions admission = {});
     
     /**
      * @brief Start accepting client connections
@@ -228,6 +674,7 @@ public:
      * @param session Shared pointer to new WebSocket session
      * @post Session is tracked and will receive broadcast messages
      * @note Called automatically when new clients connect
+     * @note Thread-safe operation
      */
     void addSession(std::shared_ptr<WebSocketSession> session);
     
@@ -236,32 +683,165 @@ public:
      * @param session Shared pointer to session being removed
      * @post Session no longer receives broadcast messages
      * @note Called automatically when clients disconnect
+     * @note Thread-safe operation
      */
     void removeSession(std::shared_ptr<WebSocketSession> session);
     
     /**
-     * @brief Send update to all connected clients
+     * @brief Send full-state update to all connected clients
      * @post Broadcast message sent to all active sessions
      * @note Uses broadcastDataCallback_ to get current data
-     * @note Called after successful booking operations
+     * @note The payload is obtained once and shared by all sessions
      */
     void broadcastUpdate();
     
+    /**
+     * @brief Send a payload to all connected clients watching its show
+     * @param message Payload in every encoding to broadcast; sessions
+     *        watching message.show get it, or every session for ALL_SHOWS
+     * @param fullState true if @p message is a complete catalogue that
+     *        supersedes older ones (see QueueLimits)
+     * @post Message queued on every active session watching it; a delta
+     *       during the batching window is merged and queued when it closes
+     * @note Called after successful booking operations with the SEAT_DELTA
+     *       produced by the message callback
+     * @note Thread-safe operation; sessions are snapshotted under the lock
+     *       and messaged outside of it
+     */
+    void broadcast(BroadcastPayload message, bool fullState = false);
+    
+    /**
+     * @brief Enable client subscriptions
+     * @param callback Resolves subscription requests to shows
+     * @note Must be set before run()
+     */
+    void setSubscriptionCallback(SubscriptionCallback callback);
+    
+    /**
+     * @brief Set the secret cluster peers must send with their hello
+     * @param secret Shared secret, empty to refuse every peer
+     * @note Must be set before run()
+     */
+    void setPeerSecret(std::string secret);
+    
+    /**
+     * @brief Check a peer hello
+     * @param hello Message starting with CinemaProtocol::PEER_HELLO
+     * @return true if it carries the peer secret
+     * @note Compares in constant time, so the secret cannot be guessed
+     *       byte by byte
+     */
+    bool acceptsPeer(std::string_view hello) const;
+    
+    /**
+     * @brief Apply a subscription request of a session
+     * @param session Client session the request came from
+     * @param message Message received from it
+     * @return Reply for the client, or null if @p message is not a
+     *         subscription request (or subscriptions are disabled);
+     *         CinemaProtocol::SUBSCRIBED_ALL once every show is watched
+     * @post Seat deltas for @p session's watched shows only reach it
+     * @note Thread-safe operation
+     */
+    SharedPayload subscribe(const std::shared_ptr<WebSocketSession>& session, const std::string& message);
+    
+    /**
+     * @brief Turn a session into a cluster peer
+     * @param session Session that sent CinemaProtocol::PEER_HELLO
+     * @post The session gets publish() messages instead of broadcasts
+     * @note Thread-safe operation
+     */
+    void markPeer(std::shared_ptr<WebSocketSession> session);
+    
+    /**
+     * @brief Relay a locally made booking to every cluster peer
+     * @param delta Text SEAT_DELTA of the booking
+     * @note Thread-safe operation; does nothing without peers
+     */
+    void publish(SharedPayload delta);
+    
     /**
      * @brief Handle message from client (delegates to callback)
      * @param message Message received from client
-     * @param shouldBroadcast Output indicating if update should be broadcast
-     * @return Response message for client
+     * @param format Wire format negotiated by the sending session
+     * @param broadcast Output payload to broadcast, empty if none
+     * @param reply Receives the response if it is produced later
+     * @return Shared response payload for client, null if deferred
      * @post Delegates to messageCallback_ for business logic
      */
-    std::string handleMessage(const std::string& message, bool& shouldBroadcast);
+    SharedPayload handleMessage(const std::string& message, WireFormat format, BroadcastPayload& broadcast,
+                                const ReplyCallback& reply = {});
+    
+    /**
+     * @brief Hold booking replies until the booking is persisted
+     * @param callback Called with a continuation after every successful
+     *        booking; the reply and broadcast are sent once it runs. If
+     *        the booking was not persisted, the reply is replaced by
+     *        MessageHandler::unsavedReply()
+     * @note Must be set before run()
+     */
+    void setDurabilityCallback(DurabilityCallback callback);
+    
+    /**
+     * @brief Check whether booking replies wait for persistence
+     * @return true if a DurabilityCallback is set
+     */
+    bool persistsBookings() const;
+    
+    /**
+     * @brief Run a function once state changes so far are durable
+     * @param done Function to run with whether they were persisted;
+     *        immediately with true if no DurabilityCallback is set
+     */
+    void whenDurable(std::function<void(bool durable)> done);
     
     /**
      * @brief Get initial data for new client (delegates to callback)
-     * @return Initial cinema data string
+     * @param format Wire format the data is sent in
+     * @return Shared initial cinema data payload
      * @post Delegates to initialDataCallback_ for current data
      */
-    std::string getInitialData();
+    SharedPayload getInitialData(WireFormat format = WireFormat::Text);
+    
+    /**
+     * @brief Get the permessage-deflate settings for new sessions
+     * @return Compression options given at construction
+     */
+    const CompressionOptions& compression() const;
+    
+    /**
+     * @brief Get the outbound queue limits for sessions
+     * @return Queue limits given at construction
+     */
+    const QueueLimits& queueLimits() const;
+    
+    /**
+     * @brief Get the admission control of new connections
+     * @return Limits and counts shared by all sessions
+     */
+    AdmissionControl& admission();
+    
+    /**
+     * @brief Get the counters sessions add their traffic to
+     * @return Server-wide counters
+     * @note Thread-safe, counters are atomic
+     */
+    TrafficCounters& traffic();
+    
+    /**
+     * @brief Get a snapshot of the byte counters
+     * @return Payload and wire bytes sent and received so far
+     * @note Thread-safe operation
+     */
+    TrafficStats stats() const;
+    
+    /**
+     * @brief Render server metrics for the /metrics route
+     * @return ServerMetrics plus session count and byte counters, in the
+     *         Prometheus text format
+     * @note Thread-safe operation
+     */
+    std::string renderMetrics();
 
 private:
     /**
@@ -273,7 +853,9 @@ private:
     /**
      * @brief Handle new client connection acceptance
      * @param ec Error code from accept operation
-     * @param socket TCP socket for new client
+     * @param socket TCP socket for new client, bound to a fresh strand
+     * @post Connections refused by admission control are closed at once,
+     *       before any handshake work
      * @post On success: new WebSocketSession created and started
      * @post Next accept operation initiated
      */
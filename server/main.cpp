@@ -12,13 +12,15 @@
  * and manages real-time communication with multiple cinema booking clients.
  * 
  * @par Application Architecture
- * - Creates initial cinema data with predefined shows and seat patterns
+ * - Loads the show catalogue from a schedule file or the built-in demo data
  * - Configures WebSocket server with callback handlers
  * - Manages concurrent client connections
  * - Coordinates booking operations and real-time updates
  * 
  * @par Data Initialization
- * Creates 9 shows (3 movies × 3 theaters) with different seat availability patterns:
+ * Loads the schedule named by CATALOGUE_FILE (see CatalogueLoader for the
+ * format), parsed on CATALOGUE_THREADS threads (default: one per core).
+ * Without it, serves 9 demo shows (3 movies × 3 theaters):
  * - Movies: Inception, Interstellar, Tenet
  * - Theaters: PVR, IMAX, Cinepolis
  * - Each show has 20 seats with predefined booking patterns
@@ -37,18 +39,32 @@
  * - Business services (CinemaService, BookingService, MessageHandler)
  */
 
-#include <iostream>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <algorithm>
 #include <thread>
+#include <cstdlib>
+#include <memory>
+#include <csignal>
+#include <stdexcept>
 #include <boost/version.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
 
+#include "lib/availability.hpp"
+#include "lib/booking_journal.hpp"
+#include "lib/catalogue_loader.hpp"
 #include "lib/cinema.hpp"
+#include "lib/cluster.hpp"
 #include "lib/websocket_server.hpp"
+#include "lib/logger.hpp"
+#include "lib/metrics.hpp"
+#include "lib/replica_sync.hpp"
+#include "lib/seat_allocator.hpp"
+#include "lib/seat_holds.hpp"
+#include "lib/trace.hpp"
 
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
@@ -58,24 +74,117 @@ using tcp = net::ip::tcp;
  * @return 0 on successful execution
  * 
  * @par Initialization Process
- * 1. Create cinema data with movies, theaters, and seat patterns
+ * 1. Load the catalogue, or create the demo shows
  * 2. Configure WebSocket server with callback handlers
- * 3. Start server on localhost:8080
- * 4. Display initial cinema state
+ * 3. Start server on port 8080 (SERVER_PORT overrides it)
+ * 4. Display initial cinema state (catalogues of up to 100 shows)
  * 5. Enter serving loop for client connections
  * 
  * @par Callback Configuration
  * - Message Callback: Routes client messages to MessageHandler
  * - Initial Data Callback: Provides current cinema state to new clients
- * - Broadcast Callback: Supplies update data for booking notifications
+ * - Broadcast Callback: Supplies full-state update data for broadcastUpdate()
+ * - Successful bookings broadcast a SEAT_DELTA instead of the full state
+ * - All three read from a shared CinemaSnapshot, so the catalogue is only
+ *   re-formatted after a booking changes it
+ * - Sessions that negotiated the binary protocol get the binary encoding
+ * 
+ * @par Compression
+ * permessage-deflate is offered to clients unless WS_DEFLATE=0.
+ * WS_DEFLATE_WINDOW_BITS, WS_DEFLATE_MEM_LEVEL, WS_DEFLATE_LEVEL and
+ * WS_DEFLATE_MIN_SIZE tune it; byte counters are logged on disconnect.
+ * 
+ * @par Backpressure
+ * WS_QUEUE_HIGH_WATER sets the per-client queued bytes above which a
+ * client is treated as slow and eventually dropped.
+ * 
+ * @par Admission control
+ * Connections beyond MAX_CONNECTIONS (default 50000), MAX_CONNECTIONS_PER_IP
+ * or MAX_HANDSHAKES (default 4096) are closed straight after accept, as
+ * are addresses opening more than IP_CONNECT_RATE connections per second.
+ * The opening handshake must finish within HANDSHAKE_TIMEOUT_MS (default
+ * 10000). Each session may send RATE_LIMIT messages per second (default
+ * 200, bursts of RATE_BURST, default 400) and each address IP_RATE_LIMIT
+ * (bursts of IP_RATE_BURST); messages over the rate get a short error
+ * without being handled. Per-address limits are off unless set, and 0
+ * turns any limit off.
+ * 
+ * @par Delta batching
+ * Seat deltas arriving within WS_BATCH_WINDOW_MS (default 20) of the
+ * last broadcast are merged into one message per show when the window
+ * closes; the first delta after a quiet period goes out at once.
+ * WS_BATCH_FLUSH_BYTES closes a window early, WS_BATCH_WINDOW_MS=0
+ * broadcasts every delta on its own.
+ * 
+ * @par Subscriptions
+ * Clients may send subscribe:show:<ids> or subscribe:theater:<names> to
+ * receive seat deltas of those shows only (subscribe:all to undo).
+ * 
+ * @par Persistence
+ * Bookings are journaled to JOURNAL_DIR (default "data") and replies wait
+ * for the group commit. If a commit fails, those bookings are answered
+ * "ERROR: Booking could not be saved" and later ones are refused with it,
+ * before taking any seat, until a restart.
+ * Startup restores the snapshot and journal tail, and refuses to start if
+ * they were written for a different catalogue.
+ * JOURNAL=0 disables it, JOURNAL_FSYNC=0 skips fsync and
+ * SNAPSHOT_INTERVAL sets the seconds between snapshots.
+ * 
+ * @par Seat holds
+ * hold:[<seconds>:]theater,movie,seats reserves seats for HOLD_TTL seconds
+ * (default 300, at most HOLD_MAX_TTL, default 1800) until confirm:<token>
+ * books them or release:<token> frees them. Expired holds are freed
+ * within a tick and announced as SEAT_FREED; holds are not journaled.
+ * 
+ * @par Best seats
+ * book_best,theater,movie,count books the best block of count adjacent
+ * free seats, chosen by SeatAllocator, and replies the seats taken.
+ * 
+ * @par Availability queries
+ * query:movie=..,theater=..,after=..,before=..,seats=n,limit=n lists the
+ * matching shows with their free seats, see AvailabilityIndex.
+ * 
+ * @par Cluster
+ * CLUSTER_NODES lists every node as "id=host:port,..." and NODE_ID names
+ * this one. Shows are split between the nodes by consistent hashing on
+ * theater and movie; bookings for shows owned elsewhere are forwarded to
+ * the owner, and each node relays its bookings to the others, which
+ * broadcast them to their own clients. Without CLUSTER_NODES the node owns
+ * every show. Nodes and replicas prove they are peers with CLUSTER_SECRET,
+ * which must be the same everywhere; without it no peer is accepted.
+ * 
+ * @par Replicas
+ * REPLICA_OF=host:port runs a read replica of that node; REPLICA=1 makes
+ * the node a replica of every member of CLUSTER_NODES (NODE_ID is then
+ * only a name for the logs). A replica owns no show: bookings, holds and
+ * best-seat requests are forwarded to the owner, while get_data, refresh,
+ * queries and subscriptions are served from its own copy of the seats,
+ * kept current by the relayed deltas and resynced on every connect (see
+ * ReplicaSync). Browse capacity grows with the number of replicas.
+ * 
+ * @par Tracing
+ * In builds configured with -DCINEMA_TRACING=ON, TRACE_FILE names a
+ * Chrome trace (chrome://tracing, ui.perfetto.dev) written on shutdown:
+ * lock wait and hold times, seat map write windows and the stages of one
+ * request in TRACE_SAMPLE (default 100). Other builds ignore it.
+ * 
+ * @par Logging
+ * All output goes through the asynchronous Logger. LOG_LEVEL selects the
+ * threshold (debug, info, warn, error, off; default info); received
+ * messages are logged at debug.
+ * 
+ * @par Shutdown
+ * SIGINT and SIGTERM stop the io_context so pending log lines are flushed.
  * 
  * @par Threading Model
  * - Main thread: Handles initialization and display
- * - WebSocket thread: Manages async I/O operations
+ * - WebSocket thread pool: SERVER_THREADS threads (default: one per core)
+ *   all running the same io_context
+ * - Each client session is serialized on its own strand
  * - Server supports multiple concurrent client connections
  * 
  * @par Data Patterns
- * Uses three predefined seat patterns to simulate different booking states:
+ * The demo catalogue uses three seat patterns to simulate different booking states:
  * - Pattern 1: Mixed availability (50% occupied)
  * - Pattern 2: Sparse availability (45% occupied)  
  * - Pattern 3: High availability (25% occupied)
@@ -83,91 +192,370 @@ using tcp = net::ip::tcp;
 
 int main() {
 
-	std::vector<std::string> movieNames = {"Inception", "Interstellar", "Tenet"};
-	std::vector<std::string> theaterNames = {"PVR", "IMAX", "Cinepolis"};
+	if (const char* logLevel = std::getenv("LOG_LEVEL")) {
+		Logger::setLevel(Logger::parseLevel(logLevel, LogLevel::Info));
+	}
 
-	std::vector<Shows> shows;
-	
-	std::vector<bool> pattern1 = {
-		true, true, false, false, true,
-		false, false, false, false, true,
-		true, false, false, true, true,
-		false, false, false, true, false
-	};
-	
-	std::vector<bool> pattern2 = {
-		false, true, false, true, false,
-		true, false, true, true, false,
-		false, true, true, false, false,
-		true, true, false, false, true
+	// Chrome trace of locks and sampled requests, written on shutdown
+	bool tracing = false;
+	if (const char* traceFile = std::getenv("TRACE_FILE")) {
+		if (Tracer::COMPILED) {
+			TraceOptions traceOptions;
+			traceOptions.path = traceFile;
+			if (const char* sample = std::getenv("TRACE_SAMPLE")) {
+				traceOptions.sampleEvery = static_cast<uint32_t>(std::max(1, std::atoi(sample)));
+			}
+			Tracer::start(traceOptions);
+			tracing = true;
+			Logger::log(LogLevel::Info, "Tracing to ", traceFile, ", one request in ", traceOptions.sampleEvery);
+		} else {
+			Logger::log(LogLevel::Warn, "TRACE_FILE ignored: built without CINEMA_TRACING");
+		}
+	}
+
+	// Schedule from CATALOGUE_FILE, or the built-in demo catalogue
+	ShowStore shows;
+	CatalogueStats catalogueStats;
+	const char* catalogueFile = std::getenv("CATALOGUE_FILE");
+	try {
+		unsigned loadThreads = 0;
+		if (const char* threads = std::getenv("CATALOGUE_THREADS")) {
+			loadThreads = static_cast<unsigned>(std::max(0, std::atoi(threads)));
+		}
+		shows = catalogueFile ? CatalogueLoader::loadFile(catalogueFile, loadThreads, &catalogueStats)
+		                      : CatalogueLoader::parse(CatalogueLoader::demoCatalogue(), 1, &catalogueStats);
+		if (shows.empty()) {
+			throw std::runtime_error("no shows");
+		}
+	} catch (const std::exception& e) {
+		Logger::log(LogLevel::Error, "Invalid catalogue ", catalogueFile ? catalogueFile : "(built-in)", ": ", e.what());
+		Logger::flush();
+		return 1;
+	}
+	Logger::log(LogLevel::Info, "Loaded ", catalogueStats.shows, " show(s) with ", catalogueStats.bookedSeats,
+	            " booked seat(s) from ", catalogueFile ? catalogueFile : "the built-in catalogue", " (",
+	            catalogueStats.bytes, " bytes, ", catalogueStats.threads, " thread(s)) in ",
+	            catalogueStats.elapsed.count(), " us");
+
+	// Number of I/O threads, configurable via environment (for Docker)
+	// Defaults to one thread per hardware core
+	const char* server_threads = std::getenv("SERVER_THREADS");
+	int threadCount = server_threads ? std::atoi(server_threads) : 0;
+	if (threadCount <= 0) {
+		threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	}
+
+	// permessage-deflate settings, configurable via environment
+	// WS_DEFLATE=0 disables compression; small replies skip it anyway
+	CompressionOptions compression;
+	if (const char* deflate = std::getenv("WS_DEFLATE")) {
+		compression.enabled = std::atoi(deflate) != 0;
+	}
+	if (const char* windowBits = std::getenv("WS_DEFLATE_WINDOW_BITS")) {
+		compression.windowBits = std::clamp(std::atoi(windowBits), 9, 15);
+	}
+	if (const char* memLevel = std::getenv("WS_DEFLATE_MEM_LEVEL")) {
+		compression.memLevel = std::clamp(std::atoi(memLevel), 1, 9);
+	}
+	if (const char* level = std::getenv("WS_DEFLATE_LEVEL")) {
+		compression.compLevel = std::clamp(std::atoi(level), 0, 9);
+	}
+	if (const char* minSize = std::getenv("WS_DEFLATE_MIN_SIZE")) {
+		compression.minSize = static_cast<std::size_t>(std::max(0, std::atoi(minSize)));
+	}
+
+	// Outbound queue size above which a client counts as slow
+	QueueLimits queueLimits;
+	if (const char* highWater = std::getenv("WS_QUEUE_HIGH_WATER")) {
+		queueLimits.highWaterBytes = static_cast<std::size_t>(std::max(1, std::atoi(highWater)));
+		queueLimits.hardLimitBytes = 8 * queueLimits.highWaterBytes;
+	}
+
+	// Seat deltas of a booking burst are merged over a short window
+	BatchingOptions batching;
+	if (const char* window = std::getenv("WS_BATCH_WINDOW_MS")) {
+		batching.window = std::chrono::milliseconds(std::clamp(std::atoi(window), 0, 1000));
+	}
+	if (const char* flushBytes = std::getenv("WS_BATCH_FLUSH_BYTES")) {
+		batching.flushBytes = static_cast<std::size_t>(std::max(1, std::atoi(flushBytes)));
+	}
+
+	// Caps and rate limits checked before any parsing or formatting
+	AdmissionOptions admission;
+	auto sizeOption = [](const char* name, std::size_t& value) {
+		if (const char* text = std::getenv(name)) {
+			value = static_cast<std::size_t>(std::max(0, std::atoi(text)));
+		}
 	};
-	
-	std::vector<bool> pattern3 = {
-		true, false, true, true, true,
-		false, true, true, false, true,
-		true, false, true, true, true,
-		false, false, true, true, true
+	auto rateOption = [](const char* name, double& value) {
+		if (const char* text = std::getenv(name)) {
+			value = std::max(0.0, std::atof(text));
+		}
 	};
+	sizeOption("MAX_CONNECTIONS", admission.maxConnections);
+	sizeOption("MAX_CONNECTIONS_PER_IP", admission.maxConnectionsPerIp);
+	sizeOption("MAX_HANDSHAKES", admission.maxHandshakes);
+	rateOption("IP_CONNECT_RATE", admission.connectRatePerIp);
+	rateOption("RATE_LIMIT", admission.messageRate);
+	rateOption("RATE_BURST", admission.messageBurst);
+	rateOption("IP_RATE_LIMIT", admission.messageRatePerIp);
+	rateOption("IP_RATE_BURST", admission.messageBurstPerIp);
+	if (const char* timeout = std::getenv("HANDSHAKE_TIMEOUT_MS")) {
+		admission.handshakeTimeout = std::chrono::milliseconds(std::clamp(std::atoi(timeout), 100, 600000));
+	}
+
+	net::io_context ioc{threadCount};
+	auto const address = net::ip::make_address("0.0.0.0");
+	unsigned short port = 8080;
+	if (const char* serverPort = std::getenv("SERVER_PORT")) {
+		port = static_cast<unsigned short>(std::clamp(std::atoi(serverPort), 1, 65535));
+	}
 	
-	std::vector<std::vector<bool>> patterns = {pattern1, pattern2, pattern3};
+	Logger::log(LogLevel::Info, "Starting WebSocket server on ", address, ":", port,
+	            " with ", threadCount, " I/O thread(s)");
 	
-	int patternIndex = 0;
-	for (const auto& tName : theaterNames) {
-		for (const auto& mName : movieNames) {
-			Shows show(mName, "2025-09-11 19:30", tName);
-			show.seats = patterns[patternIndex % patterns.size()];
-			shows.push_back(show);
-			patternIndex++;
+	// Booking journal, restored before the shows are shared
+	std::unique_ptr<BookingJournal> journal;
+	const char* journalEnabled = std::getenv("JOURNAL");
+	if (!journalEnabled || std::atoi(journalEnabled) != 0) {
+		JournalOptions journalOptions;
+		if (const char* dir = std::getenv("JOURNAL_DIR")) {
+			journalOptions.directory = dir;
+		}
+		if (const char* sync = std::getenv("JOURNAL_FSYNC")) {
+			journalOptions.sync = std::atoi(sync) != 0;
+		}
+		if (const char* interval = std::getenv("SNAPSHOT_INTERVAL")) {
+			journalOptions.snapshotInterval = std::chrono::seconds(std::max(0, std::atoi(interval)));
+		}
+		journal = std::make_unique<BookingJournal>(shows, journalOptions);
+		try {
+			RecoveryStats recovered = journal->recover();
+			journal->start();
+			Logger::log(LogLevel::Info, "Recovered from ", journalOptions.directory, ": snapshot ",
+			            recovered.snapshotLoaded ? "loaded" : "not found", " (", recovered.snapshotShows,
+			            " show(s)), ", recovered.journalRecords, " journal record(s) in ",
+			            recovered.journalFiles, " file(s), ", recovered.truncatedBytes,
+			            " torn byte(s) dropped, ", recovered.elapsed.count(), " us");
+		} catch (const std::exception& e) {
+			Logger::log(LogLevel::Error, "Booking journal unavailable: ", e.what());
+			Logger::flush();
+			return 1;
 		}
 	}
-
-	net::io_context ioc;
-	auto const address = net::ip::make_address("0.0.0.0");
-	auto const port = static_cast<unsigned short>(8080);
 	
-	std::cout << "Starting WebSocket server on " << address << ":" << port << std::endl;
+	// Index shows once for O(1) booking lookups and theater grouping
+	ShowRegistry registry(shows);
+	
+	// Formatted data is cached and only rebuilt after a booking changes it
+	CinemaSnapshot snapshot(shows, registry);
+	
+	// Search indexes over the fixed names and times; seats are read live
+	AvailabilityIndex availability(shows);
+	
+	// Seat rankings are precomputed once per auditorium size
+	SeatAllocator allocator(shows, registry);
+	
+	BookingCallback onBooked;
+	if (journal) {
+		onBooked = [&journal](ShowId showId, const SeatNumber* seats, size_t count) {
+			journal->append(showId, seats, count);
+		};
+	}
+	
+	// Set once the cluster is up; left empty, every show is booked here
+	BookingForwarder forward;
+	
+	// Created once the server exists, which announces expired holds
+	std::unique_ptr<SeatHolds> holds;
+	
+	// Created once the server exists, which relays the other nodes' deltas
+	std::unique_ptr<ClusterNode> cluster;
 	
-	auto messageCallback = [&shows](const std::string& message, bool& shouldBroadcast) -> std::string {
-		return MessageHandler::handleMessage(message, shows, shouldBroadcast);
+	auto messageCallback = [&shows, &registry, &snapshot, &availability, &allocator, &onBooked, &forward, &holds, &cluster, &journal](const std::string& message, WireFormat format,
+	                                                                                                                                  BroadcastPayload& broadcast, const ReplyCallback& reply) -> SharedPayload {
+		if (AvailabilityIndex::isQuery(message)) {
+			return availability.handleMessage(message);
+		}
+		if (ReplicaSync::isSyncRequest(message)) {
+			// Members only vouch for the shows they book
+			if (cluster && !cluster->replica()) {
+				return ReplicaSync::formatState(shows, [&cluster](ShowId id) { return cluster->owns(id); });
+			}
+			return ReplicaSync::formatState(shows);
+		}
+		// Once the journal failed, nothing that takes seats may run: they would
+		// stay taken in memory for a booking nobody was given
+		if (journal && journal->failed() &&
+		    (SeatAllocator::isBestRequest(message) || MessageHandler::isBookingRequest(message) ||
+		     (SeatHolds::isHoldRequest(message) && !SeatHolds::isReleaseRequest(message)))) {
+			ServerMetrics::instance().bookingsRejected.inc();
+			return std::make_shared<const std::string>(CinemaProtocol::BOOKING_UNSAVED);
+		}
+		if (SeatAllocator::isBestRequest(message)) {
+			return allocator.handleMessage(message, broadcast, onBooked, forward, reply);
+		}
+		if (SeatHolds::isHoldRequest(message)) {
+			return holds->handleMessage(message, broadcast, onBooked, forward, reply);
+		}
+		return MessageHandler::handleMessage(message, shows, registry, snapshot, format, broadcast, onBooked, forward, reply);
 	};
 	
-	auto initialDataCallback = [&shows]() -> std::string {
-		return CinemaService::formatCinemaData(shows);
+	auto initialDataCallback = [&snapshot](WireFormat format) -> SharedPayload {
+		return format == WireFormat::Binary ? snapshot.binaryData() : snapshot.cinemaData();
 	};
 	
-	auto broadcastDataCallback = [&shows]() -> std::string {
-		return CinemaService::formatUpdateData(shows);
+	auto broadcastDataCallback = [&snapshot](WireFormat format) -> SharedPayload {
+		return format == WireFormat::Binary ? snapshot.binaryData() : snapshot.updateData();
 	};
 	
 	WebSocketServer server(ioc, tcp::endpoint{address, port}, 
-	                      messageCallback, initialDataCallback, broadcastDataCallback);
+	                      messageCallback, initialDataCallback, broadcastDataCallback,
+	                      compression, queueLimits, batching, admission);
+	if (journal) {
+		server.setDurabilityCallback([&journal](std::function<void(bool)> done) {
+			journal->whenDurable(std::move(done));
+		});
+	}
+	server.setSubscriptionCallback([&registry](const std::string& message) {
+		return MessageHandler::parseSubscription(message, registry);
+	});
+	// Peers bypass the rate limits, so a connection must prove it is one
+	const char* clusterSecret = std::getenv("CLUSTER_SECRET");
+	server.setPeerSecret(clusterSecret ? clusterSecret : "");
 	server.run();
 	
-	std::thread websocket_thread([&ioc]() {
-		ioc.run();
+	HoldOptions holdOptions;
+	if (const char* ttl = std::getenv("HOLD_TTL")) {
+		holdOptions.defaultTtl = std::chrono::seconds(std::max(1, std::atoi(ttl)));
+	}
+	if (const char* maxTtl = std::getenv("HOLD_MAX_TTL")) {
+		holdOptions.maxTtl = std::chrono::seconds(std::max(1, std::atoi(maxTtl)));
+	}
+	holds = std::make_unique<SeatHolds>(ioc, shows, registry, holdOptions, [&server](BroadcastPayload freed) {
+		SharedPayload delta = freed.text;
+		server.broadcast(std::move(freed));
+		server.publish(std::move(delta));
+	});
+	holds->start();
+	
+	const char* clusterNodes = std::getenv("CLUSTER_NODES");
+	const char* replicaOf = std::getenv("REPLICA_OF");
+	if (clusterNodes || replicaOf) {
+		ClusterOptions clusterOptions;
+		const char* replica = std::getenv("REPLICA");
+		clusterOptions.replica = replicaOf || (replica && std::atoi(replica) != 0);
+		clusterOptions.members = ClusterOptions::parseMembers(replicaOf ? "primary=" + std::string(replicaOf) : clusterNodes);
+		const char* nodeId = std::getenv("NODE_ID");
+		clusterOptions.nodeId = nodeId ? nodeId : clusterOptions.replica ? "replica" : "";
+		clusterOptions.secret = clusterSecret ? clusterSecret : "";
+		if (clusterOptions.secret.empty()) {
+			Logger::log(LogLevel::Error, "Invalid cluster configuration: CLUSTER_SECRET must be set on every node");
+			Logger::flush();
+			return 1;
+		}
+		if (clusterOptions.members.empty()) {
+			Logger::log(LogLevel::Error, "Invalid cluster configuration: no node in ", replicaOf ? replicaOf : clusterNodes);
+			Logger::flush();
+			return 1;
+		}
+		
+		auto onRelay = [&shows, &onBooked, &server](const std::string& delta) {
+			BroadcastPayload broadcast;
+			if (MessageHandler::applyRelayedDelta(delta, shows, broadcast, onBooked)) {
+				server.broadcast(std::move(broadcast));
+			}
+		};
+		auto onSync = [&shows, &onBooked, &server](const std::string& state) {
+			size_t changed = 0;
+			if (!ReplicaSync::applyState(state, shows, onBooked, changed)) {
+				Logger::log(LogLevel::Warn, "Ignoring seat state that does not match the local catalogue");
+				return;
+			}
+			Logger::log(LogLevel::Info, "Seat state synced, ", changed, " show(s) updated");
+			if (changed > 0) {
+				server.broadcastUpdate();
+			}
+		};
+		try {
+			cluster = std::make_unique<ClusterNode>(ioc, clusterOptions, shows, onRelay, onSync);
+		} catch (const std::exception& e) {
+			Logger::log(LogLevel::Error, "Invalid cluster configuration: ", e.what());
+			Logger::flush();
+			return 1;
+		}
+		
+		size_t owned = 0;
+		for (ShowId id = 0; id < shows.size(); ++id) {
+			owned += cluster->owns(id) ? 1 : 0;
+		}
+		if (clusterOptions.replica) {
+			Logger::log(LogLevel::Info, "Read replica ", clusterOptions.nodeId, " of ", clusterOptions.members.size(),
+			            " node(s), forwarding every booking");
+		} else {
+			Logger::log(LogLevel::Info, "Cluster node ", clusterOptions.nodeId, " of ", clusterOptions.members.size(),
+			            ", owning ", owned, " of ", shows.size(), " show(s)");
+		}
+		
+		forward = [&cluster](ShowId showId, const std::string& message, WireFormat format, ReplyCallback reply) {
+			return cluster->forward(showId, message, format, std::move(reply));
+		};
+		cluster->start();
+	}
+	
+	net::signal_set signals(ioc, SIGINT, SIGTERM);
+	signals.async_wait([&ioc](const beast::error_code&, int) {
+		Logger::log(LogLevel::Info, "Shutting down");
+		ioc.stop();
 	});
 	
-	std::cout << "WebSocket server started! Connect to ws://localhost:8080" << std::endl << std::endl;
+	std::vector<std::thread> websocket_threads;
+	websocket_threads.reserve(threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		websocket_threads.emplace_back([&ioc]() {
+			if (Tracer::enabled()) {
+				Tracer::nameThread("io");
+			}
+			ioc.run();
+		});
+	}
+	
+	Logger::log(LogLevel::Info, "WebSocket server started! Connect to ws://localhost:", port);
 
-	for (const auto& theaterName : theaterNames) {
-		std::cout << "Theater: " << theaterName << "\n";
-		for (const auto& show : shows) {
-			if (show.theater == theaterName) {
-				std::cout << "  Movie: " << show.movie << "\n";
-				std::cout << "    Free seats: ";
+	// Large schedules are only summarized by the load line above
+	if (Logger::enabled(LogLevel::Info) && shows.size() <= 100) {
+		std::ostringstream catalogue;
+		catalogue << "Cinema data:\n";
+		for (size_t t = 0; t < registry.theaterCount(); ++t) {
+			catalogue << "Theater: " << registry.theaterName(t) << "\n";
+			for (ShowId id : registry.theaterShows(t)) {
+				const auto& show = shows[id];
+				catalogue << "  Movie: " << show.movie << "\n";
+				catalogue << "    Free seats: ";
 				for (auto seatNum : show.getAvailableSeats()) {
-					std::cout << static_cast<int>(seatNum) << " ";
+					catalogue << static_cast<int>(seatNum) << " ";
 				}
-				std::cout << "\n";
+				catalogue << "\n";
 			}
 		}
-		std::cout << "\n";
+		Logger::submit(LogLevel::Info, catalogue.str());
 	}
 	
-	std::cout << "Cinema data displayed. WebSocket server is running..." << std::endl;
-	std::cout << "Press Ctrl+C to stop the server." << std::endl;
+	Logger::log(LogLevel::Info, "WebSocket server is running. Press Ctrl+C to stop the server.");
 	
-	websocket_thread.join();
+	for (auto& thread : websocket_threads) {
+		thread.join();
+	}
+	
+	// Commits the last batch and writes a final snapshot
+	if (journal) {
+		journal->stop();
+	}
+	
+	if (tracing && !Tracer::stop()) {
+		Logger::log(LogLevel::Error, "Could not write trace file ", std::getenv("TRACE_FILE"));
+	}
 	
+	Logger::flush();
 	return 0;
 }
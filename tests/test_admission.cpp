@@ -0,0 +1,124 @@
+#include "simple_test.hpp"
+#include "admission.hpp"
+#include <vector>
+
+void test_token_bucket() {
+    std::cout << "\n=== Testing Token Bucket ===" << std::endl;
+    
+    auto start = TokenBucket::Clock::now();
+    TokenBucket bucket(10.0, 3.0, start);
+    int allowed = 0;
+    for (int i = 0; i < 10; ++i) {
+        if (bucket.take(start)) {
+            ++allowed;
+        }
+    }
+    SimpleTest::EXPECT_EQ(3, allowed, "Burst is allowed at once");
+    SimpleTest::EXPECT_FALSE(bucket.full(start), "Drained bucket is not full");
+    
+    auto later = start + std::chrono::milliseconds(100);
+    SimpleTest::EXPECT_TRUE(bucket.take(later), "One token refills after 1/rate seconds");
+    SimpleTest::EXPECT_FALSE(bucket.take(later), "Only one token refilled");
+    SimpleTest::EXPECT_TRUE(bucket.full(start + std::chrono::seconds(5)), "Bucket refills up to its burst");
+    
+    TokenBucket unlimited(0.0, 1.0, start);
+    bool always = true;
+    for (int i = 0; i < 1000; ++i) {
+        always = always && unlimited.take(start);
+    }
+    SimpleTest::EXPECT_TRUE(always, "Rate 0 means no limit");
+}
+
+void test_admission_caps() {
+    std::cout << "\n=== Testing Admission Caps ===" << std::endl;
+    
+    AdmissionOptions options;
+    options.maxConnections = 3;
+    options.maxHandshakes = 2;
+    AdmissionControl control(options);
+    auto address = net::ip::make_address("10.0.0.1");
+    
+    AdmissionVerdict verdict;
+    std::vector<AdmissionControl::Ticket> tickets;
+    tickets.push_back(control.admit(address, verdict));
+    tickets.push_back(control.admit(address, verdict));
+    AdmissionControl::Ticket refused = control.admit(address, verdict);
+    SimpleTest::EXPECT_FALSE(static_cast<bool>(refused), "Third pending handshake is refused");
+    SimpleTest::EXPECT_TRUE(verdict == AdmissionVerdict::TooManyHandshakes, "Refused for pending handshakes");
+    
+    tickets[0].handshakeDone();
+    tickets[0].handshakeDone();
+    SimpleTest::EXPECT_EQ((size_t)1, control.handshakes(), "Completed handshake frees its slot once");
+    tickets.push_back(control.admit(address, verdict));
+    SimpleTest::EXPECT_TRUE(static_cast<bool>(tickets.back()), "Freed handshake slot admits again");
+    
+    tickets[1].handshakeDone();
+    tickets[2].handshakeDone();
+    control.admit(address, verdict);
+    SimpleTest::EXPECT_TRUE(verdict == AdmissionVerdict::TooManyConnections, "Total connection cap applies");
+    SimpleTest::EXPECT_EQ((size_t)3, control.connections(), "Refused connections are not counted");
+    
+    tickets.pop_back();
+    SimpleTest::EXPECT_EQ((size_t)2, control.connections(), "Destroyed ticket releases its connection");
+    AdmissionControl::Ticket moved = std::move(tickets[0]);
+    SimpleTest::EXPECT_EQ((size_t)2, control.connections(), "Moving a ticket keeps one connection");
+    tickets.clear();
+    SimpleTest::EXPECT_EQ((size_t)1, control.connections(), "Moved-from ticket releases nothing");
+}
+
+void test_admission_per_address() {
+    std::cout << "\n=== Testing Per-Address Admission ===" << std::endl;
+    
+    AdmissionOptions options;
+    options.maxConnectionsPerIp = 2;
+    options.messageRate = 0;
+    options.messageRatePerIp = 1.0;
+    options.messageBurstPerIp = 3.0;
+    AdmissionControl control(options);
+    auto first = net::ip::make_address("192.168.1.10");
+    auto mapped = net::ip::make_address("::ffff:192.168.1.10");
+    auto second = net::ip::make_address("192.168.1.11");
+    
+    AdmissionVerdict verdict;
+    AdmissionControl::Ticket a = control.admit(first, verdict);
+    AdmissionControl::Ticket b = control.admit(mapped, verdict);
+    control.admit(first, verdict);
+    SimpleTest::EXPECT_TRUE(verdict == AdmissionVerdict::TooManyFromAddress, "Per-address cap counts IPv4 and its mapped form together");
+    AdmissionControl::Ticket c = control.admit(second, verdict);
+    SimpleTest::EXPECT_TRUE(static_cast<bool>(c), "Other addresses are unaffected");
+    
+    auto now = AdmissionControl::Clock::now();
+    int allowed = 0;
+    for (int i = 0; i < 4; ++i) {
+        allowed += a.allowMessage(now) ? 1 : 0;
+        allowed += b.allowMessage(now) ? 1 : 0;
+    }
+    SimpleTest::EXPECT_EQ(3, allowed, "Sessions of one address share its message burst");
+    SimpleTest::EXPECT_TRUE(c.allowMessage(now), "Another address has its own bucket");
+    SimpleTest::EXPECT_EQ((size_t)2, control.sources(), "One entry per address");
+}
+
+void test_admission_message_rate() {
+    std::cout << "\n=== Testing Session Message Rate ===" << std::endl;
+    
+    AdmissionOptions options;
+    options.messageRate = 2.0;
+    options.messageBurst = 2.0;
+    AdmissionControl control(options);
+    AdmissionVerdict verdict;
+    AdmissionControl::Ticket ticket = control.admit(net::ip::make_address("::1"), verdict);
+    
+    auto now = AdmissionControl::Clock::now();
+    SimpleTest::EXPECT_TRUE(ticket.allowMessage(now), "First message of the burst");
+    SimpleTest::EXPECT_TRUE(ticket.allowMessage(now), "Second message of the burst");
+    SimpleTest::EXPECT_FALSE(ticket.allowMessage(now), "Message over the burst is refused");
+    SimpleTest::EXPECT_TRUE(ticket.allowMessage(now + std::chrono::milliseconds(500)), "Rate refills the session bucket");
+    SimpleTest::EXPECT_EQ((size_t)0, control.sources(), "Addresses are not tracked without per-address limits");
+}
+
+void run_admission_tests() {
+    test_token_bucket();
+    test_admission_caps();
+    test_admission_per_address();
+    test_admission_message_rate();
+}
@@ -0,0 +1,160 @@
+#include "simple_test.hpp"
+#include "availability.hpp"
+
+namespace {
+
+/**
+ * @brief Seat map of @p seatCount seats with [first, last] (1-based) free and the rest booked
+ */
+SeatMap freeBlock(size_t seatCount, size_t first, size_t last) {
+    std::vector<bool> pattern(seatCount, true);
+    for (size_t seat = first; seat <= last; ++seat) {
+        pattern[seat - 1] = false;
+    }
+    SeatMap seats(seatCount);
+    seats = pattern;
+    return seats;
+}
+
+std::string reply(const AvailabilityIndex& index, std::string_view message) {
+    return *index.handleMessage(message);
+}
+
+} // namespace
+
+void test_find_free_run() {
+    std::cout << "\n=== Testing Free Seat Runs ===" << std::endl;
+
+    SeatMap empty(20);
+    SimpleTest::EXPECT_EQ((SeatNumber)1, empty.findFreeRun(1), "Empty map starts at seat 1");
+    SimpleTest::EXPECT_EQ((SeatNumber)1, empty.findFreeRun(20), "Whole map is one run");
+    SimpleTest::EXPECT_EQ((SeatNumber)0, empty.findFreeRun(21), "Run longer than the map is not found");
+
+    SeatMap demo(20);
+    demo = std::vector<bool>{true, true, false, false, true, false, false, false, false, true,
+                             true, false, false, true, true, false, false, false, true, false};
+    SimpleTest::EXPECT_EQ((SeatNumber)3, demo.findFreeRun(2), "Lowest pair is taken");
+    SimpleTest::EXPECT_EQ((SeatNumber)6, demo.findFreeRun(4), "Shorter gaps are skipped");
+    SimpleTest::EXPECT_EQ((SeatNumber)0, demo.findFreeRun(5), "No run of five");
+
+    SeatMap acrossWords = freeBlock(200, 60, 70);
+    SimpleTest::EXPECT_EQ((SeatNumber)60, acrossWords.findFreeRun(11), "Run crossing a word boundary");
+    SimpleTest::EXPECT_EQ((SeatNumber)0, acrossWords.findFreeRun(12), "Run stops at the booked seat");
+
+    SeatMap longRun = freeBlock(300, 50, 250);
+    SimpleTest::EXPECT_EQ((SeatNumber)50, longRun.findFreeRun(150), "Run longer than a word");
+    SimpleTest::EXPECT_EQ((SeatNumber)50, longRun.findFreeRun(201), "Run spanning four words");
+    SimpleTest::EXPECT_EQ((SeatNumber)0, longRun.findFreeRun(202), "Long run is bounded");
+
+    SeatMap tail = freeBlock(130, 128, 130);
+    SimpleTest::EXPECT_EQ((SeatNumber)128, tail.findFreeRun(3), "Run ending at the last seat");
+    SimpleTest::EXPECT_EQ((SeatNumber)0, tail.findFreeRun(4), "Padding bits are not seats");
+
+    SeatMap full = freeBlock(64, 1, 0);
+    SimpleTest::EXPECT_EQ((SeatNumber)0, full.findFreeRun(1), "Full map has no run");
+
+    SeatNumber seats[] = {61, 62};
+    acrossWords.tryBook(seats, 2);
+    SimpleTest::EXPECT_EQ((SeatNumber)63, acrossWords.findFreeRun(8), "Bookings are seen at once");
+}
+
+void test_availability_parse() {
+    std::cout << "\n=== Testing Availability Query Parsing ===" << std::endl;
+
+    AvailabilityQuery query;
+    SimpleTest::EXPECT_FALSE(AvailabilityQuery::parse("movie=Tenet,after=2025-09-11 18:00,before=22:30,seats=3",
+                                                      query).has_value(),
+                             "Valid query parses");
+    SimpleTest::EXPECT_EQ(std::string("Tenet"), query.movie, "Movie filter");
+    SimpleTest::EXPECT_EQ(std::string("2025-09-11 18:00"), query.after, "Value with a date bounds the date/time");
+    SimpleTest::EXPECT_EQ(std::string("22:30"), query.beforeTime, "Value without a date bounds the time of day");
+    SimpleTest::EXPECT_EQ((size_t)3, query.seats, "Seat count");
+    SimpleTest::EXPECT_EQ(AvailabilityQuery::DEFAULT_LIMIT, query.limit, "Default limit");
+
+    SimpleTest::EXPECT_FALSE(AvailabilityQuery::parse("limit=100000", query).has_value(), "Large limit parses");
+    SimpleTest::EXPECT_EQ(AvailabilityQuery::MAX_LIMIT, query.limit, "Limit is capped");
+
+    for (std::string_view bad : {"seats=x", "limit=0", "colour=red", "movie", "after=25:00", "movie="}) {
+        SimpleTest::EXPECT_CONTAINS(AvailabilityQuery::parse(bad, query).value_or(""), "ERROR: Invalid query",
+                                    "Rejected: " + std::string(bad));
+    }
+}
+
+void test_availability_find() {
+    std::cout << "\n=== Testing Availability Queries ===" << std::endl;
+
+    ShowStore shows;
+    shows.emplace_back("Dune", "2025-09-12 21:00", "IMAX", 20);
+    shows.emplace_back("Dune", "2025-09-11 14:00", "PVR", 20);
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 20);
+    shows.emplace_back("Dune", "2025-09-11 19:30", "IMAX", 20);
+    shows.emplace_back("Dune", "2025-09-13 10:15", "PVR", 20);
+    shows[3].seats = freeBlock(20, 5, 7);
+    AvailabilityIndex index(shows);
+
+    size_t total = 0;
+    auto all = index.find({}, total);
+    SimpleTest::EXPECT_EQ((size_t)5, total, "Empty query matches every show");
+    SimpleTest::EXPECT_TRUE(all.size() == 5 && all[0].id == 1 && all[1].id == 2 && all[2].id == 3 &&
+                                all[3].id == 0 && all[4].id == 4,
+                            "Matches are in start time order");
+
+    AvailabilityQuery query;
+    AvailabilityQuery::parse("movie=Dune,theater=IMAX", query);
+    auto dune = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 2 && dune[0].id == 3 && dune[1].id == 0, "Movie and theater together");
+    SimpleTest::EXPECT_EQ((size_t)3, dune[0].freeSeats, "Free seats are reported");
+
+    AvailabilityQuery::parse("after=2025-09-11,before=2025-09-12", query);
+    index.find(query, total);
+    SimpleTest::EXPECT_EQ((size_t)3, total, "Date prefixes bound a whole day");
+
+    AvailabilityQuery::parse("after=18:00,before=22:00", query);
+    auto evening = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 3 && evening[0].id == 2 && evening[1].id == 3 && evening[2].id == 0,
+                            "Time of day range across dates, in time order");
+
+    AvailabilityQuery::parse("movie=Dune,seats=4", query);
+    auto four = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 3 && four[0].id == 1 && four[0].firstSeat == 1, "Shows without the block are dropped");
+
+    AvailabilityQuery::parse("seats=3,after=19:00,before=20:00", query);
+    auto three = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 2 && three[1].id == 3 && three[1].firstSeat == 5, "Block inside a booked show");
+
+    AvailabilityQuery::parse("movie=Dune,limit=2", query);
+    auto limited = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 4 && limited.size() == 2 && limited[1].id == 3, "Limit keeps the earliest");
+
+    AvailabilityQuery::parse("after=08:00,limit=1", query);
+    auto earliest = index.find(query, total);
+    SimpleTest::EXPECT_TRUE(total == 5 && earliest.size() == 1 && earliest[0].id == 1,
+                            "Limit on hour buckets keeps the earliest");
+
+    AvailabilityQuery::parse("movie=Alien", query);
+    SimpleTest::EXPECT_TRUE(index.find(query, total).empty() && total == 0, "Unknown movie matches nothing");
+}
+
+void test_availability_reply() {
+    std::cout << "\n=== Testing Availability Replies ===" << std::endl;
+
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR", 20);
+    shows.emplace_back("Tenet", "2025-09-11 21:00", "PVR", 20);
+    AvailabilityIndex index(shows);
+
+    SimpleTest::EXPECT_TRUE(AvailabilityIndex::isQuery("query:movie=Tenet"), "Query prefix");
+    SimpleTest::EXPECT_FALSE(AvailabilityIndex::isQuery("PVR,Tenet,1"), "Booking is not a query");
+    SimpleTest::EXPECT_EQ(std::string("SHOWS: 1 of 1\n1|PVR|Tenet|2025-09-11 21:00|20|1-2"),
+                          reply(index, "query:movie=Tenet,seats=2"), "Reply lists show and seat block");
+    SimpleTest::EXPECT_EQ(std::string("SHOWS: 1 of 2\n0|PVR|Inception|2025-09-11 19:30|20"),
+                          reply(index, "query:limit=1"), "Header counts every match");
+    SimpleTest::EXPECT_CONTAINS(reply(index, "query:seats="), "ERROR:", "Malformed query gets an error");
+}
+
+void run_availability_tests() {
+    test_find_free_run();
+    test_availability_parse();
+    test_availability_find();
+    test_availability_reply();
+}
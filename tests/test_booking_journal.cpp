@@ -0,0 +1,250 @@
+#include "simple_test.hpp"
+#include "booking_journal.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+ShowStore makeShows() {
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 100);
+    return shows;
+}
+
+JournalOptions tempOptions(const std::string& name) {
+    JournalOptions options;
+    options.directory = (std::filesystem::temp_directory_path() /
+                         ("cinema_journal_" + name + "_" + std::to_string(::getpid()))).string();
+    options.sync = false;
+    std::filesystem::remove_all(options.directory);
+    return options;
+}
+
+} // namespace
+
+void test_journal_replay() {
+    std::cout << "\n=== Testing Booking Journal Replay ===" << std::endl;
+    
+    JournalOptions options = tempOptions("replay");
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.recover();
+        journal.start();
+        shows[0].bookSeats(std::vector<SeatNumber>{1, 2});
+        journal.append(0, {1, 2});
+        shows[1].bookSeats(std::vector<SeatNumber>{70});
+        uint64_t sequence = journal.append(1, {70});
+        
+        std::atomic<bool> durable{false};
+        journal.whenDurable([&durable](bool ok) { durable = ok; });
+        journal.stop();
+        SimpleTest::EXPECT_TRUE(durable.load(), "whenDurable callback runs by stop()");
+        SimpleTest::EXPECT_EQ(sequence, journal.durableSequence(), "Every appended record is durable after stop()");
+    }
+    
+    ShowStore restored = makeShows();
+    BookingJournal journal(restored, options);
+    RecoveryStats stats = journal.recover();
+    SimpleTest::EXPECT_TRUE(stats.snapshotLoaded, "stop() leaves a snapshot behind");
+    SimpleTest::EXPECT_TRUE(restored[0].seats[0] && restored[0].seats[1], "Seats 1 and 2 are restored");
+    SimpleTest::EXPECT_FALSE(restored[0].seats[2], "Unbooked seats stay free");
+    SimpleTest::EXPECT_TRUE(restored[1].seats[69], "Seat beyond the first bitmap word is restored");
+    
+    std::filesystem::remove_all(options.directory);
+}
+
+void test_journal_torn_tail() {
+    std::cout << "\n=== Testing Booking Journal Torn Tail ===" << std::endl;
+    
+    JournalOptions options = tempOptions("torn");
+    std::string path = options.directory + "/journal.1";
+    std::string records;
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.start();
+        journal.append(0, {5});
+        journal.append(0, {6});
+        std::atomic<bool> durable{false};
+        journal.whenDurable([&durable](bool ok) { durable = ok; });
+        while (!durable) {
+            std::this_thread::yield();
+        }
+        std::ifstream in(path, std::ios::binary);
+        records.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    
+    // Simulate a crash before any snapshot, in the middle of a third record
+    std::filesystem::remove_all(options.directory);
+    std::filesystem::create_directories(options.directory);
+    std::ofstream(path, std::ios::binary) << records << std::string("\x01\x00\x00", 3);
+    
+    ShowStore restored = makeShows();
+    BookingJournal journal(restored, options);
+    RecoveryStats stats = journal.recover();
+    SimpleTest::EXPECT_FALSE(stats.snapshotLoaded, "No snapshot to load");
+    SimpleTest::EXPECT_EQ((uint64_t)2, stats.journalRecords, "Complete records are replayed");
+    SimpleTest::EXPECT_EQ((uint64_t)3, stats.truncatedBytes, "Partial record is cut off");
+    SimpleTest::EXPECT_TRUE(restored[0].seats[4] && restored[0].seats[5], "Journaled seats are restored");
+    SimpleTest::EXPECT_EQ((uintmax_t)40, std::filesystem::file_size(path),
+                          "Journal is truncated to its header and complete records");
+    
+    std::filesystem::remove_all(options.directory);
+}
+
+void test_journal_snapshot_skips_holds() {
+    std::cout << "\n=== Testing Snapshots Without Seat Holds ===" << std::endl;
+    
+    JournalOptions options = tempOptions("holds");
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.recover();
+        journal.start();
+        uint64_t version = 0;
+        SeatNumber held[] = {5, 80};
+        shows[1].holdSeats(held, 2, version);
+        shows[1].bookSeats(std::vector<SeatNumber>{3});
+        journal.append(1, {3});
+        journal.stop();
+        SimpleTest::EXPECT_TRUE(shows[1].seats[4], "Held seats are taken in memory");
+    }
+    
+    ShowStore restored = makeShows();
+    BookingJournal journal(restored, options);
+    RecoveryStats stats = journal.recover();
+    SimpleTest::EXPECT_TRUE(stats.snapshotLoaded, "Snapshot is written with holds open");
+    SimpleTest::EXPECT_TRUE(restored[1].seats[2], "Booked seat is restored");
+    SimpleTest::EXPECT_FALSE(restored[1].seats[4] || restored[1].seats[79], "Held seats are free after a restart");
+    
+    std::filesystem::remove_all(options.directory);
+}
+
+void test_journal_write_failure() {
+    std::cout << "\n=== Testing Booking Journal Write Failure ===" << std::endl;
+    
+    JournalOptions options = tempOptions("failure");
+    std::string full = options.directory + "/journal.2";
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.recover();
+        journal.start();
+        shows[0].bookSeats(std::vector<SeatNumber>{1});
+        journal.append(0, {1});
+        
+        // The snapshot rolls over to generation 2, which cannot be written
+        std::filesystem::create_symlink("/dev/full", full);
+        journal.requestSnapshot();
+        for (int i = 0; i < 1000 && std::filesystem::exists(options.directory + "/journal.1"); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        
+        shows[0].bookSeats(std::vector<SeatNumber>{2});
+        journal.append(0, {2});
+        std::atomic<int> result{-1};
+        journal.whenDurable([&result](bool ok) { result = ok ? 1 : 0; });
+        while (result < 0) {
+            std::this_thread::yield();
+        }
+        SimpleTest::EXPECT_EQ(0, result.load(), "Waiters of a failed write are told it is not durable");
+        SimpleTest::EXPECT_TRUE(journal.failed(), "Journal stops after a failed write");
+        
+        shows[0].bookSeats(std::vector<SeatNumber>{3});
+        journal.append(0, {3});
+        bool later = true;
+        journal.whenDurable([&later](bool ok) { later = ok; });
+        SimpleTest::EXPECT_FALSE(later, "Later bookings are refused at once");
+        journal.stop();
+    }
+    std::filesystem::remove(full);
+    
+    ShowStore restored = makeShows();
+    BookingJournal journal(restored, options);
+    journal.recover();
+    SimpleTest::EXPECT_TRUE(restored[0].seats[0], "Booking durable before the failure is restored");
+    SimpleTest::EXPECT_FALSE(restored[0].seats[1] || restored[0].seats[2], "Refused bookings are not snapshotted");
+    
+    std::filesystem::remove_all(options.directory);
+}
+
+void test_journal_catalogue_mismatch() {
+    std::cout << "\n=== Testing Booking Journal Catalogue Mismatch ===" << std::endl;
+    
+    JournalOptions options = tempOptions("mismatch");
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.recover();
+        journal.start();
+        shows[0].bookSeats(std::vector<SeatNumber>{1});
+        journal.append(0, {1});
+        journal.stop();
+    }
+    
+    // Same seat counts, but a show inserted in front shifts every position
+    ShowStore reordered;
+    reordered.emplace_back("Dune", "2025-09-11 21:00", "PVR");
+    reordered.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    reordered.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 100);
+    BookingJournal snapshotted(reordered, options);
+    bool refused = false;
+    try {
+        snapshotted.recover();
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    SimpleTest::EXPECT_TRUE(refused, "Snapshot of another catalogue is refused");
+    SimpleTest::EXPECT_FALSE(reordered[0].seats[0], "No seat moves to the inserted show");
+    
+    // A crash before the next snapshot leaves only the journal
+    std::filesystem::remove_all(options.directory);
+    std::string path = options.directory + "/journal.1";
+    std::string records;
+    {
+        ShowStore shows = makeShows();
+        BookingJournal journal(shows, options);
+        journal.start();
+        journal.append(0, {2});
+        std::atomic<bool> durable{false};
+        journal.whenDurable([&durable](bool ok) { durable = ok; });
+        while (!durable) {
+            std::this_thread::yield();
+        }
+        std::ifstream in(path, std::ios::binary);
+        records.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::filesystem::remove_all(options.directory);
+    std::filesystem::create_directories(options.directory);
+    std::ofstream(path, std::ios::binary) << records;
+    
+    BookingJournal replayed(reordered, options);
+    refused = false;
+    try {
+        replayed.recover();
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    SimpleTest::EXPECT_TRUE(refused, "Journal of another catalogue is refused");
+    
+    ShowStore same = makeShows();
+    BookingJournal journal(same, options);
+    journal.recover();
+    SimpleTest::EXPECT_TRUE(same[0].seats[1], "Journal of the same catalogue is replayed");
+    
+    std::filesystem::remove_all(options.directory);
+}
+
+void run_booking_journal_tests() {
+    test_journal_replay();
+    test_journal_torn_tail();
+    test_journal_snapshot_skips_holds();
+    test_journal_write_failure();
+    test_journal_catalogue_mismatch();
+}
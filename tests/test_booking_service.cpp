@@ -1,10 +1,11 @@
 #include "simple_test.hpp"
 #include "cinema.hpp"
+#include <algorithm>
 
 void test_booking_service_valid_booking() {
     std::cout << "\n=== Testing Booking Service Valid Booking ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern = {
@@ -34,7 +35,7 @@ void test_booking_service_valid_booking() {
 void test_booking_service_invalid_show() {
     std::cout << "\n=== Testing Booking Service Invalid Show ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern(20, true);
@@ -59,7 +60,7 @@ void test_booking_service_invalid_show() {
 void test_booking_service_invalid_format() {
     std::cout << "\n=== Testing Booking Service Invalid Format ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern(20, true);
@@ -87,7 +88,7 @@ void test_booking_service_invalid_format() {
 void test_booking_service_invalid_seats() {
     std::cout << "\n=== Testing Booking Service Invalid Seats ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern(20, true);
@@ -120,7 +121,7 @@ void test_booking_service_invalid_seats() {
 void test_booking_service_already_booked_seats() {
     std::cout << "\n=== Testing Booking Service Already Booked Seats ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern = {
@@ -152,7 +153,7 @@ void test_booking_service_already_booked_seats() {
 void test_booking_service_multiple_seats() {
     std::cout << "\n=== Testing Booking Service Multiple Seats ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern(20, false);  // All seats available (false = available)
@@ -182,7 +183,7 @@ void test_booking_service_multiple_seats() {
 void test_booking_service_edge_cases() {
     std::cout << "\n=== Testing Booking Service Edge Cases ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern(20, true);
@@ -201,6 +202,176 @@ void test_booking_service_edge_cases() {
     SimpleTest::EXPECT_TRUE(result2.success || !result2.success, "Whitespace should not crash");
 }
 
+void test_booking_service_parsing() {
+    std::cout << "\n=== Testing Booking Service Request Parsing ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    
+    auto spaced = BookingService::processBooking("PVR,Inception, 3 ,4,", shows);
+    SimpleTest::EXPECT_TRUE(spaced.success, "Spaces around seats and a trailing comma are accepted");
+    SimpleTest::EXPECT_CONTAINS(spaced.message, "=== CINEMA DATA STREAM ===", "Successful reply carries the catalogue");
+    
+    auto conflict = BookingService::processBooking("PVR,Inception,3", shows);
+    SimpleTest::EXPECT_EQ(conflict.status, conflict.message, "Error reply is the status line only");
+    
+    auto garbage = BookingService::processBooking("PVR,Inception,3x", shows);
+    SimpleTest::EXPECT_EQ(std::string("ERROR: Invalid seat number format: 3x"), garbage.message, "Trailing garbage is rejected");
+    
+    auto huge = BookingService::processBooking("PVR,Inception,70000", shows);
+    SimpleTest::EXPECT_CONTAINS(huge.message, "Must be a positive seat number", "Out of range seat number is rejected");
+    
+    std::string many = "PVR,Inception";
+    for (size_t i = 0; i <= SeatBuffer::CAPACITY; ++i) {
+        many += ",1";
+    }
+    auto tooMany = BookingService::processBooking(many, shows);
+    SimpleTest::EXPECT_CONTAINS(tooMany.message, "Too many seats", "Seat list beyond the buffer is rejected");
+    
+    auto longName = BookingService::processBooking("PVR," + std::string(1000, 'x') + ",1", shows);
+    SimpleTest::EXPECT_TRUE(longName.message.size() < 80, "Error reply does not echo the whole request");
+    
+    SimpleTest::EXPECT_TRUE(MessageHandler::isBookingRequest("PVR,Inception,3"), "Bookings take seats");
+    SimpleTest::EXPECT_TRUE(MessageHandler::isBookingRequest("batch\n1:PVR,Inception,3"), "Batches take seats");
+    SimpleTest::EXPECT_FALSE(MessageHandler::isBookingRequest("get_data"), "Data requests take no seats");
+    SimpleTest::EXPECT_FALSE(MessageHandler::isBookingRequest("batches"), "Only the batch keyword starts a batch");
+}
+
+void test_booking_service_seat_delta() {
+    std::cout << "\n=== Testing Booking Service Seat Delta ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    
+    auto result = BookingService::processBooking("IMAX,Tenet,7,8", shows);
+    SimpleTest::EXPECT_TRUE(result.success, "Booking should succeed");
+    
+    uint64_t sequence = Shows::stateVersion();
+    std::string expected = CinemaService::formatSeatDelta(sequence, 1, {7, 8});
+    SimpleTest::EXPECT_EQ(expected, result.delta, "Delta carries sequence, show id and booked seats");
+    
+    auto failed = BookingService::processBooking("IMAX,Tenet,7", shows);
+    SimpleTest::EXPECT_FALSE(failed.success, "Re-booking the same seat should fail");
+    SimpleTest::EXPECT_TRUE(failed.delta.empty(), "Failed booking produces no delta");
+    
+    SimpleTest::EXPECT_EQ(CinemaService::encodeSeatDelta(sequence, 1, {7, 8}), result.binaryDelta, "Binary delta matches the text delta");
+    SimpleTest::EXPECT_EQ(std::string("SUCCESS: Booked seats 7, 8 for Tenet at IMAX"), result.status, "Status omits the catalogue");
+    SimpleTest::EXPECT_EQ(std::string("ERROR: One or more seats are already booked or invalid"), failed.status, "Failure status omits the catalogue");
+    SimpleTest::EXPECT_EQ((ShowId)1, result.showId, "Result names the booked show");
+    SimpleTest::EXPECT_EQ(ALL_SHOWS, failed.showId, "Failed booking names no show");
+}
+
+void test_message_handler_subscriptions() {
+    std::cout << "\n=== Testing Subscription Requests ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    shows.emplace_back("Interstellar", "2025-09-11 19:30", "IMAX");
+    ShowRegistry registry(shows);
+    
+    auto all = MessageHandler::parseSubscription("subscribe:all", registry);
+    SimpleTest::EXPECT_TRUE(all && all->subscribe && all->allShows, "subscribe:all watches every show");
+    
+    auto byId = MessageHandler::parseSubscription("subscribe:show:0,2,9", registry);
+    SimpleTest::EXPECT_TRUE(byId && byId->shows == std::vector<ShowId>({0, 2}), "Show ids are parsed, unknown ids skipped");
+    SimpleTest::EXPECT_EQ((ShowId)3, byId->showCount, "Request carries the catalogue size");
+    
+    auto byTheater = MessageHandler::parseSubscription("unsubscribe:theater:IMAX", registry);
+    SimpleTest::EXPECT_TRUE(byTheater && !byTheater->subscribe && byTheater->shows == std::vector<ShowId>({1, 2}),
+                            "Theater names expand to their shows");
+    
+    SimpleTest::EXPECT_FALSE(MessageHandler::parseSubscription("subscribe:theater:Nowhere", registry).has_value(),
+                             "Request naming no known show is rejected");
+    SimpleTest::EXPECT_FALSE(MessageHandler::parseSubscription("PVR,Inception,3", registry).has_value(),
+                             "Bookings are not subscriptions");
+    
+    CinemaSnapshot snapshot(shows, registry);
+    BroadcastPayload broadcast;
+    MessageHandler::handleMessage("IMAX,Interstellar,4", shows, registry, snapshot, WireFormat::Text, broadcast);
+    SimpleTest::EXPECT_EQ((ShowId)2, broadcast.show, "Booking broadcast is addressed to the show's watchers");
+}
+
+void test_message_handler_batch() {
+    std::cout << "\n=== Testing Batch Booking Requests ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    ShowRegistry registry(shows);
+    CinemaSnapshot snapshot(shows, registry);
+    
+    BroadcastPayload broadcast;
+    SharedPayload reply = MessageHandler::handleMessage("batch\na1:PVR,Inception,3,4\na2:PVR,Inception,4\na3:PVR,Inception,5",
+                                                        shows, registry, snapshot, WireFormat::Text, broadcast);
+    SimpleTest::EXPECT_TRUE(reply != nullptr, "Local batch is answered at once");
+    SimpleTest::EXPECT_EQ(std::string("BATCH_RESULT:3\n"
+                                      "a1:SUCCESS: Booked seats 3, 4 for Inception at PVR\n"
+                                      "a2:ERROR: One or more seats are already booked or invalid\n"
+                                      "a3:SUCCESS: Booked seats 5 for Inception at PVR"),
+                          *reply, "Every item is answered in order under its id");
+    SimpleTest::EXPECT_TRUE(shows[0].seats[2] && shows[0].seats[3] && shows[0].seats[4], "Successful items are booked");
+    SimpleTest::EXPECT_TRUE(broadcast.text && std::count(broadcast.text->begin(), broadcast.text->end(), '\n') == 1,
+                            "Deltas of the successful items are merged");
+    SimpleTest::EXPECT_EQ((ShowId)0, broadcast.show, "Single-show batch is addressed to that show");
+    
+    MessageHandler::handleMessage("batch\nb1:PVR,Inception,6\nb2:IMAX,Tenet,6", shows, registry, snapshot,
+                                  WireFormat::Binary, broadcast);
+    SimpleTest::EXPECT_EQ(ALL_SHOWS, broadcast.show, "Batch spanning shows is addressed to every session");
+    SimpleTest::EXPECT_EQ(BinaryProtocol::HEADER_SIZE + 2 * (8 + 4 + 2 + 2), broadcast.binary->size(),
+                          "Binary deltas share one frame header");
+    
+    reply = MessageHandler::handleMessage("batch\nnot an item", shows, registry, snapshot, WireFormat::Text, broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, ":ERROR: Invalid batch item", "Item without an id is rejected on its own");
+    SimpleTest::EXPECT_TRUE(broadcast.text == nullptr, "Nothing is broadcast when no item succeeds");
+    
+    reply = MessageHandler::handleMessage("batch", shows, registry, snapshot, WireFormat::Text, broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: Invalid batch", "Empty batch is rejected");
+    
+    // Items for shows owned elsewhere are answered once the owner replies
+    std::vector<ReplyCallback> owners;
+    BookingForwarder forward = [&owners](ShowId id, const std::string&, WireFormat, ReplyCallback answer) {
+        if (id != 1) {
+            return false;
+        }
+        owners.push_back(std::move(answer));
+        return true;
+    };
+    SharedPayload deferred;
+    ReplyCallback done = [&deferred](SharedPayload result) { deferred = std::move(result); };
+    reply = MessageHandler::handleMessage("batch\nc1:IMAX,Tenet,7\nc2:PVR,Inception,7", shows, registry, snapshot,
+                                          WireFormat::Text, broadcast, {}, forward, done);
+    SimpleTest::EXPECT_TRUE(reply == nullptr && owners.size() == 1, "Foreign item is forwarded");
+    SimpleTest::EXPECT_TRUE(broadcast.text != nullptr && shows[0].seats[6], "Local item is booked and broadcast at once");
+    SimpleTest::EXPECT_TRUE(deferred == nullptr, "Result waits for the owner");
+    owners[0](std::make_shared<const std::string>("SUCCESS: Booked seats 7 for Tenet at IMAX"));
+    SimpleTest::EXPECT_TRUE(deferred && *deferred == "BATCH_RESULT:2\nc1:SUCCESS: Booked seats 7 for Tenet at IMAX\n"
+                                                     "c2:SUCCESS: Booked seats 7 for Inception at PVR",
+                            "Owner's answer completes the result");
+}
+
+void test_message_handler_unsaved_reply() {
+    std::cout << "\n=== Testing Replies To Unsaved Bookings ===" << std::endl;
+    
+    auto unsaved = [](const std::string& reply) {
+        return *MessageHandler::unsavedReply(std::make_shared<const std::string>(reply));
+    };
+    SimpleTest::EXPECT_EQ(std::string("ERROR: Booking could not be saved"),
+                          unsaved("SUCCESS: Booked seats 3 for Inception at PVR"), "Success becomes an error");
+    SimpleTest::EXPECT_EQ(std::string("FORWARDED:7:ERROR: Booking could not be saved"),
+                          unsaved("FORWARDED:7:SUCCESS: Booked seats 3 for Inception at PVR"),
+                          "Forwarded reply keeps its routing prefix");
+    SimpleTest::EXPECT_EQ(std::string("BATCH_RESULT:2\na1:ERROR: Booking could not be saved\n"
+                                      "a2:ERROR: One or more seats are already booked or invalid"),
+                          unsaved("BATCH_RESULT:2\na1:SUCCESS: Booked seats 3 for Inception at PVR\n"
+                                  "a2:ERROR: One or more seats are already booked or invalid"),
+                          "Only successful batch items change");
+    
+    SharedPayload failed = std::make_shared<const std::string>("ERROR: Show not found");
+    SimpleTest::EXPECT_TRUE(MessageHandler::unsavedReply(failed) == failed, "Errors are passed through");
+}
+
 void run_booking_service_tests() {
     test_booking_service_valid_booking();
     test_booking_service_invalid_show();
@@ -209,4 +380,9 @@ void run_booking_service_tests() {
     test_booking_service_already_booked_seats();
     test_booking_service_multiple_seats();
     test_booking_service_edge_cases();
+    test_booking_service_parsing();
+    test_booking_service_seat_delta();
+    test_message_handler_subscriptions();
+    test_message_handler_batch();
+    test_message_handler_unsaved_reply();
 }
\ No newline at end of file
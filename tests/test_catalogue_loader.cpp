@@ -0,0 +1,116 @@
+#include "simple_test.hpp"
+#include "catalogue_loader.hpp"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+std::string parseError(std::string_view text) {
+    try {
+        CatalogueLoader::parse(text);
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return {};
+}
+
+} // namespace
+
+void test_catalogue_parse() {
+    std::cout << "\n=== Testing Catalogue Parsing ===" << std::endl;
+
+    CatalogueStats stats;
+    auto shows = CatalogueLoader::parse("# comment\n"
+                                        "\n"
+                                        "PVR|Inception|2025-09-11 19:30|20|1-2,5\r\n"
+                                        "IMAX|Tenet|2025-09-12 21:00\n"
+                                        "Cinepolis|Dune|2025-09-13 18:00|150|150",
+                                        1, &stats);
+    SimpleTest::EXPECT_EQ((size_t)3, shows.size(), "Comments and blank lines are skipped");
+    SimpleTest::EXPECT_EQ(std::string("PVR"), std::string(shows[0].theater), "Theater is the first field");
+    SimpleTest::EXPECT_EQ(std::string("Inception"), std::string(shows[0].movie), "Movie is the second field");
+    SimpleTest::EXPECT_EQ(std::string("2025-09-11 19:30"), std::string(shows[0].dateTime), "CR before the newline is dropped");
+    SimpleTest::EXPECT_EQ((size_t)17, shows[0].availableSeatCount(), "Booked ranges and single seats are marked");
+    SimpleTest::EXPECT_TRUE(shows[0].seats[0] && shows[0].seats[1] && shows[0].seats[4], "Listed seats are booked");
+    SimpleTest::EXPECT_EQ(Shows::DEFAULT_SEAT_COUNT, shows[1].seats.size(), "Seat count defaults");
+    SimpleTest::EXPECT_EQ((size_t)149, shows[2].availableSeatCount(), "Last seat of a large auditorium");
+    SimpleTest::EXPECT_EQ((size_t)4, stats.bookedSeats, "Booked seats are counted");
+}
+
+void test_catalogue_errors() {
+    std::cout << "\n=== Testing Catalogue Errors ===" << std::endl;
+
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11\nPVR|Tenet\n"), "2: ",
+                                "Error names the bad line");
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11|0\n"), "invalid seat count",
+                                "Zero seats are rejected");
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11|20|21\n"), "outside 1-20",
+                                "Booked seat beyond the auditorium is rejected");
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11|20|5-3\n"), "outside",
+                                "Reversed range is rejected");
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11|20|1;2\n"), "malformed",
+                                "Bad separator in the booked list is rejected");
+    SimpleTest::EXPECT_CONTAINS(parseError("PVR|Inception|2025-09-11|20|1|x\n"), "fields",
+                                "Extra fields are rejected");
+}
+
+void test_catalogue_parallel() {
+    std::cout << "\n=== Testing Parallel Catalogue Load ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "Theater " + std::to_string(i % 50) + "|Movie " + std::to_string(i) + "|2025-10-01 20:00|" +
+                std::to_string(20 + i % 100) + "|" + std::to_string(1 + i % 20) + "\n";
+    }
+    auto serial = CatalogueLoader::parse(text, 1);
+    CatalogueStats stats;
+    auto parallel = CatalogueLoader::parse(text, 8, &stats);
+
+    SimpleTest::EXPECT_TRUE(stats.threads > 1, "Large input is split across threads");
+    SimpleTest::EXPECT_EQ(serial.size(), parallel.size(), "Parallel load finds every show");
+    bool same = serial.size() == parallel.size();
+    for (size_t i = 0; same && i < serial.size(); ++i) {
+        same = serial[i].movie == parallel[i].movie && serial[i].seats.size() == parallel[i].seats.size() &&
+               serial[i].getAvailableSeats() == parallel[i].getAvailableSeats();
+    }
+    SimpleTest::EXPECT_TRUE(same, "Parallel load keeps file order and seats");
+    SimpleTest::EXPECT_EQ((size_t)20000, stats.bookedSeats, "Every chunk marks its booked seats");
+
+    std::string bad = text + "broken line\n" + text;
+    SimpleTest::EXPECT_CONTAINS(parseError(bad), "20001: ", "Line numbers count across chunks");
+}
+
+void test_catalogue_file() {
+    std::cout << "\n=== Testing Catalogue File ===" << std::endl;
+
+    auto path = std::filesystem::temp_directory_path() / "cinema_test_catalogue.txt";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << CatalogueLoader::demoCatalogue();
+    }
+    CatalogueStats stats;
+    auto shows = CatalogueLoader::loadFile(path.string(), 0, &stats);
+    std::filesystem::remove(path);
+
+    SimpleTest::EXPECT_EQ((size_t)9, shows.size(), "Demo catalogue has 9 shows");
+    SimpleTest::EXPECT_TRUE(shows[0].getAvailableSeats() ==
+                                std::vector<SeatNumber>({3, 4, 6, 7, 8, 9, 12, 13, 16, 17, 18, 20}),
+                            "Demo seat pattern is kept");
+    SimpleTest::EXPECT_EQ(std::string("Cinepolis"), std::string(shows[8].theater), "Demo shows are grouped by theater");
+
+    bool threw = false;
+    try {
+        CatalogueLoader::loadFile(path.string());
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    SimpleTest::EXPECT_TRUE(threw, "Missing file throws");
+}
+
+void run_catalogue_loader_tests() {
+    test_catalogue_parse();
+    test_catalogue_errors();
+    test_catalogue_parallel();
+    test_catalogue_file();
+}
@@ -1,10 +1,11 @@
 #include "simple_test.hpp"
 #include "cinema.hpp"
+#include <limits>
 
 void test_cinema_service_format_data() {
     std::cout << "\n=== Testing Cinema Service Format Data ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show1("Inception", "2025-09-11 19:30", "PVR");
     Shows show2("Interstellar", "2025-09-11 19:30", "IMAX");
@@ -49,7 +50,7 @@ void test_cinema_service_format_data() {
 void test_cinema_service_format_update_data() {
     std::cout << "\n=== Testing Cinema Service Format Update Data ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
     std::vector<bool> pattern = {
@@ -77,7 +78,7 @@ void test_cinema_service_format_update_data() {
 void test_cinema_service_empty_shows() {
     std::cout << "\n=== Testing Cinema Service with Empty Shows ===" << std::endl;
     
-    std::vector<Shows> emptyShows;
+    ShowStore emptyShows;
     
     std::string data = CinemaService::formatCinemaData(emptyShows);
     SimpleTest::EXPECT_CONTAINS(data, "=== CINEMA DATA STREAM ===", "Empty shows still has header");
@@ -91,7 +92,7 @@ void test_cinema_service_empty_shows() {
 void test_cinema_service_multiple_theaters_same_movie() {
     std::cout << "\n=== Testing Cinema Service Multiple Theaters Same Movie ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show1("Inception", "2025-09-11 19:30", "PVR");
     Shows show2("Inception", "2025-09-11 19:30", "IMAX");
@@ -133,7 +134,7 @@ void test_cinema_service_multiple_theaters_same_movie() {
 void test_cinema_service_seat_numbering() {
     std::cout << "\n=== Testing Cinema Service Seat Numbering ===" << std::endl;
     
-    std::vector<Shows> shows;
+    ShowStore shows;
     
     Shows show("Test Movie", "2025-09-11 19:30", "Test Theater");
     
@@ -161,10 +162,103 @@ void test_cinema_service_seat_numbering() {
     SimpleTest::EXPECT_EQ(5, (int)availableSeats[2], "Third available seat should be 5");
 }
 
+void test_cinema_service_seat_delta_format() {
+    std::cout << "\n=== Testing Cinema Service Seat Delta Format ===" << std::endl;
+    
+    std::string delta = CinemaService::formatSeatDelta(42, 3, {1, 5, 20});
+    SimpleTest::EXPECT_EQ(std::string("SEAT_DELTA:42:3:1,5,20"), delta, "Delta message format");
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "PVR");
+    
+    std::string data = CinemaService::formatCinemaData(shows);
+    SimpleTest::EXPECT_CONTAINS(data, "Sequence: " + std::to_string(Shows::stateVersion()), "Data stream carries state version");
+    SimpleTest::EXPECT_CONTAINS(data, "    Show ID: 0", "First show carries its id");
+    SimpleTest::EXPECT_CONTAINS(data, "    Show ID: 1", "Second show carries its id");
+}
+
+void test_cinema_service_binary_encoding() {
+    std::cout << "\n=== Testing Cinema Service Binary Encoding ===" << std::endl;
+    
+    std::string delta = CinemaService::encodeSeatDelta(42, 3, {1, 300});
+    SimpleTest::EXPECT_EQ(21, (int)delta.size(), "Delta frame is header, sequence, id, count and seats");
+    SimpleTest::EXPECT_EQ((int)BinaryProtocol::MAGIC, (int)(uint8_t)delta[0], "Delta frame starts with magic byte");
+    SimpleTest::EXPECT_EQ((int)BinaryProtocol::SEAT_DELTA, (int)(uint8_t)delta[2], "Delta frame type");
+    SimpleTest::EXPECT_EQ(42, (int)(uint8_t)delta[3], "Sequence is little-endian");
+    SimpleTest::EXPECT_EQ(3, (int)(uint8_t)delta[11], "Show id follows the sequence");
+    SimpleTest::EXPECT_EQ(300 & 0xFF, (int)(uint8_t)delta[19], "Seats are 16-bit little-endian");
+    SimpleTest::EXPECT_EQ(300 >> 8, (int)(uint8_t)delta[20], "Seat high byte");
+    
+    ShowStore shows;
+    shows.emplace_back("Tenet", "19:30", "PVR");
+    std::vector<bool> pattern(20, false);
+    pattern[0] = true;   // Seat 1
+    pattern[9] = true;   // Seat 10
+    shows[0].seats = pattern;
+    
+    ShowRegistry registry(shows);
+    std::string frame = CinemaService::encodeCatalogue(shows, registry);
+    // header 3 + sequence 8 + theaters 4 + "PVR" 5 + shows 4 + id 4 + "Tenet" 7 + "19:30" 7 + seats 2 + bits 3
+    SimpleTest::EXPECT_EQ(47, (int)frame.size(), "Catalogue frame size");
+    SimpleTest::EXPECT_EQ((int)BinaryProtocol::CATALOGUE, (int)(uint8_t)frame[2], "Catalogue frame type");
+    SimpleTest::EXPECT_EQ(std::string("PVR"), frame.substr(17, 3), "Theater name is length-prefixed");
+    SimpleTest::EXPECT_EQ(1, (int)(uint8_t)frame[20], "Show count is a u32");
+    SimpleTest::EXPECT_EQ(20, (int)(uint8_t)frame[42], "Seat count precedes the seat bits");
+    SimpleTest::EXPECT_EQ(0x01, (int)(uint8_t)frame[44], "Seat 1 is bit 0 of the first byte");
+    SimpleTest::EXPECT_EQ(0x02, (int)(uint8_t)frame[45], "Seat 10 is bit 1 of the second byte");
+}
+
+void test_cinema_service_format_large_shows() {
+    std::cout << "\n=== Testing Cinema Service Format Large Shows ===" << std::endl;
+    
+    static_assert(CinemaProtocol::CatalogueLayout<CinemaProtocol::Catalogue::Full>::HEADER ==
+                  "=== CINEMA DATA STREAM ===\nSequence: ");
+    static_assert(CinemaProtocol::CatalogueLayout<CinemaProtocol::Catalogue::Update>::FOOTER ==
+                  "=== END UPDATED DATA ===\n");
+    
+    ShowStore shows;
+    shows.emplace_back("Dune", "2025-09-11 21:00", "IMAX", 700);
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 2);
+    std::vector<SeatNumber> booked;
+    for (SeatNumber seat = 1; seat <= 700; ++seat) {
+        if (seat != 5 && seat != 64 && seat != 65 && seat != 600 && seat != 601 && seat != 700) {
+            booked.push_back(seat);
+        }
+    }
+    shows[0].bookSeats(booked);
+    shows[1].bookSeats(std::vector<SeatNumber>{1, 2});
+    
+    std::string sequence = std::to_string(Shows::stateVersion());
+    std::string listing = "Theater: IMAX\n"
+                          "  Movie: Dune (2025-09-11 21:00)\n"
+                          "    Show ID: 0\n"
+                          "    Available seats: 5, 64, 65, 600, 601, 700 (Total: 6/700)\n"
+                          "  Movie: Tenet (2025-09-11 19:30)\n"
+                          "    Show ID: 1\n"
+                          "    Available seats: SOLD OUT (Total: 0/2)\n"
+                          "\n";
+    SimpleTest::EXPECT_EQ("=== CINEMA DATA STREAM ===\nSequence: " + sequence + "\n" + listing + "=== END CINEMA DATA ===\n",
+                          CinemaService::formatCinemaData(shows),
+                          "Seats across words and past the lookup table are listed in order");
+    SimpleTest::EXPECT_EQ("BOOKING_UPDATE:\n=== UPDATED CINEMA DATA ===\nSequence: " + sequence + "\n" + listing +
+                          "=== END UPDATED DATA ===\n",
+                          CinemaService::formatUpdateData(shows), "Update stream shares the listing");
+    
+    std::vector<SeatNumber> seats = {9, 600, 601, 65535};
+    SimpleTest::EXPECT_EQ(std::string("SEAT_FREED:18446744073709551615:4294967295:9,600,601,65535"),
+                          CinemaService::formatSeatDelta(std::numeric_limits<uint64_t>::max(), 4294967295u,
+                                                         seats.data(), seats.size(), SeatChange::Freed),
+                          "Seat delta fits the largest numbers");
+}
+
 void run_cinema_service_tests() {
     test_cinema_service_format_data();
     test_cinema_service_format_update_data();
     test_cinema_service_empty_shows();
     test_cinema_service_multiple_theaters_same_movie();
     test_cinema_service_seat_numbering();
+    test_cinema_service_seat_delta_format();
+    test_cinema_service_binary_encoding();
+    test_cinema_service_format_large_shows();
 }
\ No newline at end of file
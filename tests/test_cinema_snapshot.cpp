@@ -0,0 +1,64 @@
+#include "simple_test.hpp"
+#include "cinema.hpp"
+
+void test_cinema_snapshot_matches_formatter() {
+    std::cout << "\n=== Testing Cinema Snapshot Matches Formatter ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    
+    CinemaSnapshot snapshot(shows);
+    
+    SimpleTest::EXPECT_EQ(CinemaService::formatCinemaData(shows), *snapshot.cinemaData(),
+                          "Snapshot cinema data equals formatCinemaData output");
+    SimpleTest::EXPECT_EQ(CinemaService::formatUpdateData(shows), *snapshot.updateData(),
+                          "Snapshot update data equals formatUpdateData output");
+}
+
+void test_cinema_snapshot_reuses_payload() {
+    std::cout << "\n=== Testing Cinema Snapshot Payload Reuse ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    
+    CinemaSnapshot snapshot(shows);
+    
+    auto first = snapshot.cinemaData();
+    auto second = snapshot.cinemaData();
+    SimpleTest::EXPECT_TRUE(first == second, "Unchanged state returns the same cached payload");
+    SimpleTest::EXPECT_EQ(Shows::stateVersion(), snapshot.version(), "Snapshot is stamped with current state version");
+    
+    // A failed booking does not change state, so the cache stays valid
+    std::vector<uint8_t> invalidSeats = {0};
+    shows[0].bookSeats(invalidSeats);
+    SimpleTest::EXPECT_TRUE(first == snapshot.cinemaData(), "Failed booking keeps the cached payload");
+}
+
+void test_cinema_snapshot_rebuilds_after_booking() {
+    std::cout << "\n=== Testing Cinema Snapshot Rebuild After Booking ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    
+    CinemaSnapshot snapshot(shows);
+    
+    auto before = snapshot.cinemaData();
+    uint64_t versionBefore = snapshot.version();
+    SimpleTest::EXPECT_CONTAINS(*before, "(Total: 20/20)", "All seats free before booking");
+    
+    std::vector<uint8_t> seatsToBook = {1, 2};
+    SimpleTest::EXPECT_TRUE(shows[0].bookSeats(seatsToBook), "Booking succeeds");
+    
+    auto after = snapshot.cinemaData();
+    SimpleTest::EXPECT_TRUE(before != after, "Booking invalidates the cached payload");
+    SimpleTest::EXPECT_CONTAINS(*after, "(Total: 18/20)", "Rebuilt payload reflects the booking");
+    SimpleTest::EXPECT_TRUE(snapshot.version() > versionBefore, "Snapshot version advances after booking");
+    SimpleTest::EXPECT_CONTAINS(*before, "(Total: 20/20)", "Previously handed out payload is unchanged");
+}
+
+void run_cinema_snapshot_tests() {
+    test_cinema_snapshot_matches_formatter();
+    test_cinema_snapshot_reuses_payload();
+    test_cinema_snapshot_rebuilds_after_booking();
+}
@@ -0,0 +1,113 @@
+#include "simple_test.hpp"
+#include "cluster.hpp"
+#include <map>
+
+void test_cluster_members() {
+    std::cout << "\n=== Testing Cluster Member Parsing ===" << std::endl;
+    
+    auto members = ClusterOptions::parseMembers("a=cinema-1:8080,bad,b=10.0.0.2:9000,c=:1");
+    SimpleTest::EXPECT_EQ((size_t)2, members.size(), "Malformed entries are skipped");
+    SimpleTest::EXPECT_EQ(std::string("a"), members[0].id, "Parses the node id");
+    SimpleTest::EXPECT_EQ(std::string("cinema-1"), members[0].host, "Parses the host");
+    SimpleTest::EXPECT_EQ(std::string("9000"), members[1].port, "Parses the port");
+}
+
+void test_shard_ring() {
+    std::cout << "\n=== Testing Shard Ring ===" << std::endl;
+    
+    ShardRing ring({"a", "b", "c"});
+    ShardRing reordered({"c", "a", "b"});
+    ShardRing grown({"a", "b", "c", "d"});
+    
+    std::map<std::string, int> perNode;
+    bool sameOwners = true;
+    int moved = 0;
+    int movedElsewhere = 0;
+    const int keys = 3000;
+    for (int i = 0; i < keys; ++i) {
+        std::string key = "Theater" + std::to_string(i % 30) + "/Movie" + std::to_string(i);
+        const std::string& owner = ring.owner(key);
+        ++perNode[owner];
+        sameOwners &= reordered.owner(key) == owner;
+        if (grown.owner(key) != owner) {
+            ++moved;
+            movedElsewhere += grown.owner(key) != "d";
+        }
+    }
+    
+    SimpleTest::EXPECT_TRUE(sameOwners, "Owners do not depend on member order");
+    bool balanced = true;
+    for (const auto& [node, count] : perNode) {
+        balanced &= count > keys / 5 && count < keys / 2;
+    }
+    SimpleTest::EXPECT_TRUE(balanced && perNode.size() == 3, "Keys are spread over every node");
+    SimpleTest::EXPECT_TRUE(moved > keys / 8 && moved < keys / 3, "Adding a node moves about a quarter of the keys");
+    SimpleTest::EXPECT_EQ(0, movedElsewhere, "Moved keys only go to the new node");
+}
+
+void test_booking_forwarding() {
+    std::cout << "\n=== Testing Booking Forwarding ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    ShowRegistry registry(shows);
+    CinemaSnapshot snapshot(shows, registry);
+    
+    ShowId forwardedShow = 99;
+    std::string forwardedMessage;
+    BookingForwarder forward = [&](ShowId showId, const std::string& message, WireFormat, ReplyCallback) {
+        forwardedShow = showId;
+        forwardedMessage = message;
+        return showId == 1;
+    };
+    ReplyCallback reply = [](SharedPayload) {};
+    
+    BroadcastPayload broadcast;
+    SharedPayload response = MessageHandler::handleMessage("IMAX,Tenet,3", shows, registry, snapshot,
+                                                           WireFormat::Text, broadcast, {}, forward, reply);
+    SimpleTest::EXPECT_TRUE(response == nullptr, "Forwarded booking has no immediate reply");
+    SimpleTest::EXPECT_EQ((ShowId)1, forwardedShow, "Forwarder gets the show id");
+    SimpleTest::EXPECT_EQ(std::string("IMAX,Tenet,3"), forwardedMessage, "Forwarder gets the request");
+    SimpleTest::EXPECT_FALSE(shows[1].seats[2], "Forwarded booking is not applied locally");
+    
+    response = MessageHandler::handleMessage("PVR,Inception,3", shows, registry, snapshot,
+                                             WireFormat::Text, broadcast, {}, forward, reply);
+    SimpleTest::EXPECT_TRUE(response != nullptr && broadcast.text != nullptr, "Locally owned show is booked here");
+    
+    forwardedShow = 99;
+    response = MessageHandler::handleMessage("IMAX,Tenet,4", shows, registry, snapshot,
+                                             WireFormat::Text, broadcast, {}, forward, {});
+    SimpleTest::EXPECT_EQ((ShowId)99, forwardedShow, "Requests without a reply callback are never forwarded");
+    SimpleTest::EXPECT_TRUE(shows[1].seats[3], "They are booked locally instead");
+}
+
+void test_relayed_delta() {
+    std::cout << "\n=== Testing Relayed Deltas ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows[0].bookSeats(std::vector<SeatNumber>{2});
+    
+    BroadcastPayload broadcast;
+    SimpleTest::EXPECT_TRUE(MessageHandler::applyRelayedDelta("SEAT_DELTA:41:0:1,2", shows, broadcast),
+                            "Valid delta is applied");
+    SimpleTest::EXPECT_TRUE(shows[0].seats[0] && shows[0].seats[1], "Relayed seats are booked, known ones kept");
+    SimpleTest::EXPECT_TRUE(broadcast.text && broadcast.text->find(":0:1,2") != std::string::npos,
+                            "Delta is re-broadcast for local clients");
+    SimpleTest::EXPECT_TRUE(broadcast.text->find("SEAT_DELTA:41:") == std::string::npos,
+                            "Local sequence replaces the sender's");
+    
+    SimpleTest::EXPECT_FALSE(MessageHandler::applyRelayedDelta("SEAT_DELTA:1:5:1", shows, broadcast),
+                             "Unknown show is rejected");
+    SimpleTest::EXPECT_FALSE(MessageHandler::applyRelayedDelta("SEAT_DELTA:1:0:21", shows, broadcast),
+                             "Out-of-range seat is rejected");
+    SimpleTest::EXPECT_TRUE(broadcast.text == nullptr, "Nothing is broadcast for a rejected delta");
+}
+
+void run_cluster_tests() {
+    test_cluster_members();
+    test_shard_ring();
+    test_booking_forwarding();
+    test_relayed_delta();
+}
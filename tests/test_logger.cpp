@@ -0,0 +1,40 @@
+#include "simple_test.hpp"
+#include "logger.hpp"
+
+void test_logger_levels() {
+    std::cout << "\n=== Testing Logger Levels ===" << std::endl;
+    
+    SimpleTest::EXPECT_TRUE(Logger::parseLevel("debug", LogLevel::Info) == LogLevel::Debug, "Parses debug");
+    SimpleTest::EXPECT_TRUE(Logger::parseLevel("WARN", LogLevel::Info) == LogLevel::Warn, "Level names are case-insensitive");
+    SimpleTest::EXPECT_TRUE(Logger::parseLevel("off", LogLevel::Info) == LogLevel::Off, "Parses off");
+    SimpleTest::EXPECT_TRUE(Logger::parseLevel("verbose", LogLevel::Error) == LogLevel::Error, "Unknown name gives the fallback");
+    
+    LogLevel previous = Logger::level();
+    Logger::setLevel(LogLevel::Warn);
+    SimpleTest::EXPECT_FALSE(Logger::enabled(LogLevel::Info), "Info is filtered below a warn threshold");
+    SimpleTest::EXPECT_TRUE(Logger::enabled(LogLevel::Error), "Error passes a warn threshold");
+    Logger::setLevel(LogLevel::Off);
+    SimpleTest::EXPECT_FALSE(Logger::enabled(LogLevel::Error), "Off disables every level");
+    Logger::setLevel(previous);
+}
+
+void test_log_rate_limiter() {
+    std::cout << "\n=== Testing Log Rate Limiter ===" << std::endl;
+    
+    LogRateLimiter limiter(0.0, 3.0);
+    int allowed = 0;
+    for (int i = 0; i < 10; ++i) {
+        if (limiter.allow()) {
+            ++allowed;
+        }
+    }
+    
+    SimpleTest::EXPECT_EQ(3, allowed, "Burst size limits lines without refill");
+    SimpleTest::EXPECT_EQ((uint64_t)7, limiter.takeSuppressed(), "Refused lines are counted");
+    SimpleTest::EXPECT_EQ((uint64_t)0, limiter.takeSuppressed(), "Suppressed count resets when taken");
+}
+
+void run_logger_tests() {
+    test_logger_levels();
+    test_log_rate_limiter();
+}
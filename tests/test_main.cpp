@@ -5,6 +5,19 @@
 void run_shows_tests();
 void run_cinema_service_tests();
 void run_booking_service_tests();
+void run_cinema_snapshot_tests();
+void run_show_registry_tests();
+void run_metrics_tests();
+void run_logger_tests();
+void run_booking_journal_tests();
+void run_cluster_tests();
+void run_seat_holds_tests();
+void run_admission_tests();
+void run_catalogue_loader_tests();
+void run_availability_tests();
+void run_seat_allocator_tests();
+void run_trace_tests();
+void run_replica_sync_tests();
 
 int main() {
     std::cout << "Cinema service testing" << std::endl;
@@ -21,6 +34,45 @@ int main() {
         std::cout << "\nRunning Booking Service Tests..." << std::endl;
         run_booking_service_tests();
         
+        std::cout << "\nRunning Cinema Snapshot Tests..." << std::endl;
+        run_cinema_snapshot_tests();
+        
+        std::cout << "\nRunning Show Registry Tests..." << std::endl;
+        run_show_registry_tests();
+        
+        std::cout << "\nRunning Metrics Tests..." << std::endl;
+        run_metrics_tests();
+        
+        std::cout << "\nRunning Logger Tests..." << std::endl;
+        run_logger_tests();
+        
+        std::cout << "\nRunning Booking Journal Tests..." << std::endl;
+        run_booking_journal_tests();
+        
+        std::cout << "\nRunning Cluster Tests..." << std::endl;
+        run_cluster_tests();
+        
+        std::cout << "\nRunning Seat Hold Tests..." << std::endl;
+        run_seat_holds_tests();
+        
+        std::cout << "\nRunning Admission Tests..." << std::endl;
+        run_admission_tests();
+        
+        std::cout << "\nRunning Catalogue Loader Tests..." << std::endl;
+        run_catalogue_loader_tests();
+        
+        std::cout << "\nRunning Availability Tests..." << std::endl;
+        run_availability_tests();
+        
+        std::cout << "\nRunning Seat Allocator Tests..." << std::endl;
+        run_seat_allocator_tests();
+        
+        std::cout << "\nRunning Trace Tests..." << std::endl;
+        run_trace_tests();
+        
+        std::cout << "\nRunning Replica Sync Tests..." << std::endl;
+        run_replica_sync_tests();
+        
         // Print final results
         std::cout << "\n" << std::string(60, '=') << std::endl;
         SimpleTest::printResults();
@@ -0,0 +1,80 @@
+#include "simple_test.hpp"
+#include "metrics.hpp"
+#include "cinema.hpp"
+#include <thread>
+#include <vector>
+
+void test_metric_counter_threads() {
+    std::cout << "\n=== Testing Metric Counter Across Threads ===" << std::endl;
+    
+    MetricCounter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 1000; ++i) {
+                counter.inc();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    SimpleTest::EXPECT_EQ((uint64_t)8000, counter.value(), "Counter sums increments from every thread");
+    counter.inc(5);
+    SimpleTest::EXPECT_EQ((uint64_t)8005, counter.value(), "Counter adds larger increments");
+}
+
+void test_metric_histogram_buckets() {
+    std::cout << "\n=== Testing Metric Histogram Buckets ===" << std::endl;
+    
+    MetricHistogram histogram({10, 100});
+    histogram.observe(uint64_t{5});
+    histogram.observe(uint64_t{10});
+    histogram.observe(uint64_t{50});
+    histogram.observe(uint64_t{1000});
+    
+    auto snap = histogram.snapshot();
+    SimpleTest::EXPECT_EQ((size_t)3, snap.counts.size(), "Two bounds give three buckets including +Inf");
+    SimpleTest::EXPECT_EQ((uint64_t)2, snap.counts[0], "Values up to and including the bound share the first bucket");
+    SimpleTest::EXPECT_EQ((uint64_t)1, snap.counts[1], "Value between bounds lands in the second bucket");
+    SimpleTest::EXPECT_EQ((uint64_t)1, snap.counts[2], "Value above every bound lands in +Inf");
+    SimpleTest::EXPECT_EQ((uint64_t)4, snap.count, "Count covers every observation");
+    SimpleTest::EXPECT_EQ((uint64_t)1065, snap.sum, "Sum adds observed values");
+    
+    std::string text;
+    ServerMetrics::renderHistogram(text, "test_depth", "Test histogram", histogram, 1.0);
+    SimpleTest::EXPECT_CONTAINS(text, "# TYPE test_depth histogram", "Histogram declares its type");
+    SimpleTest::EXPECT_CONTAINS(text, "test_depth_bucket{le=\"100\"} 3", "Buckets are rendered cumulatively");
+    SimpleTest::EXPECT_CONTAINS(text, "test_depth_bucket{le=\"+Inf\"} 4", "+Inf bucket equals the count");
+    SimpleTest::EXPECT_CONTAINS(text, "test_depth_count 4", "Count line is rendered");
+}
+
+void test_server_metrics_bookings() {
+    std::cout << "\n=== Testing Booking Metrics ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    ServerMetrics& metrics = ServerMetrics::instance();
+    uint64_t succeeded = metrics.bookingsSucceeded.value();
+    uint64_t conflicted = metrics.bookingsConflicted.value();
+    uint64_t rejected = metrics.bookingsRejected.value();
+    
+    BookingService::processBooking("PVR,Inception,1", shows);
+    BookingService::processBooking("PVR,Inception,1", shows);
+    BookingService::processBooking("PVR,Inception,99", shows);
+    
+    SimpleTest::EXPECT_EQ(succeeded + 1, metrics.bookingsSucceeded.value(), "Successful booking is counted");
+    SimpleTest::EXPECT_EQ(conflicted + 1, metrics.bookingsConflicted.value(), "Booking of a taken seat counts as conflict");
+    SimpleTest::EXPECT_EQ(rejected + 1, metrics.bookingsRejected.value(), "Out-of-range seat counts as rejected");
+    
+    std::string text = metrics.render();
+    SimpleTest::EXPECT_CONTAINS(text, "cinema_bookings_total{result=\"success\"}", "Rendered metrics include booking outcomes");
+    SimpleTest::EXPECT_CONTAINS(text, "# TYPE cinema_message_handling_seconds histogram", "Rendered metrics include message handling latency");
+}
+
+void run_metrics_tests() {
+    test_metric_counter_threads();
+    test_metric_histogram_buckets();
+    test_server_metrics_bookings();
+}
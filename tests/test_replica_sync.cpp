@@ -0,0 +1,138 @@
+#include "simple_test.hpp"
+#include "replica_sync.hpp"
+#include "cluster.hpp"
+#include "metrics.hpp"
+#include <stdexcept>
+
+namespace {
+
+ShowStore makeShows() {
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 100);
+    shows.emplace_back("Interstellar", "2025-09-11 19:30", "Cinepolis");
+    return shows;
+}
+
+std::vector<SeatNumber> freeSeats(const ShowStore& shows, ShowId id) {
+    return shows[id].getAvailableSeats();
+}
+
+} // namespace
+
+void test_replica_sync_format() {
+    std::cout << "\n=== Testing Replica Seat State Format ===" << std::endl;
+
+    ShowStore shows = makeShows();
+    SimpleTest::EXPECT_TRUE(ReplicaSync::isSyncRequest("protocol:sync"), "Sync request");
+    SimpleTest::EXPECT_FALSE(ReplicaSync::isSyncRequest("protocol:peer"), "Peer hello is not a sync request");
+    SimpleTest::EXPECT_EQ(std::string("STATE_SYNC:3\n0:\n1:\n2:"), *ReplicaSync::formatState(shows),
+                          "Shows with every seat free get an empty line");
+
+    uint64_t version = 0;
+    shows[0].bookSeats(std::vector<SeatNumber>{1, 2});
+    SeatNumber held[] = {70};
+    shows[1].holdSeats(held, 1, version);
+    SharedPayload state = ReplicaSync::formatState(shows);
+    SimpleTest::EXPECT_TRUE(ReplicaSync::isState(*state), "Reply is a seat state");
+    SimpleTest::EXPECT_EQ(std::string("STATE_SYNC:3\n0:3\n1:0,0;0,20\n2:"), *state,
+                          "Booked words in hex, held words after a semicolon");
+
+    state = ReplicaSync::formatState(shows, [](ShowId id) { return id != 0; });
+    SimpleTest::EXPECT_EQ(std::string("STATE_SYNC:3\n1:0,0;0,20\n2:"), *state, "Filtered shows are left out");
+}
+
+void test_replica_sync_apply() {
+    std::cout << "\n=== Testing Replica Seat State Apply ===" << std::endl;
+
+    ShowStore primary = makeShows();
+    ShowStore replica = makeShows();
+    uint64_t version = 0;
+
+    // Replica missed bookings and holds, and still has a hold the primary freed
+    primary[0].bookSeats(std::vector<SeatNumber>{3, 4});
+    replica[0].bookSeats(std::vector<SeatNumber>{3});
+    SeatNumber held[] = {65, 66};
+    primary[1].holdSeats(held, 2, version);
+    SeatNumber stale[] = {5};
+    replica[2].holdSeats(stale, 1, version);
+    SeatNumber confirmed[] = {7};
+    replica[2].holdSeats(confirmed, 1, version);
+    primary[2].bookSeats(std::vector<SeatNumber>{7});
+
+    std::vector<std::pair<ShowId, std::vector<SeatNumber>>> journaled;
+    BookingCallback onBooked = [&journaled](ShowId id, const SeatNumber* seats, size_t count) {
+        journaled.emplace_back(id, std::vector<SeatNumber>(seats, seats + count));
+    };
+    size_t syncs = ServerMetrics::instance().replicaSyncs.value();
+    size_t changed = 0;
+    SimpleTest::EXPECT_TRUE(ReplicaSync::applyState(*ReplicaSync::formatState(primary), replica, onBooked, changed),
+                            "State of the same catalogue is applied");
+    SimpleTest::EXPECT_EQ((size_t)3, changed, "Every show that differed is updated");
+    SimpleTest::EXPECT_TRUE(freeSeats(replica, 0) == freeSeats(primary, 0), "Missed booking is merged");
+    SimpleTest::EXPECT_TRUE(freeSeats(replica, 1) == freeSeats(primary, 1), "Missed hold is placed");
+    SimpleTest::EXPECT_EQ((size_t)2, replica[1].seats.heldCount(), "Mirrored seats stay holds");
+    SimpleTest::EXPECT_TRUE(freeSeats(replica, 2) == freeSeats(primary, 2), "Freed hold is released");
+    SimpleTest::EXPECT_EQ((size_t)0, replica[2].seats.heldCount(), "Hold confirmed on the primary is booked");
+    SimpleTest::EXPECT_TRUE(journaled.size() == 2 && journaled[0].first == 0 &&
+                            journaled[0].second == std::vector<SeatNumber>({4}),
+                            "Only newly booked seats are reported for the journal");
+    SimpleTest::EXPECT_EQ(syncs + 1, ServerMetrics::instance().replicaSyncs.value(), "Sync is counted");
+
+    SimpleTest::EXPECT_TRUE(ReplicaSync::applyState(*ReplicaSync::formatState(primary), replica, {}, changed) &&
+                            changed == 0, "Applying the same state again changes nothing");
+
+    // The primary's only hold of a show was released while the link was down
+    SeatNumber missed[] = {9};
+    replica[1].holdSeats(missed, 1, version);
+    ShowStore empty = makeShows();
+    SimpleTest::EXPECT_TRUE(ReplicaSync::applyState(*ReplicaSync::formatState(empty), replica, {}, changed),
+                            "State with empty shows is applied");
+    SimpleTest::EXPECT_FALSE(replica[1].seats[8], "Hold of a show now empty on the primary is released");
+
+    ShowStore other = makeShows();
+    other.emplace_back("Dune", "2025-09-11 19:30", "PVR");
+    SimpleTest::EXPECT_FALSE(ReplicaSync::applyState(*ReplicaSync::formatState(other), replica, {}, changed),
+                             "State of another catalogue is refused");
+    SimpleTest::EXPECT_FALSE(ReplicaSync::applyState("STATE_SYNC:3\n1:0", replica, {}, changed),
+                             "Line with too few words is refused");
+    SimpleTest::EXPECT_FALSE(ReplicaSync::applyState("STATE_SYNC:3\n9:0", replica, {}, changed),
+                             "Unknown show is refused");
+    SimpleTest::EXPECT_FALSE(ReplicaSync::applyState("SEAT_DELTA:1:0:1", replica, {}, changed),
+                             "Delta is not a seat state");
+}
+
+void test_replica_cluster_node() {
+    std::cout << "\n=== Testing Replica Cluster Node ===" << std::endl;
+
+    net::io_context ioc;
+    ShowStore shows = makeShows();
+    ClusterOptions options;
+    options.members = ClusterOptions::parseMembers("primary=localhost:1");
+    options.nodeId = "replica";
+
+    bool refused = false;
+    try {
+        ClusterNode member(ioc, options, shows, [](const std::string&) {});
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    SimpleTest::EXPECT_TRUE(refused, "A member must be on the ring");
+
+    options.replica = true;
+    ClusterNode replica(ioc, options, shows, [](const std::string&) {}, [](const std::string&) {});
+    bool ownsNone = true;
+    for (ShowId id = 0; id < shows.size(); ++id) {
+        ownsNone = ownsNone && !replica.owns(id) && replica.ownerOf(id) == "primary";
+    }
+    SimpleTest::EXPECT_TRUE(replica.replica() && ownsNone, "Replica owns no show");
+    SimpleTest::EXPECT_TRUE(replica.forward(0, "PVR,Inception,1", WireFormat::Text, [](SharedPayload) {}),
+                            "Every booking is forwarded");
+    SimpleTest::EXPECT_EQ(std::string("replica"), replica.ownerOf(99), "Unknown shows stay local");
+}
+
+void run_replica_sync_tests() {
+    test_replica_sync_format();
+    test_replica_sync_apply();
+    test_replica_cluster_node();
+}
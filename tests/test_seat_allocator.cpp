@@ -0,0 +1,160 @@
+#include "simple_test.hpp"
+#include "seat_allocator.hpp"
+#include "metrics.hpp"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+std::vector<SeatNumber> seatsOf(const SeatBuffer& seats) {
+    return std::vector<SeatNumber>(seats.begin(), seats.end());
+}
+
+} // namespace
+
+void test_seat_layout() {
+    std::cout << "\n=== Testing Seat Layout ===" << std::endl;
+
+    SeatLayout row(20);
+    SimpleTest::EXPECT_EQ((size_t)20, row.maxBlock(), "One row of 20 seats");
+    SimpleTest::EXPECT_TRUE(row.score(9) == row.score(10) && row.score(9) < row.score(8), "Middle seats score best");
+    SimpleTest::EXPECT_EQ((SeatNumber)9, row.blocks(2)[0], "Best pair is the middle pair");
+    SimpleTest::EXPECT_EQ((SeatNumber)9, row.blocks(1)[0], "Ties keep the lower seat first");
+    SimpleTest::EXPECT_EQ((SeatNumber)8, row.blocks(3)[0], "Odd block is centred, lower side first");
+    SimpleTest::EXPECT_EQ((size_t)1, row.blocks(20).size(), "Whole row is the only block of 20");
+
+    SeatLayout hall(100);
+    SimpleTest::EXPECT_EQ((SeatNumber)(2 * 20 + 9), hall.blocks(2)[0], "Best block is in the preferred row");
+    bool withinRows = true;
+    for (SeatNumber first : hall.blocks(5)) {
+        withinRows = withinRows && first / SeatLayout::ROW_SEATS == (first + 4) / SeatLayout::ROW_SEATS;
+    }
+    SimpleTest::EXPECT_TRUE(withinRows, "Blocks never span rows");
+    SimpleTest::EXPECT_EQ((size_t)5 * 16, hall.blocks(5).size(), "Every block of every row is ranked");
+
+    SeatLayout small(6);
+    SimpleTest::EXPECT_EQ((size_t)6, small.maxBlock(), "Short auditorium is one short row");
+    SimpleTest::EXPECT_EQ((SeatNumber)2, small.blocks(2)[0], "Centre of a short row");
+}
+
+void test_seat_allocator_allocate() {
+    std::cout << "\n=== Testing Best Seat Allocation ===" << std::endl;
+
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR", 20);
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "PVR", 100);
+    ShowRegistry registry(shows);
+    SeatAllocator allocator(shows, registry);
+
+    SeatBuffer seats;
+    uint64_t sequence = 0;
+    SimpleTest::EXPECT_TRUE(allocator.allocate(0, 2, seats, sequence), "Empty show has a pair");
+    SimpleTest::EXPECT_TRUE(seatsOf(seats) == std::vector<SeatNumber>({10, 11}), "Middle pair is taken first");
+    SimpleTest::EXPECT_TRUE(allocator.allocate(0, 2, seats, sequence), "Second pair");
+    SimpleTest::EXPECT_TRUE(seatsOf(seats) == std::vector<SeatNumber>({8, 9}), "Next best pair beside it");
+    SimpleTest::EXPECT_TRUE(shows[0].seats[9] && shows[0].seats[10] && shows[0].seats[7], "Seats are booked");
+    SimpleTest::EXPECT_EQ(shows[0].stateVersion(), sequence, "Sequence of the booking");
+
+    SimpleTest::EXPECT_FALSE(allocator.allocate(0, 17, seats, sequence), "No block of 17 is left");
+    SimpleTest::EXPECT_TRUE(allocator.allocate(0, 7, seats, sequence), "Block beside the booked seats");
+    SimpleTest::EXPECT_TRUE(seatsOf(seats) == std::vector<SeatNumber>({12, 13, 14, 15, 16, 17, 18}),
+                            "Block of 7 nearest the centre");
+    SimpleTest::EXPECT_FALSE(allocator.allocate(0, 21, seats, sequence), "Longer than a row");
+
+    SimpleTest::EXPECT_TRUE(allocator.allocate(1, 4, seats, sequence), "Large auditorium");
+    SimpleTest::EXPECT_TRUE(seatsOf(seats) == std::vector<SeatNumber>({49, 50, 51, 52}), "Centre of the preferred row");
+
+    SeatNumber held[] = {10};
+    uint64_t version = 0;
+    shows[0].seats = std::vector<bool>(20, false);
+    shows[0].holdSeats(held, 1, version);
+    SimpleTest::EXPECT_TRUE(allocator.allocate(0, 1, seats, sequence) && seats.data()[0] == 11,
+                            "Held seats are skipped");
+}
+
+void test_seat_allocator_contention() {
+    std::cout << "\n=== Testing Concurrent Best Seat Allocation ===" << std::endl;
+
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR", 200);
+    ShowRegistry registry(shows);
+    SeatAllocator allocator(shows, registry);
+
+    std::atomic<size_t> booked{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&allocator, &booked] {
+            SeatBuffer seats;
+            uint64_t sequence = 0;
+            // Centred pairs leave the odd seat at each end of a row
+            for (size_t count : {2, 1}) {
+                while (allocator.allocate(0, count, seats, sequence)) {
+                    booked += seats.size();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    SimpleTest::EXPECT_EQ((size_t)200, booked.load(), "Pairs and singles fill the auditorium without double booking");
+    SimpleTest::EXPECT_EQ((size_t)0, shows[0].availableSeatCount(), "Every seat is booked once");
+}
+
+void test_seat_allocator_messages() {
+    std::cout << "\n=== Testing Best Seat Requests ===" << std::endl;
+
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR", 20);
+    shows[0].seats = std::vector<bool>{true, true, false, false, true, false, false, false, false, true,
+                                       true, false, false, true, true, false, false, false, true, false};
+    ShowRegistry registry(shows);
+    SeatAllocator allocator(shows, registry);
+
+    SimpleTest::EXPECT_TRUE(SeatAllocator::isBestRequest("book_best,PVR,Inception,2"), "Request prefix");
+    SimpleTest::EXPECT_FALSE(SeatAllocator::isBestRequest("PVR,Inception,2"), "Booking is not a best-seat request");
+
+    std::vector<SeatNumber> booked;
+    BookingCallback onBooked = [&booked](ShowId, const SeatNumber* seats, size_t count) {
+        booked.assign(seats, seats + count);
+    };
+    BroadcastPayload broadcast;
+    size_t before = ServerMetrics::instance().bookingsSucceeded.value();
+    auto reply = allocator.handleMessage("book_best,PVR,Inception,3", broadcast, onBooked);
+    SimpleTest::EXPECT_EQ(std::string("SUCCESS: Booked seats 7, 8, 9 for Inception at PVR"), *reply,
+                          "Best free block of three");
+    SimpleTest::EXPECT_TRUE(broadcast.text && broadcast.text->find("SEAT_DELTA:") == 0 && broadcast.show == 0,
+                            "Booking is broadcast as a delta");
+    SimpleTest::EXPECT_TRUE(booked == std::vector<SeatNumber>({7, 8, 9}), "Booking is reported for the journal");
+    SimpleTest::EXPECT_EQ(before + 1, ServerMetrics::instance().bookingsSucceeded.value(), "Counted as a booking");
+
+    reply = allocator.handleMessage("book_best,PVR,Inception,4", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: No 4 adjacent seats", "No block of four is left");
+    SimpleTest::EXPECT_TRUE(broadcast.text == nullptr, "Failure is not broadcast");
+
+    SimpleTest::EXPECT_CONTAINS(*allocator.handleMessage("book_best,PVR,Inception,x", broadcast),
+                                "ERROR: Invalid request", "Count must be a number");
+    SimpleTest::EXPECT_CONTAINS(*allocator.handleMessage("book_best,PVR,Inception,0", broadcast),
+                                "ERROR: Invalid request", "Count must be positive");
+    SimpleTest::EXPECT_CONTAINS(*allocator.handleMessage("book_best,PVR", broadcast),
+                                "ERROR: Invalid request", "Movie is required");
+    SimpleTest::EXPECT_CONTAINS(*allocator.handleMessage("book_best,IMAX,Inception,2", broadcast),
+                                "ERROR: Show not found", "Unknown show");
+    SimpleTest::EXPECT_CONTAINS(*allocator.handleMessage("book_best,PVR,Inception,21", broadcast),
+                                "At most 20 adjacent seats", "Block longer than a row");
+
+    bool forwarded = false;
+    BookingForwarder forward = [&forwarded](ShowId, const std::string&, WireFormat, ReplyCallback) {
+        forwarded = true;
+        return true;
+    };
+    reply = allocator.handleMessage("book_best,PVR,Inception,1", broadcast, {}, forward, [](SharedPayload) {});
+    SimpleTest::EXPECT_TRUE(forwarded && reply == nullptr, "Request for a remote show is forwarded");
+}
+
+void run_seat_allocator_tests() {
+    test_seat_layout();
+    test_seat_allocator_allocate();
+    test_seat_allocator_contention();
+    test_seat_allocator_messages();
+}
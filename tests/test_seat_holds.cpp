@@ -0,0 +1,269 @@
+#include "simple_test.hpp"
+#include "seat_holds.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+ShowStore makeShows() {
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX", 100);
+    return shows;
+}
+
+/**
+ * @brief Token of a "HELD: <token> seats ..." reply
+ */
+std::string tokenOf(const std::string& reply) {
+    size_t start = reply.find(' ') + 1;
+    return reply.substr(start, reply.find(' ', start) - start);
+}
+
+} // namespace
+
+void test_timer_wheel() {
+    std::cout << "\n=== Testing Timer Wheel ===" << std::endl;
+
+    TimerWheel wheel(10);
+    wheel.schedule(1, 12);
+    wheel.schedule(2, 10 + 64 * 3 + 5);       // level 1
+    wheel.schedule(3, 10 + 64 * 64 * 7);      // level 2
+    wheel.schedule(4, 5);                     // already due
+    wheel.schedule(5, uint64_t{1} << 30);     // beyond the wheel
+    SimpleTest::EXPECT_EQ((size_t)5, wheel.size(), "Every entry is scheduled");
+
+    auto due = wheel.advance(11);
+    SimpleTest::EXPECT_TRUE(due.size() == 1 && due[0] == 4, "Past deadlines fire on the next tick");
+    due = wheel.advance(12);
+    SimpleTest::EXPECT_TRUE(due.size() == 1 && due[0] == 1, "Near deadline fires on its tick");
+    due = wheel.advance(10 + 64 * 3 + 4);
+    SimpleTest::EXPECT_TRUE(due.empty(), "Cascaded entry does not fire early");
+    due = wheel.advance(10 + 64 * 3 + 5);
+    SimpleTest::EXPECT_TRUE(due.size() == 1 && due[0] == 2, "Cascaded entry fires on its tick");
+    due = wheel.advance(10 + 64 * 64 * 7);
+    SimpleTest::EXPECT_TRUE(due.size() == 1 && due[0] == 3, "Entry two levels up fires on its tick");
+    due = wheel.advance((uint64_t{1} << 30) - 1);
+    SimpleTest::EXPECT_TRUE(due.empty(), "Overflow entry waits");
+    due = wheel.advance(uint64_t{1} << 30);
+    SimpleTest::EXPECT_TRUE(due.size() == 1 && due[0] == 5, "Overflow entry fires on its tick");
+    SimpleTest::EXPECT_EQ((size_t)0, wheel.size(), "Nothing is left scheduled");
+
+    // Many random-ish deadlines, each reported exactly once and never early
+    TimerWheel busy;
+    for (uint64_t id = 0; id < 5000; ++id) {
+        busy.schedule(id, 1 + (id * 7919) % 300000);
+    }
+    std::unordered_set<uint64_t> seen;
+    bool onTime = true;
+    for (uint64_t tick = 1; tick < 300000 + 97; tick += 97) {
+        for (uint64_t id : busy.advance(tick)) {
+            uint64_t deadline = 1 + (id * 7919) % 300000;
+            onTime &= deadline <= tick && deadline + 97 > tick;
+            seen.insert(id);
+        }
+    }
+    SimpleTest::EXPECT_EQ((size_t)5000, seen.size(), "Every deadline fires exactly once");
+    SimpleTest::EXPECT_TRUE(onTime, "No deadline fires early or late");
+}
+
+void test_seat_map_holds() {
+    std::cout << "\n=== Testing Seat Map Holds ===" << std::endl;
+
+    SeatMap seats(100);
+    SeatNumber held[] = {10, 70};
+    SimpleTest::EXPECT_TRUE(seats.tryHold(held, 2), "Free seats can be held");
+    SimpleTest::EXPECT_TRUE(seats[9] && seats[69], "Held seats look booked");
+    SimpleTest::EXPECT_EQ((size_t)2, seats.heldCount(), "Held seats are counted");
+    SimpleTest::EXPECT_FALSE(seats.tryBook(held, 1), "Held seats cannot be booked");
+
+    std::vector<uint64_t> words(seats.wordCount());
+    seats.loadBookedWords(words.data());
+    SimpleTest::EXPECT_TRUE(words[0] == 0 && words[1] == 0, "Booked view leaves holds out");
+
+    SimpleTest::EXPECT_TRUE(seats.releaseHeld(held, 1), "Held seat is released");
+    SimpleTest::EXPECT_FALSE(seats[9], "Released seat is free again");
+    SimpleTest::EXPECT_TRUE(seats.confirmHeld(held + 1, 1), "Held seat is confirmed");
+    SimpleTest::EXPECT_EQ((size_t)0, seats.heldCount(), "Nothing is held after confirming");
+    SimpleTest::EXPECT_FALSE(seats.releaseHeld(held + 1, 1), "Confirmed seat is not released");
+    SimpleTest::EXPECT_TRUE(seats[69], "Confirmed seat stays booked");
+
+    SimpleTest::EXPECT_TRUE(seats.tryHold(held, 1), "Freed seat can be held again");
+    SeatNumber mixed[] = {10, 90};
+    SimpleTest::EXPECT_FALSE(seats.confirmHeld(mixed, 2), "Seats not all held are not confirmed");
+    SimpleTest::EXPECT_EQ((size_t)1, seats.heldCount(), "A failed confirm keeps the hold");
+    SimpleTest::EXPECT_FALSE(seats[89], "A failed confirm books nothing");
+
+    SimpleTest::EXPECT_TRUE(seats.settle(mixed, 2), "Held and free seats are settled together");
+    SimpleTest::EXPECT_TRUE(seats[9] && seats[89], "Settled seats are booked");
+    SimpleTest::EXPECT_EQ((size_t)0, seats.heldCount(), "Settling confirms the hold");
+    SimpleTest::EXPECT_FALSE(seats.settle(mixed, 2), "Settling booked seats changes nothing");
+}
+
+void test_seat_hold_protocol() {
+    std::cout << "\n=== Testing Seat Hold Protocol ===" << std::endl;
+
+    net::io_context ioc;
+    ShowStore shows = makeShows();
+    ShowRegistry registry(shows);
+    SeatHolds holds(ioc, shows, registry, HoldOptions{}, {});
+    std::vector<ShowId> journaled;
+    BookingCallback onBooked = [&journaled](ShowId showId, const SeatNumber*, size_t count) {
+        journaled.insert(journaled.end(), count, showId);
+    };
+
+    SimpleTest::EXPECT_TRUE(SeatHolds::isHoldRequest("hold:PVR,Inception,1"), "Hold requests are recognised");
+    SimpleTest::EXPECT_FALSE(SeatHolds::isHoldRequest("PVR,Inception,1"), "Bookings are not hold requests");
+
+    BroadcastPayload broadcast;
+    SharedPayload reply = holds.handleMessage("hold:60:IMAX,Tenet,3,4", broadcast, onBooked);
+    SimpleTest::EXPECT_CONTAINS(*reply, "HELD: 1-", "Hold reply carries a token naming the show");
+    SimpleTest::EXPECT_CONTAINS(*reply, "seats 3, 4 for Tenet at IMAX, expires in 60s", "Hold reply lists seats and lifetime");
+    SimpleTest::EXPECT_CONTAINS(*broadcast.text, "SEAT_HELD:", "Hold broadcasts SEAT_HELD");
+    SimpleTest::EXPECT_EQ(BinaryProtocol::SEAT_DELTA, static_cast<uint8_t>((*broadcast.binary)[2]),
+                          "Held seats are a SEAT_DELTA frame for binary clients");
+    SimpleTest::EXPECT_TRUE(shows[1].seats[2] && shows[1].seats[3], "Held seats are taken");
+    SimpleTest::EXPECT_TRUE(journaled.empty(), "Holds are not journaled");
+
+    auto booking = BookingService::reserveSeats("IMAX,Tenet,3", shows, registry);
+    SimpleTest::EXPECT_FALSE(booking.success, "Held seats cannot be booked");
+    reply = holds.handleMessage("hold:IMAX,Tenet,4,5", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR:", "Held seats cannot be held again");
+    SimpleTest::EXPECT_FALSE(shows[1].seats[4], "A failed hold takes no seats");
+
+    std::string first = tokenOf(*holds.handleMessage("hold:IMAX,Tenet,10", broadcast));
+    reply = holds.handleMessage("confirm:" + first, broadcast, onBooked);
+    SimpleTest::EXPECT_CONTAINS(*reply, "SUCCESS: Booked seats 10 for Tenet at IMAX", "Confirm books the held seats");
+    SimpleTest::EXPECT_CONTAINS(*broadcast.text, "SEAT_DELTA:", "Confirm broadcasts SEAT_DELTA");
+    SimpleTest::EXPECT_EQ((size_t)1, journaled.size(), "Confirmed seats are journaled");
+    SimpleTest::EXPECT_EQ((size_t)2, shows[1].seats.heldCount(), "Confirmed seat is no longer held");
+    reply = holds.handleMessage("confirm:" + first, broadcast, onBooked);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: Unknown or expired hold", "A hold is confirmed once");
+
+    std::string lapsed = tokenOf(*holds.handleMessage("hold:IMAX,Tenet,30,31", broadcast));
+    uint64_t version = 0;
+    SeatNumber dropped = 31;
+    shows[1].releaseSeats(&dropped, 1, version);
+    reply = holds.handleMessage("confirm:" + lapsed, broadcast, onBooked);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: Hold", "Confirm fails once a seat is no longer held");
+    SimpleTest::EXPECT_CONTAINS(*broadcast.text, "SEAT_FREED:", "Seats left on the lapsed hold are freed");
+    SimpleTest::EXPECT_EQ(version + 1, shows[1].stateVersion(), "Only the release moves the version");
+    SimpleTest::EXPECT_FALSE(shows[1].seats[29] || shows[1].seats[30], "A failed confirm books nothing");
+    SimpleTest::EXPECT_EQ((size_t)1, journaled.size(), "A failed confirm is not journaled");
+
+    std::string second = tokenOf(*holds.handleMessage("hold:IMAX,Tenet,20,21", broadcast));
+    SimpleTest::EXPECT_TRUE(std::stoull(second.substr(2)) != std::stoull(first.substr(2)) + 1,
+                            "Hold ids are not sequential");
+    reply = holds.handleMessage("release:" + second, broadcast);
+    SimpleTest::EXPECT_EQ(std::string("RELEASED: ") + second, *reply, "Release replies with the token");
+    SimpleTest::EXPECT_CONTAINS(*broadcast.text, "SEAT_FREED:", "Release broadcasts SEAT_FREED");
+    SimpleTest::EXPECT_EQ(BinaryProtocol::SEAT_FREED, static_cast<uint8_t>((*broadcast.binary)[2]),
+                          "Released seats are a SEAT_FREED frame");
+    SimpleTest::EXPECT_FALSE(shows[1].seats[19] || shows[1].seats[20], "Released seats are free");
+
+    reply = holds.handleMessage("release:0-" + second.substr(second.find('-') + 1), broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR:", "Token of another show is rejected");
+    reply = holds.handleMessage("confirm:nonsense", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: Invalid hold token", "Malformed token is rejected");
+    reply = holds.handleMessage("hold:0:IMAX,Tenet,30", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "ERROR: Invalid hold", "Zero lifetime is rejected");
+}
+
+void test_seat_hold_expiry() {
+    std::cout << "\n=== Testing Seat Hold Expiry ===" << std::endl;
+
+    net::io_context ioc;
+    ShowStore shows = makeShows();
+    ShowRegistry registry(shows);
+    std::vector<std::string> freed;
+    HoldOptions options;
+    options.maxTtl = std::chrono::seconds(10);
+    SeatHolds holds(ioc, shows, registry, options, [&freed](BroadcastPayload broadcast) {
+        freed.push_back(*broadcast.text);
+    });
+
+    BroadcastPayload broadcast;
+    uint64_t now = holds.currentTick();
+    holds.handleMessage("hold:1:IMAX,Tenet,1", broadcast);
+    holds.handleMessage("hold:1:IMAX,Tenet,2", broadcast);
+    holds.handleMessage("hold:1:PVR,Inception,3", broadcast);
+    std::string kept = tokenOf(*holds.handleMessage("hold:1:PVR,Inception,4", broadcast));
+    holds.handleMessage("release:" + kept, broadcast);
+    SharedPayload capped = holds.handleMessage("hold:3600:IMAX,Tenet,50", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*capped, "expires in 10s", "Lifetime is capped at maxTtl");
+    SimpleTest::EXPECT_EQ((size_t)4, holds.size(), "Open holds are counted");
+
+    SimpleTest::EXPECT_EQ((size_t)0, holds.expire(now + 5), "Nothing expires before the deadline");
+    SimpleTest::EXPECT_EQ((size_t)3, holds.expire(now + 20), "Due holds expire; released ones are skipped");
+    SimpleTest::EXPECT_EQ((size_t)2, freed.size(), "One SEAT_FREED per show and tick");
+    bool merged = std::any_of(freed.begin(), freed.end(), [](const std::string& delta) {
+        return delta.find("SEAT_FREED:") == 0 && delta.find(":1:1,2") != std::string::npos;
+    });
+    SimpleTest::EXPECT_TRUE(merged, "Seats of a show are freed in one delta");
+    SimpleTest::EXPECT_FALSE(shows[1].seats[0] || shows[1].seats[1] || shows[0].seats[2], "Expired seats are free");
+    SimpleTest::EXPECT_TRUE(shows[1].seats[49], "Longer hold is still open");
+    SimpleTest::EXPECT_EQ((size_t)1, holds.size(), "Only the longer hold is left");
+}
+
+void test_relayed_holds() {
+    std::cout << "\n=== Testing Relayed Holds ===" << std::endl;
+
+    ShowStore shows = makeShows();
+    int journaled = 0;
+    BookingCallback onBooked = [&journaled](ShowId, const SeatNumber*, size_t) { ++journaled; };
+    BroadcastPayload broadcast;
+
+    SimpleTest::EXPECT_TRUE(MessageHandler::applyRelayedDelta("SEAT_HELD:7:1:5,6", shows, broadcast, onBooked),
+                            "Relayed hold is applied");
+    SimpleTest::EXPECT_TRUE(shows[1].seats[4] && shows[1].seats.heldCount() == 2, "Mirror holds the seats");
+    SimpleTest::EXPECT_CONTAINS(*broadcast.text, "SEAT_HELD:", "Relayed hold is rebroadcast as SEAT_HELD");
+
+    MessageHandler::applyRelayedDelta("SEAT_DELTA:8:1:5", shows, broadcast, onBooked);
+    SimpleTest::EXPECT_EQ((size_t)1, shows[1].seats.heldCount(), "Relayed booking confirms the held seat");
+    MessageHandler::applyRelayedDelta("SEAT_FREED:9:1:6", shows, broadcast, onBooked);
+    SimpleTest::EXPECT_FALSE(shows[1].seats[5], "Relayed release frees the seat");
+    SimpleTest::EXPECT_TRUE(shows[1].seats[4], "Confirmed seat stays booked");
+    SimpleTest::EXPECT_EQ(1, journaled, "Only bookings are journaled");
+
+    MessageHandler::applyRelayedDelta("SEAT_HELD:10:1:7", shows, broadcast, onBooked);
+    uint64_t version = shows[1].stateVersion();
+    MessageHandler::applyRelayedDelta("SEAT_DELTA:11:1:7,8", shows, broadcast, onBooked);
+    SimpleTest::EXPECT_TRUE(shows[1].seats[6] && shows[1].seats[7], "Held and free seats are both booked");
+    SimpleTest::EXPECT_EQ((size_t)0, shows[1].seats.heldCount(), "The held seat is confirmed");
+    SimpleTest::EXPECT_EQ(version + 1, shows[1].stateVersion(), "One relayed delta is one state change");
+}
+
+void test_showtime_holds() {
+    std::cout << "\n=== Testing Showtime Holds ===" << std::endl;
+
+    net::io_context ioc;
+    ShowStore shows = makeShows();
+    shows.emplace_back("Inception", "2025-09-11 22:00", "PVR");
+    ShowRegistry registry(shows);
+    SeatHolds holds(ioc, shows, registry, HoldOptions{}, {});
+    BroadcastPayload broadcast;
+
+    SharedPayload reply = holds.handleMessage("hold:PVR,Inception@2025-09-11 22:00,3", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "HELD: 2-", "Showtime hold without a lifetime is placed");
+    reply = holds.handleMessage("hold:30:PVR,Inception@2025-09-11 22:00,4", broadcast);
+    SimpleTest::EXPECT_CONTAINS(*reply, "expires in 30s", "Showtime hold with a lifetime is placed");
+    SimpleTest::EXPECT_TRUE(shows[2].seats[2] && shows[2].seats[3], "The later showtime holds the seats");
+    SimpleTest::EXPECT_FALSE(shows[0].seats[2] || shows[0].seats[3], "The earlier showtime is untouched");
+
+    ShowId routed = ALL_SHOWS;
+    BookingForwarder forward = [&routed](ShowId show, const std::string&, WireFormat, ReplyCallback) {
+        routed = show;
+        return true;
+    };
+    reply = holds.handleMessage("hold:PVR,Inception@2025-09-11 22:00,5", broadcast, {}, forward, [](SharedPayload) {});
+    SimpleTest::EXPECT_TRUE(reply == nullptr && routed == 2, "Showtime hold is routed to its show");
+}
+
+void run_seat_holds_tests() {
+    test_timer_wheel();
+    test_seat_map_holds();
+    test_seat_hold_protocol();
+    test_seat_hold_expiry();
+    test_relayed_holds();
+    test_showtime_holds();
+}
@@ -0,0 +1,59 @@
+#include "simple_test.hpp"
+#include "cinema.hpp"
+
+void test_show_registry_lookup() {
+    std::cout << "\n=== Testing Show Registry Lookup ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    shows.emplace_back("Inception", "2025-09-11 22:00", "PVR");
+    
+    ShowRegistry registry(shows);
+    SimpleTest::EXPECT_EQ(3, (int)registry.size(), "Registry indexes every show");
+    
+    auto first = registry.find("PVR", "Inception");
+    SimpleTest::EXPECT_TRUE(first.has_value(), "Finds show by theater and movie");
+    SimpleTest::EXPECT_EQ(0, (int)first.value_or(99), "Theater and movie lookup returns first registered show");
+    
+    auto late = registry.find("PVR", "Inception", "2025-09-11 22:00");
+    SimpleTest::EXPECT_EQ(2, (int)late.value_or(99), "Date and time selects the later show");
+    SimpleTest::EXPECT_EQ(2, (int)registry.find("PVR", "Inception@2025-09-11 22:00").value_or(99),
+                          "Showtime after the movie title selects the later show");
+    SimpleTest::EXPECT_FALSE(registry.find("PVR", "Inception@2025-09-12 19:30").has_value(),
+                             "Unknown showtime after the movie title is not found");
+    
+    auto booking = BookingService::reserveSeats("PVR,Inception@2025-09-11 22:00,3", shows, registry);
+    SimpleTest::EXPECT_TRUE(booking.success, "Later showtime can be booked");
+    SimpleTest::EXPECT_TRUE(shows[2].seats[2] && !shows[0].seats[2], "Booking lands in the later showtime");
+    
+    SimpleTest::EXPECT_EQ(1, (int)registry.find("IMAX", "Tenet").value_or(99), "Finds show in second theater");
+    SimpleTest::EXPECT_FALSE(registry.find("IMAX", "Inception").has_value(), "Movie not playing at theater is not found");
+    SimpleTest::EXPECT_FALSE(registry.find("Cinepolis", "Tenet").has_value(), "Unknown theater is not found");
+    SimpleTest::EXPECT_FALSE(registry.find("PVR", "Inception", "2025-09-12 19:30").has_value(), "Unknown date and time is not found");
+}
+
+void test_show_registry_theater_grouping() {
+    std::cout << "\n=== Testing Show Registry Theater Grouping ===" << std::endl;
+    
+    ShowStore shows;
+    shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    shows.emplace_back("Tenet", "2025-09-11 19:30", "IMAX");
+    shows.emplace_back("Interstellar", "2025-09-11 19:30", "PVR");
+    
+    ShowRegistry registry(shows);
+    
+    SimpleTest::EXPECT_EQ(2, (int)registry.theaterCount(), "Two distinct theaters");
+    SimpleTest::EXPECT_EQ(std::string("PVR"), std::string(registry.theaterName(0)), "Theaters keep first-appearance order");
+    SimpleTest::EXPECT_EQ(std::string("IMAX"), std::string(registry.theaterName(1)), "Second theater is IMAX");
+    SimpleTest::EXPECT_EQ(2, (int)registry.theaterShows(0).size(), "PVR has two shows");
+    SimpleTest::EXPECT_EQ(2, (int)registry.theaterShows(0)[1], "PVR shows keep vector order");
+    
+    SimpleTest::EXPECT_EQ(CinemaService::formatCinemaData(shows), CinemaService::formatCinemaData(shows, registry),
+                          "Formatting with a prebuilt registry matches the plain formatter");
+}
+
+void run_show_registry_tests() {
+    test_show_registry_lookup();
+    test_show_registry_theater_grouping();
+}
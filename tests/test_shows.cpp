@@ -1,13 +1,15 @@
 #include "simple_test.hpp"
 #include "cinema.hpp"
+#include <thread>
+#include <atomic>
 
 void test_shows_basic_functionality() {
     std::cout << "\n=== Testing Shows Basic Functionality ===" << std::endl;
     
     Shows show("Inception", "2025-09-11 19:30", "PVR");
-    SimpleTest::EXPECT_EQ(std::string("Inception"), show.movie, "Movie name initialization");
-    SimpleTest::EXPECT_EQ(std::string("2025-09-11 19:30"), show.dateTime, "Show date time initialization");
-    SimpleTest::EXPECT_EQ(std::string("PVR"), show.theater, "Theater name initialization");
+    SimpleTest::EXPECT_EQ(std::string("Inception"), std::string(show.movie), "Movie name initialization");
+    SimpleTest::EXPECT_EQ(std::string("2025-09-11 19:30"), std::string(show.dateTime), "Show date time initialization");
+    SimpleTest::EXPECT_EQ(std::string("PVR"), std::string(show.theater), "Theater name initialization");
     SimpleTest::EXPECT_EQ(20, (int)show.seats.size(), "Default seats size should be 20");
 }
 
@@ -136,6 +138,97 @@ void test_shows_edge_cases() {
     SimpleTest::EXPECT_EQ(0, (int)available.size(), "No seats should be available when all occupied");
 }
 
+void test_shows_large_auditorium() {
+    std::cout << "\n=== Testing Shows Large Auditorium ===" << std::endl;
+    
+    Shows show("Inception", "2025-09-11 19:30", "IMAX", 300);
+    SimpleTest::EXPECT_EQ(300, (int)show.seats.size(), "Seat count should follow constructor argument");
+    SimpleTest::EXPECT_EQ(300, (int)show.availableSeatCount(), "All 300 seats should start available");
+    
+    // Seats 64 and 65 sit in different storage words
+    std::vector<SeatNumber> spanning = {63, 64, 65, 200, 300};
+    SimpleTest::EXPECT_TRUE(show.bookSeats(spanning), "Booking across several words should succeed");
+    SimpleTest::EXPECT_TRUE(show.seats[63] && show.seats[64] && show.seats[299], "Booked seats should be marked");
+    SimpleTest::EXPECT_EQ(295, (int)show.availableSeatCount(), "Available count should drop by five");
+    
+    // Seat 300 is taken, so the whole request must roll back
+    std::vector<SeatNumber> conflicting = {10, 130, 300};
+    SimpleTest::EXPECT_FALSE(show.bookSeats(conflicting), "Booking with a taken seat should fail");
+    SimpleTest::EXPECT_FALSE(show.seats[9], "Seat 10 should be rolled back");
+    SimpleTest::EXPECT_FALSE(show.seats[129], "Seat 130 should be rolled back");
+    SimpleTest::EXPECT_EQ(295, (int)show.getAvailableSeats().size(), "Failed booking should not change availability");
+    
+    std::vector<SeatNumber> outOfRange = {301};
+    SimpleTest::EXPECT_FALSE(show.bookSeats(outOfRange), "Seat beyond capacity should fail");
+}
+
+void test_shows_concurrent_booking() {
+    std::cout << "\n=== Testing Shows Concurrent Booking ===" << std::endl;
+    
+    Shows show("Tenet", "2025-09-11 19:30", "PVR", 128);
+    std::atomic<int> successes{0};
+    std::vector<std::thread> threads;
+    
+    // Every thread races for the same pair of seats in different words
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&show, &successes]() {
+            std::vector<SeatNumber> seats = {1, 128};
+            if (show.bookSeats(seats)) {
+                successes++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    SimpleTest::EXPECT_EQ(1, successes.load(), "Exactly one concurrent booking should win");
+    SimpleTest::EXPECT_EQ(126, (int)show.availableSeatCount(), "Only the winning booking should hold seats");
+}
+
+void test_show_store() {
+    std::cout << "\n=== Testing Show Store ===" << std::endl;
+    
+    ShowStore shows;
+    Shows& first = shows.emplace_back("Inception", "2025-09-11 19:30", "PVR");
+    const Shows* firstAddress = &first;
+    const char* movieName = first.movie.data();
+    for (size_t i = 1; i < 3 * ShowStore::SLAB_SHOWS; ++i) {
+        shows.emplace_back("Inception", "2025-09-11 19:30", "Theater " + std::to_string(i), 20 + i % 300);
+    }
+    SimpleTest::EXPECT_EQ(3 * ShowStore::SLAB_SHOWS, shows.size(), "Store grows past several slabs");
+    SimpleTest::EXPECT_TRUE(&shows[0] == firstAddress, "Growing never moves a show");
+    SimpleTest::EXPECT_TRUE(shows[1].movie.data() == movieName, "Equal names share one interned copy");
+    
+    bool aligned = true;
+    bool seatsApart = true;
+    for (size_t i = 0; i < shows.size(); ++i) {
+        aligned = aligned && reinterpret_cast<uintptr_t>(&shows[i]) % CACHE_LINE_SIZE == 0;
+        std::vector<SeatNumber> seat = {static_cast<SeatNumber>(shows[i].seats.size())};
+        seatsApart = seatsApart && shows[i].bookSeats(seat) &&
+                     shows[i].availableSeatCount() == shows[i].seats.size() - 1;
+    }
+    SimpleTest::EXPECT_TRUE(aligned, "Every record is cache-line aligned");
+    SimpleTest::EXPECT_TRUE(seatsApart, "Seats of neighbouring shows do not overlap");
+    
+    size_t visited = 0;
+    for (const Shows& show : shows) {
+        visited += &show == &shows[visited] ? 1 : 0;
+    }
+    SimpleTest::EXPECT_EQ(shows.size(), visited, "Iteration walks the shows in id order");
+    
+    Shows copy("Tenet", "2025-09-12 21:00", "IMAX", 64);
+    std::vector<SeatNumber> booked = {5, 64};
+    copy.bookSeats(booked);
+    Shows& added = shows.push_back(copy);
+    SimpleTest::EXPECT_TRUE(added.seats[4] && added.seats[63] && added.availableSeatCount() == 62,
+                            "push_back copies the seat state");
+    
+    ShowStore moved = std::move(shows);
+    SimpleTest::EXPECT_TRUE(&moved[0] == firstAddress, "Moving the store keeps show addresses");
+    SimpleTest::EXPECT_TRUE(shows.empty(), "Moved-from store is empty");
+}
+
 void run_shows_tests() {
     test_shows_basic_functionality();
     test_shows_seat_availability();
@@ -143,4 +236,7 @@ void run_shows_tests() {
     test_shows_booking_failures();
     test_shows_thread_safety_simulation();
     test_shows_edge_cases();
+    test_shows_large_auditorium();
+    test_shows_concurrent_booking();
+    test_show_store();
 }
\ No newline at end of file
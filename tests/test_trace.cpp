@@ -0,0 +1,108 @@
+#include "simple_test.hpp"
+#include "trace.hpp"
+#include <mutex>
+#include <thread>
+
+namespace {
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+void test_trace_events() {
+    std::cout << "\n=== Testing Trace Events ===" << std::endl;
+
+    Tracer::clear();
+    Tracer::start({});
+    TraceStamp start = Tracer::now();
+    Tracer::complete("pipeline", "handleMessage", start, start + 2500, 7);
+    Tracer::instant("pipeline", "read", 7);
+    Tracer::asyncBegin("request", 7, start);
+    Tracer::asyncEnd("request", 7, start + 5000);
+    std::thread worker([] {
+        Tracer::nameThread("worker");
+        Tracer::instant("test", "from worker");
+    });
+    worker.join();
+    Tracer::stop();
+
+    std::string json = Tracer::toJson();
+    SimpleTest::EXPECT_EQ((size_t)5, Tracer::eventCount(), "Events of every thread are kept");
+    SimpleTest::EXPECT_CONTAINS(json, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", "Chrome trace object");
+    SimpleTest::EXPECT_CONTAINS(json, "\"ph\":\"X\",\"cat\":\"pipeline\",\"name\":\"handleMessage\"", "Span event");
+    SimpleTest::EXPECT_CONTAINS(json, "\"dur\":2.500", "Durations in microseconds");
+    SimpleTest::EXPECT_CONTAINS(json, "\"args\":{\"request\":7}", "Request id in args");
+    SimpleTest::EXPECT_CONTAINS(json, "\"ph\":\"b\",\"cat\":\"request\",\"name\":\"request\"", "Async span begins");
+    SimpleTest::EXPECT_CONTAINS(json, "\"args\":{\"name\":\"worker\"}", "Thread names are written");
+    SimpleTest::EXPECT_TRUE(json.find("\"tid\":") != std::string::npos && json.back() == '\n', "Thread ids and end");
+
+    Tracer::instant("test", "after stop");
+    Tracer::clear();
+    SimpleTest::EXPECT_EQ((size_t)0, Tracer::eventCount(), "clear() drops the events");
+}
+
+void test_trace_sampling() {
+    std::cout << "\n=== Testing Trace Sampling ===" << std::endl;
+
+    TraceOptions options;
+    options.sampleEvery = 4;
+    options.maxEventsPerThread = 3;
+    Tracer::start(options);
+    size_t sampled = 0;
+    for (int i = 0; i < 100; ++i) {
+        sampled += Tracer::sample() != 0;
+    }
+    SimpleTest::EXPECT_EQ((size_t)25, sampled, "One in sampleEvery is traced");
+
+    for (int i = 0; i < 10; ++i) {
+        Tracer::instant("test", "capped");
+    }
+    Tracer::stop();
+    SimpleTest::EXPECT_EQ((size_t)3, Tracer::eventCount(), "Events beyond the cap are dropped");
+    SimpleTest::EXPECT_CONTAINS(Tracer::toJson(), "\"name\":\"events dropped\"", "Dropped events are reported");
+    Tracer::clear();
+    Tracer::start({});
+    Tracer::stop();
+}
+
+void test_traced_lock() {
+    std::cout << "\n=== Testing Traced Locks ===" << std::endl;
+
+    std::mutex mutex;
+    {
+        TracedLock<std::mutex> lock(mutex, "test lock");
+        SimpleTest::EXPECT_FALSE(mutex.try_lock(), "Lock is held in scope");
+    }
+    SimpleTest::EXPECT_TRUE(mutex.try_lock(), "Lock is released at scope end");
+    mutex.unlock();
+    SimpleTest::EXPECT_EQ((size_t)0, Tracer::eventCount(), "Nothing is recorded while stopped");
+
+    Tracer::start({});
+    {
+        TracedLock<std::mutex> lock(mutex, "test lock");
+        TraceScope scope("format", "test scope");
+    }
+    Tracer::stop();
+    std::string json = Tracer::toJson();
+    if (Tracer::COMPILED) {
+        SimpleTest::EXPECT_EQ((size_t)1, countOf(json, "\"cat\":\"lock.wait\",\"name\":\"test lock\""), "Wait is recorded");
+        SimpleTest::EXPECT_EQ((size_t)1, countOf(json, "\"cat\":\"lock.hold\",\"name\":\"test lock\""), "Hold is recorded");
+        SimpleTest::EXPECT_EQ((size_t)1, countOf(json, "\"name\":\"test scope\""), "Scope is recorded");
+    } else {
+        SimpleTest::EXPECT_FALSE(Tracer::enabled(), "Trace points are compiled out");
+        SimpleTest::EXPECT_EQ((size_t)0, Tracer::eventCount(), "Compiled-out trace points record nothing");
+    }
+    Tracer::clear();
+}
+
+void run_trace_tests() {
+    test_trace_events();
+    test_trace_sampling();
+    test_traced_lock();
+}